@@ -5,6 +5,7 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <optional>
@@ -245,12 +246,40 @@ bool BedFile::load(std::istream& input_stream) {
         return false;
     }
 
+    build_indices();
     return true;
 }
 
+void BedFile::build_indices() {
+    m_genome_indices.clear();
+    for (const auto& [genome, entries] : m_genomes) {
+        EntryIndex::interval_vector intervals;
+        intervals.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            intervals.emplace_back(entries[i].start, entries[i].end, i);
+        }
+        m_genome_indices.emplace(genome, EntryIndex(std::move(intervals)));
+    }
+}
+
 const BedFile::Entries& BedFile::entries(const std::string& genome) const {
     auto it = m_genomes.find(genome);
     return it != m_genomes.end() ? it->second : NO_ENTRIES;
 }
 
+std::vector<size_t> BedFile::overlapping_entries(const std::string& genome,
+                                                 size_t start,
+                                                 size_t end) const {
+    std::vector<size_t> hits;
+    auto it = m_genome_indices.find(genome);
+    if (it == m_genome_indices.end()) {
+        return hits;
+    }
+    it->second.visit_overlapping(start, end, [&hits](const EntryIndex::interval& interval) {
+        hits.push_back(interval.value);
+    });
+    std::sort(hits.begin(), hits.end());
+    return hits;
+}
+
 }  // namespace dorado::alignment
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <IntervalTree.h>
+
 #include <istream>
 #include <map>
 #include <string>
@@ -29,10 +31,21 @@ public:
 
     const Entries& entries(const std::string& genome) const;
 
+    // Returns the indices into entries(genome) of all entries overlapping the closed range
+    // [start, end], in file order. Callers apply any stricter boundary or strand checks.
+    std::vector<size_t> overlapping_entries(const std::string& genome,
+                                            size_t start,
+                                            size_t end) const;
+
     const std::string& filename() const;
 
 private:
+    using EntryIndex = interval_tree::IntervalTree<size_t, size_t>;
+
+    void build_indices();
+
     std::map<std::string, Entries> m_genomes;
+    std::map<std::string, EntryIndex> m_genome_indices;
     std::string m_file_name{"<stream>"};
     static const Entries NO_ENTRIES;
 };
@@ -1,6 +1,8 @@
 #include "CPUDecoder.h"
 
 #include "beam_search.h"
+#include "utils/concurrency/synchronisation.h"
+#include "utils/simd.h"
 
 #include <ATen/Functions.h>
 #include <ATen/TensorIndexing.h>
@@ -8,15 +10,246 @@
 #include <math.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <exception>
+#include <iterator>
 #include <vector>
 
 namespace {
 
+constexpr int NUM_BASES = 4;
+// Each state can be reached by a stay, or by a step from one of NUM_BASES states.
+constexpr int NUM_TRANSITIONS = NUM_BASES + 1;
+
+// A log-semiring scan over the CRF transition structure of a single chunk, where each timestep
+// has num_states = 4^state_len state scores and 4 * num_states transition scores.
+struct ScanParams {
+    // Transition scores for timestep t start at scores[t * scores_stride].
+    const float* scores;
+    int64_t scores_stride;
+    // State scores for timestep t start at out[t * out_stride].
+    float* out;
+    int64_t out_stride;
+    int num_timesteps;
+    int num_states;
+    int state_shift;  // log2(num_states / NUM_BASES)
+    float stay_score;
+    bool backward;
+};
+
+// Writes the log-scores of the NUM_TRANSITIONS transitions into |state| from |prev|, spaced
+// |stride| apart in |terms|. Forward, state s is reached by a step from (base, s / 4). Backward,
+// the scan runs in reverse and state s steps to ((s % (num_states / 4)), base).
+inline void gather_transitions(const ScanParams& params,
+                               const float* prev,
+                               const float* scores,
+                               int state,
+                               float* terms,
+                               int stride) {
+    terms[0] = prev[state] + params.stay_score;
+    const int low_mask = (1 << params.state_shift) - 1;
+    for (int base = 0; base < NUM_BASES; ++base) {
+        float term;
+        if (params.backward) {
+            const int next = NUM_BASES * (state & low_mask) + base;
+            term = prev[next] + scores[next * NUM_BASES + (state >> params.state_shift)];
+        } else {
+            const int from = (base << params.state_shift) + state / NUM_BASES;
+            term = prev[from] + scores[state * NUM_BASES + base];
+        }
+        terms[(base + 1) * stride] = term;
+    }
+}
+
+#if !ENABLE_NEON_IMPL  // We only need the scalar implementation when we don't have Neon support.
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void scan_step(const ScanParams& params, const float* prev, const float* scores, float* out) {
+    float terms[NUM_TRANSITIONS];
+    for (int state = 0; state < params.num_states; ++state) {
+        gather_transitions(params, prev, scores, state, terms, 1);
+        const float max_term = *std::max_element(std::begin(terms), std::end(terms));
+        float sum = 0;
+        for (const float term : terms) {
+            sum += std::exp(term - max_term);
+        }
+        out[state] = max_term + std::log(sum);
+    }
+}
+#endif  // !ENABLE_NEON_IMPL
+
+#if ENABLE_AVX2_IMPL || ENABLE_NEON_IMPL
+// Polynomial approximations of exp and log, following Cephes expf/logf.
+constexpr float EXP_HI = 88.3762626647949f;
+constexpr float EXP_LO = -87.3365447504019f;
+constexpr float LOG2E = 1.44269504088896341f;
+constexpr float LN2_HI = 0.693359375f;
+constexpr float LN2_LO = -2.12194440e-4f;
+constexpr float SQRT_HALF = 0.707106781186547524f;
+constexpr std::array<float, 6> EXP_POLY = {
+        1.9875691500E-4f, 1.3981999507E-3f, 8.3334519073E-3f,
+        4.1665795894E-2f, 1.6666665459E-1f, 5.0000001201E-1f,
+};
+constexpr std::array<float, 9> LOG_POLY = {
+        7.0376836292E-2f, -1.1514610310E-1f, 1.1676998740E-1f,
+        -1.2420140846E-1f, 1.4249322787E-1f, -1.6668057665E-1f,
+        2.0000714765E-1f, -2.4999993993E-1f, 3.3333331174E-1f,
+};
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2")))
+#endif
+inline dorado::utils::simd::FloatRegister simd_exp(dorado::utils::simd::FloatRegister x) {
+#if ENABLE_AVX2_IMPL
+    x = _mm256_min_ps(simd_max_32(x, simd_set1_32(EXP_LO)), simd_set1_32(EXP_HI));
+#else
+    x = vminq_f32(simd_max_32(x, simd_set1_32(EXP_LO)), simd_set1_32(EXP_HI));
+#endif
+    // x = fx * ln(2) + r, with |r| <= ln(2) / 2.
+    auto fx = simd_add_32(simd_mul_32(x, simd_set1_32(LOG2E)), simd_set1_32(0.5f));
+#if ENABLE_AVX2_IMPL
+    fx = _mm256_floor_ps(fx);
+#else
+    fx = vrndmq_f32(fx);
+#endif
+    x = simd_sub_32(x, simd_mul_32(fx, simd_set1_32(LN2_HI)));
+    x = simd_sub_32(x, simd_mul_32(fx, simd_set1_32(LN2_LO)));
+    const auto z = simd_mul_32(x, x);
+    auto y = simd_set1_32(EXP_POLY[0]);
+    for (size_t i = 1; i < EXP_POLY.size(); ++i) {
+        y = simd_add_32(simd_mul_32(y, x), simd_set1_32(EXP_POLY[i]));
+    }
+    y = simd_add_32(simd_add_32(simd_mul_32(y, z), x), simd_set1_32(1.f));
+
+    // Scale by 2^fx by building the float exponent directly.
+#if ENABLE_AVX2_IMPL
+    auto pow2n = _mm256_add_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32(127));
+    return simd_mul_32(y, _mm256_castsi256_ps(_mm256_slli_epi32(pow2n, 23)));
+#else
+    auto pow2n = vaddq_s32(vcvtq_s32_f32(fx), vdupq_n_s32(127));
+    return simd_mul_32(y, vreinterpretq_f32_s32(vshlq_n_s32(pow2n, 23)));
+#endif
+}
+
+// Only valid for positive, normal inputs.
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2")))
+#endif
+inline dorado::utils::simd::FloatRegister simd_log(dorado::utils::simd::FloatRegister x) {
+    const auto one = simd_set1_32(1.f);
+    // Split x into a mantissa in [0.5, 1) and an exponent.
+#if ENABLE_AVX2_IMPL
+    auto xi = _mm256_castps_si256(x);
+    auto exponent = _mm256_cvtepi32_ps(
+            _mm256_sub_epi32(_mm256_srli_epi32(xi, 23), _mm256_set1_epi32(126)));
+    xi = _mm256_or_si256(_mm256_and_si256(xi, _mm256_set1_epi32(0x007fffff)),
+                         _mm256_set1_epi32(0x3f000000));
+    auto m = _mm256_castsi256_ps(xi);
+    // Shift the mantissa into [sqrt(0.5), sqrt(2)) for the best polynomial accuracy.
+    const auto mask = _mm256_cmp_ps(m, simd_set1_32(SQRT_HALF), _CMP_LT_OS);
+    exponent = simd_sub_32(exponent, _mm256_and_ps(one, mask));
+    m = simd_add_32(simd_sub_32(m, one), _mm256_and_ps(m, mask));
+#else
+    auto xi = vreinterpretq_s32_f32(x);
+    auto exponent = vcvtq_f32_s32(vsubq_s32(vshrq_n_s32(xi, 23), vdupq_n_s32(126)));
+    xi = vorrq_s32(vandq_s32(xi, vdupq_n_s32(0x007fffff)), vdupq_n_s32(0x3f000000));
+    auto m = vreinterpretq_f32_s32(xi);
+    // Shift the mantissa into [sqrt(0.5), sqrt(2)) for the best polynomial accuracy.
+    const auto mask = vcltq_f32(m, simd_set1_32(SQRT_HALF));
+    exponent = simd_sub_32(
+            exponent, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(one), mask)));
+    m = simd_add_32(simd_sub_32(m, one),
+                    vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(m), mask)));
+#endif
+    const auto z = simd_mul_32(m, m);
+    auto y = simd_set1_32(LOG_POLY[0]);
+    for (size_t i = 1; i < LOG_POLY.size(); ++i) {
+        y = simd_add_32(simd_mul_32(y, m), simd_set1_32(LOG_POLY[i]));
+    }
+    y = simd_mul_32(simd_mul_32(y, m), z);
+    y = simd_add_32(y, simd_mul_32(exponent, simd_set1_32(LN2_LO)));
+    y = simd_sub_32(y, simd_mul_32(z, simd_set1_32(0.5f)));
+    return simd_add_32(simd_add_32(m, y), simd_mul_32(exponent, simd_set1_32(LN2_HI)));
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2")))
+#endif
+void scan_step(const ScanParams& params, const float* prev, const float* scores, float* out) {
+    namespace simd = dorado::utils::simd;
+    constexpr int kWidth = int(simd::kFloatsPerRegister);
+    // Transition terms for kWidth consecutive states, one row per transition.
+    alignas(32) float terms[NUM_TRANSITIONS * kWidth];
+
+    // num_states is a power of 4 and at least 16 for any real model, so there's no remainder.
+    for (int first_state = 0; first_state < params.num_states; first_state += kWidth) {
+        for (int lane = 0; lane < kWidth; ++lane) {
+            gather_transitions(params, prev, scores, first_state + lane, terms + lane, kWidth);
+        }
+        simd::FloatRegister transitions[NUM_TRANSITIONS];
+        auto max_term = simd_load_32(terms);
+        for (int i = 0; i < NUM_TRANSITIONS; ++i) {
+            transitions[i] = simd_load_32(terms + i * kWidth);
+            max_term = simd_max_32(max_term, transitions[i]);
+        }
+        auto sum = simd_set1_32(0.f);
+        for (int i = 0; i < NUM_TRANSITIONS; ++i) {
+            sum = simd_add_32(sum, simd_exp(simd_sub_32(transitions[i], max_term)));
+        }
+        simd_store_32(out + first_state, simd_add_32(max_term, simd_log(sum)));
+    }
+}
+#endif  // ENABLE_AVX2_IMPL || ENABLE_NEON_IMPL
+
+void scan(const ScanParams& params) {
+    const int T = params.num_timesteps;
+    // The guide values at the first (or, going backward, last) timestep are zero.
+    std::fill_n(params.out + (params.backward ? T * params.out_stride : 0), params.num_states, 0.f);
+    for (int i = 0; i < T; ++i) {
+        const int t = params.backward ? T - 1 - i : i;
+        const int prev_t = params.backward ? t + 1 : t;
+        const int out_t = params.backward ? t : t + 1;
+        scan_step(params, params.out + prev_t * params.out_stride,
+                  params.scores + t * params.scores_stride, params.out + out_t * params.out_stride);
+    }
+}
+
+// Runs the scan over each chunk of scores_TNC, returning the state scores in (T + 1)NS.
+at::Tensor scan_chunks(const at::Tensor& scores_TNC, const float fixed_stay_score, bool backward) {
+    const auto scores = scores_TNC.stride(2) == 1 ? scores_TNC : scores_TNC.contiguous();
+    const int T = int(scores.size(0));
+    const int N = int(scores.size(1));
+    const int C = int(scores.size(2));
+    const int num_states = C / NUM_BASES;
+    int state_shift = 0;
+    while ((NUM_BASES << state_shift) < num_states) {
+        ++state_shift;
+    }
+
+    at::Tensor out = at::empty({T + 1, N, num_states}, scores.options().dtype(at::kFloat));
+    for (int n = 0; n < N; ++n) {
+        ScanParams params{scores.data_ptr<float>() + n * scores.stride(1),
+                          scores.stride(0),
+                          out.data_ptr<float>() + n * num_states,
+                          int64_t(N) * num_states,
+                          T,
+                          num_states,
+                          state_shift,
+                          fixed_stay_score,
+                          backward};
+        scan(params);
+    }
+    return out;
+}
+
 // Operates in TNC
-at::Tensor scan(const at::Tensor& Ms,
-                const float fixed_stay_score,
-                const at::Tensor& idx,
-                const at::Tensor& v0) {
+at::Tensor scan_aten(const at::Tensor& Ms,
+                     const float fixed_stay_score,
+                     const at::Tensor& idx,
+                     const at::Tensor& v0) {
     const int T = int(Ms.size(0));
     const int N = int(Ms.size(1));
     const int C = int(Ms.size(2));
@@ -40,6 +273,14 @@ at::Tensor scan(const at::Tensor& Ms,
 namespace dorado::basecall::decode::inner {
 
 at::Tensor forward_scores(const at::Tensor& scores_TNC, const float fixed_stay_score) {
+    return scan_chunks(scores_TNC, fixed_stay_score, false);
+}
+
+at::Tensor backward_scores(const at::Tensor& scores_TNC, const float fixed_stay_score) {
+    return scan_chunks(scores_TNC, fixed_stay_score, true);
+}
+
+at::Tensor forward_scores_aten(const at::Tensor& scores_TNC, const float fixed_stay_score) {
     const int T = int(scores_TNC.size(0));  // Signal len
     const int N = int(scores_TNC.size(1));  // Num batches
     const int C = int(scores_TNC.size(2));  // 4^state_len * 4 = 4^(state_len + 1)
@@ -61,10 +302,10 @@ at::Tensor forward_scores(const at::Tensor& scores_TNC, const float fixed_stay_s
     const auto idx =
             at::arange(num_states).repeat_interleave(n_base).reshape({n_base, -1}).t().contiguous();
 
-    return scan(Ms, fixed_stay_score, idx, v0);
+    return scan_aten(Ms, fixed_stay_score, idx, v0);
 }
 
-at::Tensor backward_scores(const at::Tensor& scores_TNC, const float fixed_stay_score) {
+at::Tensor backward_scores_aten(const at::Tensor& scores_TNC, const float fixed_stay_score) {
     const int N = int(scores_TNC.size(1));  // Num batches
     const int C = int(scores_TNC.size(2));  // 4^state_len * 4 = 4^(state_len + 1)
 
@@ -87,13 +328,20 @@ at::Tensor backward_scores(const at::Tensor& scores_TNC, const float fixed_stay_
     // For each state, the indices of the 4 states that could succeed it via a step transition.
     idx_T = at::bitwise_right_shift(idx_T, 2);
 
-    return scan(Ms_T.flip(0), fixed_stay_score, idx_T.to(at::kLong), vT).flip(0);
+    return scan_aten(Ms_T.flip(0), fixed_stay_score, idx_T.to(at::kLong), vT).flip(0);
 }
 
 }  // namespace dorado::basecall::decode::inner
 
 namespace dorado::basecall::decode {
 
+CPUDecoder::CPUDecoder(int num_threads)
+        : m_num_threads(std::max(num_threads, 1)),
+          m_thread_pool(std::make_unique<utils::concurrency::MultiQueueThreadPool>(
+                  size_t(m_num_threads), "cpu_decode")),
+          m_task_queue(
+                  &m_thread_pool->create_task_queue(utils::concurrency::TaskPriority::normal)) {}
+
 DecodeData CPUDecoder::beam_search_part_1(DecodeData data) const { return data; }
 
 std::vector<DecodedChunk> CPUDecoder::beam_search_part_2(DecodeData data) const {
@@ -101,54 +349,65 @@ std::vector<DecodedChunk> CPUDecoder::beam_search_part_2(DecodeData data) const
     const auto scores_cpu = data.data.to(at::kCPU);
     const auto num_chunks = data.num_chunks;
     const auto& options = data.options;
-    int num_threads = std::min(num_chunks, 4);
+    int num_threads = std::min(num_chunks, m_num_threads);
+    if (num_threads == 0) {
+        return {};
+    }
     int chunks_per_thread = num_chunks / num_threads;
     int num_threads_with_one_more_chunk = num_chunks % num_threads;
 
     std::vector<DecodedChunk> chunk_results(num_chunks);
+    std::vector<std::exception_ptr> errors(num_threads);
+    utils::concurrency::Latch tasks_done(num_threads);
 
-    std::vector<std::thread> threads;
-    threads.reserve(num_threads);
     for (int i = 0; i < num_threads; ++i) {
-        threads.emplace_back([&, i]() {
-            at::InferenceMode inference_mode_guard;
-
-            int t_first_chunk =
-                    i * chunks_per_thread + std::min(i, num_threads_with_one_more_chunk);
-            int t_num_chunks = chunks_per_thread + int(i < num_threads_with_one_more_chunk);
-
-            // Slice TNC -> TnC
-            using Slice = at::indexing::Slice;
-            auto t_scores =
-                    scores_cpu.index({Slice(), Slice(t_first_chunk, t_first_chunk + t_num_chunks)});
-
-            at::Tensor fwd = inner::forward_scores(t_scores, options.blank_score);
-            at::Tensor bwd = inner::backward_scores(t_scores, options.blank_score);
-
-            at::Tensor posts = at::softmax(fwd + bwd, -1);
-
-            // Transpose TnC to nTC
-            t_scores = t_scores.transpose(0, 1);
-            bwd = bwd.transpose(0, 1).contiguous();
-            posts = posts.transpose(0, 1).contiguous();
-
-            // Iter over n in nTC, passing TC tensors to beam_search_decode
-            for (int chunk_idx = 0; chunk_idx < t_num_chunks; chunk_idx++) {
-                auto decode_result = beam_search_decode(t_scores[chunk_idx], bwd[chunk_idx],
-                                                        posts[chunk_idx], options.beam_width,
-                                                        options.beam_cut, options.blank_score,
-                                                        options.q_shift, options.q_scale, 1.0f);
-                chunk_results[t_first_chunk + chunk_idx] = DecodedChunk{
-                        std::get<0>(decode_result),
-                        std::get<1>(decode_result),
-                        std::get<2>(decode_result),
-                };
+        m_task_queue->push([&, i]() {
+            try {
+                at::InferenceMode inference_mode_guard;
+
+                int t_first_chunk =
+                        i * chunks_per_thread + std::min(i, num_threads_with_one_more_chunk);
+                int t_num_chunks = chunks_per_thread + int(i < num_threads_with_one_more_chunk);
+
+                // Slice TNC -> TnC
+                using Slice = at::indexing::Slice;
+                auto t_scores = scores_cpu.index(
+                        {Slice(), Slice(t_first_chunk, t_first_chunk + t_num_chunks)});
+
+                at::Tensor fwd = inner::forward_scores(t_scores, options.blank_score);
+                at::Tensor bwd = inner::backward_scores(t_scores, options.blank_score);
+
+                at::Tensor posts = at::softmax(fwd + bwd, -1);
+
+                // Transpose TnC to nTC
+                t_scores = t_scores.transpose(0, 1);
+                bwd = bwd.transpose(0, 1).contiguous();
+                posts = posts.transpose(0, 1).contiguous();
+
+                // Iter over n in nTC, passing TC tensors to beam_search_decode
+                for (int chunk_idx = 0; chunk_idx < t_num_chunks; chunk_idx++) {
+                    auto decode_result = beam_search_decode(
+                            t_scores[chunk_idx], bwd[chunk_idx], posts[chunk_idx],
+                            options.beam_width, options.beam_cut, options.blank_score,
+                            options.q_shift, options.q_scale, 1.0f);
+                    chunk_results[t_first_chunk + chunk_idx] = DecodedChunk{
+                            std::get<0>(decode_result),
+                            std::get<1>(decode_result),
+                            std::get<2>(decode_result),
+                    };
+                }
+            } catch (...) {
+                errors[i] = std::current_exception();
             }
+            tasks_done.count_down();
         });
     }
 
-    for (auto& thread : threads) {
-        thread.join();
+    tasks_done.wait();
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
     }
 
     return chunk_results;
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "Decoder.h"
+#include "utils/concurrency/multi_queue_thread_pool.h"
 
 #include <ATen/core/TensorBody.h>
 
+#include <memory>
+
 namespace dorado::basecall::decode {
 
 namespace inner {
@@ -11,14 +14,26 @@ namespace inner {
 at::Tensor forward_scores(const at::Tensor& scores_TNC, float fixed_stay_score);
 at::Tensor backward_scores(const at::Tensor& scores_TNC, float fixed_stay_score);
 
+// Reference implementations of the above using ATen ops, for testing and benchmarking.
+at::Tensor forward_scores_aten(const at::Tensor& scores_TNC, float fixed_stay_score);
+at::Tensor backward_scores_aten(const at::Tensor& scores_TNC, float fixed_stay_score);
+
 }  // namespace inner
 
 class CPUDecoder final : public Decoder {
 public:
+    // Decoding of each batch is split across |num_threads| long-lived worker threads.
+    explicit CPUDecoder(int num_threads);
+
     DecodeData beam_search_part_1(DecodeData data) const;
     std::vector<DecodedChunk> beam_search_part_2(DecodeData data) const;
 
     at::ScalarType dtype() const { return at::ScalarType::Float; };
+
+private:
+    const int m_num_threads;
+    std::unique_ptr<utils::concurrency::MultiQueueThreadPool> m_thread_pool;
+    utils::concurrency::MultiQueueThreadPool::ThreadPoolQueue* m_task_queue;
 };
 
 }  // namespace dorado::basecall::decode
@@ -9,18 +9,24 @@
 
 #include <c10/core/Device.h>
 
+#include <algorithm>
+
 namespace dorado::basecall::decode {
 
+namespace {
+// Upper limit on the threads used to decode a single batch on the CPU.
+constexpr int MAX_CPU_DECODE_THREADS = 4;
+}  // namespace
+
 std::unique_ptr<Decoder> create_decoder(c10::Device device, const CRFModelConfig& config) {
 #if DORADO_CUDA_BUILD
     if (device.is_cuda()) {
         return std::make_unique<decode::CUDADecoder>(config.clamp ? 5.f : 0.f);
     }
-#else
-    (void)config;  // unused in other build types
 #endif
     if (device.is_cpu()) {
-        return std::make_unique<decode::CPUDecoder>();
+        return std::make_unique<decode::CPUDecoder>(
+                std::min(config.basecaller.batch_size(), MAX_CPU_DECODE_THREADS));
     }
 
     throw std::runtime_error("Unsupported device type for decoder creation: " + device.str());
@@ -10,23 +10,30 @@
 #include "read_pipeline/HtsWriter.h"
 #include "read_pipeline/ProgressTracker.h"
 #include "read_pipeline/ReadPipeline.h"
+#include "read_pipeline/SummaryWriterNode.h"
 #include "read_pipeline/read_output_progress_stats.h"
 #include "summary/summary.h"
 #include "utils/PostCondition.h"
 #include "utils/arg_parse_ext.h"
 #include "utils/bam_utils.h"
+#include "utils/concurrency/multi_queue_thread_pool.h"
 #include "utils/log_utils.h"
 #include "utils/stats.h"
+#include "utils/thread_naming.h"
 #include "utils/tty_utils.h"
 
+#include <cxxpool.h>
 #include <minimap.h>
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_set>
@@ -103,6 +110,202 @@ void add_pg_hdr(sam_hdr_t* hdr) {
 
 namespace dorado {
 
+namespace {
+
+// What each input file is aligned against, and with.
+struct FileAlignmentSetup {
+    std::shared_ptr<alignment::IndexFileAccess> index_file_access;
+    std::shared_ptr<alignment::BedFileAccess> bed_file_access;
+    std::shared_ptr<alignment::AlignmentInfo> align_info;
+    std::shared_ptr<DefaultClientInfo> client_info;
+    std::shared_ptr<utils::concurrency::MultiQueueThreadPool> thread_pool;
+    int aligner_threads{0};
+    int max_reads{0};
+    std::shared_ptr<SummaryWriter> summary_writer;
+};
+
+// An input file that has been through its alignment pipeline. Its output is complete apart
+// from being finalised, which for sorted BAM means merging the temporary files.
+struct AlignedFile {
+    std::shared_ptr<utils::HtsFile> hts_file;
+    std::size_t num_reads{0};
+    stats::NamedStats final_stats;
+    std::size_t total{0};
+    std::size_t primary{0};
+    std::size_t unmapped{0};
+};
+
+// Aligns |file_info| through a pipeline of its own, whose AlignerNode runs on the setup's
+// thread pool. Stats are sampled into |stats_callables|, if there are any, while the pipeline
+// runs. Throws if the output can't be created or the pipeline fails.
+AlignedFile align_file(const alignment::AlignmentProcessingInfo& file_info,
+                       const FileAlignmentSetup& setup,
+                       int writer_threads,
+                       std::size_t buffer_size,
+                       const std::vector<stats::StatsCallable>& stats_callables) {
+    spdlog::info("processing {} -> {}", file_info.input, file_info.output);
+    auto reader = std::make_unique<HtsReader>(file_info.input, std::nullopt);
+    reader->set_client_info(setup.client_info);
+    reader->set_decode_threads(writer_threads);
+    if (file_info.output != "-" &&
+        !create_output_folder(std::filesystem::path(file_info.output).parent_path())) {
+        throw std::runtime_error("Unable to create output folder for " + file_info.output);
+    }
+
+    spdlog::debug("> input fmt: {} aligned: {}", reader->format(), reader->is_aligned);
+    auto header = SamHdrPtr(sam_hdr_dup(reader->header()));
+    utils::add_hd_header_line(header.get());
+    add_pg_hdr(header.get());
+    utils::strip_alignment_data_from_header(header.get());
+
+    const bool sort_bam =
+            (file_info.output_mode == utils::HtsFile::OutputMode::BAM && file_info.output != "-");
+    AlignedFile result;
+    result.hts_file = std::make_shared<utils::HtsFile>(file_info.output, file_info.output_mode,
+                                                       writer_threads, sort_bam);
+    if (sort_bam) {
+        result.hts_file->set_buffer_size(buffer_size);
+    }
+    PipelineDescriptor pipeline_desc;
+    auto hts_writer = pipeline_desc.add_node<HtsWriter>({}, *result.hts_file, "");
+    auto aligner_sink = hts_writer;
+    if (setup.summary_writer) {
+        aligner_sink =
+                pipeline_desc.add_node<SummaryWriterNode>({hts_writer}, setup.summary_writer);
+    }
+    const auto& align_info = *setup.align_info;
+    auto aligner = pipeline_desc.add_node<AlignerNode>(
+            {aligner_sink}, setup.index_file_access, setup.bed_file_access, setup.thread_pool,
+            align_info.reference_file, align_info.bed_file, align_info.minimap_options,
+            setup.aligner_threads);
+
+    // Create the Pipeline from our description.
+    std::vector<dorado::stats::StatsReporter> stats_reporters;
+    auto pipeline = Pipeline::create(std::move(pipeline_desc), &stats_reporters);
+    if (pipeline == nullptr) {
+        throw std::runtime_error("Failed to create pipeline");
+    }
+    stats_reporters.push_back(stats::make_stats_reporter(*reader));
+
+    // At present, header output file header writing relies on direct node method calls
+    // rather than the pipeline framework.
+    const auto& aligner_ref = dynamic_cast<AlignerNode&>(pipeline->get_node_ref(aligner));
+    utils::add_sq_hdr(header.get(), aligner_ref.get_sequence_records_for_header());
+    result.hts_file->set_header(header.get());
+    if (setup.summary_writer) {
+        dynamic_cast<SummaryWriterNode&>(pipeline->get_node_ref(aligner_sink))
+                .set_header(header.get());
+    }
+
+    std::unique_ptr<dorado::stats::StatsSampler> stats_sampler;
+    if (!stats_callables.empty()) {
+        constexpr auto kStatsPeriod = 100ms;
+        stats_sampler = std::make_unique<dorado::stats::StatsSampler>(
+                kStatsPeriod, stats_reporters, stats_callables, static_cast<size_t>(0));
+    }
+
+    spdlog::info("> starting alignment");
+    result.num_reads = reader->read(*pipeline, setup.max_reads);
+
+    // Wait for the pipeline to complete.  When it does, we collect
+    // final stats to allow accurate summarisation.
+    result.final_stats = pipeline->terminate(DefaultFlushOptions());
+
+    // Stop the stats sampler thread before tearing down any pipeline objects.
+    if (stats_sampler) {
+        stats_sampler->terminate();
+    }
+
+    const auto& hts_writer_ref = dynamic_cast<HtsWriter&>(pipeline->get_node_ref(hts_writer));
+    result.total = hts_writer_ref.get_total();
+    result.primary = hts_writer_ref.get_primary();
+    result.unmapped = hts_writer_ref.get_unmapped();
+    return result;
+}
+
+// Aligns the input files |num_concurrent_files| at a time. Each file has its own pipeline, but
+// their AlignerNodes share one alignment thread pool and the loaded index, so the index isn't
+// left idle while a file is starting up or winding down. Finalising an output file, which for
+// sorted BAM means merging its temporary files, is done in the background so that the next
+// input can start straight away.
+//
+// Progress is reported as each file completes rather than with a progress bar.
+bool align_files_concurrently(const std::vector<alignment::AlignmentProcessingInfo>& all_files,
+                              std::size_t num_concurrent_files,
+                              const FileAlignmentSetup& setup,
+                              int writer_threads,
+                              ReadOutputProgressStats& progress_stats) {
+    // The writer threads and the sorting buffer are split between the files written at once.
+    const int file_writer_threads =
+            std::max(1, writer_threads / static_cast<int>(num_concurrent_files));
+    const std::size_t file_buffer_size = BAM_BUFFER_SIZE / num_concurrent_files;
+
+    cxxpool::thread_pool finalise_pool{num_concurrent_files};
+    std::mutex progress_mutex;
+    std::atomic_size_t next_file_index{0};
+    std::atomic_size_t num_completed_files{0};
+    std::atomic_bool failed{false};
+
+    auto finalise_file = [&](const std::string& output, const AlignedFile& aligned) {
+        aligned.hts_file->finalise([](size_t) {});
+        {
+            std::lock_guard lock(progress_mutex);
+            progress_stats.update_reads_per_file_estimate(aligned.num_reads);
+            progress_stats.notify_stats_collector_completed(aligned.final_stats);
+            progress_stats.notify_post_processing_completed();
+        }
+        spdlog::info("> finished {} ({}/{} files), total/primary/unmapped {}/{}/{}", output,
+                     ++num_completed_files, all_files.size(), aligned.total, aligned.primary,
+                     aligned.unmapped);
+    };
+
+    auto process_files = [&] {
+        utils::set_thread_name("align_files");
+        // Each worker has at most one file being finalised, which bounds the memory held by
+        // output files waiting to be finalised.
+        std::future<void> pending_finalise;
+        try {
+            while (!failed) {
+                const std::size_t file_index = next_file_index++;
+                if (file_index >= all_files.size()) {
+                    break;
+                }
+                const auto& file_info = all_files[file_index];
+                auto aligned =
+                        align_file(file_info, setup, file_writer_threads, file_buffer_size, {});
+                if (pending_finalise.valid()) {
+                    pending_finalise.get();
+                }
+                pending_finalise =
+                        finalise_pool.push([&finalise_file, output = file_info.output,
+                                            aligned = std::move(aligned)] {
+                            finalise_file(output, aligned);
+                        });
+            }
+            if (pending_finalise.valid()) {
+                pending_finalise.get();
+            }
+        } catch (const std::exception& e) {
+            spdlog::error("Alignment failed: {}", e.what());
+            failed = true;
+            if (pending_finalise.valid()) {
+                pending_finalise.wait();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < num_concurrent_files; ++i) {
+        workers.emplace_back(process_files);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return !failed;
+}
+
+}  // namespace
+
 int aligner(int argc, char* argv[]) {
     utils::arg_parse::ArgParser parser("dorado aligner");
     parser.visible.add_description(
@@ -144,6 +347,12 @@ int aligner(int argc, char* argv[]) {
             .help("number of threads for alignment and BAM writing (0=unlimited).")
             .default_value(0)
             .scan<'i', int>();
+    parser.visible.add_argument("--concurrent-files")
+            .help("number of input files to align at the same time. The files share the index "
+                  "and the alignment threads, and each output file is finalised in the "
+                  "background while the next input file is aligned.")
+            .default_value(1)
+            .scan<'i', int>();
     parser.visible.add_argument("-n", "--max-reads")
             .help("maximum number of reads to process (for debugging, 0=unlimited).")
             .default_value(0)
@@ -197,6 +406,12 @@ int aligner(int argc, char* argv[]) {
 
     auto max_reads(parser.visible.get<int>("max-reads"));
 
+    auto concurrent_files(parser.visible.get<int>("concurrent-files"));
+    if (concurrent_files < 1) {
+        spdlog::error("--concurrent-files must be at least 1.");
+        return EXIT_FAILURE;
+    }
+
     std::string err_msg{};
     auto minimap_options = alignment::mm2::try_parse_options(mm2_option_string, err_msg);
     if (!minimap_options) {
@@ -258,106 +473,96 @@ int aligner(int argc, char* argv[]) {
     auto client_info = std::make_shared<DefaultClientInfo>();
     client_info->contexts().register_context<const alignment::AlignmentInfo>(align_info);
 
-    for (const auto& file_info : all_files) {
-        spdlog::info("processing {} -> {}", file_info.input, file_info.output);
-        auto reader = std::make_unique<HtsReader>(file_info.input, std::nullopt);
-        reader->set_client_info(client_info);
-        if (file_info.output != "-" &&
-            !create_output_folder(std::filesystem::path(file_info.output).parent_path())) {
+    // The summary is written as records are aligned, rather than by reading back the output.
+    std::ofstream summary_out;
+    std::shared_ptr<SummaryWriter> summary_writer;
+    if (emit_summary) {
+        if (!create_output_folder(output_folder)) {
             return EXIT_FAILURE;
         }
+        const auto summary_file = std::filesystem::path(output_folder) / "alignment_summary.txt";
+        summary_out.open(summary_file.string());
+        summary_writer = std::make_shared<SummaryWriter>(
+                summary_out, SummaryData(SummaryData::ALIGNMENT_FIELDS));
+    }
 
-        spdlog::debug("> input fmt: {} aligned: {}", reader->format(), reader->is_aligned);
-        auto header = SamHdrPtr(sam_hdr_dup(reader->header()));
-        utils::add_hd_header_line(header.get());
-        add_pg_hdr(header.get());
-        dorado::utils::strip_alignment_data_from_header(header.get());
-
-        const bool sort_bam = (file_info.output_mode == utils::HtsFile::OutputMode::BAM &&
-                               file_info.output != "-");
-        utils::HtsFile hts_file(file_info.output, file_info.output_mode, writer_threads, sort_bam);
-        if (sort_bam) {
-            hts_file.set_buffer_size(BAM_BUFFER_SIZE);
-        }
-        PipelineDescriptor pipeline_desc;
-        auto hts_writer = pipeline_desc.add_node<HtsWriter>({}, hts_file, "");
-        auto aligner = pipeline_desc.add_node<AlignerNode>(
-                {hts_writer}, index_file_access, bed_file_access, align_info->reference_file,
-                align_info->bed_file, align_info->minimap_options, aligner_threads);
-
-        // Create the Pipeline from our description.
-        std::vector<dorado::stats::StatsReporter> stats_reporters;
-        auto pipeline = Pipeline::create(std::move(pipeline_desc), &stats_reporters);
-        if (pipeline == nullptr) {
-            spdlog::error("Failed to create pipeline");
+    const FileAlignmentSetup setup{index_file_access,
+                                   bed_file_access,
+                                   align_info,
+                                   client_info,
+                                   std::make_shared<utils::concurrency::MultiQueueThreadPool>(
+                                           aligner_threads, "align_node_pool"),
+                                   aligner_threads,
+                                   max_reads,
+                                   summary_writer};
+
+    // Output to stdout can only come from one file at a time.
+    const bool output_to_stdout = std::any_of(all_files.begin(), all_files.end(),
+                                              [](const auto& info) { return info.output == "-"; });
+    const auto num_concurrent_files =
+            output_to_stdout ? std::size_t{1}
+                             : std::min(static_cast<std::size_t>(concurrent_files),
+                                        all_files.size());
+    if (num_concurrent_files > 1) {
+        spdlog::info("> aligning {} files at a time", num_concurrent_files);
+        if (!align_files_concurrently(all_files, num_concurrent_files, setup, writer_threads,
+                                      progress_stats)) {
             return EXIT_FAILURE;
         }
-
-        // At present, header output file header writing relies on direct node method calls
-        // rather than the pipeline framework.
-        const auto& aligner_ref = dynamic_cast<AlignerNode&>(pipeline->get_node_ref(aligner));
-        utils::add_sq_hdr(header.get(), aligner_ref.get_sequence_records_for_header());
-        auto& hts_writer_ref = dynamic_cast<HtsWriter&>(pipeline->get_node_ref(hts_writer));
-        hts_file.set_header(header.get());
-
-        // All progress reporting is in the post-processing part.
-        ProgressTracker tracker(0, false, 1.f);
-        if (progress_stats_frequency > 0) {
-            tracker.disable_progress_reporting();
-        }
-        tracker.set_description("Aligning");
-
-        // Set up stats counting
-        std::vector<dorado::stats::StatsCallable> stats_callables;
-        stats_callables.push_back(
-                [&tracker](const stats::NamedStats& stats) { tracker.update_progress_bar(stats); });
-        stats_callables.push_back([&progress_stats](const stats::NamedStats& stats) {
-            progress_stats.update_stats(stats);
-        });
-        constexpr auto kStatsPeriod = 100ms;
-        auto stats_sampler = std::make_unique<dorado::stats::StatsSampler>(
-                kStatsPeriod, stats_reporters, stats_callables, static_cast<size_t>(0));
-
-        spdlog::info("> starting alignment");
-        auto num_reads_in_file = reader->read(*pipeline, max_reads);
-
-        // Wait for the pipeline to complete.  When it does, we collect
-        // final stats to allow accurate summarisation.
-        auto final_stats = pipeline->terminate(DefaultFlushOptions());
-
-        // Stop the stats sampler thread before tearing down any pipeline objects.
-        stats_sampler->terminate();
-        tracker.update_progress_bar(final_stats);
-        progress_stats.update_reads_per_file_estimate(num_reads_in_file);
-        progress_stats.notify_stats_collector_completed(final_stats);
-
-        spdlog::info("> finished alignment");
-
-        // Report progress during output file finalisation.
-        if (!hts_file.finalise_is_noop()) {
-            spdlog::info("> merging temporary BAM files");
+    } else {
+        for (const auto& file_info : all_files) {
+            // All progress reporting is in the post-processing part.
+            ProgressTracker tracker(0, false, 1.f);
+            if (progress_stats_frequency > 0) {
+                tracker.disable_progress_reporting();
+            }
+            tracker.set_description("Aligning");
+
+            // Set up stats counting
+            std::vector<dorado::stats::StatsCallable> stats_callables;
+            stats_callables.push_back([&tracker](const stats::NamedStats& stats) {
+                tracker.update_progress_bar(stats);
+            });
+            stats_callables.push_back([&progress_stats](const stats::NamedStats& stats) {
+                progress_stats.update_stats(stats);
+            });
+
+            AlignedFile aligned;
+            try {
+                aligned = align_file(file_info, setup, writer_threads, BAM_BUFFER_SIZE,
+                                     stats_callables);
+            } catch (const std::exception& e) {
+                spdlog::error("Alignment failed: {}", e.what());
+                return EXIT_FAILURE;
+            }
+            tracker.update_progress_bar(aligned.final_stats);
+            progress_stats.update_reads_per_file_estimate(aligned.num_reads);
+            progress_stats.notify_stats_collector_completed(aligned.final_stats);
+
+            spdlog::info("> finished alignment");
+
+            // Report progress during output file finalisation.
+            if (!aligned.hts_file->finalise_is_noop()) {
+                spdlog::info("> merging temporary BAM files");
+            }
+            tracker.set_description("Merging temporary BAM files");
+            aligned.hts_file->finalise([&](size_t progress) {
+                tracker.update_post_processing_progress(static_cast<float>(progress));
+                progress_stats.update_post_processing_progress(static_cast<float>(progress));
+            });
+
+            progress_stats.notify_post_processing_completed();
+            tracker.summarize();
+
+            spdlog::info("> total/primary/unmapped {}/{}/{}", aligned.total, aligned.primary,
+                         aligned.unmapped);
         }
-        tracker.set_description("Merging temporary BAM files");
-        hts_file.finalise([&](size_t progress) {
-            tracker.update_post_processing_progress(static_cast<float>(progress));
-            progress_stats.update_post_processing_progress(static_cast<float>(progress));
-        });
-
-        progress_stats.notify_post_processing_completed();
-        tracker.summarize();
-
-        spdlog::info("> total/primary/unmapped {}/{}/{}", hts_writer_ref.get_total(),
-                     hts_writer_ref.get_primary(), hts_writer_ref.get_unmapped());
     }
 
     progress_stats.report_final_stats();
 
     if (emit_summary) {
-        spdlog::info("> generating summary file");
-        SummaryData summary(SummaryData::ALIGNMENT_FIELDS);
-        auto summary_file = std::filesystem::path(output_folder) / "alignment_summary.txt";
-        std::ofstream summary_out(summary_file.string());
-        summary.process_tree(output_folder, summary_out);
+        summary_out.close();
         spdlog::info("> summary file complete.");
     }
 
@@ -37,6 +37,7 @@
 #include "utils/dev_utils.h"
 #include "utils/fs_utils.h"
 #include "utils/modbase_parameters.h"
+#include "utils/read_id_set.h"
 #include "utils/string_utils.h"
 
 #include <argparse.hpp>
@@ -482,7 +483,8 @@ void setup(const std::vector<std::string>& args,
             std::unordered_set<std::string>{}, thread_allocations.read_filter_threads);
 
     if ((barcoding_info && barcoding_info->trim) || adapter_trimming_enabled) {
-        current_sink_node = pipeline_desc.add_node<TrimmerNode>({current_sink_node}, 1);
+        current_sink_node = pipeline_desc.add_node<TrimmerNode>(
+                {current_sink_node}, std::max(thread_allocations.trimmer_threads, 1));
     }
 
     const bool is_rna_adapter =
@@ -537,7 +539,7 @@ void setup(const std::vector<std::string>& args,
     }
     hts_file->set_header(hdr.get());
 
-    std::unordered_set<std::string> reads_already_processed;
+    utils::ReadIdSet reads_already_processed;
     if (!resume_from_file.empty()) {
         spdlog::info("> Inspecting resume file...");
         // Turn off warning logging as header info is fetched.
@@ -599,8 +601,9 @@ void setup(const std::vector<std::string>& args,
     auto stats_sampler = std::make_unique<dorado::stats::StatsSampler>(
             kStatsPeriod, stats_reporters, stats_callables, max_stats_records);
 
-    DataLoader loader(*pipeline, "cpu", thread_allocations.loader_threads, max_reads, read_list,
-                      reads_already_processed);
+    DataLoader loader(*pipeline, "cpu", thread_allocations.loader_threads, max_reads,
+                      std::optional<utils::ReadIdSet>(read_list),
+                      std::move(reads_already_processed));
 
     auto func = [client_info](ReadCommon& read) { read.client_info = client_info; };
     loader.add_read_initialiser(func);
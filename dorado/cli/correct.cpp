@@ -1,6 +1,7 @@
 #include "cli/cli_utils.h"
 #include "correct/CorrectionProgressTracker.h"
 #include "dorado_version.h"
+#include "hts_io/ReadNameTable.h"
 #include "model_downloader/model_downloader.h"
 #include "read_pipeline/CorrectionInferenceNode.h"
 #include "read_pipeline/CorrectionMapperNode.h"
@@ -388,7 +389,8 @@ int correct(int argc, char* argv[]) {
         if (opt.compute_num_blocks) {
             spdlog::debug("Only computing the number of index blocks.");
 
-            CorrectionMapperNode node(in_reads_fn, aligner_threads, opt.index_size, {}, {}, -1);
+            CorrectionMapperNode node(in_reads_fn, nullptr, aligner_threads, opt.index_size, {}, {},
+                                      -1);
 
             // Loop through all index blocks.
             while (node.load_next_index_block()) {
@@ -427,6 +429,9 @@ int correct(int argc, char* argv[]) {
         //      tensors, run inference and decode the windows into a final corrected sequence.
         //  3. Corrected reads will be written out FASTA or BAM format.
 
+        // Dense IDs of the input reads, which the overlaps refer to their query reads by.
+        const auto read_names = std::make_shared<const hts_io::ReadNameTable>(in_reads_fn);
+
         std::unique_ptr<utils::HtsFile, HtsFileDeleter> hts_file;
         PipelineDescriptor pipeline_desc;
 
@@ -460,11 +465,12 @@ int correct(int argc, char* argv[]) {
         // is not part of the pipeline, so the stats are not automatically gathered.
         std::unique_ptr<MessageSink> aligner;
         if (!std::empty(opt.in_paf_fn)) {
-            aligner = std::make_unique<CorrectionPafReaderNode>(opt.in_paf_fn, std::move(skip_set));
+            aligner = std::make_unique<CorrectionPafReaderNode>(opt.in_paf_fn, read_names,
+                                                                std::move(skip_set));
         } else {
             // 1. Alignment node that generates alignments per read to be corrected.
             aligner = std::make_unique<CorrectionMapperNode>(
-                    in_reads_fn, aligner_threads, opt.index_size, furthest_skip_header,
+                    in_reads_fn, read_names, aligner_threads, opt.index_size, furthest_skip_header,
                     std::move(skip_set), (opt.run_block_id) ? *opt.run_block_id : -1);
         }
 
@@ -25,12 +25,15 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <thread>
+#include <tuple>
 #include <vector>
 using namespace std::chrono_literals;
 
@@ -226,6 +229,7 @@ int demuxer(int argc, char* argv[]) {
     auto read_list = utils::load_read_list(parser.visible.get<std::string>("--read-ids"));
 
     HtsReader reader(all_files[0].input, read_list);
+    reader.set_decode_threads(demux_writer_threads);
     utils::MergeHeaders hdr_merger(strip_alignment);
     hdr_merger.add_header(reader.header(), all_files[0].input);
 
@@ -255,10 +259,17 @@ int demuxer(int argc, char* argv[]) {
 
     auto barcoding_info = get_barcoding_info(parser, sample_sheet.get());
 
+    // Split the barcodes between several writers once there are enough writer threads, so that
+    // they aren't all compressed and sorted through a single thread.
+    constexpr int WRITER_THREADS_PER_SHARD = 4;
+    const auto num_writer_shards =
+            static_cast<size_t>(std::max(1, demux_writer_threads / WRITER_THREADS_PER_SHARD));
+    spdlog::debug("> writer shards {}", num_writer_shards);
+
     PipelineDescriptor pipeline_desc;
     auto demux_writer = pipeline_desc.add_node<BarcodeDemuxerNode>(
             {}, output_dir, demux_writer_threads, parser.visible.get<bool>("--emit-fastq"),
-            std::move(sample_sheet), sort_bam);
+            std::move(sample_sheet), sort_bam, num_writer_shards);
 
     if (barcoding_info) {
         std::optional<std::string> custom_seqs =
@@ -307,7 +318,8 @@ int demuxer(int argc, char* argv[]) {
         client_info->contexts().register_context<const demux::BarcodingInfo>(barcoding_info);
         auto current_node = demux_writer;
         if (!no_trim) {
-            current_node = pipeline_desc.add_node<TrimmerNode>({demux_writer}, 1);
+            current_node =
+                    pipeline_desc.add_node<TrimmerNode>({demux_writer}, demux_writer_threads);
         }
         pipeline_desc.add_node<BarcodeClassifierNode>({current_node}, demux_threads);
     }
@@ -326,6 +338,14 @@ int demuxer(int argc, char* argv[]) {
             dynamic_cast<BarcodeDemuxerNode&>(pipeline->get_node_ref(demux_writer));
     demux_writer_ref.set_header(header.get());
 
+    // Input files are read one after another, so report the stats of whichever reader is active.
+    std::mutex active_reader_mutex;
+    const HtsReader* active_reader = &reader;
+    stats_reporters.push_back([&active_reader_mutex, &active_reader] {
+        std::lock_guard lock(active_reader_mutex);
+        return std::make_tuple(active_reader->get_name(), active_reader->sample_stats());
+    });
+
     // All progress reporting is in the post-processing part.
     ProgressTracker tracker(0, false, 1.f);
     if (progress_stats_frequency > 0) {
@@ -368,12 +388,21 @@ int demuxer(int argc, char* argv[]) {
     for (size_t input_idx = 1; input_idx < all_files.size(); input_idx++) {
         HtsReader input_reader(all_files[input_idx].input, read_list);
         input_reader.set_client_info(client_info);
+        input_reader.set_decode_threads(demux_writer_threads);
         if (!strip_alignment) {
             input_reader.set_record_mutator([&sq_mapping, input_idx](BamPtr& record) {
                 adjust_tid(sq_mapping[input_idx], record);
             });
         }
+        {
+            std::lock_guard lock(active_reader_mutex);
+            active_reader = &input_reader;
+        }
         num_reads_in_file = input_reader.read(*pipeline, max_reads);
+        {
+            std::lock_guard lock(active_reader_mutex);
+            active_reader = &reader;
+        }
         spdlog::trace("pushed to pipeline: {}", num_reads_in_file);
         progress_stats.update_reads_per_file_estimate(num_reads_in_file);
     }
@@ -324,6 +324,11 @@ int duplex(int argc, char* argv[]) {
                 .default_value(std::string(""))
                 .help("Space-delimited csv containing read ID pairs. If not provided, pairing will "
                       "be performed automatically.");
+        parser.visible.add_argument("--cache-channel-index")
+                .help("Save the channel index of each POD5 file next to it, and reuse it in later "
+                      "runs over the same data.")
+                .default_value(false)
+                .implicit_value(true);
     }
     {
         parser.visible.add_group("Output arguments");
@@ -461,6 +466,7 @@ int duplex(int argc, char* argv[]) {
         const size_t max_stats_records = static_cast<size_t>(dump_stats_file.empty() ? 0 : 100000);
 
         const bool recursive_file_loading = parser.visible.get<bool>("--recursive");
+        const bool cache_channel_index = parser.visible.get<bool>("--cache-channel-index");
         auto input_files = DataLoader::InputFiles::search(reads, recursive_file_loading);
         if (!input_files.has_value()) {
             // search() will have logged an error message for us.
@@ -755,8 +761,11 @@ int duplex(int argc, char* argv[]) {
             }
             hts_file->set_header(hdr.get());
 
-            DataLoader loader(*pipeline, "cpu", num_devices, 0, std::move(read_list), {});
+            DataLoader loader(*pipeline, "cpu", num_devices, 0,
+                              std::optional<utils::ReadIdSet>(read_list), {});
             loader.add_read_initialiser(client_info_init_func);
+            // Input directories may be read-only or shared, so only write sidecars when asked to.
+            loader.set_use_channel_index_sidecars(cache_channel_index);
 
             stats_sampler = std::make_unique<dorado::stats::StatsSampler>(
                     kStatsPeriod, stats_reporters, stats_callables, max_stats_records);
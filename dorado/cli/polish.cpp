@@ -4,6 +4,7 @@
 #include "model_downloader/model_downloader.h"
 #include "models/models.h"
 #include "polish/architectures/model_config.h"
+#include "polish/draft_results_collector.h"
 #include "polish/interval.h"
 #include "polish/polish_impl.h"
 #include "polish/polish_progress_tracker.h"
@@ -12,6 +13,7 @@
 #include "torch_utils/auto_detect_device.h"
 #include "torch_utils/gpu_profiling.h"
 #include "utils/AsyncQueue.h"
+#include "utils/PostCondition.h"
 #include "utils/arg_parse_ext.h"
 #include "utils/fai_utils.h"
 #include "utils/fs_utils.h"
@@ -25,12 +27,15 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
 #include <memory>
 #include <numeric>
 #include <optional>
@@ -1006,122 +1011,187 @@ void run_polishing(const Options& opt,
     }
 
     // Prepare regions for processing.
-    const auto [input_regions, region_batches] =
+    // Not a structured binding, because the producer lambda below captures these.
+    const auto regions_and_batches =
             prepare_region_batches(draft_lens, opt.regions, opt.draft_batch_size);
+    const std::vector<std::vector<polisher::Region>>& input_regions = regions_and_batches.first;
+    const std::vector<polisher::Interval>& region_batches = regions_and_batches.second;
 
     // Update the progress tracker.
-    {
-        int64_t total_input_bases =
-                std::accumulate(std::begin(input_regions), std::end(input_regions),
-                                static_cast<int64_t>(0), [](const int64_t a, const auto& b) {
-                                    int64_t sum = 0;
-                                    for (const auto& region : b) {
-                                        sum += region.end - region.start;
-                                    }
-                                    return a + sum;
-                                });
-
-        // Variant calling likely takes much less time than consensus,
-        // but we need an estimate.
-        if (opt.run_variant_calling) {
-            total_input_bases *= 2;
-        }
-
-        polish_stats.set("total", static_cast<double>(total_input_bases));
-        polish_stats.set("processed", 0.0);
+    int64_t total_input_bases =
+            std::accumulate(std::begin(input_regions), std::end(input_regions),
+                            static_cast<int64_t>(0), [](const int64_t a, const auto& b) {
+                                int64_t sum = 0;
+                                for (const auto& region : b) {
+                                    sum += region.end - region.start;
+                                }
+                                return a + sum;
+                            });
+
+    // Variant calling likely takes much less time than consensus,
+    // but we need an estimate.
+    if (opt.run_variant_calling) {
+        total_input_bases *= 2;
     }
 
-    int64_t total_batch_bases = 0;
+    polish_stats.set("total", static_cast<double>(total_input_bases));
+    polish_stats.set("processed", 0.0);
 
-    // Process the draft sequences in batches of user-specified size.
-    for (const auto& batch_interval : region_batches) {
-        // Get the regions for this interval.
-        std::vector<polisher::Region> region_batch;
-        for (int32_t i = batch_interval.start; i < batch_interval.end; ++i) {
-            region_batch.insert(std::end(region_batch), std::begin(input_regions[i]),
-                                std::end(input_regions[i]));
-        }
-
-        // Total number of bases in this batch.
-        const int64_t batch_bases = std::accumulate(
-                std::begin(region_batch), std::end(region_batch), static_cast<int64_t>(0),
-                [](const int64_t a, const auto& b) { return a + b.end - b.start; });
-
-        // Debug print.
-        spdlog::debug("[run_polishing] =============================");
-        spdlog::debug("[run_polishing] Processing batch interval of drafts: [{}, {})",
-                      batch_interval.start, batch_interval.end);
-        for (int64_t i = 0; i < dorado::ssize(region_batch); ++i) {
-            spdlog::debug("[run_polishing] region_batch i = {}: {}", i,
-                          polisher::region_to_string(region_batch[i]));
-        }
+    // Results of the drafts which are in flight. Stitching and variant calling of a draft start as
+    // soon as all of its samples have been decoded, while the following drafts are still inferred.
+    polisher::DraftResultsCollector collector(static_cast<int32_t>(std::size(draft_lens)));
 
-        // Split the sequences into larger BAM windows, like Medaka.
-        // NOTE: the window.seq_id is the _absolute_ sequence ID of the input draft sequences.
-        spdlog::debug("Creating BAM windows.");
-        const std::vector<polisher::Window> bam_regions = polisher::create_windows_from_regions(
-                region_batch, draft_lookup, opt.bam_chunk, opt.window_overlap);
+    // Each item is one batch for inference.
+    utils::AsyncQueue<polisher::InferenceData> batch_queue(opt.queue_size);
+    utils::AsyncQueue<polisher::DecodeData> decode_queue(opt.queue_size);
 
-        spdlog::debug(
-                "[run_polishing] Starting to produce consensus for regions: {}-{}/{} "
-                "(number: {}, total "
-                "length: {:.2f} Mbp)",
-                batch_interval.start, batch_interval.end, std::size(input_regions),
-                std::size(region_batch), batch_bases / (1000.0 * 1000.0));
+    // Unblocks every stage, so that all the threads exit early once one of them has failed.
+    std::atomic<bool> stopped{false};
+    const auto stop_pipeline = [&]() {
+        stopped = true;
+        batch_queue.terminate();
+        decode_queue.terminate();
+        collector.terminate();
+    };
 
-        // Update the tracker title.
-        {
-            std::ostringstream oss;
-            oss << batch_interval.start << "-" << batch_interval.end << "/"
-                << std::size(input_regions) << ", bases: " << batch_bases;
-            tracker.set_description("Polishing draft sequences: " + oss.str());
+    // Runs one stage on its own thread, keeping its exception to be rethrown once all the
+    // threads have been joined.
+    const auto run_stage = [&stop_pipeline](std::exception_ptr& error, const auto& stage) {
+        try {
+            stage();
+        } catch (...) {
+            error = std::current_exception();
+            stop_pipeline();
         }
+    };
 
-        // Each item is one batch for inference.
-        utils::AsyncQueue<polisher::InferenceData> batch_queue(opt.queue_size);
-        utils::AsyncQueue<polisher::DecodeData> decode_queue(opt.queue_size);
-        std::vector<polisher::ConsensusResult> all_results_cons;
-        std::vector<polisher::VariantCallingSample> vc_input_data;
+    // Produces the samples of all draft batches, one after the other, into the same queue.
+    const auto produce_samples = [&]() {
+        for (const auto& batch_interval : region_batches) {
+            if (stopped) {
+                break;
+            }
+            // Get the regions for this interval.
+            std::vector<polisher::Region> region_batch;
+            for (int32_t i = batch_interval.start; i < batch_interval.end; ++i) {
+                region_batch.insert(std::end(region_batch), std::begin(input_regions[i]),
+                                    std::end(input_regions[i]));
+            }
 
-        std::thread thread_sample_producer =
-                std::thread(&polisher::sample_producer, std::ref(resources), std::cref(bam_regions),
-                            std::cref(draft_lens), opt.threads, opt.batch_size, opt.window_len,
-                            opt.window_overlap, opt.bam_subchunk, std::ref(batch_queue));
+            // Total number of bases in this batch.
+            const int64_t batch_bases = std::accumulate(
+                    std::begin(region_batch), std::end(region_batch), static_cast<int64_t>(0),
+                    [](const int64_t a, const auto& b) { return a + b.end - b.start; });
+
+            // Debug print.
+            spdlog::debug("[run_polishing] =============================");
+            spdlog::debug("[run_polishing] Processing batch interval of drafts: [{}, {})",
+                          batch_interval.start, batch_interval.end);
+            for (int64_t i = 0; i < dorado::ssize(region_batch); ++i) {
+                spdlog::debug("[run_polishing] region_batch i = {}: {}", i,
+                              polisher::region_to_string(region_batch[i]));
+            }
 
-        std::thread thread_sample_decoder = std::thread(
-                &polisher::decode_samples_in_parallel, std::ref(all_results_cons),
-                std::ref(vc_input_data), std::ref(decode_queue), std::ref(polish_stats),
-                std::cref(*resources.decoder), opt.threads, opt.min_depth, opt.run_variant_calling);
+            // Split the sequences into larger BAM windows, like Medaka.
+            // NOTE: the window.seq_id is the _absolute_ sequence ID of the input draft sequences.
+            spdlog::debug("Creating BAM windows.");
+            const std::vector<polisher::Window> bam_regions =
+                    polisher::create_windows_from_regions(region_batch, draft_lookup,
+                                                          opt.bam_chunk, opt.window_overlap);
+
+            spdlog::debug(
+                    "[run_polishing] Starting to produce consensus for regions: {}-{}/{} "
+                    "(number: {}, total "
+                    "length: {:.2f} Mbp)",
+                    batch_interval.start, batch_interval.end, std::size(input_regions),
+                    std::size(region_batch), batch_bases / (1000.0 * 1000.0));
+
+            // Update the tracker title.
+            {
+                std::ostringstream oss;
+                oss << batch_interval.start << "-" << batch_interval.end << "/"
+                    << std::size(input_regions) << ", bases: " << batch_bases;
+                tracker.set_description("Polishing draft sequences: " + oss.str());
+            }
 
-        polisher::infer_samples_in_parallel(batch_queue, decode_queue, resources.models,
-                                            *resources.encoder);
+            polisher::sample_producer(resources, bam_regions, draft_lens, opt.threads,
+                                      opt.batch_size, opt.window_len, opt.window_overlap,
+                                      opt.bam_subchunk, batch_queue, collector);
 
-        if (thread_sample_producer.joinable()) {
-            thread_sample_producer.join();
+            // Drafts without any BAM regions are complete too.
+            for (int32_t seq_id = batch_interval.start; seq_id < batch_interval.end; ++seq_id) {
+                collector.seal(seq_id);
+            }
         }
+        batch_queue.terminate();
+    };
 
-        if (thread_sample_decoder.joinable()) {
-            thread_sample_decoder.join();
+    std::exception_ptr producer_error;
+    std::exception_ptr inference_error;
+    std::exception_ptr decoder_error;
+    std::thread thread_sample_producer;
+    std::thread thread_sample_inference;
+    std::thread thread_sample_decoder;
+    const auto join_threads = [&]() {
+        for (auto* thread :
+             {&thread_sample_producer, &thread_sample_inference, &thread_sample_decoder}) {
+            if (thread->joinable()) {
+                thread->join();
+            }
         }
+    };
+    // If anything below throws, the threads are stopped and joined before unwinding further.
+    auto stop_threads = utils::PostCondition([&]() {
+        stop_pipeline();
+        join_threads();
+    });
+
+    thread_sample_producer = std::thread([&]() { run_stage(producer_error, produce_samples); });
+
+    thread_sample_decoder = std::thread([&]() {
+        run_stage(decoder_error, [&]() {
+            polisher::decode_samples_in_parallel(collector, decode_queue, polish_stats,
+                                                 *resources.decoder, opt.threads, opt.min_depth,
+                                                 opt.run_variant_calling);
+        });
+        // Nothing more will be completed, so unblock the consumer if a draft is incomplete.
+        collector.terminate();
+    });
+
+    thread_sample_inference = std::thread([&]() {
+        run_stage(inference_error, [&]() {
+            polisher::infer_samples_in_parallel(batch_queue, decode_queue, resources.models,
+                                                *resources.encoder);
+        });
+    });
 
-        // Round the counter, in case some samples were dropped.
-        total_batch_bases += batch_bases;
-        polish_stats.set("processed", static_cast<double>(total_batch_bases));
+    // Stitch and call variants for the drafts as they are completed, in the order of their IDs.
+    std::vector<polisher::DraftResults> ready;
+    while (collector.pop_ready(ready)) {
+        const polisher::Interval ready_interval{ready.front().seq_id, ready.back().seq_id + 1};
 
-        spdlog::debug(
-                "[run_polishing] Stitching sequences: {}-{}/{} (number: {}, total "
-                "length: {:.2f} Mbp), parts: {}",
-                batch_interval.start, batch_interval.end, std::size(input_regions),
-                std::size(region_batch), batch_bases / (1000.0 * 1000.0),
-                std::size(all_results_cons));
+        std::vector<polisher::ConsensusResult> all_results_cons;
+        std::vector<polisher::VariantCallingSample> vc_input_data;
+        for (auto& draft : ready) {
+            all_results_cons.insert(std::end(all_results_cons),
+                                    std::make_move_iterator(std::begin(draft.results_cons)),
+                                    std::make_move_iterator(std::end(draft.results_cons)));
+            vc_input_data.insert(std::end(vc_input_data),
+                                 std::make_move_iterator(std::begin(draft.results_vc_data)),
+                                 std::make_move_iterator(std::end(draft.results_vc_data)));
+        }
+        ready.clear();
 
-        spdlog::debug("Data for variant calling: num elements = {}, num consensus results = {}",
-                      std::size(vc_input_data), std::size(all_results_cons));
+        spdlog::debug(
+                "[run_polishing] Stitching sequences: {}-{}/{}, parts: {}, data for variant "
+                "calling: {}, drafts in flight: {}",
+                ready_interval.start, ready_interval.end, std::size(draft_lens),
+                std::size(all_results_cons), std::size(vc_input_data), collector.num_in_flight());
 
         // Construct the consensus sequences, only if they will be written.
         if (opt.write_consensus) {
             const std::vector<std::vector<polisher::ConsensusResult>> consensus_seqs =
-                    construct_consensus_seqs(batch_interval, all_results_cons, draft_lens,
+                    construct_consensus_seqs(ready_interval, all_results_cons, draft_lens,
                                              opt.fill_gaps, opt.fill_char, *draft_readers.front());
 
             // Write the consensus file.
@@ -1134,7 +1204,7 @@ void run_polishing(const Options& opt,
         // Run variant calling, optionally.
         if (opt.run_variant_calling) {
             std::vector<polisher::Variant> variants = call_variants(
-                    batch_interval, vc_input_data, draft_readers, draft_lens, *resources.decoder,
+                    ready_interval, vc_input_data, draft_readers, draft_lens, *resources.decoder,
                     opt.ambig_ref, opt.vc_type == VariantCallingEnum::GVCF, opt.threads,
                     polish_stats);
 
@@ -1146,13 +1216,18 @@ void run_polishing(const Options& opt,
             for (const auto& variant : variants) {
                 vcf_writer->write_variant(variant);
             }
+        }
+    }
 
-            // We approximate the progress by expecting 2x bases to be processed
-            // when doing variant calling.
-            total_batch_bases += batch_bases;
-            polish_stats.set("processed", static_cast<double>(total_batch_bases));
+    join_threads();
+    for (const auto& error : {producer_error, inference_error, decoder_error}) {
+        if (error) {
+            std::rethrow_exception(error);
         }
     }
+
+    // Round the counter, in case some samples were dropped.
+    polish_stats.set("processed", static_cast<double>(total_input_bases));
 }
 
 int polish(int argc, char* argv[]) {
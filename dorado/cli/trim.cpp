@@ -121,6 +121,7 @@ int trim(int argc, char* argv[]) {
     }
 
     HtsReader reader(reads[0], read_list);
+    reader.set_decode_threads(trim_writer_threads);
     auto header = SamHdrPtr(sam_hdr_dup(reader.header()));
     cli::add_pg_hdr(header.get(), "trim", args, "cpu");
     // Always remove alignment information from input header
@@ -152,7 +153,7 @@ int trim(int argc, char* argv[]) {
     PipelineDescriptor pipeline_desc;
     auto hts_writer = pipeline_desc.add_node<HtsWriter>({}, hts_file, "");
 
-    auto trimmer = pipeline_desc.add_node<TrimmerNode>({hts_writer}, 1);
+    auto trimmer = pipeline_desc.add_node<TrimmerNode>({hts_writer}, trim_writer_threads);
 
     auto adapter_info = std::make_shared<demux::AdapterInfo>();
     adapter_info->trim_adapters = true;
@@ -173,6 +174,7 @@ int trim(int argc, char* argv[]) {
         spdlog::error("Failed to create pipeline");
         return EXIT_FAILURE;
     }
+    stats_reporters.push_back(stats::make_stats_reporter(reader));
 
     // Set up stats counting
     ProgressTracker tracker(0, false, hts_file.finalise_is_noop() ? 0.f : 0.5f);
@@ -74,10 +74,12 @@ std::string decode_window(const WindowFeatures& wf) {
     }
     auto& bases = wf.bases;
     int tpos = -1, ins = 0;
-    int length = (int)bases.sizes()[1];
-    int* bases_tensor = bases.data_ptr<int>();
+    int length = (int)bases.sizes()[0];
+    int reads = (int)bases.sizes()[1];
+    const int* bases_tensor = bases.data_ptr<int>();
     for (int c = 0; c < length; c++) {
-        const auto tbase = bases_tensor[c];
+        const int* column = &bases_tensor[int64_t(c) * reads];
+        const auto tbase = column[0];
         if (base_decoding[tbase] == '*') {
             ins += 1;
         } else {
@@ -96,7 +98,7 @@ std::string decode_window(const WindowFeatures& wf) {
         } else {
             std::array<base_count_t, 5> counter;
             for (int r = 0; r < wf.n_alns + 1; r++) {
-                auto base = bases_tensor[r * length + c];
+                auto base = column[r];
                 if (base_decoding[base] == '.') {
                     continue;
                 }
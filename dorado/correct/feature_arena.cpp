@@ -0,0 +1,288 @@
+#include "feature_arena.h"
+
+#include <ATen/Functions.h>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Number of idle slabs kept for reuse before they start being freed.
+constexpr size_t MAX_IDLE_SLABS = 4;
+
+}  // namespace
+
+namespace dorado::correction {
+
+struct FeatureArena::Slab {
+    int id = -1;
+    int padded_length = 0;
+    int capacity = 0;
+    at::Tensor bases;
+    at::Tensor quals;
+
+    // Slots [next_slot, capacity) have never been acquired since the slab was last reset.
+    int next_slot = 0;
+    std::vector<int> free_slots;
+    std::vector<int> committed_slots;
+    std::vector<WindowFeatures> windows;
+    int num_in_flight = 0;
+    bool filling = false;
+
+    void reset() {
+        next_slot = 0;
+        free_slots.clear();
+        committed_slots.clear();
+        windows.clear();
+        num_in_flight = 0;
+        filling = true;
+    }
+
+    bool full() const { return free_slots.empty() && (next_slot == capacity); }
+};
+
+FeatureArena::FeatureArena(int batch_size, bool pin_memory, BatchCallback on_batch_ready)
+        : m_batch_size(batch_size),
+          m_pin_memory(pin_memory),
+          m_on_batch_ready(std::move(on_batch_ready)) {
+    if (m_batch_size <= 0) {
+        throw std::runtime_error("FeatureArena batch size must be positive, got " +
+                                 std::to_string(m_batch_size));
+    }
+}
+
+FeatureArena::~FeatureArena() = default;
+
+bool FeatureArena::is_idle(const Slab& slab) const {
+    // The slab itself holds one reference to each storage, and every view given out holds another.
+    return !slab.filling && (slab.num_in_flight == 0) && slab.windows.empty() &&
+           (slab.bases.storage().use_count() == 1) && (slab.quals.storage().use_count() == 1);
+}
+
+FeatureArena::Slab& FeatureArena::get_filling_slab(int padded_length) {
+    const auto filling_it = m_filling_slabs.find(padded_length);
+    if (filling_it != m_filling_slabs.end()) {
+        return *m_slabs.at(filling_it->second);
+    }
+
+    // Reuse an idle slab of the same length if there is one, and free idle slabs of other lengths
+    // beyond the limit.
+    Slab* reused = nullptr;
+    size_t num_idle = 0;
+    for (auto it = m_slabs.begin(); it != m_slabs.end();) {
+        Slab& slab = *it->second;
+        if (!is_idle(slab)) {
+            ++it;
+        } else if (!reused && (slab.padded_length == padded_length)) {
+            reused = &slab;
+            ++it;
+        } else if (num_idle >= MAX_IDLE_SLABS) {
+            it = m_slabs.erase(it);
+        } else {
+            ++num_idle;
+            ++it;
+        }
+    }
+
+    if (!reused) {
+        auto slab = std::make_unique<Slab>();
+        slab->id = m_next_slab_id++;
+        slab->padded_length = padded_length;
+        slab->capacity =
+                std::max(1, m_batch_size / ((padded_length - 1) / MAX_COLUMNS_PER_BATCH_SLOT + 1));
+        const auto options = at::TensorOptions().device(at::kCPU).pinned_memory(m_pin_memory);
+        slab->bases = at::empty({slab->capacity, padded_length, NUM_FEATURE_ROWS},
+                                options.dtype(at::kInt));
+        slab->quals = at::empty({slab->capacity, padded_length, NUM_FEATURE_ROWS},
+                                options.dtype(at::kFloat));
+        reused = slab.get();
+        m_slabs.emplace(slab->id, std::move(slab));
+    }
+
+    reused->reset();
+    m_filling_slabs[padded_length] = reused->id;
+    return *reused;
+}
+
+void FeatureArena::acquire(WindowFeatures& wf, int length) {
+    if (wf.arena_slab >= 0) {
+        throw std::runtime_error("Window " + std::to_string(wf.window_idx) + " of " +
+                                 wf.read_name + " already has a feature arena slot.");
+    }
+    const int columns = std::max(length, 1);
+    const int padded_length =
+            (columns + COLUMN_GRANULARITY - 1) / COLUMN_GRANULARITY * COLUMN_GRANULARITY;
+
+    at::Tensor slab_bases;
+    at::Tensor slab_quals;
+    int slot = -1;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Slab& slab = get_filling_slab(padded_length);
+        if (!slab.free_slots.empty()) {
+            slot = slab.free_slots.back();
+            slab.free_slots.pop_back();
+        } else {
+            slot = slab.next_slot++;
+        }
+        ++slab.num_in_flight;
+        if (slab.full()) {
+            // Completed once the windows being written are committed or released.
+            slab.filling = false;
+            m_filling_slabs.erase(padded_length);
+        }
+        wf.arena_slab = slab.id;
+        wf.arena_slot = slot;
+        slab_bases = slab.bases;
+        slab_quals = slab.quals;
+    }
+
+    // The slot is ours until it's committed or released, so it can be written without the lock.
+    at::Tensor slot_bases = slab_bases.select(0, slot);
+    at::Tensor slot_quals = slab_quals.select(0, slot);
+    int* bases_ptr = slot_bases.data_ptr<int>();
+    float* quals_ptr = slot_quals.data_ptr<float>();
+    std::fill(bases_ptr + int64_t(length) * NUM_FEATURE_ROWS,
+              bases_ptr + int64_t(padded_length) * NUM_FEATURE_ROWS, FEATURE_BASES_PAD);
+    std::fill(quals_ptr + int64_t(length) * NUM_FEATURE_ROWS,
+              quals_ptr + int64_t(padded_length) * NUM_FEATURE_ROWS, FEATURE_QUALS_PAD);
+
+    wf.bases = slot_bases.narrow(0, 0, length);
+    wf.quals = slot_quals.narrow(0, 0, length);
+}
+
+bool FeatureArena::take_ready_batch(Slab& slab, FeatureBatch& batch) {
+    if (slab.filling || (slab.num_in_flight > 0) || slab.windows.empty()) {
+        return false;
+    }
+
+    // Order the windows by slot, so they match the rows of the batch.
+    const size_t num_windows = slab.windows.size();
+    std::vector<size_t> order(num_windows);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&slab](size_t a, size_t b) {
+        return slab.committed_slots[a] < slab.committed_slots[b];
+    });
+
+    batch.windows.clear();
+    batch.windows.reserve(num_windows);
+    std::vector<int64_t> slots;
+    slots.reserve(num_windows);
+    for (const size_t i : order) {
+        batch.windows.push_back(std::move(slab.windows[i]));
+        slots.push_back(slab.committed_slots[i]);
+    }
+    slab.windows.clear();
+    slab.committed_slots.clear();
+
+    // Slots are handed out in order, so the committed ones are only out of place if some were
+    // released once the slab had stopped filling. Those rare batches need a copy.
+    const bool contiguous = (slots.back() == int64_t(num_windows) - 1);
+    if (contiguous) {
+        batch.bases = slab.bases.narrow(0, 0, num_windows);
+        batch.quals = slab.quals.narrow(0, 0, num_windows);
+    } else {
+        const at::Tensor index = at::tensor(slots, at::TensorOptions().dtype(at::kLong));
+        batch.bases = slab.bases.index_select(0, index);
+        batch.quals = slab.quals.index_select(0, index);
+    }
+
+    ++m_num_batches;
+    m_num_batched_windows += num_windows;
+    m_num_batch_slots += slab.capacity;
+    return true;
+}
+
+void FeatureArena::commit(WindowFeatures&& wf) {
+    if (wf.arena_slab < 0) {
+        throw std::runtime_error("Window " + std::to_string(wf.window_idx) + " of " +
+                                 wf.read_name + " has no feature arena slot to commit.");
+    }
+    FeatureBatch batch;
+    bool ready = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Slab& slab = *m_slabs.at(wf.arena_slab);
+        --slab.num_in_flight;
+        slab.committed_slots.push_back(wf.arena_slot);
+        slab.windows.push_back(std::move(wf));
+        ready = take_ready_batch(slab, batch);
+    }
+    if (ready) {
+        m_on_batch_ready(std::move(batch));
+    }
+}
+
+void FeatureArena::release(WindowFeatures& wf) {
+    if (wf.arena_slab < 0) {
+        return;
+    }
+    wf.bases = at::Tensor();
+    wf.quals = at::Tensor();
+
+    FeatureBatch batch;
+    bool ready = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Slab& slab = *m_slabs.at(wf.arena_slab);
+        --slab.num_in_flight;
+        if (slab.filling) {
+            slab.free_slots.push_back(wf.arena_slot);
+        }
+        ready = take_ready_batch(slab, batch);
+    }
+    wf.arena_slab = -1;
+    wf.arena_slot = -1;
+    if (ready) {
+        m_on_batch_ready(std::move(batch));
+    }
+}
+
+std::vector<FeatureBatch> FeatureArena::flush() {
+    std::vector<FeatureBatch> batches;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [padded_length, slab_id] : m_filling_slabs) {
+        Slab& slab = *m_slabs.at(slab_id);
+        slab.filling = false;
+        FeatureBatch batch;
+        if (take_ready_batch(slab, batch)) {
+            batches.push_back(std::move(batch));
+        }
+    }
+    m_filling_slabs.clear();
+    return batches;
+}
+
+stats::NamedStats FeatureArena::sample_stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats::NamedStats stats;
+    size_t num_idle = 0;
+    size_t num_bytes = 0;
+    int64_t filling_used_slots = 0;
+    int64_t filling_capacity = 0;
+    for (const auto& [id, slab] : m_slabs) {
+        num_bytes += slab->bases.nbytes() + slab->quals.nbytes();
+        if (is_idle(*slab)) {
+            ++num_idle;
+        }
+        if (slab->filling) {
+            filling_used_slots += slab->next_slot - int64_t(slab->free_slots.size());
+            filling_capacity += slab->capacity;
+        }
+    }
+    stats["feature_arena_slabs"] = double(m_slabs.size());
+    stats["feature_arena_slabs_filling"] = double(m_filling_slabs.size());
+    stats["feature_arena_slabs_idle"] = double(num_idle);
+    stats["feature_arena_bytes"] = double(num_bytes);
+    stats["feature_arena_filling_occupancy"] =
+            filling_capacity > 0 ? double(filling_used_slots) / double(filling_capacity) : 0.0;
+    stats["feature_arena_batches"] = double(m_num_batches);
+    stats["feature_arena_batch_occupancy"] =
+            m_num_batch_slots > 0 ? double(m_num_batched_windows) / double(m_num_batch_slots)
+                                  : 0.0;
+    return stats;
+}
+
+}  // namespace dorado::correction
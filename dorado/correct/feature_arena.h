@@ -0,0 +1,99 @@
+#pragma once
+
+#include "types.h"
+#include "utils/stats.h"
+
+#include <ATen/Tensor.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace dorado::correction {
+
+// Values the columns beyond the end of a window are padded with in a batch.
+constexpr int FEATURE_BASES_PAD = 11;
+constexpr float FEATURE_QUALS_PAD = 0.f;
+
+// Windows with more columns than this take up more than one slot of an inference batch.
+constexpr int MAX_COLUMNS_PER_BATCH_SLOT = 5120;
+
+// A batch of windows ready for inference. The bases and quals have the shape
+// [windows.size(), padded length, NUM_FEATURE_ROWS], in the same order as the windows.
+struct FeatureBatch {
+    at::Tensor bases;
+    at::Tensor quals;
+    std::vector<WindowFeatures> windows;
+};
+
+/**
+ * @brief Pool of preallocated inference batches which window features are written into directly.
+ *
+ * Each slab of the arena holds a whole batch of windows with the same padded length, i.e. the
+ * number of columns rounded up to a multiple of COLUMN_GRANULARITY. Feature extraction acquires
+ * a slot for its window, and writes the features straight into the layout the model takes, so
+ * there are no per-window tensors and no copy to collate them into a batch.
+ *
+ * Every acquired slot is then either committed for inference or released. Once all the slots of
+ * a slab are used and none are still being written, the slab is passed to the batch callback.
+ * Slabs are reused once every tensor referring to them has been dropped, and are allocated in
+ * pinned memory if requested, so that they can be copied to the GPU quickly.
+ *
+ * Thread safe.
+ */
+class FeatureArena {
+public:
+    using BatchCallback = std::function<void(FeatureBatch&&)>;
+
+    static constexpr int COLUMN_GRANULARITY = 256;
+
+    // |batch_size| is the number of batch slots in each slab. The callback is called without any
+    // locks held, from the thread which completes the slab.
+    FeatureArena(int batch_size, bool pin_memory, BatchCallback on_batch_ready);
+    ~FeatureArena();
+
+    // Claims a slot for a window with |length| columns. The bases and quals of the window are set
+    // to [length, NUM_FEATURE_ROWS] views of the slot, with undefined contents.
+    void acquire(WindowFeatures& wf, int length);
+
+    // Hands over a window with an acquired slot for inference.
+    void commit(WindowFeatures&& wf);
+
+    // Returns the slot of a window which won't be inferred. The bases and quals of the window
+    // are reset, since the slot may be written by another window straight away.
+    // Does nothing if the window has no slot.
+    void release(WindowFeatures& wf);
+
+    // Stops filling the slabs which are partially used, so that they can be inferred without
+    // waiting for more windows. The batches which are ready are returned rather than passed to
+    // the callback, and the rest are passed to the callback once their windows are committed.
+    std::vector<FeatureBatch> flush();
+
+    stats::NamedStats sample_stats() const;
+
+private:
+    struct Slab;
+
+    Slab& get_filling_slab(int padded_length);
+    bool is_idle(const Slab& slab) const;
+    bool take_ready_batch(Slab& slab, FeatureBatch& batch);
+
+    const int m_batch_size;
+    const bool m_pin_memory;
+    const BatchCallback m_on_batch_ready;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<int, std::unique_ptr<Slab>> m_slabs;
+    // Padded length -> ID of the slab being filled for it.
+    std::unordered_map<int, int> m_filling_slabs;
+    int m_next_slab_id{0};
+
+    int64_t m_num_batches{0};
+    int64_t m_num_batched_windows{0};
+    int64_t m_num_batch_slots{0};
+};
+
+}  // namespace dorado::correction
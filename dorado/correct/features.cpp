@@ -1,6 +1,7 @@
 #include "features.h"
 
 #include "conversions.h"
+#include "correct/feature_arena.h"
 #include "correct/types.h"
 #include "read_pipeline/messages.h"
 #include "utils/cigar.cpp"
@@ -12,6 +13,7 @@
 #include <torch/types.h>
 
 #include <cstdint>
+#include <string_view>
 
 #ifdef NDEBUG
 #define LOG_TRACE(...)
@@ -19,8 +21,6 @@
 #define LOG_TRACE(...) spdlog::trace(__VA_ARGS__)
 #endif
 
-const int TOP_K = 30;
-
 namespace dorado::correction {
 
 bool overlap_has_long_indel(const OverlapWindow& overlap, const CorrectionAlignments& alignments) {
@@ -131,41 +131,58 @@ std::vector<int> get_max_ins_for_window(const std::vector<OverlapWindow>& overla
     return max_ins;
 }
 
-// Generate the tensor encoding for each chunk/window. This function
-// reads the bases from the target and query sequences and qualitiy
-// scores and fills 2x2D matrices where each column in a position
-// in the pileup and each row is a read.
-std::tuple<at::Tensor, at::Tensor> get_features_for_window(
-        const std::vector<OverlapWindow>& overlaps,
-        const CorrectionAlignments& alignments,
-        int win_len,
-        int tstart,
-        const std::vector<int>& max_ins) {
+// Accessor for one row (read) of the window features, which are stored with the
+// rows of each column next to each other.
+template <typename T>
+class FeatureRow {
+public:
+    FeatureRow(T* features, int row) : m_features(features + row) {}
+    T& operator[](int column) { return m_features[int64_t(column) * NUM_FEATURE_ROWS]; }
+    void fill(int start, int end, T value) {
+        for (int column = start; column < end; column++) {
+            (*this)[column] = value;
+        }
+    }
+
+private:
+    T* m_features;
+};
+
+// Number of columns of the window features: one for each target position and
+// one for each insertion after it.
+int get_features_length(const std::vector<int>& max_ins) {
+    return std::accumulate(max_ins.begin(), max_ins.end(), 0) + (int)max_ins.size();
+}
+
+// Generate the encoding for each chunk/window. This function reads the bases
+// from the target and query sequences and qualitiy scores and fills 2x2D
+// matrices where each column in a position in the pileup and each row is a read.
+// The matrices are [length, NUM_FEATURE_ROWS] in the layout used for inference.
+void get_features_for_window(const std::vector<OverlapWindow>& overlaps,
+                             const CorrectionAlignments& alignments,
+                             int win_len,
+                             int tstart,
+                             const std::vector<int>& max_ins,
+                             int* bases,
+                             float* quals) {
     static auto base_encoding = gen_base_encoding();
 #ifndef NDEBUG
     static auto base_decoding = gen_base_decoding();
 #endif
-    auto bases_options = at::TensorOptions().dtype(torch::kInt32).device(torch::kCPU);
-    auto quals_options = at::TensorOptions().dtype(torch::kFloat32).device(torch::kCPU);
 
-    const int length = std::accumulate(max_ins.begin(), max_ins.end(), 0) + (int)max_ins.size();
-    const int reads = 1 + TOP_K;
+    const int length = get_features_length(max_ins);
 
-    auto bases = at::empty({reads, length}, bases_options);
-    std::fill(bases.data_ptr<int>(), bases.data_ptr<int>() + bases.numel(), base_encoding['.']);
-    auto quals = at::empty({reads, length}, quals_options);
-    std::fill(quals.data_ptr<float>(), quals.data_ptr<float>() + quals.numel(),
-              normalize_quals((float)'!'));
+    std::fill(bases, bases + int64_t(length) * NUM_FEATURE_ROWS, base_encoding['.']);
+    std::fill(quals, quals + int64_t(length) * NUM_FEATURE_ROWS, normalize_quals((float)'!'));
 
     // Write bases/qual for target read
     const std::string& tseq = alignments.read_seq;
     const std::vector<uint8_t>& tqual = alignments.read_qual;
 
     int tpos = 0;
-    int* target_bases_tensor = bases.data_ptr<int>();
-    std::fill(target_bases_tensor, target_bases_tensor + length, base_encoding['*']);
-    float* target_quals_tensor = quals.data_ptr<float>();
-    // PyTorch stores data in column major format.
+    FeatureRow<int> target_bases_tensor(bases, 0);
+    target_bases_tensor.fill(0, length, base_encoding['*']);
+    FeatureRow<float> target_quals_tensor(quals, 0);
     for (int i = 0; i < win_len; i++) {
         target_bases_tensor[tpos] = base_encoding[tseq[i + tstart]];
         target_quals_tensor[tpos] = normalize_quals(float(tqual[i + tstart] + 33));
@@ -178,8 +195,8 @@ std::tuple<at::Tensor, at::Tensor> get_features_for_window(
     // Write bases for each overlap in the window
     for (int w = 0; w < (int)overlaps.size(); w++) {
         LOG_TRACE("get_features_for_ol_window for window {}", w);
-        int* query_bases_tensor = &target_bases_tensor[length * (w + 1)];
-        float* query_quals_tensor = &target_quals_tensor[length * (w + 1)];
+        FeatureRow<int> query_bases_tensor(bases, w + 1);
+        FeatureRow<float> query_quals_tensor(quals, w + 1);
         const auto& overlap = overlaps[w];
         const auto& cigar = alignments.cigars[overlap.overlap_idx];
         int offset = overlap.tstart - tstart;
@@ -216,7 +233,7 @@ std::tuple<at::Tensor, at::Tensor> get_features_for_window(
 
         uint8_t gap = fwd ? '*' : '#';
 
-        std::fill(query_bases_tensor, query_bases_tensor + length, base_encoding[gap]);
+        query_bases_tensor.fill(0, length, base_encoding[gap]);
 
         tpos = offset;
         int idx = offset + std::accumulate(max_ins.begin(), max_ins.begin() + offset, 0);
@@ -225,7 +242,7 @@ std::tuple<at::Tensor, at::Tensor> get_features_for_window(
                   cigar_end, gap, tpos, idx, fwd ? '+' : '-');
 
         if (idx > 0) {
-            std::fill(query_bases_tensor, query_bases_tensor + idx, base_encoding['.']);
+            query_bases_tensor.fill(0, idx, base_encoding['.']);
         }
 
         for (int cigar_idx = 0; cigar_idx < cigar_end; cigar_idx++) {
@@ -296,13 +313,9 @@ std::tuple<at::Tensor, at::Tensor> get_features_for_window(
         }
 
         if (idx < length) {
-            std::fill(query_bases_tensor + idx, query_bases_tensor + length, base_encoding['.']);
+            query_bases_tensor.fill(idx, length, base_encoding['.']);
         }
-
-        LOG_TRACE("sum of bases at at overlap {} {}", w, bases.sum().item<int>());
     }
-
-    return {std::move(bases), std::move(quals)};
 }
 
 // From the encoding get positions of the target
@@ -314,22 +327,23 @@ std::tuple<at::Tensor, at::Tensor> get_features_for_window(
 // first element being a position in the target sequence
 // and the second element being an insertion offset from that
 // position.
-std::vector<std::pair<int, int>> get_supported(at::Tensor& bases) {
+std::vector<std::pair<int, int>> get_supported(const at::Tensor& bases) {
     std::vector<std::pair<int, int>> supported;
 
     static auto base_forward = base_forward_mapping();
     static auto base_encoding = gen_base_encoding();
     static auto base_decoding = gen_base_decoding();
 
-    const int reads = static_cast<int>(bases.sizes()[0]);
-    const int length = static_cast<int>(bases.sizes()[1]);
+    const int length = static_cast<int>(bases.sizes()[0]);
+    const int reads = static_cast<int>(bases.sizes()[1]);
 
-    auto bases_ptr = bases.data_ptr<int>();
+    const int* bases_ptr = bases.data_ptr<int>();
 
     int tpos = -1, ins = 0;
     std::array<int, 128> counter;
     for (int c = 0; c < length; c++) {
-        if (bases_ptr[c] == base_encoding['*']) {
+        const int* column = &bases_ptr[int64_t(c) * reads];
+        if (column[0] == base_encoding['*']) {
             ins += 1;
         } else {
             tpos += 1;
@@ -337,7 +351,7 @@ std::vector<std::pair<int, int>> get_supported(at::Tensor& bases) {
         }
         counter.fill(0);
         for (int r = 0; r < reads; r++) {
-            auto base = bases_ptr[r * length + c];
+            auto base = column[r];
             LOG_TRACE("row {} base {}", r, base);
             if (base == base_encoding['.']) {
                 continue;
@@ -362,10 +376,11 @@ std::vector<std::pair<int, int>> get_supported(at::Tensor& bases) {
 // column in the tensor.
 at::Tensor get_indices(const at::Tensor& bases, const std::vector<std::pair<int, int>>& supported) {
     static auto base_encoding = gen_base_encoding();
-    auto tbase_tensor = bases.data_ptr<int>();
+    const int* tbase_tensor = bases.data_ptr<int>();
+    const int64_t reads = bases.sizes()[1];
     std::vector<int> indices;
-    for (int i = 0; i < bases.sizes()[1]; i++) {
-        if (tbase_tensor[i] != base_encoding['*']) {
+    for (int i = 0; i < bases.sizes()[0]; i++) {
+        if (tbase_tensor[i * reads] != base_encoding['*']) {
             indices.push_back(i);
         }
     }
@@ -407,8 +422,8 @@ std::unordered_set<int> filter_features(std::vector<std::vector<OverlapWindow>>&
             std::sort(overlap_windows.begin(), overlap_windows.end(),
                       [&alignments](const OverlapWindow& a, const OverlapWindow& b) {
                           if (std::fabs(a.accuracy - b.accuracy) < 1e-10) {
-                              const auto& a_qname = alignments.qnames[a.overlap_idx];
-                              const auto& b_qname = alignments.qnames[b.overlap_idx];
+                              const std::string_view a_qname = alignments.qname(a.overlap_idx);
+                              const std::string_view b_qname = alignments.qname(b.overlap_idx);
                               return std::lexicographical_compare(a_qname.begin(), a_qname.end(),
                                                                   b_qname.begin(), b_qname.end());
                           }
@@ -439,36 +454,46 @@ std::unordered_set<int> filter_features(std::vector<std::vector<OverlapWindow>>&
 // given the overlaps for a target read.
 std::vector<WindowFeatures> extract_features(std::vector<std::vector<OverlapWindow>>& windows,
                                              const CorrectionAlignments& alignments,
-                                             int window_size) {
+                                             int window_size,
+                                             FeatureArena& arena) {
     const std::string& tseq = alignments.read_seq;
     int tlen = (int)tseq.length();
 
     std::vector<WindowFeatures> wfs;
-    for (int w = 0; w < (int)windows.size(); w++) {
-        int win_len = (w == (int)windows.size() - 1) ? tlen - window_size * w : window_size;
-        LOG_TRACE("win idx {}: win len {}", w, win_len);
-        auto& overlap_windows = windows[w];
-
-        WindowFeatures wf;
-        wf.window_idx = w;
-        wf.read_name = alignments.read_name;
-        wf.n_alns = (int)overlap_windows.size();
-        if (overlap_windows.size() > 1) {
-            // Find the maximum insert size
-            auto max_ins =
-                    get_max_ins_for_window(overlap_windows, alignments, w * window_size, win_len);
-
-            // Create tensors
-            auto [bases, quals] = get_features_for_window(overlap_windows, alignments, win_len,
-                                                          w * window_size, max_ins);
-            auto supported = get_supported(bases);
-            wf.bases = std::move(bases);
-            wf.quals = std::move(quals);
-            wf.supported = std::move(supported);
-            wf.length = (int)wf.supported.size();
-            wf.indices = get_indices(wf.bases, wf.supported);
+    wfs.reserve(windows.size());
+    try {
+        for (int w = 0; w < (int)windows.size(); w++) {
+            int win_len = (w == (int)windows.size() - 1) ? tlen - window_size * w : window_size;
+            LOG_TRACE("win idx {}: win len {}", w, win_len);
+            auto& overlap_windows = windows[w];
+
+            wfs.emplace_back();
+            WindowFeatures& wf = wfs.back();
+            wf.window_idx = w;
+            wf.read_name = alignments.read_name;
+            wf.read_id = alignments.read_id;
+            wf.n_alns = (int)overlap_windows.size();
+            if (overlap_windows.size() > 1) {
+                // Find the maximum insert size
+                auto max_ins = get_max_ins_for_window(overlap_windows, alignments,
+                                                      w * window_size, win_len);
+
+                // Write the features straight into a slot of an inference batch.
+                arena.acquire(wf, get_features_length(max_ins));
+                get_features_for_window(overlap_windows, alignments, win_len, w * window_size,
+                                        max_ins, wf.bases.data_ptr<int>(),
+                                        wf.quals.data_ptr<float>());
+                wf.supported = get_supported(wf.bases);
+                wf.length = (int)wf.supported.size();
+                wf.indices = get_indices(wf.bases, wf.supported);
+            }
+        }
+    } catch (...) {
+        // Don't leave the arena waiting for windows which will never be committed.
+        for (auto& wf : wfs) {
+            arena.release(wf);
         }
-        wfs.push_back(std::move(wf));
+        throw;
     }
 
     return wfs;
@@ -10,12 +10,17 @@ struct CorrectionAlignments;
 
 namespace dorado::correction {
 
+class FeatureArena;
+
 // Filter window features to TOP_K best. Returns collection of useful overlap indices
 std::unordered_set<int> filter_features(std::vector<std::vector<OverlapWindow>>& windows,
                                         const CorrectionAlignments& alignments);
 
+// Window features are written into slots acquired from |arena|. Each window with
+// features must then be committed to the arena for inference, or released.
 std::vector<WindowFeatures> extract_features(std::vector<std::vector<OverlapWindow>>& windows,
                                              const CorrectionAlignments& alignments,
-                                             int window_size);
+                                             int window_size,
+                                             FeatureArena& arena);
 
 }  // namespace dorado::correction
@@ -2,11 +2,19 @@
 
 #include <ATen/Tensor.h>
 
+#include <cstdint>
 #include <filesystem>
+#include <string>
 #include <vector>
 
 namespace dorado::correction {
 
+// Number of overlaps kept for each window.
+constexpr int TOP_K = 30;
+
+// Number of rows in the features of a window: the target read followed by the TOP_K overlaps.
+constexpr int NUM_FEATURE_ROWS = TOP_K + 1;
+
 struct OverlapWindow {
     // CorrectionAlignments overlap vector index
     int overlap_idx = -1;
@@ -21,6 +29,7 @@ struct OverlapWindow {
 };
 
 struct WindowFeatures {
+    // Features with shape [columns, NUM_FEATURE_ROWS], held in a slot of a FeatureArena.
     at::Tensor bases;
     at::Tensor quals;
     at::Tensor indices;
@@ -29,7 +38,10 @@ struct WindowFeatures {
     std::vector<char> inferred_bases;
     int n_alns = 0;
     std::string read_name = "";
+    int32_t read_id = -1;
     int window_idx = -1;
+    int arena_slab = -1;
+    int arena_slot = -1;
 
     size_t size() {
         size_t total = 0;
@@ -3,6 +3,7 @@
 #include "models/kits.h"
 #include "read_pipeline/ReadPipeline.h"
 #include "read_pipeline/messages.h"
+#include "utils/AsyncQueue.h"
 #include "utils/PostCondition.h"
 #include "utils/fs_utils.h"
 #include "utils/thread_naming.h"
@@ -20,10 +21,14 @@
 #include <algorithm>
 #include <cctype>
 #include <ctime>
+#include <exception>
 #include <filesystem>
+#include <future>
 #include <mutex>
 #include <optional>
+#include <set>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
 namespace dorado {
@@ -36,6 +41,10 @@ static_assert(sizeof(dorado::ReadID) == sizeof(read_id_t));
 // 37 = number of bytes in UUID (32 hex digits + 4 dashes + null terminator)
 const uint32_t POD5_READ_ID_LEN = 37;
 
+// Number of POD5 batches that can be read ahead of the one being pushed to the pipeline.
+// The reads of each batch are decoded as soon as it's read, so this bounds the memory used.
+constexpr size_t POD5_READ_AHEAD_BATCHES = 2;
+
 void string_reader(HighFive::Attribute& attribute, std::string& target_str) {
     // Load as a variable string if possible
     if (attribute.getDataType().isVariableStr()) {
@@ -228,10 +237,21 @@ SimplexReadPtr process_pod5_thread_fn(
     return new_read;
 }
 
+bool can_process_read_id(const dorado::ReadID& read_id,
+                         const std::optional<dorado::utils::ReadIdSet>& allowed_read_ids,
+                         const dorado::utils::ReadIdSet& ignored_read_ids) {
+    bool read_in_ignore_list = ignored_read_ids.contains(read_id);
+    bool read_in_read_list = !allowed_read_ids || allowed_read_ids->contains(read_id);
+    if (!read_in_ignore_list && read_in_read_list) {
+        return true;
+    }
+    return false;
+}
+
 bool can_process_pod5_row(Pod5ReadRecordBatch_t* batch,
                           int row,
-                          const std::optional<std::unordered_set<std::string>>& allowed_read_ids,
-                          const std::unordered_set<std::string>& ignored_read_ids) {
+                          const std::optional<dorado::utils::ReadIdSet>& allowed_read_ids,
+                          const dorado::utils::ReadIdSet& ignored_read_ids) {
     uint16_t read_table_version = 0;
     ReadBatchRowInfo_t read_data;
     if (pod5_get_read_batch_row_info_data(batch, row, READ_BATCH_ROW_INFO_VERSION, &read_data,
@@ -240,97 +260,165 @@ bool can_process_pod5_row(Pod5ReadRecordBatch_t* batch,
         return false;
     }
 
+    // The read id sets hold UUIDs in the same packed form as POD5, so there's no need to format
+    // the read id as a string to look it up.
+    dorado::ReadID read_id;
+    std::copy(std::begin(read_data.read_id), std::end(read_data.read_id), read_id.begin());
+    return can_process_read_id(read_id, allowed_read_ids, ignored_read_ids);
+}
+
+std::string format_read_id(const dorado::ReadID& read_id) {
     char read_id_tmp[POD5_READ_ID_LEN];
-    if (pod5_format_read_id(read_data.read_id, read_id_tmp) != POD5_OK) {
+    if (pod5_format_read_id(read_id.data(), read_id_tmp) != POD5_OK) {
         spdlog::error("Failed to format read id");
+        return {};
     }
+    return read_id_tmp;
+}
 
-    std::string read_id_str(read_id_tmp);
-    bool read_in_ignore_list = ignored_read_ids.find(read_id_str) != ignored_read_ids.end();
-    bool read_in_read_list =
-            !allowed_read_ids || (allowed_read_ids->find(read_id_str) != allowed_read_ids->end());
-    if (!read_in_ignore_list && read_in_read_list) {
-        return true;
+// Opens a POD5 file that's closed once the last reference to it is released.
+std::shared_ptr<Pod5FileReader_t> open_pod5_file(const std::string& path) {
+    Pod5FileReader_t* file = pod5_open_file(path.c_str());
+    if (!file) {
+        spdlog::error("Failed to open file {}: {}", path, pod5_get_error_string());
+        return nullptr;
     }
-    return false;
+    return std::shared_ptr<Pod5FileReader_t>(file, [path](Pod5FileReader_t* reader) {
+        if (pod5_close_and_free_reader(reader) != POD5_OK) {
+            spdlog::error("Failed to close and free POD5 reader for file {}", path);
+        }
+    });
 }
 
 }  // namespace
 
+struct DataLoader::Pod5LoadBatch {
+    // Shared by all batches from the file, so that it stays open until they've been loaded.
+    std::shared_ptr<Pod5FileReader_t> file;
+    std::shared_ptr<const std::string> path;
+    Pod5ReadRecordBatch_t* batch{nullptr};
+    std::vector<uint32_t> rows;
+    std::vector<std::future<SimplexReadPtr>> reads;
+
+    ~Pod5LoadBatch() {
+        // The decode tasks use the batch, so must finish before it's released.
+        for (auto& read : reads) {
+            if (read.valid()) {
+                read.wait();
+            }
+        }
+        if (batch && pod5_free_read_batch(batch) != POD5_OK) {
+            spdlog::error("Failed to release batch");
+        }
+    }
+};
+
 void DataLoader::load_reads_by_channel(const std::vector<std::filesystem::directory_entry>& files) {
     // If traversal in channel order is required, the following algorithm
     // is used -
-    // 1. iterate through all the read metadata to collect channel information
-    // across all pod5 files
-    // 2. store the read list sorted by channel number
+    // 1. index the reads of each pod5 file by channel, reusing the sidecar
+    // index saved by an earlier run where there is one
+    std::vector<std::string> pod5_paths;
+    for (const auto& entry : files) {
+        auto entry_path = std::filesystem::path(entry);
+        std::string ext = entry_path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        if (ext == ".fast5") {
+            throw std::runtime_error(
+                    "Traversing reads by channel is only available for POD5. "
+                    "Encountered FAST5 at " +
+                    entry_path.string());
+        } else if (ext == ".pod5") {
+            pod5_paths.push_back(entry_path.string());
+        }
+    }
     spdlog::info("> Reading read channel info");
-    load_read_channels(files);
+    const auto indexes = load_channel_indexes(pod5_paths);
     spdlog::info("> Processed read channel info");
-    // 3. for each channel, iterate through all files and in each iteration
-    // only load the reads that correspond to that channel.
-    for (int channel = 0; channel <= m_max_channel; channel++) {
-        if (m_reads_by_channel.find(channel) != m_reads_by_channel.end()) {
-            // Sort the read ids within a channel by its mux
-            // and start time.
-            spdlog::trace("Sort channel {}", channel);
-            auto& reads = m_reads_by_channel.at(channel);
-            std::sort(reads.begin(), reads.end(), [](ReadSortInfo& a, ReadSortInfo& b) {
-                if (a.mux != b.mux) {
-                    return a.mux < b.mux;
-                } else {
-                    return a.read_number < b.read_number;
+
+    std::set<int> channels;
+    for (const auto& index : indexes) {
+        if (index) {
+            for (const auto& [channel, reads] : index->channels()) {
+                channels.insert(channel);
+            }
+        }
+    }
+
+    // 2. for each channel, gather the channel's reads from every index and
+    // sort them, so only one channel's read ids are held at a time
+    // 3. then iterate through all files and in each iteration only load the
+    // reads that correspond to that channel, using their location in the index.
+    for (const int channel : channels) {
+        if (m_loaded_read_count == m_max_reads) {
+            break;
+        }
+        spdlog::trace("Sort channel {}", channel);
+        auto& reads = m_reads_by_channel[channel];
+        for (const auto& index : indexes) {
+            if (index) {
+                for (const auto& entry : index->reads_in_channel(channel)) {
+                    reads.push_back({format_read_id(entry.read_id), entry.mux, entry.read_number});
                 }
-            });
-            // Once sorted, create a hash table from read id
-            // to index in the sorted list to quickly fetch the
-            // read location and its neighbors.
-            for (size_t i = 0; i < reads.size(); i++) {
-                m_read_id_to_index[reads[i].read_id] = i;
             }
-            spdlog::trace("Sorted channel {}", channel);
         }
-        for (const auto& entry : files) {
+        // Sort the read ids within a channel by its mux
+        // and start time.
+        std::sort(reads.begin(), reads.end(), [](ReadSortInfo& a, ReadSortInfo& b) {
+            if (a.mux != b.mux) {
+                return a.mux < b.mux;
+            } else {
+                return a.read_number < b.read_number;
+            }
+        });
+        // Once sorted, create a hash table from read id
+        // to index in the sorted list to quickly fetch the
+        // read location and its neighbors.
+        for (size_t i = 0; i < reads.size(); i++) {
+            m_read_id_to_index[reads[i].read_id] = i;
+        }
+        spdlog::trace("Sorted channel {}", channel);
+
+        for (size_t file_index = 0; file_index < pod5_paths.size(); ++file_index) {
             if (m_loaded_read_count == m_max_reads) {
                 break;
             }
-            auto entry_path = std::filesystem::path(entry);
-            std::string ext = entry_path.extension().string();
-            std::transform(ext.begin(), ext.end(), ext.begin(),
-                           [](unsigned char c) { return std::tolower(c); });
-            if (ext == ".fast5") {
-                throw std::runtime_error(
-                        "Traversing reads by channel is only available for POD5. "
-                        "Encountered FAST5 at " +
-                        entry_path.string());
-            } else if (ext == ".pod5") {
-                auto& channel_to_read_ids = m_file_channel_read_order_map.at(entry_path.string());
-                auto& read_ids = channel_to_read_ids[channel];
-                if (!read_ids.empty()) {
-                    load_pod5_reads_from_file_by_read_ids(entry_path.string(), read_ids);
-                }
+            if (!indexes[file_index]) {
+                continue;
+            }
+            const auto& channel_reads = indexes[file_index]->reads_in_channel(channel);
+            if (!channel_reads.empty()) {
+                load_pod5_reads_from_file_by_rows(pod5_paths[file_index], channel_reads);
             }
         }
         // Erase sorted list as it's not needed anymore.
         m_reads_by_channel.erase(channel);
+        m_read_id_to_index.clear();
     }
 }
 
 void DataLoader::load_reads_unrestricted(
         const std::vector<std::filesystem::directory_entry>& files) {
+    // POD5 files are loaded together so that reading ahead can cross file boundaries.
+    std::vector<std::string> pod5_paths;
     for (const auto& entry : files) {
         if (m_loaded_read_count == m_max_reads) {
             break;
         }
-        spdlog::debug("Load reads from file {}", entry.path().string());
         std::string ext = std::filesystem::path(entry).extension().string();
         std::transform(ext.begin(), ext.end(), ext.begin(),
                        [](unsigned char c) { return std::tolower(c); });
         if (ext == ".fast5") {
+            spdlog::debug("Load reads from file {}", entry.path().string());
             load_fast5_reads_from_file(entry.path().string());
         } else if (ext == ".pod5") {
-            load_pod5_reads_from_file(entry.path().string());
+            pod5_paths.push_back(entry.path().string());
         }
     }
+    if (!pod5_paths.empty()) {
+        load_pod5_reads_from_files(pod5_paths);
+    }
 }
 
 void DataLoader::load_reads(const InputFiles& input_files, ReadOrder traversal_order) {
@@ -347,237 +435,194 @@ void DataLoader::load_reads(const InputFiles& input_files, ReadOrder traversal_o
     }
 }
 
-void DataLoader::load_read_channels(const std::vector<std::filesystem::directory_entry>& files) {
-    for (const auto& entry : files) {
-        auto file_path = std::filesystem::path(entry);
-        std::string ext = file_path.extension().string();
-        std::transform(ext.begin(), ext.end(), ext.begin(),
-                       [](unsigned char c) { return std::tolower(c); });
-        if (ext != ".pod5") {
-            continue;
-        }
-        pod5_init();
-
-        // Use a std::map to store by sorted channel order.
-        m_file_channel_read_order_map.emplace(file_path.string(), channel_to_read_id_t());
-        auto& channel_to_read_id = m_file_channel_read_order_map[file_path.string()];
-
-        // Open the file ready for walking:
-        Pod5FileReader_t* file = pod5_open_file(file_path.string().c_str());
-
-        if (!file) {
-            spdlog::error("Failed to open file {}: {}", file_path.string().c_str(),
-                          pod5_get_error_string());
-            continue;
-        }
-        std::size_t batch_count = 0;
-        if (pod5_get_read_batch_count(&batch_count, file) != POD5_OK) {
-            spdlog::error("Failed to query batch count: {}", pod5_get_error_string());
-        }
-
-        for (std::size_t batch_index = 0; batch_index < batch_count; ++batch_index) {
-            Pod5ReadRecordBatch_t* batch = nullptr;
-            if (pod5_get_read_batch(&batch, file, batch_index) != POD5_OK) {
-                spdlog::error("Failed to get batch: {}", pod5_get_error_string());
-                continue;
-            }
-
-            std::size_t batch_row_count = 0;
-            if (pod5_get_read_batch_row_count(&batch_row_count, batch) != POD5_OK) {
-                spdlog::error("Failed to get batch row count");
-                continue;
-            }
-
-            for (std::size_t row = 0; row < batch_row_count; ++row) {
-                uint16_t read_table_version = 0;
-                ReadBatchRowInfo_t read_data;
-                if (pod5_get_read_batch_row_info_data(batch, row, READ_BATCH_ROW_INFO_VERSION,
-                                                      &read_data, &read_table_version) != POD5_OK) {
-                    spdlog::error("Failed to get read {}", row);
-                    continue;
-                }
-
-                int channel = read_data.channel;
-
-                // Update maximum number of channels encountered.
-                m_max_channel = std::max(m_max_channel, channel);
-
-                // Store the read_id in the channel's list.
-                ReadID read_id;
-                std::memcpy(read_id.data(), read_data.read_id, POD5_READ_ID_SIZE);
-                channel_to_read_id[channel].push_back(read_id);
-
-                char read_id_tmp[POD5_READ_ID_LEN];
-                if (pod5_format_read_id(read_data.read_id, read_id_tmp) != POD5_OK) {
-                    spdlog::error("Failed to format read id");
-                }
-                std::string rid(read_id_tmp);
-                m_reads_by_channel[channel].push_back({rid, read_data.well, read_data.read_number});
-            }
-
-            if (pod5_free_read_batch(batch) != POD5_OK) {
-                spdlog::error("Failed to release batch");
-            }
-        }
-        if (pod5_close_and_free_reader(file) != POD5_OK) {
-            spdlog::error("Failed to close and free POD5 reader");
-        }
+std::vector<std::optional<Pod5ChannelIndex>> DataLoader::load_channel_indexes(
+        const std::vector<std::string>& paths) {
+    // Files are indexed concurrently, as building an index reads the metadata of every row.
+    std::vector<std::future<std::optional<Pod5ChannelIndex>>> futures;
+    futures.reserve(paths.size());
+    for (const auto& path : paths) {
+        futures.push_back(m_pod5_decode_pool->push(
+                [path, use_sidecar = m_use_channel_index_sidecars] {
+                    return Pod5ChannelIndex::load_or_build(path, use_sidecar);
+                }));
     }
-}
 
-void DataLoader::load_pod5_reads_from_file_by_read_ids(const std::string& path,
-                                                       const std::vector<ReadID>& read_ids) {
-    pod5_init();
-
-    // Open the file ready for walking:
-    // TODO: The earlier implementation was caching the pod5 readers into a
-    // map and re-using it during each iteration. However, we found a leak
-    // in the pod5 traversal API which persists unless the reader is opened
-    // and closed everytime. So the caching logic was reverted until the
-    // leak is fixed in pod5 API.
-    Pod5FileReader_t* file = pod5_open_file(path.c_str());
-
-    if (!file) {
-        spdlog::error("Failed to open file {}: {}", path, pod5_get_error_string());
-        return;
-    }
-
-    auto free_pod5 = [&]() {
-        if (pod5_close_and_free_reader(file) != POD5_OK) {
-            spdlog::error("Failed to close and free POD5 reader for file {}", path.c_str());
-        }
-    };
-
-    auto post = utils::PostCondition(free_pod5);
-
-    std::vector<uint8_t> read_id_array(POD5_READ_ID_SIZE * read_ids.size());
-    for (size_t i = 0; i < read_ids.size(); i++) {
-        std::memcpy(read_id_array.data() + POD5_READ_ID_SIZE * i, read_ids[i].data(),
-                    POD5_READ_ID_SIZE);
-    }
-
-    std::size_t batch_count = 0;
-    if (pod5_get_read_batch_count(&batch_count, file) != POD5_OK) {
-        spdlog::error("Failed to query batch count: {}", pod5_get_error_string());
-    }
-
-    std::vector<std::uint32_t> traversal_batch_counts(batch_count);
-    std::vector<std::uint32_t> traversal_batch_rows(read_ids.size());
-    size_t find_success_count;
-    pod5_error_t err = pod5_plan_traversal(file, read_id_array.data(), read_ids.size(),
-                                           traversal_batch_counts.data(),
-                                           traversal_batch_rows.data(), &find_success_count);
-    if (err != POD5_OK) {
-        spdlog::error("Couldn't create plan for {} with reads {}", path, read_ids.size());
-        return;
+    std::vector<std::optional<Pod5ChannelIndex>> indexes;
+    indexes.reserve(paths.size());
+    for (auto& future : futures) {
+        indexes.push_back(future.get());
     }
+    return indexes;
+}
 
-    if (find_success_count != read_ids.size()) {
-        spdlog::error("Reads found by plan {}, reads in input {}", find_success_count,
-                      read_ids.size());
-        throw std::runtime_error("Plan traveral didn't yield correct number of reads");
-    }
-
-    // Create static threadpool so it is reused across calls to this function.
-    static cxxpool::thread_pool pool{m_num_worker_threads};
-
-    uint32_t row_offset = 0;
-    for (std::size_t batch_index = 0; batch_index < batch_count; ++batch_index) {
-        if (m_loaded_read_count == m_max_reads) {
-            break;
-        }
-        Pod5ReadRecordBatch_t* batch = nullptr;
-        if (pod5_get_read_batch(&batch, file, batch_index) != POD5_OK) {
-            spdlog::error("Failed to get batch: {}", pod5_get_error_string());
-            continue;
+void DataLoader::load_pod5_batches(
+        const std::function<void(const Pod5BatchSinkF&)>& produce_batches) {
+    utils::AsyncQueue<std::unique_ptr<Pod5LoadBatch>> read_ahead_queue(POD5_READ_AHEAD_BATCHES);
+
+    // Batches are read and their reads queued for decoding on the read-ahead thread, so that
+    // I/O and decoding of the following batches overlap with pushing reads into the pipeline.
+    std::exception_ptr read_ahead_exception;
+    std::thread read_ahead_thread([&] {
+        utils::set_thread_name("pod5_read_ahead");
+        try {
+            produce_batches([&](std::unique_ptr<Pod5LoadBatch> batch) {
+                for (const auto row : batch->rows) {
+                    batch->reads.push_back(m_pod5_decode_pool->push(
+                            process_pod5_thread_fn, row, batch->batch, batch->file.get(),
+                            std::cref(*batch->path), std::cref(m_reads_by_channel),
+                            std::cref(m_read_id_to_index)));
+                }
+                const size_t num_reads = batch->reads.size();
+                m_pod5_reads_decoding += num_reads;
+                ++m_pod5_batches_read_ahead;
+                const auto status = read_ahead_queue.try_push(std::move(batch));
+                if (status != utils::AsyncQueueStatus::Success) {
+                    m_pod5_reads_decoding -= num_reads;
+                    --m_pod5_batches_read_ahead;
+                    return false;
+                }
+                return true;
+            });
+        } catch (...) {
+            read_ahead_exception = std::current_exception();
         }
-
-        std::vector<std::future<SimplexReadPtr>> futures;
-        for (std::size_t row_idx = 0; row_idx < traversal_batch_counts[batch_index]; row_idx++) {
-            uint32_t row = traversal_batch_rows[row_idx + row_offset];
-
-            if (can_process_pod5_row(batch, row, m_allowed_read_ids, m_ignored_read_ids)) {
-                futures.push_back(pool.push(process_pod5_thread_fn, row, batch, file,
-                                            std::cref(path), std::cref(m_reads_by_channel),
-                                            std::cref(m_read_id_to_index)));
-            }
+        read_ahead_queue.terminate();
+    });
+    // Stop reading ahead if pushing the reads fails.
+    auto stop_read_ahead = utils::PostCondition([&] {
+        if (read_ahead_thread.joinable()) {
+            read_ahead_queue.terminate();
+            read_ahead_thread.join();
         }
+    });
 
-        for (auto& v : futures) {
-            auto read = v.get();
+    std::unique_ptr<Pod5LoadBatch> batch;
+    while (read_ahead_queue.try_pop(batch) == utils::AsyncQueueStatus::Success) {
+        --m_pod5_batches_read_ahead;
+        for (auto& future : batch->reads) {
+            auto read = future.get();
             initialise_read(read->read_common);
             check_read(read);
             m_pipeline.push_message(std::move(read));
             m_loaded_read_count++;
+            --m_pod5_reads_decoding;
         }
+        batch.reset();
+        ++m_pod5_batches_loaded;
+    }
 
-        if (pod5_free_read_batch(batch) != POD5_OK) {
-            spdlog::error("Failed to release batch");
-        }
-
-        row_offset += traversal_batch_counts[batch_index];
+    read_ahead_thread.join();
+    if (read_ahead_exception) {
+        std::rethrow_exception(read_ahead_exception);
     }
 }
 
-void DataLoader::load_pod5_reads_from_file(const std::string& path) {
+void DataLoader::load_pod5_reads_from_file_by_rows(
+        const std::string& path,
+        const std::vector<Pod5ChannelIndex::Entry>& reads) {
     pod5_init();
 
-    // Open the file ready for walking:
-    Pod5FileReader_t* file = pod5_open_file(path.c_str());
-
+    // Open the file ready for walking. Files are opened for each channel
+    // rather than held open, as there can be more files than the limit on
+    // open files.
+    auto file = open_pod5_file(path);
     if (!file) {
-        spdlog::error("Failed to open file {}: {}", path, pod5_get_error_string());
+        return;
     }
 
-    std::size_t batch_count = 0;
-    if (pod5_get_read_batch_count(&batch_count, file) != POD5_OK) {
-        spdlog::error("Failed to query batch count: {}", pod5_get_error_string());
-    }
+    load_pod5_batches([&](const Pod5BatchSinkF& sink) {
+        const auto shared_path = std::make_shared<const std::string>(path);
+        size_t num_scheduled_reads = m_loaded_read_count;
+        // The index holds the reads of a channel in file order, so the reads
+        // from each batch are contiguous.
+        auto batch_begin = reads.begin();
+        while (batch_begin != reads.end() && num_scheduled_reads < m_max_reads) {
+            const uint32_t batch_index = batch_begin->batch;
+            const auto batch_end = std::find_if(batch_begin, reads.end(), [&](const auto& read) {
+                return read.batch != batch_index;
+            });
 
-    cxxpool::thread_pool pool{m_num_worker_threads};
+            auto batch = std::make_unique<Pod5LoadBatch>();
+            batch->file = file;
+            batch->path = shared_path;
+            for (auto read = batch_begin; read != batch_end; ++read) {
+                if (can_process_read_id(read->read_id, m_allowed_read_ids, m_ignored_read_ids)) {
+                    batch->rows.push_back(read->row);
+                }
+            }
+            batch_begin = batch_end;
+            if (batch->rows.empty()) {
+                continue;
+            }
 
-    for (std::size_t batch_index = 0; batch_index < batch_count; ++batch_index) {
-        if (m_loaded_read_count == m_max_reads) {
-            break;
-        }
-        Pod5ReadRecordBatch_t* batch = nullptr;
-        if (pod5_get_read_batch(&batch, file, batch_index) != POD5_OK) {
-            spdlog::error("Failed to get batch: {}", pod5_get_error_string());
-        }
+            if (pod5_get_read_batch(&batch->batch, file.get(), batch_index) != POD5_OK) {
+                spdlog::error("Failed to get batch: {}", pod5_get_error_string());
+                continue;
+            }
 
-        std::size_t batch_row_count = 0;
-        if (pod5_get_read_batch_row_count(&batch_row_count, batch) != POD5_OK) {
-            spdlog::error("Failed to get batch row count");
+            num_scheduled_reads += batch->rows.size();
+            if (!sink(std::move(batch))) {
+                return;
+            }
         }
-        batch_row_count = std::min(batch_row_count, m_max_reads - m_loaded_read_count);
+    });
+}
 
-        std::vector<std::future<SimplexReadPtr>> futures;
+void DataLoader::load_pod5_reads_from_files(const std::vector<std::string>& paths) {
+    pod5_init();
 
-        for (std::size_t row = 0; row < batch_row_count; ++row) {
-            // TODO - check the read ID here, for each one, only send the row if it is in the list of ones we care about
+    load_pod5_batches([&](const Pod5BatchSinkF& sink) {
+        size_t num_scheduled_reads = m_loaded_read_count;
+        for (const auto& path : paths) {
+            if (num_scheduled_reads >= m_max_reads) {
+                break;
+            }
+            spdlog::debug("Load reads from file {}", path);
 
-            if (can_process_pod5_row(batch, int(row), m_allowed_read_ids, m_ignored_read_ids)) {
-                futures.push_back(pool.push(process_pod5_thread_fn, row, batch, file,
-                                            std::cref(path), std::cref(m_reads_by_channel),
-                                            std::cref(m_read_id_to_index)));
+            // Open the file ready for walking:
+            auto file = open_pod5_file(path);
+            if (!file) {
+                continue;
             }
-        }
+            const auto shared_path = std::make_shared<const std::string>(path);
 
-        for (auto& v : futures) {
-            auto read = v.get();
-            initialise_read(read->read_common);
-            check_read(read);
-            m_pipeline.push_message(std::move(read));
-            m_loaded_read_count++;
-        }
+            std::size_t batch_count = 0;
+            if (pod5_get_read_batch_count(&batch_count, file.get()) != POD5_OK) {
+                spdlog::error("Failed to query batch count: {}", pod5_get_error_string());
+            }
 
-        if (pod5_free_read_batch(batch) != POD5_OK) {
-            spdlog::error("Failed to release batch");
+            for (std::size_t batch_index = 0; batch_index < batch_count; ++batch_index) {
+                if (num_scheduled_reads >= m_max_reads) {
+                    break;
+                }
+                auto batch = std::make_unique<Pod5LoadBatch>();
+                batch->file = file;
+                batch->path = shared_path;
+                if (pod5_get_read_batch(&batch->batch, file.get(), batch_index) != POD5_OK) {
+                    spdlog::error("Failed to get batch: {}", pod5_get_error_string());
+                    continue;
+                }
+
+                std::size_t batch_row_count = 0;
+                if (pod5_get_read_batch_row_count(&batch_row_count, batch->batch) != POD5_OK) {
+                    spdlog::error("Failed to get batch row count");
+                }
+                batch_row_count = std::min(batch_row_count, m_max_reads - num_scheduled_reads);
+
+                for (std::size_t row = 0; row < batch_row_count; ++row) {
+                    if (can_process_pod5_row(batch->batch, int(row), m_allowed_read_ids,
+                                             m_ignored_read_ids)) {
+                        batch->rows.push_back(static_cast<uint32_t>(row));
+                    }
+                }
+
+                num_scheduled_reads += batch->rows.size();
+                if (!sink(std::move(batch))) {
+                    return;
+                }
+            }
         }
-    }
-    if (pod5_close_and_free_reader(file) != POD5_OK) {
-        spdlog::error("Failed to close and free POD5 reader");
-    }
+    });
 }
 
 void DataLoader::load_fast5_reads_from_file(const std::string& path) {
@@ -674,8 +719,7 @@ void DataLoader::load_fast5_reads_from_file(const std::string& path) {
         new_read->read_common.experiment_id = group_protocol_id;
         new_read->read_common.is_duplex = false;
 
-        if (!m_allowed_read_ids || (m_allowed_read_ids->find(new_read->read_common.read_id) !=
-                                    m_allowed_read_ids->end())) {
+        if (!m_allowed_read_ids || m_allowed_read_ids->contains(new_read->read_common.read_id)) {
             initialise_read(new_read->read_common);
             m_pipeline.push_message(std::move(new_read));
             m_loaded_read_count++;
@@ -702,11 +746,12 @@ DataLoader::DataLoader(Pipeline& pipeline,
                        const std::string& device,
                        size_t num_worker_threads,
                        size_t max_reads,
-                       std::optional<std::unordered_set<std::string>> read_list,
-                       std::unordered_set<std::string> read_ignore_list)
+                       std::optional<utils::ReadIdSet> read_list,
+                       utils::ReadIdSet read_ignore_list)
         : m_pipeline(pipeline),
           m_device(device),
           m_num_worker_threads(num_worker_threads),
+          m_pod5_decode_pool(std::make_unique<cxxpool::thread_pool>(num_worker_threads)),
           m_allowed_read_ids(std::move(read_list)),
           m_ignored_read_ids(std::move(read_ignore_list)) {
     m_max_reads = max_reads == 0 ? std::numeric_limits<decltype(m_max_reads)>::max() : max_reads;
@@ -715,6 +760,8 @@ DataLoader::DataLoader(Pipeline& pipeline,
     std::call_once(vbz_init_flag, vbz_register);
 }
 
+DataLoader::~DataLoader() = default;
+
 std::optional<DataLoader::InputFiles> DataLoader::InputFiles::search(
         const std::filesystem::path& path,
         bool recursive) {
@@ -735,6 +782,21 @@ const std::vector<std::filesystem::directory_entry>& DataLoader::InputFiles::get
 }
 
 stats::NamedStats DataLoader::sample_stats() const {
-    return stats::NamedStats{{"loaded_read_count", static_cast<double>(m_loaded_read_count)}};
+    stats::NamedStats stats{{"loaded_read_count", static_cast<double>(m_loaded_read_count)}};
+    stats["pod5_batches_read_ahead"] = static_cast<double>(m_pod5_batches_read_ahead);
+    stats["pod5_reads_decoding"] = static_cast<double>(m_pod5_reads_decoding);
+    stats["pod5_batches_loaded"] = static_cast<double>(m_pod5_batches_loaded);
+    // The read id lists aren't modified after construction, so are safe to inspect here.
+    size_t read_id_bytes = m_ignored_read_ids.memory_usage();
+    size_t string_set_bytes = m_ignored_read_ids.string_set_memory_usage();
+    if (m_allowed_read_ids) {
+        read_id_bytes += m_allowed_read_ids->memory_usage();
+        string_set_bytes += m_allowed_read_ids->string_set_memory_usage();
+    }
+    stats["read_id_lists_mb"] = static_cast<double>(read_id_bytes) / (1024 * 1024);
+    stats["read_id_lists_saved_mb"] =
+            (static_cast<double>(string_set_bytes) - static_cast<double>(read_id_bytes)) /
+            (1024 * 1024);
+    return stats;
 }
 }  // namespace dorado
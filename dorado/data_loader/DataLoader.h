@@ -1,22 +1,27 @@
 #pragma once
 
+#include "Pod5ChannelIndex.h"
 #include "file_info/file_info.h"
 #include "models/kits.h"
+#include "utils/read_id_set.h"
 #include "utils/stats.h"
 #include "utils/types.h"
 
 #include <array>
+#include <atomic>
 #include <filesystem>
 #include <functional>
-#include <map>
 #include <memory>
 #include <optional>
 #include <set>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
+namespace cxxpool {
+class thread_pool;
+}
+
 namespace dorado {
 
 class Pipeline;
@@ -24,19 +29,15 @@ class ReadCommon;
 class SimplexRead;
 using SimplexReadPtr = std::unique_ptr<SimplexRead>;
 
-constexpr size_t POD5_READ_ID_SIZE = 16;
-using ReadID = std::array<uint8_t, POD5_READ_ID_SIZE>;
-typedef std::map<int, std::vector<ReadID>> channel_to_read_id_t;
-
 class DataLoader {
 public:
     DataLoader(Pipeline& pipeline,
                const std::string& device,
                size_t num_worker_threads,
                size_t max_reads,
-               std::optional<std::unordered_set<std::string>> read_list,
-               std::unordered_set<std::string> read_ignore_list);
-    ~DataLoader() = default;
+               std::optional<utils::ReadIdSet> read_list,
+               utils::ReadIdSet read_ignore_list);
+    ~DataLoader();
 
     // Holds the directory entries for the pod5 or fast5 files from the input path.
     // If there are both fast5 and pod5 only the pod5 will be held.
@@ -61,6 +62,12 @@ public:
         uint32_t read_number;
     };
 
+    // Whether loading reads by channel reuses and saves a channel index next to each POD5 file,
+    // so later runs over the same files don't need to read every row to find its channel.
+    void set_use_channel_index_sidecars(bool use_sidecars) {
+        m_use_channel_index_sidecars = use_sidecars;
+    }
+
     using ReadInitialiserF = std::function<void(ReadCommon&)>;
     void add_read_initialiser(ReadInitialiserF func) {
         m_read_initialisers.push_back(std::move(func));
@@ -73,11 +80,21 @@ public:
             bool recursive_file_loading);
 
 private:
+    // A batch of rows being loaded from a POD5 file.
+    struct Pod5LoadBatch;
+    // Takes the next batch to load, returning false if loading should stop.
+    using Pod5BatchSinkF = std::function<bool(std::unique_ptr<Pod5LoadBatch>)>;
+
     void load_fast5_reads_from_file(const std::string& path);
-    void load_pod5_reads_from_file(const std::string& path);
-    void load_pod5_reads_from_file_by_read_ids(const std::string& path,
-                                               const std::vector<ReadID>& read_ids);
-    void load_read_channels(const std::vector<std::filesystem::directory_entry>& files);
+    void load_pod5_reads_from_files(const std::vector<std::string>& paths);
+    void load_pod5_reads_from_file_by_rows(const std::string& path,
+                                           const std::vector<Pod5ChannelIndex::Entry>& reads);
+    // Runs |produce_batches| on a read-ahead thread, decoding the reads of each batch it
+    // produces on the worker pool while the reads of earlier batches are pushed to the pipeline.
+    void load_pod5_batches(const std::function<void(const Pod5BatchSinkF&)>& produce_batches);
+    // Returns the channel index of each file, or std::nullopt for files that can't be read.
+    std::vector<std::optional<Pod5ChannelIndex>> load_channel_indexes(
+            const std::vector<std::string>& paths);
 
     void load_reads_by_channel(const std::vector<std::filesystem::directory_entry>& files);
     void load_reads_unrestricted(const std::vector<std::filesystem::directory_entry>& files);
@@ -89,13 +106,17 @@ private:
     std::string m_device;
     size_t m_num_worker_threads{1};
     size_t m_max_reads{0};
-    std::optional<std::unordered_set<std::string>> m_allowed_read_ids;
-    std::unordered_set<std::string> m_ignored_read_ids;
+    std::unique_ptr<cxxpool::thread_pool> m_pod5_decode_pool;
+    // Depths of the POD5 loading stages, for stats.
+    std::atomic<size_t> m_pod5_batches_read_ahead{0};
+    std::atomic<size_t> m_pod5_reads_decoding{0};
+    std::atomic<size_t> m_pod5_batches_loaded{0};
+    std::optional<utils::ReadIdSet> m_allowed_read_ids;
+    utils::ReadIdSet m_ignored_read_ids;
 
-    std::unordered_map<std::string, channel_to_read_id_t> m_file_channel_read_order_map;
     std::unordered_map<int, std::vector<ReadSortInfo>> m_reads_by_channel;
     std::unordered_map<std::string, size_t> m_read_id_to_index;
-    int m_max_channel{0};
+    bool m_use_channel_index_sidecars{false};
 
     std::vector<ReadInitialiserF> m_read_initialisers;
 
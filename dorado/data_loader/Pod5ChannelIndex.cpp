@@ -0,0 +1,239 @@
+#include "Pod5ChannelIndex.h"
+
+#include <pod5_format/c_api.h>
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <system_error>
+#include <type_traits>
+
+namespace dorado {
+
+namespace {
+
+// Written at the start of every index file, followed by the format version.
+constexpr std::array<char, 8> INDEX_MAGIC{'D', 'R', 'D', 'C', 'H', 'I', 'D', 'X'};
+constexpr uint32_t INDEX_VERSION = 1;
+
+// Entries are written as-is, so must not contain any padding.
+static_assert(std::is_trivially_copyable_v<Pod5ChannelIndex::Entry>);
+static_assert(sizeof(Pod5ChannelIndex::Entry) ==
+              POD5_READ_ID_SIZE + 2 * sizeof(uint32_t) + sizeof(int32_t) + sizeof(uint32_t));
+
+template <typename T>
+void write_value(std::ostream& stream, const T& value) {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_value(std::istream& stream, T& value) {
+    return bool(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+}  // namespace
+
+std::optional<Pod5ChannelIndex::FileStamp> Pod5ChannelIndex::stamp_file(
+        const std::filesystem::path& pod5_path) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(pod5_path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    const auto modified_time = std::filesystem::last_write_time(pod5_path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return FileStamp{static_cast<uint64_t>(size),
+                     static_cast<int64_t>(modified_time.time_since_epoch().count())};
+}
+
+std::optional<Pod5ChannelIndex> Pod5ChannelIndex::build(const std::filesystem::path& pod5_path) {
+    const auto stamp = stamp_file(pod5_path);
+    if (!stamp) {
+        spdlog::error("Failed to stat file {}", pod5_path.string());
+        return std::nullopt;
+    }
+
+    pod5_init();
+    std::unique_ptr<Pod5FileReader_t, void (*)(Pod5FileReader_t*)> file(
+            pod5_open_file(pod5_path.string().c_str()), [](Pod5FileReader_t* reader) {
+                if (pod5_close_and_free_reader(reader) != POD5_OK) {
+                    spdlog::error("Failed to close and free POD5 reader");
+                }
+            });
+    if (!file) {
+        spdlog::error("Failed to open file {}: {}", pod5_path.string(), pod5_get_error_string());
+        return std::nullopt;
+    }
+
+    std::size_t batch_count = 0;
+    if (pod5_get_read_batch_count(&batch_count, file.get()) != POD5_OK) {
+        spdlog::error("Failed to query batch count: {}", pod5_get_error_string());
+        return std::nullopt;
+    }
+
+    Pod5ChannelIndex index;
+    index.m_pod5_stamp = *stamp;
+    for (std::size_t batch_index = 0; batch_index < batch_count; ++batch_index) {
+        Pod5ReadRecordBatch_t* batch = nullptr;
+        if (pod5_get_read_batch(&batch, file.get(), batch_index) != POD5_OK) {
+            spdlog::error("Failed to get batch: {}", pod5_get_error_string());
+            continue;
+        }
+
+        std::size_t batch_row_count = 0;
+        if (pod5_get_read_batch_row_count(&batch_row_count, batch) != POD5_OK) {
+            spdlog::error("Failed to get batch row count");
+            batch_row_count = 0;
+        }
+
+        for (std::size_t row = 0; row < batch_row_count; ++row) {
+            uint16_t read_table_version = 0;
+            ReadBatchRowInfo_t read_data;
+            if (pod5_get_read_batch_row_info_data(batch, row, READ_BATCH_ROW_INFO_VERSION,
+                                                  &read_data, &read_table_version) != POD5_OK) {
+                spdlog::error("Failed to get read {}", row);
+                continue;
+            }
+
+            Entry entry;
+            std::memcpy(entry.read_id.data(), read_data.read_id, POD5_READ_ID_SIZE);
+            entry.batch = static_cast<uint32_t>(batch_index);
+            entry.row = static_cast<uint32_t>(row);
+            entry.mux = read_data.well;
+            entry.read_number = read_data.read_number;
+            index.m_channels[read_data.channel].push_back(entry);
+            ++index.m_num_reads;
+        }
+
+        if (pod5_free_read_batch(batch) != POD5_OK) {
+            spdlog::error("Failed to release batch");
+        }
+    }
+    return index;
+}
+
+std::optional<Pod5ChannelIndex> Pod5ChannelIndex::load(const std::filesystem::path& pod5_path,
+                                                       const std::filesystem::path& index_path) {
+    std::error_code ec;
+    const auto index_size = std::filesystem::file_size(index_path, ec);
+    std::ifstream stream(index_path, std::ios::binary);
+    if (ec || !stream) {
+        return std::nullopt;
+    }
+
+    std::array<char, INDEX_MAGIC.size()> magic{};
+    uint32_t version = 0;
+    FileStamp saved_stamp;
+    uint32_t num_channels = 0;
+    if (!read_value(stream, magic) || magic != INDEX_MAGIC || !read_value(stream, version) ||
+        version != INDEX_VERSION || !read_value(stream, saved_stamp.size) ||
+        !read_value(stream, saved_stamp.modified_time) || !read_value(stream, num_channels)) {
+        spdlog::debug("Ignoring invalid channel index {}", index_path.string());
+        return std::nullopt;
+    }
+
+    const auto stamp = stamp_file(pod5_path);
+    if (!stamp || stamp->size != saved_stamp.size ||
+        stamp->modified_time != saved_stamp.modified_time) {
+        spdlog::debug("Ignoring out of date channel index {}", index_path.string());
+        return std::nullopt;
+    }
+
+    Pod5ChannelIndex index;
+    index.m_pod5_stamp = saved_stamp;
+    for (uint32_t i = 0; i < num_channels; ++i) {
+        int32_t channel = 0;
+        uint64_t num_entries = 0;
+        // Check the count against the rest of the file before sizing anything from it, dividing
+        // rather than multiplying so that a corrupt count can't overflow.
+        if (!read_value(stream, channel) || !read_value(stream, num_entries) ||
+            num_entries > (index_size - static_cast<uint64_t>(stream.tellg())) / sizeof(Entry)) {
+            spdlog::debug("Ignoring truncated channel index {}", index_path.string());
+            return std::nullopt;
+        }
+        auto& entries = index.m_channels[channel];
+        entries.resize(num_entries);
+        if (!stream.read(reinterpret_cast<char*>(entries.data()), num_entries * sizeof(Entry))) {
+            spdlog::debug("Ignoring truncated channel index {}", index_path.string());
+            return std::nullopt;
+        }
+        index.m_num_reads += num_entries;
+    }
+    return index;
+}
+
+bool Pod5ChannelIndex::save(const std::filesystem::path& index_path) const {
+    // Write to a temporary file first so that an interrupted run can't leave a partial index.
+    auto temp_path = index_path;
+    temp_path += ".tmp";
+    {
+        std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+        if (!stream) {
+            return false;
+        }
+        write_value(stream, INDEX_MAGIC);
+        write_value(stream, INDEX_VERSION);
+        write_value(stream, m_pod5_stamp.size);
+        write_value(stream, m_pod5_stamp.modified_time);
+        write_value(stream, static_cast<uint32_t>(m_channels.size()));
+        for (const auto& [channel, entries] : m_channels) {
+            write_value(stream, static_cast<int32_t>(channel));
+            write_value(stream, static_cast<uint64_t>(entries.size()));
+            stream.write(reinterpret_cast<const char*>(entries.data()),
+                         entries.size() * sizeof(Entry));
+        }
+        if (!stream.flush()) {
+            std::error_code ec;
+            std::filesystem::remove(temp_path, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, index_path, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+std::optional<Pod5ChannelIndex> Pod5ChannelIndex::load_or_build(
+        const std::filesystem::path& pod5_path,
+        bool use_sidecar) {
+    const auto index_path = sidecar_path(pod5_path);
+    if (use_sidecar) {
+        auto index = load(pod5_path, index_path);
+        if (index) {
+            spdlog::trace("Loaded channel index {}", index_path.string());
+            return index;
+        }
+    }
+
+    auto index = build(pod5_path);
+    if (index && use_sidecar) {
+        if (index->save(index_path)) {
+            spdlog::trace("Saved channel index {}", index_path.string());
+        } else {
+            spdlog::debug("Unable to save channel index {}", index_path.string());
+        }
+    }
+    return index;
+}
+
+std::filesystem::path Pod5ChannelIndex::sidecar_path(const std::filesystem::path& pod5_path) {
+    auto index_path = pod5_path;
+    index_path += ".channel_index";
+    return index_path;
+}
+
+const std::vector<Pod5ChannelIndex::Entry>& Pod5ChannelIndex::reads_in_channel(int channel) const {
+    static const std::vector<Entry> no_reads;
+    auto it = m_channels.find(channel);
+    return it != m_channels.end() ? it->second : no_reads;
+}
+
+}  // namespace dorado
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace dorado {
+
+constexpr size_t POD5_READ_ID_SIZE = 16;
+using ReadID = std::array<uint8_t, POD5_READ_ID_SIZE>;
+
+/**
+ * @brief The reads of a POD5 file grouped by channel, with where to find each one in the file.
+ *
+ * Loading reads in channel order needs the channel of every read up front. Building the index
+ * reads the metadata of every row in the file, so it can be saved as a sidecar file next to the
+ * POD5 file and reused by later runs over the same data. A saved index records the size and
+ * modification time of its POD5 file, and is rebuilt if either has changed.
+ */
+class Pod5ChannelIndex {
+public:
+    struct Entry {
+        ReadID read_id;
+        uint32_t batch;
+        uint32_t row;
+        int32_t mux;
+        uint32_t read_number;
+    };
+
+    // Builds the index by reading the metadata of every row in the file.
+    // Returns std::nullopt if the file can't be read.
+    static std::optional<Pod5ChannelIndex> build(const std::filesystem::path& pod5_path);
+
+    // Loads a saved index, returning std::nullopt if it's missing, invalid or out of date.
+    static std::optional<Pod5ChannelIndex> load(const std::filesystem::path& pod5_path,
+                                                const std::filesystem::path& index_path);
+
+    // If |use_sidecar| is set, loads the sidecar index of the file if it's up to date, otherwise
+    // builds the index and tries to save it as the sidecar. Failing to save isn't an error.
+    static std::optional<Pod5ChannelIndex> load_or_build(const std::filesystem::path& pod5_path,
+                                                         bool use_sidecar);
+
+    // Returns true if the index was written.
+    bool save(const std::filesystem::path& index_path) const;
+
+    // Where the sidecar index of a POD5 file is saved.
+    static std::filesystem::path sidecar_path(const std::filesystem::path& pod5_path);
+
+    // The reads in |channel|, in the order they appear in the file.
+    const std::vector<Entry>& reads_in_channel(int channel) const;
+
+    const std::map<int, std::vector<Entry>>& channels() const { return m_channels; }
+    int max_channel() const { return m_channels.empty() ? 0 : m_channels.rbegin()->first; }
+    size_t num_reads() const { return m_num_reads; }
+
+private:
+    struct FileStamp {
+        uint64_t size{0};
+        int64_t modified_time{0};
+    };
+    static std::optional<FileStamp> stamp_file(const std::filesystem::path& pod5_path);
+
+    FileStamp m_pod5_stamp;
+    std::map<int, std::vector<Entry>> m_channels;
+    size_t m_num_reads{0};
+};
+
+}  // namespace dorado
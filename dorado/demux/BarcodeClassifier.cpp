@@ -1,6 +1,7 @@
 #include "BarcodeClassifier.h"
 
 #include "barcoding_info.h"
+#include "splitter/myers.h"
 #include "utils/alignment_utils.h"
 #include "utils/barcode_kits.h"
 #include "utils/sequence_utils.h"
@@ -11,6 +12,7 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -118,6 +120,59 @@ bool barcode_is_permitted(const BarcodeFilterSet& allowed_barcodes,
     return allowed_barcodes->count(normalized_barcode_name) != 0;
 }
 
+std::vector<bool> permitted_barcodes(const BarcodeFilterSet& allowed_barcodes,
+                                     const std::vector<std::string>& barcode_names) {
+    std::vector<bool> permitted(barcode_names.size());
+    for (size_t i = 0; i < barcode_names.size(); i++) {
+        permitted[i] = barcode_is_permitted(allowed_barcodes, barcode_names[i]);
+    }
+    return permitted;
+}
+
+// The barcodes of a kit padded with the flank buffers, as they are aligned against the
+// barcode mask region of a read. If the padded barcodes are short enough then all of them
+// can be scored against a mask region in a single bit-parallel pass.
+struct PaddedBarcodes {
+    std::vector<std::string> sequences;
+    std::optional<splitter::MultiPatternMyers> scorer;
+};
+
+PaddedBarcodes pad_barcodes(const std::string& left_buffer,
+                            const std::vector<std::string>& barcodes,
+                            const std::string& right_buffer) {
+    PaddedBarcodes padded;
+    for (const auto& barcode : barcodes) {
+        padded.sequences.push_back(left_buffer + barcode + right_buffer);
+    }
+    if (!padded.sequences.empty() &&
+        padded.sequences.front().length() <= splitter::MultiPatternMyers::MAX_PATTERN_LENGTH) {
+        padded.scorer.emplace(padded.sequences);
+    }
+    return padded;
+}
+
+// Helper function to globally align each permitted barcode to a region
+// within the read. Penalties of barcodes that aren't permitted are unspecified.
+std::vector<int> extract_barcode_penalties(const PaddedBarcodes& barcodes,
+                                           std::string_view read,
+                                           const std::vector<bool>& permitted,
+                                           const EdlibAlignConfig& config,
+                                           const char* debug_prefix) {
+    // The alignments are only needed for trace logging, otherwise all barcodes
+    // can be scored together.
+    if (barcodes.scorer.has_value() && config.task == EDLIB_TASK_LOC) {
+        return barcodes.scorer->global_edists(read);
+    }
+    std::vector<int> penalties(barcodes.sequences.size(), 0);
+    for (size_t i = 0; i < barcodes.sequences.size(); i++) {
+        if (permitted[i]) {
+            penalties[i] = extract_barcode_penalty(barcodes.sequences[i], read, config,
+                                                   debug_prefix);
+        }
+    }
+    return penalties;
+}
+
 // Helper to extract left buffer from a flank.
 std::string extract_left_buffer(const std::string& flank, int buffer) {
     return flank.substr(std::max(0, static_cast<int>(flank.length()) - buffer));
@@ -170,6 +225,11 @@ struct BarcodeClassifier::BarcodeCandidateKit {
     std::string bottom_context_rev_left_buffer;
     std::string bottom_context_rev_right_buffer;
     std::vector<std::string> barcode_names;
+    // The barcodes padded with the buffers of their context.
+    PaddedBarcodes top_barcodes;
+    PaddedBarcodes top_barcodes_rev;
+    PaddedBarcodes bottom_barcodes;
+    PaddedBarcodes bottom_barcodes_rev;
     // This is the specific barcode kit product name
     // that is selected by the user, such as SQK-RBK114-96
     // or EXP-PBC096
@@ -310,6 +370,19 @@ std::vector<BarcodeClassifier::BarcodeCandidateKit> BarcodeClassifier::generate_
             candidate.barcode_names.push_back(bc_name);
         }
 
+        candidate.top_barcodes =
+                pad_barcodes(candidate.top_context_left_buffer, candidate.barcodes1,
+                             candidate.top_context_right_buffer);
+        candidate.top_barcodes_rev =
+                pad_barcodes(candidate.top_context_rev_left_buffer, candidate.barcodes1_rev,
+                             candidate.top_context_rev_right_buffer);
+        candidate.bottom_barcodes =
+                pad_barcodes(candidate.bottom_context_left_buffer, candidate.barcodes2,
+                             candidate.bottom_context_right_buffer);
+        candidate.bottom_barcodes_rev =
+                pad_barcodes(candidate.bottom_context_rev_left_buffer, candidate.barcodes2_rev,
+                             candidate.bottom_context_rev_right_buffer);
+
         candidates_list.push_back(std::move(candidate));
     }
     spdlog::debug("> Kits to evaluate: {}", candidates_list.size());
@@ -407,34 +480,35 @@ std::vector<BarcodeScoreResult> BarcodeClassifier::calculate_barcode_score_diffe
     spdlog::trace("total v1 edit dist {}, total v2 edit dis {}", total_v1_penalty,
                   total_v2_penalty);
 
+    // Calculate barcode penalties for both variants.
+    const auto permitted = permitted_barcodes(allowed_barcodes, candidate.barcode_names);
+    const auto top_mask_penalties_v1 = extract_barcode_penalties(
+            candidate.top_barcodes, top_mask_v1, permitted, mask_config, "top window v1");
+    const auto bottom_mask_penalties_v1 =
+            extract_barcode_penalties(candidate.bottom_barcodes_rev, bottom_mask_v1, permitted,
+                                      mask_config, "bottom window v1");
+    const auto top_mask_penalties_v2 = extract_barcode_penalties(
+            candidate.bottom_barcodes, top_mask_v2, permitted, mask_config, "top window v2");
+    const auto bottom_mask_penalties_v2 =
+            extract_barcode_penalties(candidate.top_barcodes_rev, bottom_mask_v2, permitted,
+                                      mask_config, "bottom window v2");
+
     std::vector<BarcodeScoreResult> results;
     for (size_t i = 0; i < candidate.barcodes1.size(); i++) {
-        const auto barcode1 = std::string(top_context_v1_left_buffer)
-                                      .append(candidate.barcodes1[i])
-                                      .append(top_context_v1_right_buffer);
-        const auto barcode1_rev = std::string(bottom_context_v2_left_buffer)
-                                          .append(candidate.barcodes1_rev[i])
-                                          .append(bottom_context_v2_right_buffer);
-        const auto barcode2 = std::string(top_context_v2_left_buffer)
-                                      .append(candidate.barcodes2[i])
-                                      .append(top_context_v2_right_buffer);
-        const auto barcode2_rev = std::string(bottom_context_v1_left_buffer)
-                                          .append(candidate.barcodes2_rev[i])
-                                          .append(bottom_context_v1_right_buffer);
-        auto& barcode_name = candidate.barcode_names[i];
-
-        if (!barcode_is_permitted(allowed_barcodes, barcode_name)) {
+        if (!permitted[i]) {
             continue;
         }
 
-        spdlog::trace("Checking barcode {}", barcode_name);
+        const auto& barcode1 = candidate.top_barcodes.sequences[i];
+        const auto& barcode1_rev = candidate.top_barcodes_rev.sequences[i];
+        const auto& barcode2 = candidate.bottom_barcodes.sequences[i];
+        const auto& barcode2_rev = candidate.bottom_barcodes_rev.sequences[i];
+        auto& barcode_name = candidate.barcode_names[i];
 
-        // Calculate barcode penalties for v1.
-        auto top_mask_result_penalty_v1 =
-                extract_barcode_penalty(barcode1, top_mask_v1, mask_config, "top window v1");
+        spdlog::trace("Checking barcode {}", barcode_name);
 
-        auto bottom_mask_result_penalty_v1 = extract_barcode_penalty(
-                barcode2_rev, bottom_mask_v1, mask_config, "bottom window v1");
+        auto top_mask_result_penalty_v1 = top_mask_penalties_v1[i];
+        auto bottom_mask_result_penalty_v1 = bottom_mask_penalties_v1[i];
 
         BarcodeScoreResult v1;
         v1.top_penalty = top_mask_result_penalty_v1;
@@ -451,12 +525,8 @@ std::vector<BarcodeScoreResult> BarcodeClassifier::calculate_barcode_score_diffe
         v1.bottom_barcode_pos = {bottom_start + bottom_result_v1.startLocations[0],
                                  bottom_start + bottom_result_v1.endLocations[0]};
 
-        // Calculate barcode penalties for v2.
-        auto top_mask_result_penalty_v2 =
-                extract_barcode_penalty(barcode2, top_mask_v2, mask_config, "top window v2");
-
-        auto bottom_mask_result_penalty_v2 = extract_barcode_penalty(
-                barcode1_rev, bottom_mask_v2, mask_config, "bottom window v2");
+        auto top_mask_result_penalty_v2 = top_mask_penalties_v2[i];
+        auto bottom_mask_result_penalty_v2 = bottom_mask_penalties_v2[i];
 
         BarcodeScoreResult v2;
         v2.top_penalty = top_mask_result_penalty_v2;
@@ -609,26 +679,25 @@ std::vector<BarcodeScoreResult> BarcodeClassifier::calculate_barcode_score_doubl
     std::string_view bottom_mask =
             read_bottom.substr(bottom_start_idx, bottom_end_idx - bottom_start_idx);
 
+    const auto permitted = permitted_barcodes(allowed_barcodes, candidate.barcode_names);
+    const auto top_mask_penalties = extract_barcode_penalties(
+            candidate.top_barcodes, top_mask, permitted, mask_config, "top window");
+    const auto bottom_mask_penalties = extract_barcode_penalties(
+            candidate.top_barcodes_rev, bottom_mask, permitted, mask_config, "bottom window");
+
     std::vector<BarcodeScoreResult> results;
     for (size_t i = 0; i < candidate.barcodes1.size(); i++) {
-        auto barcode = std::string(top_left_buffer)
-                               .append(candidate.barcodes1[i])
-                               .append(top_right_buffer);
-        auto barcode_rev = std::string(bottom_left_buffer)
-                                   .append(candidate.barcodes1_rev[i])
-                                   .append(bottom_right_buffer);
-        auto& barcode_name = candidate.barcode_names[i];
-
-        if (!barcode_is_permitted(allowed_barcodes, barcode_name)) {
+        if (!permitted[i]) {
             continue;
         }
-        spdlog::trace("Checking barcode {}", barcode_name);
 
-        auto top_mask_penalty =
-                extract_barcode_penalty(barcode, top_mask, mask_config, "top window");
+        const auto& barcode = candidate.top_barcodes.sequences[i];
+        const auto& barcode_rev = candidate.top_barcodes_rev.sequences[i];
+        auto& barcode_name = candidate.barcode_names[i];
+        spdlog::trace("Checking barcode {}", barcode_name);
 
-        auto bottom_mask_penalty =
-                extract_barcode_penalty(barcode_rev, bottom_mask, mask_config, "bottom window");
+        auto top_mask_penalty = top_mask_penalties[i];
+        auto bottom_mask_penalty = bottom_mask_penalties[i];
 
         BarcodeScoreResult res;
         res.barcode_name = barcode_name;
@@ -734,19 +803,21 @@ std::vector<BarcodeScoreResult> BarcodeClassifier::calculate_barcode_score(
 
     spdlog::trace("BC location {}", top_bc_loc);
 
+    const auto permitted = permitted_barcodes(allowed_barcodes, candidate.barcode_names);
+    const auto top_mask_penalties = extract_barcode_penalties(
+            candidate.top_barcodes, top_mask, permitted, mask_config, "top window");
+
     std::vector<BarcodeScoreResult> results;
     for (size_t i = 0; i < candidate.barcodes1.size(); i++) {
-        const auto barcode = candidate.top_context_left_buffer + candidate.barcodes1[i] +
-                             candidate.top_context_right_buffer;
-        auto& barcode_name = candidate.barcode_names[i];
-
-        if (!barcode_is_permitted(allowed_barcodes, barcode_name)) {
+        if (!permitted[i]) {
             continue;
         }
+
+        const auto& barcode = candidate.top_barcodes.sequences[i];
+        auto& barcode_name = candidate.barcode_names[i];
         spdlog::trace("Checking barcode {}", barcode_name);
 
-        auto top_mask_penalty =
-                extract_barcode_penalty(barcode, top_mask, mask_config, "top window");
+        auto top_mask_penalty = top_mask_penalties[i];
 
         BarcodeScoreResult res;
         res.barcode_name = barcode_name;
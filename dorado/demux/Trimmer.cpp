@@ -10,6 +10,11 @@
 #include <htslib/sam.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
 using Slice = at::indexing::Slice;
 
 namespace {
@@ -119,33 +124,65 @@ std::pair<int, int> Trimmer::determine_trim_interval(const AdapterScoreResult& r
 }
 
 BamPtr Trimmer::trim_sequence(bam1_t* input_record, std::pair<int, int> trim_interval) {
-    bool is_seq_reversed = input_record->core.flag & BAM_FREVERSE;
-
-    // Fetch components that need to be trimmed.
-    std::string seq = utils::extract_sequence(input_record);
-    std::vector<uint8_t> qual = utils::extract_quality(input_record);
-    auto [stride, move_vals] = utils::extract_move_table(input_record);
-    int ts = bam_aux_get(input_record, "ts") ? int(bam_aux2i(bam_aux_get(input_record, "ts"))) : -1;
-    int ns = bam_aux_get(input_record, "ns") ? int(bam_aux2i(bam_aux_get(input_record, "ns"))) : -1;
-    auto [modbase_str, modbase_probs] = utils::extract_modbase_info(input_record);
-
-    // Any barcode/primer/adapter detection was done against the fwd sequence, so ensure we trim in that orientation too
-    if (is_seq_reversed) {
-        seq = utils::reverse_complement(seq);
-        std::reverse(std::begin(qual), std::end(qual));
-    }
+    BamPtr output(bam_dup1(input_record));
+    trim_sequence_in_place(output.get(), trim_interval);
+    return output;
+}
 
-    // Actually trim components.
-    auto trimmed_seq = utils::trim_sequence(seq, trim_interval);
-    auto trimmed_qual = utils::trim_quality(qual, trim_interval);
-    auto [positions_trimmed, trimmed_moves] = utils::trim_move_table(move_vals, trim_interval);
+void Trimmer::trim_sequence_in_place(bam1_t* record, std::pair<int, int> trim_interval) {
+    // Any barcode/primer/adapter detection was done against the fwd sequence, so ensure we trim in that orientation too.
+    // Reverse strand records are flipped back to it when their alignment data is stripped.
+    utils::make_record_unmapped(record);
+
+    int ts = bam_aux_get(record, "ts") ? int(bam_aux2i(bam_aux_get(record, "ts"))) : -1;
+    int ns = bam_aux_get(record, "ns") ? int(bam_aux2i(bam_aux_get(record, "ns"))) : -1;
+
+    // The mod base tags are trimmed against the untrimmed sequence, which is only decoded if
+    // there are any.
+    auto [modbase_str, modbase_probs] = utils::extract_modbase_info(record);
+    std::string trimmed_modbase_str;
+    std::vector<uint8_t> trimmed_modbase_probs;
+    if (!modbase_str.empty()) {
+        std::tie(trimmed_modbase_str, trimmed_modbase_probs) = utils::trim_modbase_info(
+                utils::extract_sequence(record), modbase_str, modbase_probs, trim_interval);
+    }
 
-    if (move_vals.empty()) {
+    // Trim the move table in place. The moves of the kept bases are contiguous, so all that's
+    // needed is to remove the moves either side of them, keeping the stride in front.
+    auto move_table = bam_aux_get(record, "mv");
+    const uint32_t move_table_len = move_table ? bam_auxB_len(move_table) : 0;
+    if (move_table_len <= 1) {
         ns = -1;
         ts = -1;
     } else {
+        const int stride = int(bam_auxB2i(move_table, 0));
+        uint32_t positions_trimmed = 0;
+        uint32_t num_trimmed_moves = 0;
+        // Start with -1 because as soon as the first move_val==1 is encountered,
+        // we have moved to the first base.
+        int seq_base_pos = -1;
+        for (uint32_t i = 1; i < move_table_len; ++i) {
+            if (bam_auxB2i(move_table, i) == 1) {
+                seq_base_pos++;
+            }
+            if (seq_base_pos >= trim_interval.second) {
+                break;
+            } else if (seq_base_pos >= trim_interval.first) {
+                num_trimmed_moves++;
+            } else {
+                positions_trimmed++;
+            }
+        }
+
+        if (num_trimmed_moves > 0) {
+            const uint32_t trimmed_moves_end = 1 + positions_trimmed + num_trimmed_moves;
+            utils::remove_aux_array_elements(record, move_table, trimmed_moves_end,
+                                             move_table_len - trimmed_moves_end);
+            utils::remove_aux_array_elements(record, move_table, 1, positions_trimmed);
+        }
+
         if (ts >= 0) {
-            ts += positions_trimmed * stride;
+            ts += int(positions_trimmed) * stride;
         }
         if (ns >= 0) {
             // After sequence trimming, the number of samples corresponding to the sequence is the size of
@@ -153,48 +190,32 @@ BamPtr Trimmer::trim_sequence(bam1_t* input_record, std::pair<int, int> trim_int
             // the front of the read as well. If ts is negative, the tag is not present, so treat it as 0.
             // |---------------------- ns ------------------|
             // |----ts----|--------moves signal-------------|
-            ns = int(trimmed_moves.size() * stride) + std::max(0, ts);
+            ns = int(num_trimmed_moves) * stride + std::max(0, ts);
         }
     }
 
-    auto [trimmed_modbase_str, trimmed_modbase_probs] =
-            utils::trim_modbase_info(seq, modbase_str, modbase_probs, trim_interval);
-
-    // Create a new bam record to hold the trimmed read.
-    BamPtr output(utils::new_unmapped_record(input_record, trimmed_seq, trimmed_qual));
-    bam1_t* out_record = output.get();
-
-    // Insert the new tags and delete the old ones.
-    if (!trimmed_moves.empty()) {
-        bam_aux_del(out_record, bam_aux_get(out_record, "mv"));
-        // Move table format is stride followed by moves.
-        trimmed_moves.insert(trimmed_moves.begin(), uint8_t(stride));
-        bam_aux_update_array(out_record, "mv", 'c', int(trimmed_moves.size()),
-                             (uint8_t*)trimmed_moves.data());
-    }
+    // Actually trim the sequence. This shifts the aux data, so any pointers to tags are invalid
+    // from here on.
+    utils::trim_record_sequence(record, trim_interval);
 
     if (!trimmed_modbase_str.empty()) {
-        bam_aux_del(out_record, bam_aux_get(out_record, "MM"));
-        bam_aux_append(out_record, "MM", 'Z', int(trimmed_modbase_str.length() + 1),
-                       (uint8_t*)trimmed_modbase_str.c_str());
-        bam_aux_del(out_record, bam_aux_get(out_record, "ML"));
-        bam_aux_update_array(out_record, "ML", 'C', int(trimmed_modbase_probs.size()),
-                             (uint8_t*)trimmed_modbase_probs.data());
-        bam_aux_update_int(out_record, "MN", trimmed_seq.length());
+        bam_aux_update_str(record, "MM", int(trimmed_modbase_str.length() + 1),
+                           trimmed_modbase_str.c_str());
+        bam_aux_update_array(record, "ML", 'C', uint32_t(trimmed_modbase_probs.size()),
+                             trimmed_modbase_probs.data());
+        bam_aux_update_int(record, "MN", record->core.l_qseq);
     }
 
     if (ts >= 0) {
-        bam_aux_update_int(out_record, "ts", ts);
-    } else if (bam_aux_get(out_record, "ts")) {
-        bam_aux_del(out_record, bam_aux_get(out_record, "ts"));
+        bam_aux_update_int(record, "ts", ts);
+    } else if (bam_aux_get(record, "ts")) {
+        bam_aux_del(record, bam_aux_get(record, "ts"));
     }
     if (ns >= 0) {
-        bam_aux_update_int(out_record, "ns", ns);
-    } else if (bam_aux_get(out_record, "ns")) {
-        bam_aux_del(out_record, bam_aux_get(out_record, "ns"));
+        bam_aux_update_int(record, "ns", ns);
+    } else if (bam_aux_get(record, "ns")) {
+        bam_aux_del(record, bam_aux_get(record, "ns"));
     }
-
-    return output;
 }
 
 void Trimmer::trim_sequence(SimplexRead& read, std::pair<int, int> trim_interval) {
@@ -14,6 +14,8 @@ struct BarcodeScoreResult;
 class Trimmer {
 public:
     static BamPtr trim_sequence(bam1_t* irecord, std::pair<int, int> interval);
+    // Same as trim_sequence, but trims the record in place rather than a copy of it.
+    static void trim_sequence_in_place(bam1_t* record, std::pair<int, int> interval);
     static void trim_sequence(SimplexRead& read, std::pair<int, int> interval);
     static std::pair<int, int> determine_trim_interval(const BarcodeScoreResult& res, int seqlen);
     static std::pair<int, int> determine_trim_interval(const AdapterScoreResult& res, int seqlen);
@@ -7,6 +7,8 @@
 
 #include <algorithm>
 #include <memory>
+#include <stdexcept>
+#include <string>
 
 struct CharDestructor {
     void operator()(char* ptr) { hts_free(ptr); };
@@ -76,4 +78,11 @@ std::vector<uint8_t> FastxRandomReader::fetch_qual(const std::string& read_id) c
 
 int FastxRandomReader::num_entries() const { return faidx_nseq(m_faidx.get()); }
 
+std::string_view FastxRandomReader::read_name(const int id) const {
+    if ((id < 0) || (id >= num_entries())) {
+        throw std::out_of_range("Read ID " + std::to_string(id) + " is not in the FASTx index.");
+    }
+    return faidx_iseq(m_faidx.get(), id);
+}
+
 }  // namespace dorado::hts_io
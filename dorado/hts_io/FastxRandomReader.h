@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Class to wrap reading randomly from a FASTx
@@ -27,6 +28,9 @@ public:
     std::vector<uint8_t> fetch_qual(const std::string& read_id) const;
 
     int num_entries() const;
+
+    // Name of the |id|-th read in the index, which lives as long as the reader.
+    std::string_view read_name(int id) const;
 };
 
 }  // namespace dorado::hts_io
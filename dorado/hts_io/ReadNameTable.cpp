@@ -0,0 +1,23 @@
+#include "ReadNameTable.h"
+
+#include <spdlog/spdlog.h>
+
+namespace dorado::hts_io {
+
+ReadNameTable::ReadNameTable(const std::filesystem::path& fastx_path)
+        : m_reader(fastx_path), m_num_reads(m_reader.num_entries()) {
+    m_ids.reserve(m_num_reads);
+    for (int32_t id = 0; id < m_num_reads; ++id) {
+        m_ids.emplace(m_reader.read_name(id), id);
+    }
+    spdlog::debug("Assigned IDs to {} reads from {}.", m_num_reads, fastx_path.string());
+}
+
+int32_t ReadNameTable::find(const std::string_view name) const {
+    const auto it = m_ids.find(name);
+    return (it != m_ids.end()) ? it->second : -1;
+}
+
+std::string_view ReadNameTable::name(const int32_t id) const { return m_reader.read_name(id); }
+
+}  // namespace dorado::hts_io
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "FastxRandomReader.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+namespace dorado::hts_io {
+
+/**
+ * @brief Dense integer IDs for the reads of a FASTx file.
+ *
+ * The ID of a read is its position in the FASTx index, and the names are the ones held by the
+ * index itself, so the table only adds the lookup from names to IDs. It's immutable once built,
+ * so it can be shared between threads without locking.
+ */
+class ReadNameTable {
+public:
+    explicit ReadNameTable(const std::filesystem::path& fastx_path);
+
+    // Returns -1 if there is no read with this name.
+    int32_t find(std::string_view name) const;
+
+    // Throws if the ID is out of range.
+    std::string_view name(int32_t id) const;
+
+    int32_t size() const { return m_num_reads; }
+
+private:
+    FastxRandomReader m_reader;
+    int32_t m_num_reads{0};
+    std::unordered_map<std::string_view, int32_t> m_ids;
+};
+
+}  // namespace dorado::hts_io
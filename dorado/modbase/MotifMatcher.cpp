@@ -4,8 +4,7 @@
 
 #include <nvtx3/nvtx3.hpp>
 
-#include <iterator>
-#include <regex>
+#include <stdexcept>
 #include <unordered_map>
 
 namespace {
@@ -17,28 +16,21 @@ const std::unordered_map<char, std::string> IUPAC_CODES =
         {'G', "G"},
         {'T', "T"},
         {'U', "T"},  // basecalls will have "T"s instead of "U"s
-        {'R', "[AG]"},
-        {'Y', "[CT]"}, 
-        {'S', "[GC]"}, 
-        {'W', "[AT]"},
-        {'K', "[GT]"}, 
-        {'M', "[AC]"}, 
-        {'B', "[CGT]"},
-        {'D', "[AGT]"},
-        {'H', "[ACT]"},
-        {'V', "[ACG]"},
-        {'N', "[ACGT]"},
+        {'R', "AG"},
+        {'Y', "CT"}, 
+        {'S', "GC"}, 
+        {'W', "AT"},
+        {'K', "GT"}, 
+        {'M', "AC"}, 
+        {'B', "CGT"},
+        {'D', "AGT"},
+        {'H', "ACT"},
+        {'V', "ACG"},
+        {'N', "ACGT"},
                 // clang-format on
 };
 
-std::string expand_motif_regex(const std::string& motif) {
-    std::string motif_regex = "(";
-    for (auto base : motif) {
-        motif_regex += IUPAC_CODES.at(base);
-    }
-    motif_regex += ")";
-    return motif_regex;
-}
+constexpr size_t MAX_MOTIF_SIZE = 64;
 
 }  // namespace
 
@@ -48,23 +40,31 @@ MotifMatcher::MotifMatcher(const ModBaseModelConfig& model_config)
         : MotifMatcher(model_config.mods.motif, model_config.mods.motif_offset) {}
 
 MotifMatcher::MotifMatcher(const std::string& motif, size_t offset)
-        : m_motif(expand_motif_regex(motif)), m_motif_offset(offset) {}
+        : m_motif_size(motif.size()), m_motif_offset(offset) {
+    if (motif.empty() || motif.size() > MAX_MOTIF_SIZE) {
+        throw std::runtime_error("Invalid motif '" + motif + "': length must be between 1 and " +
+                                 std::to_string(MAX_MOTIF_SIZE) + ".");
+    }
+    for (size_t i = 0; i < motif.size(); ++i) {
+        for (auto base : IUPAC_CODES.at(motif[i])) {
+            m_base_masks[static_cast<uint8_t>(base)] |= uint64_t{1} << i;
+        }
+    }
+    m_accept_bit = uint64_t{1} << (motif.size() - 1);
+}
 
 std::vector<size_t> MotifMatcher::get_motif_hits(std::string_view seq) const {
     NVTX3_FUNC_RANGE();
     std::vector<size_t> context_hits;
 
-    std::regex regex(m_motif);
-    auto start = std::cbegin(seq);
-    auto end = std::cend(seq);
-    auto pos = start;
-    // string_view on linux uses `const_iterator=const char*`,
-    // but on Windows it's a `std::_String_view_iterator<_Traits>`
-    std::match_results<decltype(pos)> motif_match;
-    while (std::regex_search(pos, end, motif_match, regex)) {
-        auto hit = std::distance(start, pos) + motif_match.position(0) + m_motif_offset;
-        context_hits.push_back(hit);
-        pos += motif_match.position(0) + 1;
+    // Bit i of |state| is set if seq[pos - i, pos] matches the first i + 1 bases of the motif,
+    // so every (possibly overlapping) hit is reported as soon as its last base is consumed.
+    uint64_t state = 0;
+    for (size_t pos = 0; pos < seq.size(); ++pos) {
+        state = ((state << 1) | 1) & m_base_masks[static_cast<uint8_t>(seq[pos])];
+        if (state & m_accept_bit) {
+            context_hits.push_back(pos + 1 - m_motif_size + m_motif_offset);
+        }
     }
     return context_hits;
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -15,7 +17,11 @@ public:
     std::vector<size_t> get_motif_hits(std::string_view seq) const;
 
 private:
-    const std::string m_motif;
+    // Shift-and automaton compiled from the IUPAC motif: bit i of m_base_masks[c] is set
+    // if base c is accepted at position i of the motif.
+    std::array<uint64_t, 256> m_base_masks{};
+    uint64_t m_accept_bit = 0;
+    const size_t m_motif_size;
     const size_t m_motif_offset;
 };
 
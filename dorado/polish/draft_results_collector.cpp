@@ -0,0 +1,141 @@
+#include "draft_results_collector.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace dorado::polisher {
+
+DraftResultsCollector::DraftResultsCollector(const int32_t num_drafts)
+        : m_drafts(std::max(num_drafts, 0)) {
+    for (int32_t seq_id = 0; seq_id < num_drafts; ++seq_id) {
+        m_drafts[seq_id].results.seq_id = seq_id;
+    }
+}
+
+DraftResultsCollector::DraftState& DraftResultsCollector::get_draft(const int32_t seq_id) {
+    if ((seq_id < 0) || (seq_id >= static_cast<int32_t>(std::size(m_drafts)))) {
+        throw std::out_of_range("Draft ID out of bounds in DraftResultsCollector! seq_id = " +
+                                std::to_string(seq_id) +
+                                ", num_drafts = " + std::to_string(std::size(m_drafts)));
+    }
+    DraftState& draft = m_drafts[seq_id];
+    if (!draft.started) {
+        draft.started = true;
+        ++m_num_in_flight;
+    }
+    return draft;
+}
+
+bool DraftResultsCollector::is_next_complete() const {
+    if (m_next_seq_id >= static_cast<int32_t>(std::size(m_drafts))) {
+        return false;
+    }
+    const DraftState& draft = m_drafts[m_next_seq_id];
+    return draft.sealed && (draft.num_pending == 0);
+}
+
+void DraftResultsCollector::add_samples(const int32_t seq_id, const int64_t num_samples) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DraftState& draft = get_draft(seq_id);
+    if (draft.sealed) {
+        throw std::runtime_error("Cannot add samples to a sealed draft! seq_id = " +
+                                 std::to_string(seq_id));
+    }
+    draft.num_pending += num_samples;
+}
+
+void DraftResultsCollector::seal(const int32_t seq_id) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        get_draft(seq_id).sealed = true;
+        if (!is_next_complete()) {
+            return;
+        }
+    }
+    m_cv.notify_all();
+}
+
+void DraftResultsCollector::add_results(const std::vector<int32_t>& sample_seq_ids,
+                                        std::vector<ConsensusResult> results_cons,
+                                        std::vector<VariantCallingSample> results_vc_data) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto& result : results_cons) {
+            if (result.draft_id < 0) {
+                continue;
+            }
+            if (result.draft_id < m_next_seq_id) {
+                spdlog::error("Consensus result received for an already processed draft ID: {}",
+                              result.draft_id);
+                continue;
+            }
+            get_draft(result.draft_id).results.results_cons.emplace_back(std::move(result));
+        }
+
+        for (auto& vc_sample : results_vc_data) {
+            if (vc_sample.seq_id < 0) {
+                continue;
+            }
+            if (vc_sample.seq_id < m_next_seq_id) {
+                spdlog::error("Variant calling data received for an already processed draft ID: {}",
+                              vc_sample.seq_id);
+                continue;
+            }
+            get_draft(vc_sample.seq_id).results.results_vc_data.emplace_back(std::move(vc_sample));
+        }
+
+        for (const int32_t seq_id : sample_seq_ids) {
+            DraftState& draft = get_draft(seq_id);
+            if (draft.num_pending <= 0) {
+                throw std::runtime_error("More samples decoded than produced for draft ID: " +
+                                         std::to_string(seq_id));
+            }
+            --draft.num_pending;
+        }
+
+        if (!is_next_complete()) {
+            return;
+        }
+    }
+    m_cv.notify_all();
+}
+
+bool DraftResultsCollector::pop_ready(std::vector<DraftResults>& ready) {
+    ready.clear();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]() {
+        return is_next_complete() || m_terminated ||
+               (m_next_seq_id >= static_cast<int32_t>(std::size(m_drafts)));
+    });
+
+    while (is_next_complete()) {
+        DraftState& draft = m_drafts[m_next_seq_id];
+        ready.emplace_back(std::move(draft.results));
+        draft.results = {};
+        --m_num_in_flight;
+        ++m_next_seq_id;
+    }
+
+    return !std::empty(ready);
+}
+
+void DraftResultsCollector::terminate() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_terminated = true;
+    }
+    m_cv.notify_all();
+}
+
+int32_t DraftResultsCollector::num_in_flight() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_num_in_flight;
+}
+
+}  // namespace dorado::polisher
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "consensus_result.h"
+#include "variant_calling_sample.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace dorado::polisher {
+
+/**
+ * \brief Decoded results of all samples of one draft sequence, ready for stitching and variant calling.
+ */
+struct DraftResults {
+    int32_t seq_id = -1;
+    std::vector<ConsensusResult> results_cons;
+    std::vector<VariantCallingSample> results_vc_data;
+};
+
+/**
+ * \brief Collects the decoded results of each draft sequence while its samples are still in flight, so that
+ *          a draft can be stitched and variant called as soon as all of its samples are decoded, while the
+ *          following drafts are still being inferred.
+ *          The producer announces the samples of a draft before pushing them for inference, and seals the draft
+ *          once all of its samples have been announced. The decoders report every decoded sample, even if it
+ *          yielded no results. Completed drafts are handed out in the order of their IDs, so that the output
+ *          stays sorted, and only the drafts which are in flight or waiting on an earlier draft are held in memory.
+ *          Thread safe.
+ */
+class DraftResultsCollector {
+public:
+    explicit DraftResultsCollector(const int32_t num_drafts);
+
+    /**
+     * \brief Announces num_samples more samples of the draft, which will be reported by the decoders.
+     */
+    void add_samples(const int32_t seq_id, const int64_t num_samples);
+
+    /**
+     * \brief Marks that no more samples will be announced for the draft. Sealing a draft twice is allowed.
+     */
+    void seal(const int32_t seq_id);
+
+    /**
+     * \brief Reports the decoded samples of one batch. The results are assigned to drafts by their draft_id
+     *          and seq_id respectively, and results with a negative ID (filtered samples) are dropped.
+     * \param sample_seq_ids Draft ID of each decoded sample in the batch.
+     */
+    void add_results(const std::vector<int32_t>& sample_seq_ids,
+                     std::vector<ConsensusResult> results_cons,
+                     std::vector<VariantCallingSample> results_vc_data);
+
+    /**
+     * \brief Blocks until the next draft in order is complete, and moves it and all the complete drafts
+     *          which directly follow it into the ready vector. The IDs of the returned drafts are consecutive.
+     * \returns False once all drafts have been handed out, or when terminated and the next draft is not complete.
+     */
+    bool pop_ready(std::vector<DraftResults>& ready);
+
+    /**
+     * \brief Wakes up the consumer after no more samples will be reported, e.g. on an error upstream.
+     */
+    void terminate();
+
+    /**
+     * \brief Number of drafts which have been started but not handed out yet.
+     */
+    int32_t num_in_flight() const;
+
+private:
+    struct DraftState {
+        int64_t num_pending = 0;
+        bool started = false;
+        bool sealed = false;
+        DraftResults results;
+    };
+
+    DraftState& get_draft(const int32_t seq_id);
+    bool is_next_complete() const;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<DraftState> m_drafts;
+    int32_t m_next_seq_id = 0;
+    int32_t m_num_in_flight = 0;
+    bool m_terminated = false;
+};
+
+}  // namespace dorado::polisher
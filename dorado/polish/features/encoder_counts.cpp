@@ -317,10 +317,10 @@ Sample EncoderCounts::encode_region(BamFile& bam_file,
     // NOTE: the `num_qstrat` is passed into the `num_homop` parameter as is done in `pileup_counts` in features.py.
     CountsResult pileup_tensors;
     try {
-        PileupData pileup =
-                calculate_pileup(bam_file, ref_name, ref_start, ref_end, m_num_dtypes, m_dtypes,
-                                 num_qstrat, m_tag_name, m_tag_value, m_tag_keep_missing,
-                                 weibull_summation, m_read_group, m_min_mapq);
+        PileupData pileup = calculate_pileup_from_cigars(
+                bam_file, ref_name, ref_start, ref_end, m_num_dtypes, m_dtypes, num_qstrat,
+                m_tag_name, m_tag_value, m_tag_keep_missing, weibull_summation, m_read_group,
+                m_min_mapq);
 
         // Create Torch tensors from the pileup.
         const size_t n_rows = std::size(PILEUP_BASES) * m_num_dtypes * num_qstrat;
@@ -5,12 +5,16 @@
 #include <htslib/sam.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <ostream>
+#include <queue>
+#include <stdexcept>
 #include <unordered_set>
 
 #define bam1_seq(b) ((b)->data + (b)->core.n_cigar * 4 + (b)->core.l_qname)
@@ -78,6 +82,23 @@ void print_pileup_data(std::ostream &os,
     }
 }
 
+namespace {
+
+// Fills the first num_homop elements of fraction_counts with the homopolymer scores given by
+// Weibull scale and shape parameters.
+void fill_weibull_scores(const float scale,
+                         const float shape,
+                         const int64_t num_homop,
+                         float *fraction_counts) {
+    for (int64_t x = 1; x < (num_homop + 1); ++x) {
+        float a = std::pow((x - 1) / scale, shape);
+        float b = std::pow(x / scale, shape);
+        fraction_counts[x - 1] = std::fmax(0.0f, -std::exp(-a) * std::expm1(a - b));
+    }
+}
+
+}  // namespace
+
 std::vector<float> _get_weibull_scores(const bam_pileup1_t *p,
                                        const int64_t indel,
                                        const int64_t num_homop,
@@ -111,11 +132,7 @@ std::vector<float> _get_weibull_scores(const bam_pileup1_t *p,
     // Found tags, fill in values.
     const float scale = static_cast<float>(wtag_vals[0]);  //wl
     const float shape = static_cast<float>(wtag_vals[1]);  //wk
-    for (int64_t x = 1; x < (num_homop + 1); ++x) {
-        float a = std::pow((x - 1) / scale, shape);
-        float b = std::pow(x / scale, shape);
-        fraction_counts[x - 1] = std::fmax(0.0f, -std::exp(-a) * std::expm1(a - b));
-    }
+    fill_weibull_scores(scale, shape, num_homop, std::data(fraction_counts));
     return fraction_counts;
 }
 
@@ -324,4 +341,352 @@ PileupData calculate_pileup(BamFile &bam_file,
     return pileup;
 }
 
+namespace {
+
+// Default maximum depth of htslib's mpileup, which calculate_pileup doesn't change.
+constexpr int64_t MPILEUP_MAX_DEPTH = 8000;
+
+// Counts the bases of one alignment into the buffers of calculate_pileup_from_cigars.
+class CigarPileupCounter {
+public:
+    CigarPileupCounter(const int64_t start,
+                       const int64_t end,
+                       const int64_t num_dtypes,
+                       const std::vector<std::string> &dtypes,
+                       const int64_t num_homop,
+                       const bool weibull_summation)
+            : m_start{start},
+              m_end{end},
+              m_num_dtypes{num_dtypes},
+              m_dtypes{dtypes},
+              m_num_homop{num_homop},
+              m_weibull_summation{weibull_summation},
+              m_featlen{PILEUP_BASES_SIZE * num_dtypes * num_homop},
+              m_major_counts(static_cast<size_t>((end - start) * m_featlen), 0),
+              m_insertion_counts(end - start),
+              m_max_insertion(end - start, 0),
+              m_coverage_delta(end - start + 1, 0),
+              m_fraction_counts(num_homop, 0.0f) {}
+
+    void add_alignment(const bam1_t *b);
+
+    // Lays out the counts as the columns of the pileup.
+    PileupData build_pileup() const;
+
+private:
+    int32_t find_dtype(const bam1_t *b) const;
+    bool fetch_weibull_tags(const bam1_t *b);
+    // Adds the base at query_pos to the features at row.
+    void count_base(int64_t *row, const int64_t query_pos);
+    int64_t *insertion_row(const int64_t index, const int64_t minor);
+
+    const int64_t m_start;
+    const int64_t m_end;
+    const int64_t m_num_dtypes;
+    const std::vector<std::string> &m_dtypes;
+    const int64_t m_num_homop;
+    const bool m_weibull_summation;
+    const int64_t m_featlen;
+
+    // Counts at each reference position in the region.
+    std::vector<int64_t> m_major_counts;
+    // Counts of the bases inserted after each reference position, one row per inserted base.
+    std::vector<std::vector<int64_t>> m_insertion_counts;
+    std::vector<int32_t> m_max_insertion;
+    // Change in the number of alignments covering each position, relative to the previous one.
+    std::vector<int32_t> m_coverage_delta;
+
+    // State of the alignment being counted.
+    const bam1_t *m_record = nullptr;
+    const uint8_t *m_seq = nullptr;
+    const uint8_t *m_qual = nullptr;
+    int32_t m_strand_offset = 0;
+    int64_t m_dtype_offset = 0;
+    const uint8_t *m_weibull_tags[2] = {nullptr, nullptr};
+    std::vector<float> m_fraction_counts;
+};
+
+int32_t CigarPileupCounter::find_dtype(const bam1_t *b) const {
+    if (m_num_dtypes == 1) {
+        return 0;
+    }
+    const uint8_t *tag = bam_aux_get(b, std::data(DATATYPE_TAG));
+    const char *tag_val = tag ? bam_aux2Z(tag) : nullptr;
+    if (tag_val) {
+        const int32_t num_named = static_cast<int32_t>(std::min<int64_t>(
+                m_num_dtypes, static_cast<int64_t>(std::size(m_dtypes))));
+        for (int32_t dtype = 0; dtype < num_named; ++dtype) {
+            if (m_dtypes[dtype] == tag_val) {
+                return dtype;
+            }
+        }
+    }
+    throw std::runtime_error("Datatype not found for '" + std::string(bam_get_qname(b)) + "'.");
+}
+
+bool CigarPileupCounter::fetch_weibull_tags(const bam1_t *b) {
+    static const char *wtags[] = {"WL", "WK"};  // scale, shape
+    for (int64_t i = 0; i < 2; ++i) {
+        m_weibull_tags[i] = bam_aux_get(b, wtags[i]);
+        if (m_weibull_tags[i] == nullptr) {
+            spdlog::warn("Failed to retrieve Weibull parameter tag '{}' for read {}.", wtags[i],
+                         bam_get_qname(b));
+            return false;
+        }
+    }
+    return true;
+}
+
+void CigarPileupCounter::count_base(int64_t *row, const int64_t query_pos) {
+    const int32_t base_i = NUM_TO_COUNT_BASE[bam_seqi(m_seq, query_pos) + m_strand_offset];
+    if (base_i == -1) {  // An ambiguity code.
+        return;
+    }
+    int64_t *counts = row + m_dtype_offset + base_i;
+
+    if (m_weibull_summation) {
+        if (m_weibull_tags[0] == nullptr) {
+            return;
+        }
+        float wtag_vals[2] = {0.0f, 0.0f};
+        for (int64_t i = 0; i < 2; ++i) {
+            const uint32_t taglen = bam_auxB_len(m_weibull_tags[i]);
+            if (query_pos >= taglen) {
+                spdlog::warn("Weibull tag was out of range for {} position {}. taglen: {}",
+                             bam_get_qname(m_record), query_pos, taglen);
+                return;
+            }
+            wtag_vals[i] = static_cast<float>(
+                    bam_auxB2f(m_weibull_tags[i], static_cast<uint32_t>(query_pos)));
+        }
+        fill_weibull_scores(wtag_vals[0], wtag_vals[1], m_num_homop, std::data(m_fraction_counts));
+        for (int64_t qstrat = 0; qstrat < m_num_homop; ++qstrat) {
+            static const int32_t scale = 10000;
+            counts[PILEUP_BASES_SIZE * qstrat] +=
+                    static_cast<int64_t>(scale * m_fraction_counts[qstrat]);
+        }
+    } else {
+        int32_t qstrat = 0;
+        if (m_num_homop > 1) {
+            // want something in [0, num_homop-1]
+            qstrat = static_cast<int32_t>(std::min<int64_t>(m_qual[query_pos], m_num_homop));
+            qstrat = std::max(0, qstrat - 1);
+        }
+        counts[PILEUP_BASES_SIZE * qstrat] += 1;
+    }
+}
+
+int64_t *CigarPileupCounter::insertion_row(const int64_t index, const int64_t minor) {
+    auto &insertions = m_insertion_counts[index];
+    const size_t required = static_cast<size_t>(minor * m_featlen);
+    if (std::size(insertions) < required) {
+        insertions.resize(required, 0);
+    }
+    return std::data(insertions) + (minor - 1) * m_featlen;
+}
+
+void CigarPileupCounter::add_alignment(const bam1_t *b) {
+    m_record = b;
+    m_seq = bam_get_seq(b);
+    m_qual = bam_get_qual(b);
+    m_strand_offset = bam_is_rev(b) ? 16 : 0;
+    m_dtype_offset = PILEUP_BASES_SIZE * find_dtype(b) * m_num_homop;
+    if (m_weibull_summation && !fetch_weibull_tags(b)) {
+        m_weibull_tags[0] = nullptr;
+    }
+
+    const uint32_t *cigar = bam_get_cigar(b);
+    const int64_t del_base = bam_is_rev(b) ? PILEUP_POS_DEL_REV : PILEUP_POS_DEL_FWD;
+    int64_t ref_pos = b->core.pos;
+    int64_t query_pos = 0;
+
+    // Insertions are placed after the last reference position of the preceding M, D or N
+    // operation, as mpileup does. Padding between insertions doesn't break them up.
+    bool has_anchor = false;
+    bool anchor_is_refskip = false;
+    int64_t anchor_minor = 0;
+
+    for (uint32_t k = 0; k < b->core.n_cigar; ++k) {
+        const int32_t op = bam_cigar_op(cigar[k]);
+        const int64_t len = bam_cigar_oplen(cigar[k]);
+        const int64_t overlap_start = std::max(ref_pos, m_start);
+        const int64_t overlap_end = std::min(ref_pos + len, m_end);
+
+        switch (op) {
+        case BAM_CMATCH:
+        case BAM_CEQUAL:
+        case BAM_CDIFF:
+            for (int64_t pos = overlap_start; pos < overlap_end; ++pos) {
+                count_base(std::data(m_major_counts) + (pos - m_start) * m_featlen,
+                           query_pos + (pos - ref_pos));
+            }
+            ref_pos += len;
+            query_pos += len;
+            has_anchor = true;
+            anchor_is_refskip = false;
+            anchor_minor = 0;
+            break;
+        case BAM_CDEL:
+            // Deletions are kept in the first layer of qscore stratification, if any.
+            for (int64_t pos = overlap_start; pos < overlap_end; ++pos) {
+                m_major_counts[(pos - m_start) * m_featlen + m_dtype_offset + del_base] += 1;
+            }
+            ref_pos += len;
+            has_anchor = true;
+            anchor_is_refskip = false;
+            anchor_minor = 0;
+            break;
+        case BAM_CREF_SKIP:
+            ref_pos += len;
+            has_anchor = true;
+            anchor_is_refskip = true;
+            anchor_minor = 0;
+            break;
+        case BAM_CINS: {
+            const int64_t anchor_pos = ref_pos - 1;
+            if (has_anchor && (anchor_pos >= m_start) && (anchor_pos < m_end)) {
+                const int64_t index = anchor_pos - m_start;
+                // Reference skips still widen the column, but their bases aren't counted.
+                if (!anchor_is_refskip) {
+                    for (int64_t i = 0; i < len; ++i) {
+                        count_base(insertion_row(index, anchor_minor + i + 1), query_pos + i);
+                    }
+                }
+                m_max_insertion[index] = std::max(m_max_insertion[index],
+                                                  static_cast<int32_t>(anchor_minor + len));
+            }
+            anchor_minor += len;
+            query_pos += len;
+            break;
+        }
+        case BAM_CSOFT_CLIP:
+            query_pos += len;
+            has_anchor = false;
+            break;
+        case BAM_CPAD:
+            break;
+        default:
+            has_anchor = false;
+            break;
+        }
+    }
+
+    // Alignments which don't consume the reference don't appear in the pileup.
+    const int64_t covered_start = std::max<int64_t>(b->core.pos, m_start);
+    const int64_t covered_end = std::min(ref_pos, m_end);
+    if (covered_start < covered_end) {
+        ++m_coverage_delta[covered_start - m_start];
+        --m_coverage_delta[covered_end - m_start];
+    }
+}
+
+PileupData CigarPileupCounter::build_pileup() const {
+    const int64_t region_len = m_end - m_start;
+
+    // Only positions which are covered by at least one alignment have columns.
+    std::vector<bool> covered(region_len, false);
+    int64_t n_cols = 0;
+    int32_t depth = 0;
+    for (int64_t i = 0; i < region_len; ++i) {
+        depth += m_coverage_delta[i];
+        covered[i] = depth > 0;
+        if (covered[i]) {
+            n_cols += 1 + m_max_insertion[i];
+        }
+    }
+
+    PileupData pileup(n_cols, n_cols, m_num_dtypes, m_num_homop, 0);
+    int64_t col = 0;
+    for (int64_t i = 0; i < region_len; ++i) {
+        if (!covered[i]) {
+            continue;
+        }
+        const auto major_row = std::begin(m_major_counts) + i * m_featlen;
+        std::copy(major_row, major_row + m_featlen, std::begin(pileup.matrix) + col * m_featlen);
+        const auto &insertions = m_insertion_counts[i];
+        std::copy(std::begin(insertions), std::end(insertions),
+                  std::begin(pileup.matrix) + (col + 1) * m_featlen);
+        for (int64_t minor = 0; minor <= m_max_insertion[i]; ++minor) {
+            pileup.major[col + minor] = m_start + i;
+            pileup.minor[col + minor] = minor;
+        }
+        col += 1 + m_max_insertion[i];
+    }
+
+    return pileup;
+}
+
+}  // namespace
+
+PileupData calculate_pileup_from_cigars(BamFile &bam_file,
+                                        const std::string &chr_name,
+                                        const int64_t start,  // Zero-based.
+                                        const int64_t end,    // Non-inclusive.
+                                        const int64_t num_dtypes,
+                                        const std::vector<std::string> &dtypes,
+                                        const int64_t num_homop,
+                                        const std::string &tag_name,
+                                        const int32_t tag_value,
+                                        const bool keep_missing,
+                                        const bool weibull_summation,
+                                        const std::string &read_group,
+                                        const int32_t min_mapq) {
+    if ((num_dtypes == 1) && !std::empty(dtypes)) {
+        throw std::runtime_error(
+                "Received invalid num_dtypes and dtypes args. num_dtypes == 1 but size(dtypes) = " +
+                std::to_string(std::size(dtypes)));
+    }
+    if (num_dtypes == 0) {
+        throw std::runtime_error("The num_dtypes needs to be > 0.");
+    }
+    if (end <= start) {
+        return PileupData(0, 0, num_dtypes, num_homop, 0);
+    }
+
+    const std::string region =
+            chr_name + ':' + std::to_string(start + 1) + '-' + std::to_string(end);
+
+    HtslibMpileupData data;
+    data.fp = bam_file.fp();
+    data.hdr = bam_file.hdr();
+    data.iter = bam_itr_querys(bam_file.idx(), data.hdr, region.c_str());
+    if (data.iter == nullptr) {
+        throw std::runtime_error("Failed to query region " + region + ".");
+    }
+    std::unique_ptr<hts_itr_t, decltype(&hts_itr_destroy)> iter(data.iter, hts_itr_destroy);
+    data.min_mapq = min_mapq;
+    memcpy(data.tag_name, tag_name.c_str(), 2);
+    data.tag_value = tag_value;
+    data.keep_missing = keep_missing;
+    data.read_group = std::empty(read_group) ? nullptr : read_group.c_str();
+
+    CigarPileupCounter counter(start, end, num_dtypes, dtypes, num_homop, weibull_summation);
+    BamPtr record(bam_init1());
+    // Ends of the alignments which mpileup would still be holding when the next one is read.
+    std::priority_queue<int64_t, std::vector<int64_t>, std::greater<int64_t>> held_ends;
+    int32_t ret = 0;
+    while ((ret = mpileup_read_bam(&data, record.get())) >= 0) {
+        while (!std::empty(held_ends) && (held_ends.top() < record->core.pos)) {
+            held_ends.pop();
+        }
+        // Once mpileup holds MPILEUP_MAX_DEPTH alignments it starts dropping the ones which
+        // begin at the current position. Leave regions that deep to mpileup so that both
+        // produce the same counts.
+        if ((static_cast<int64_t>(std::size(held_ends)) + 1) >= MPILEUP_MAX_DEPTH) {
+            spdlog::debug("Pileup depth in region {} reaches {}, falling back to mpileup.", region,
+                          MPILEUP_MAX_DEPTH);
+            return calculate_pileup(bam_file, chr_name, start, end, num_dtypes, dtypes, num_homop,
+                                    tag_name, tag_value, keep_missing, weibull_summation,
+                                    read_group, min_mapq);
+        }
+        held_ends.push(bam_endpos(record.get()));
+        counter.add_alignment(record.get());
+    }
+    if (ret < -1) {
+        throw std::runtime_error("Failed to read alignments in region " + region + ".");
+    }
+
+    return counter.build_pileup();
+}
+
 }  // namespace dorado::polisher
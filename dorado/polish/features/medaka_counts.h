@@ -112,4 +112,29 @@ PileupData calculate_pileup(BamFile &bam_file,
                             const std::string &read_group,
                             const int32_t min_mapq);
 
+/**
+ * \brief Generates the same feature data as calculate_pileup, without using htslib's mpileup.
+ *          Each alignment is processed once by walking its CIGAR string, scattering its counts
+ *          into a buffer which spans the region, and the columns are only laid out once all
+ *          alignments have been counted. Takes the same arguments as calculate_pileup.
+ *          Regions deep enough for mpileup's depth cap to drop alignments are handed to
+ *          calculate_pileup, so that both always give the same output.
+ * \returns PileupData object which contains base counts per column.
+ *
+ * Throws exceptions on errors.
+ */
+PileupData calculate_pileup_from_cigars(BamFile &bam_file,
+                                        const std::string &chr_name,
+                                        const int64_t start,  // Zero-based.
+                                        const int64_t end,    // Non-inclusive.
+                                        const int64_t num_dtypes,
+                                        const std::vector<std::string> &dtypes,
+                                        const int64_t num_homop,
+                                        const std::string &tag_name,
+                                        const int32_t tag_value,
+                                        const bool keep_missing,
+                                        const bool weibull_summation,
+                                        const std::string &read_group,
+                                        const int32_t min_mapq);
+
 }  // namespace dorado::polisher
@@ -14,6 +14,7 @@
 #include <spdlog/spdlog.h>
 
 #include <memory>
+#include <unordered_map>
 
 #if DORADO_CUDA_BUILD
 #include "torch_utils/cuda_utils.h"
@@ -127,6 +128,9 @@ PolisherResources create_resources(const ModelConfig& model_config,
         resources.bam_handles.emplace_back(BamFile(in_aln_bam_fn));
     }
 
+    // Persistent worker threads for encoding, one per BAM handle.
+    resources.scheduler = std::make_unique<WindowScheduler>(num_bam_threads);
+
     return resources;
 }
 
@@ -474,7 +478,7 @@ std::pair<std::vector<Sample>, std::vector<TrimInfo>> merge_and_split_bam_region
         const EncoderBase& encoder,
         const Span<const Window> bam_regions,
         const Span<const Interval> bam_region_intervals,
-        const int32_t num_threads,
+        WindowScheduler& scheduler,
         const int32_t window_len,
         const int32_t window_overlap,
         const int32_t window_interval_offset) {
@@ -493,93 +497,81 @@ std::pair<std::vector<Sample>, std::vector<TrimInfo>> merge_and_split_bam_region
     };
 #endif
 
-    const auto worker = [&](const int32_t start, const int32_t end,
-                            std::vector<std::vector<Sample>>& results_samples,
-                            std::vector<std::vector<TrimInfo>>& results_trims) {
-        for (int32_t bam_region_id = start; bam_region_id < end; ++bam_region_id) {
-            // Get the interval of samples for this BAM region and subtract the offset due to batching.
-            Interval interval = bam_region_intervals[bam_region_id];
-            interval.start -= window_interval_offset;
-            interval.end -= window_interval_offset;
-
-            spdlog::trace("- [bam_region_id = {}] (0) Before merging: interval = [{}, {}]",
-                          bam_region_id, interval.start, interval.end);
+    // Result vectors for each BAM region.
+    std::vector<std::vector<Sample>> results_samples(std::size(bam_region_intervals));
+    std::vector<std::vector<TrimInfo>> results_trims(std::size(bam_region_intervals));
+
+    const auto worker = [&](const int32_t /*thread_id*/, const int32_t bam_region_id) {
+        // Get the interval of samples for this BAM region and subtract the offset due to batching.
+        Interval interval = bam_region_intervals[bam_region_id];
+        interval.start -= window_interval_offset;
+        interval.end -= window_interval_offset;
+
+        spdlog::trace("- [bam_region_id = {}] (0) Before merging: interval = [{}, {}]",
+                      bam_region_id, interval.start, interval.end);
 #ifdef DEBUG_POLISH_SAMPLE_CONSTRUCTION
-            debug_print_samples(std::cerr, window_samples, interval.start, interval.end, -1);
+        debug_print_samples(std::cerr, window_samples, interval.start, interval.end, -1);
 #endif
 
-            std::vector<Sample> local_samples;
+        std::vector<Sample> local_samples;
 
-            // Split all samples on discontinuities.
-            for (int32_t sample_id = interval.start; sample_id < interval.end; ++sample_id) {
-                auto& sample = window_samples[sample_id];
-                std::vector<Sample> disc_samples = split_sample_on_discontinuities(sample);
-                local_samples.insert(std::end(local_samples),
-                                     std::make_move_iterator(std::begin(disc_samples)),
-                                     std::make_move_iterator(std::end(disc_samples)));
-            }
+        // Split all samples on discontinuities.
+        for (int32_t sample_id = interval.start; sample_id < interval.end; ++sample_id) {
+            auto& sample = window_samples[sample_id];
+            std::vector<Sample> disc_samples = split_sample_on_discontinuities(sample);
+            local_samples.insert(std::end(local_samples),
+                                 std::make_move_iterator(std::begin(disc_samples)),
+                                 std::make_move_iterator(std::end(disc_samples)));
+        }
 
-            spdlog::trace(
-                    "- [bam_region_id = {}] (1) After splitting on discontinuities: "
-                    "local_samples = {}",
-                    bam_region_id, std::size(local_samples));
+        spdlog::trace(
+                "- [bam_region_id = {}] (1) After splitting on discontinuities: "
+                "local_samples = {}",
+                bam_region_id, std::size(local_samples));
 #ifdef DEBUG_POLISH_SAMPLE_CONSTRUCTION
-            debug_print_samples(std::cerr, local_samples, 0, -1, -1);
+        debug_print_samples(std::cerr, local_samples, 0, -1, -1);
 #endif
 
-            // Merge adjacent samples.
-            local_samples = encoder.merge_adjacent_samples(local_samples);
+        // Merge adjacent samples.
+        local_samples = encoder.merge_adjacent_samples(local_samples);
 
-            spdlog::trace("- [bam_region_id = {}] (2) After merging adjacent: local_samples = {}",
-                          bam_region_id, std::size(local_samples));
+        spdlog::trace("- [bam_region_id = {}] (2) After merging adjacent: local_samples = {}",
+                      bam_region_id, std::size(local_samples));
 #ifdef DEBUG_POLISH_SAMPLE_CONSTRUCTION
-            debug_print_samples(std::cerr, local_samples, 0, -1, -1);
+        debug_print_samples(std::cerr, local_samples, 0, -1, -1);
 #endif
 
-            // Bluntly split samples for inference.
-            local_samples = split_samples(std::move(local_samples), window_len, window_overlap);
+        // Bluntly split samples for inference.
+        local_samples = split_samples(std::move(local_samples), window_len, window_overlap);
 
-            spdlog::trace(
-                    "- [bam_region_id = {}] (3) After splitting samples: local_samples = {}, "
-                    "window_len = {}, window_overlap = {}",
-                    bam_region_id, std::size(local_samples), window_len, window_overlap);
+        spdlog::trace(
+                "- [bam_region_id = {}] (3) After splitting samples: local_samples = {}, "
+                "window_len = {}, window_overlap = {}",
+                bam_region_id, std::size(local_samples), window_len, window_overlap);
 #ifdef DEBUG_POLISH_SAMPLE_CONSTRUCTION
-            debug_print_samples(std::cerr, local_samples, 0, -1, -1);
+        debug_print_samples(std::cerr, local_samples, 0, -1, -1);
 #endif
 
-            // Compute sample trimming coordinates.
-            const Window& reg = bam_regions[bam_region_id];
-            results_trims[bam_region_id] = trim_samples(
-                    local_samples, std::optional<RegionInt>(
-                                           {reg.seq_id, reg.start_no_overlap, reg.end_no_overlap}));
-            results_samples[bam_region_id] = std::move(local_samples);
-        }
+        // Compute sample trimming coordinates.
+        const Window& reg = bam_regions[bam_region_id];
+        results_trims[bam_region_id] = trim_samples(
+                local_samples, std::optional<RegionInt>(
+                                       {reg.seq_id, reg.start_no_overlap, reg.end_no_overlap}));
+        results_samples[bam_region_id] = std::move(local_samples);
     };
 
-    // Result vectors for each BAM region.
-    std::vector<std::vector<Sample>> merged_samples(std::size(bam_region_intervals));
-    std::vector<std::vector<TrimInfo>> merged_trims(std::size(bam_region_intervals));
-
-    // Process BAM regions in parallel.
-    const std::vector<Interval> thread_chunks =
-            compute_partitions(static_cast<int32_t>(std::size(bam_region_intervals)), num_threads);
+    // The cost of a BAM region is proportional to the number of window samples it merges.
+    std::vector<int64_t> costs(std::size(bam_region_intervals));
+    for (size_t i = 0; i < std::size(bam_region_intervals); ++i) {
+        costs[i] = bam_region_intervals[i].length();
+    }
 
     spdlog::trace("Starting to merge samples for {} BAM windows using {} threads.",
-                  std::size(bam_region_intervals), std::size(thread_chunks));
+                  std::size(bam_region_intervals), scheduler.num_threads());
 
     // Parallel processing of BAM regions.
-    cxxpool::thread_pool pool{std::size(thread_chunks)};
-    std::vector<std::future<void>> futures;
-    futures.reserve(std::size(thread_chunks));
-    for (size_t tid = 0; tid < std::size(thread_chunks); ++tid) {
-        const auto [chunk_start, chunk_end] = thread_chunks[tid];
-        futures.emplace_back(pool.push(worker, chunk_start, chunk_end, std::ref(merged_samples),
-                                       std::ref(merged_trims)));
-    }
     try {
-        for (auto& f : futures) {
-            f.get();
-        }
+        scheduler.run(Span<const int64_t>(std::data(costs), std::size(costs)), worker);
     } catch (const std::exception& e) {
         throw std::runtime_error{std::string("Caught exception from merge-samples task: ") +
                                  e.what()};
@@ -587,25 +579,25 @@ std::pair<std::vector<Sample>, std::vector<TrimInfo>> merge_and_split_bam_region
 
     // Flatten the samples obtained for each BAM region.
     size_t num_samples = 0;
-    for (const auto& vals : merged_samples) {
+    for (const auto& vals : results_samples) {
         num_samples += std::size(vals);
     }
 
-    std::vector<Sample> results_samples;
-    results_samples.reserve(num_samples);
-    for (auto& vals : merged_samples) {
-        results_samples.insert(std::end(results_samples), std::make_move_iterator(std::begin(vals)),
-                               std::make_move_iterator(std::end(vals)));
+    std::vector<Sample> merged_samples;
+    merged_samples.reserve(num_samples);
+    for (auto& vals : results_samples) {
+        merged_samples.insert(std::end(merged_samples), std::make_move_iterator(std::begin(vals)),
+                              std::make_move_iterator(std::end(vals)));
     }
 
-    std::vector<TrimInfo> results_trims;
-    results_trims.reserve(num_samples);
-    for (auto& vals : merged_trims) {
-        results_trims.insert(std::end(results_trims), std::make_move_iterator(std::begin(vals)),
-                             std::make_move_iterator(std::end(vals)));
+    std::vector<TrimInfo> merged_trims;
+    merged_trims.reserve(num_samples);
+    for (auto& vals : results_trims) {
+        merged_trims.insert(std::end(merged_trims), std::make_move_iterator(std::begin(vals)),
+                            std::make_move_iterator(std::end(vals)));
     }
 
-    return {results_samples, results_trims};
+    return {merged_samples, merged_trims};
 }
 
 std::vector<Sample> encode_windows_in_parallel(
@@ -613,50 +605,39 @@ std::vector<Sample> encode_windows_in_parallel(
         const EncoderBase& encoder,
         const std::vector<std::pair<std::string, int64_t>>& draft_lens,
         const dorado::Span<const Window> windows,
-        const int32_t num_threads) {
-    // Worker function, each thread computes tensors for a set of windows assigned to it.
-    const auto worker = [&](const int32_t thread_id, const int32_t start, const int32_t end,
-                            std::vector<Sample>& results) {
-        for (int32_t i = start; i < end; ++i) {
-            const auto& window = windows[i];
-            const std::string& name = draft_lens[window.seq_id].first;
-            if (thread_id == 0) {
-                spdlog::trace(
-                        "[start = {}, end = {}] Encoding i = {}, region = "
-                        "{}:{}-{} ({} %).",
-                        start, end, i, name, window.start, window.end,
-                        100.0 * static_cast<double>(i - start) / (end - start));
-            }
-            results[i] = encoder.encode_region(bam_handles[thread_id], name, window.start,
-                                               window.end, window.seq_id);
-        }
-    };
-
-    const std::vector<Interval> thread_chunks =
-            compute_partitions(static_cast<int32_t>(std::size(windows)),
-                               std::min(num_threads, static_cast<int32_t>(std::size(bam_handles))));
-
-    spdlog::debug("Starting to encode regions for {} windows using {} threads.", std::size(windows),
-                  std::size(thread_chunks));
-
-    // Create the thread pool, futures and results.
-    cxxpool::thread_pool pool{std::size(thread_chunks)};
-    std::vector<std::future<void>> futures;
-    futures.reserve(std::size(thread_chunks));
+        const dorado::Span<const int64_t> window_costs,
+        WindowScheduler& scheduler) {
+    if (std::size(window_costs) != std::size(windows)) {
+        throw std::runtime_error{
+                "Number of window costs does not match the number of windows! windows.size() = " +
+                std::to_string(std::size(windows)) +
+                ", window_costs.size() = " + std::to_string(std::size(window_costs))};
+    }
+    if (scheduler.num_threads() > dorado::ssize(bam_handles)) {
+        throw std::runtime_error{
+                "Not enough BAM handles for the scheduler threads! bam_handles.size() = " +
+                std::to_string(std::size(bam_handles)) +
+                ", num_threads = " + std::to_string(scheduler.num_threads())};
+    }
 
     std::vector<Sample> results(std::size(windows));
 
-    // Add jobs to the pool.
-    for (int32_t tid = 0; tid < dorado::ssize(thread_chunks); ++tid) {
-        const auto [chunk_start, chunk_end] = thread_chunks[tid];
-        futures.emplace_back(pool.push(worker, tid, chunk_start, chunk_end, std::ref(results)));
-    }
+    // Worker function, each call computes the tensors for one window using the BAM handle of the thread.
+    const auto worker = [&](const int32_t thread_id, const int32_t i) {
+        const auto& window = windows[i];
+        const std::string& name = draft_lens[window.seq_id].first;
+        spdlog::trace("[thread_id = {}] Encoding i = {}, region = {}:{}-{}, cost = {}.", thread_id,
+                      i, name, window.start, window.end, window_costs[i]);
+        results[i] = encoder.encode_region(bam_handles[thread_id], name, window.start, window.end,
+                                           window.seq_id);
+    };
 
-    // Join and catch errors.
+    spdlog::debug("Starting to encode regions for {} windows using {} threads.", std::size(windows),
+                  scheduler.num_threads());
+
+    // Run and catch errors.
     try {
-        for (auto& f : futures) {
-            f.get();
-        }
+        scheduler.run(window_costs, worker);
     } catch (const std::exception& e) {
         throw std::runtime_error{std::string("Caught exception from encoding task: ") + e.what()};
     }
@@ -714,9 +695,17 @@ void sample_producer(PolisherResources& resources,
                      const int32_t window_len,
                      const int32_t window_overlap,
                      const int32_t bam_subchunk_len,
-                     utils::AsyncQueue<InferenceData>& infer_data) {
+                     utils::AsyncQueue<InferenceData>& infer_data,
+                     DraftResultsCollector& collector) {
     spdlog::debug("[producer] Input: {} BAM windows.", std::size(bam_regions));
 
+    // Index of the last BAM region of each draft, so that drafts can be sealed as soon as
+    // all of their regions have been processed.
+    std::unordered_map<int32_t, int32_t> last_region_of_draft;
+    for (int32_t i = 0; i < static_cast<int32_t>(std::size(bam_regions)); ++i) {
+        last_region_of_draft[bam_regions[i].seq_id] = i;
+    }
+
     // Split large BAM regions into non-overlapping windows for parallel encoding.
     // The non-overlapping windows will be merged after samples are constructed.
     std::vector<Window> windows;
@@ -736,6 +725,18 @@ void sample_producer(PolisherResources& resources,
         windows.insert(std::end(windows), std::begin(new_windows), std::end(new_windows));
     }
 
+    if (!resources.scheduler) {
+        throw std::runtime_error("No scheduler has been initialized, cannot encode samples.");
+    }
+    if (std::empty(resources.bam_handles)) {
+        throw std::runtime_error("No BAM handles have been initialized, cannot encode samples.");
+    }
+
+    // Estimated cost of encoding each window, for scheduling.
+    const std::vector<int64_t> window_costs = estimate_window_costs(
+            resources.bam_handles.front(), draft_lens,
+            Span<const Window>(std::data(windows), std::size(windows)));
+
     // Divide draft sequences into groups of specified size, as sort of a barrier.
     const std::vector<Interval> bam_region_batches =
             create_batches(bam_region_intervals, num_threads,
@@ -758,7 +759,9 @@ void sample_producer(PolisherResources& resources,
         // Encode samples in parallel. Non-const by design, data will be moved.
         std::vector<Sample> region_samples = encode_windows_in_parallel(
                 resources.bam_handles, *resources.encoder, draft_lens,
-                Span<const Window>(std::data(windows) + window_id_start, num_windows), num_threads);
+                Span<const Window>(std::data(windows) + window_id_start, num_windows),
+                Span<const int64_t>(std::data(window_costs) + window_id_start, num_windows),
+                *resources.scheduler);
 
         spdlog::trace(
                 "[producer] Merging the samples into {} BAM chunks. parallel_results.size() = {}",
@@ -769,7 +772,7 @@ void sample_producer(PolisherResources& resources,
                 Span<const Window>(std::data(bam_regions) + region_id_start, num_regions),
                 Span<const Interval>(std::data(bam_region_intervals) + region_id_start,
                                      num_regions),
-                num_threads, window_len, window_overlap, window_id_start);
+                *resources.scheduler, window_len, window_overlap, window_id_start);
 
         if (std::size(samples) != std::size(trims)) {
             throw std::runtime_error("Size of samples and trims does not match! samples.size() = " +
@@ -777,6 +780,17 @@ void sample_producer(PolisherResources& resources,
                                      ", trims.size() = " + std::to_string(std::size(trims)));
         }
 
+        // Announce the samples before any of them can reach the decoders.
+        {
+            std::unordered_map<int32_t, int64_t> num_samples_per_draft;
+            for (const Sample& sample : samples) {
+                ++num_samples_per_draft[sample.seq_id];
+            }
+            for (const auto& [seq_id, num_samples] : num_samples_per_draft) {
+                collector.add_samples(seq_id, num_samples);
+            }
+        }
+
         // Add samples to the batches.
         for (size_t i = 0; i < std::size(samples); ++i) {
             // If any of the samples is of wrong size, create a remainder batch of 1.
@@ -805,6 +819,14 @@ void sample_producer(PolisherResources& resources,
                 buffer = {};
             }
         }
+
+        // All samples of the drafts which end in this group of regions have been announced.
+        for (int32_t i = region_id_start; i < region_id_end; ++i) {
+            const int32_t seq_id = bam_regions[i].seq_id;
+            if (last_region_of_draft[seq_id] == i) {
+                collector.seal(seq_id);
+            }
+        }
     }
 
     if (!std::empty(buffer.samples)) {
@@ -816,8 +838,6 @@ void sample_producer(PolisherResources& resources,
         buffer = {};
         spdlog::debug("[producer] Pushed final batch for inference to infer_data queue.");
     }
-
-    infer_data.terminate();
 }
 
 void infer_samples_in_parallel(utils::AsyncQueue<InferenceData>& batch_queue,
@@ -940,8 +960,7 @@ void infer_samples_in_parallel(utils::AsyncQueue<InferenceData>& batch_queue,
     spdlog::debug("[infer_samples_in_parallel] Finished running inference.");
 }
 
-void decode_samples_in_parallel(std::vector<ConsensusResult>& results_cons,
-                                std::vector<VariantCallingSample>& results_vc_data,
+void decode_samples_in_parallel(DraftResultsCollector& collector,
                                 utils::AsyncQueue<DecodeData>& decode_queue,
                                 PolishStats& polish_stats,
                                 const DecoderBase& decoder,
@@ -1058,8 +1077,7 @@ void decode_samples_in_parallel(std::vector<ConsensusResult>& results_cons,
         return final_results;
     };
 
-    const auto worker = [&](const int32_t tid, std::vector<ConsensusResult>& thread_results,
-                            std::vector<VariantCallingSample>& thread_vc_data) {
+    const auto worker = [&](const int32_t tid) {
         at::InferenceMode infer_guard;
 
         while (true) {
@@ -1081,19 +1099,24 @@ void decode_samples_in_parallel(std::vector<ConsensusResult>& results_cons,
                     tid, tensor_shape_as_string(item.logits), dorado::ssize(item.trims),
                     tensor_batch_size, std::size(decode_queue));
 
+            // Every sample has to be reported to the collector, even if it produces no results.
+            std::vector<int32_t> sample_seq_ids;
+            sample_seq_ids.reserve(std::size(item.samples));
+            for (const Sample& sample : item.samples) {
+                sample_seq_ids.emplace_back(sample.seq_id);
+            }
+
             // This should handle the timeout case too.
             if (tensor_batch_size == 0) {
+                collector.add_results(sample_seq_ids, {}, {});
                 continue;
             }
 
             // Inference.
             std::vector<ConsensusResult> results_samples = batch_decode(item, tid);
 
-            thread_results.insert(std::end(thread_results),
-                                  std::make_move_iterator(std::begin(results_samples)),
-                                  std::make_move_iterator(std::end(results_samples)));
-
             // Separate the logits for each sample.
+            std::vector<VariantCallingSample> results_vc_data;
             if (collect_vc_data) {
                 // Split logits for each input sample in the batch, and check that the number matches.
                 const std::vector<torch::Tensor> split_logits = item.logits.unbind(0);
@@ -1105,29 +1128,30 @@ void decode_samples_in_parallel(std::vector<ConsensusResult>& results_cons,
                             "possible. "
                             "samples.size = {}, split_logits.size = {}",
                             std::size(item.samples), std::size(split_logits));
-                    continue;
-                }
-                // Create the variant calling data. Clone the tensor to convert the view to actual data.
-                for (int64_t i = 0; i < dorado::ssize(item.samples); ++i) {
-                    thread_vc_data.emplace_back(VariantCallingSample{
-                            item.samples[i].seq_id, std::move(item.samples[i].positions_major),
-                            std::move(item.samples[i].positions_minor), split_logits[i].clone()});
+                } else {
+                    // Create the variant calling data. Clone the tensor to convert the view to actual data.
+                    results_vc_data.reserve(std::size(item.samples));
+                    for (int64_t i = 0; i < dorado::ssize(item.samples); ++i) {
+                        results_vc_data.emplace_back(VariantCallingSample{
+                                item.samples[i].seq_id, std::move(item.samples[i].positions_major),
+                                std::move(item.samples[i].positions_minor),
+                                split_logits[i].clone()});
+                    }
                 }
             }
+
+            collector.add_results(sample_seq_ids, std::move(results_samples),
+                                  std::move(results_vc_data));
         }
     };
 
-    std::vector<std::vector<ConsensusResult>> thread_results(num_threads);
-    std::vector<std::vector<VariantCallingSample>> thread_vc_data(num_threads);
-
     cxxpool::thread_pool pool{static_cast<size_t>(num_threads)};
 
     std::vector<std::future<void>> futures;
     futures.reserve(num_threads);
 
     for (int32_t tid = 0; tid < static_cast<int32_t>(num_threads); ++tid) {
-        futures.emplace_back(pool.push(worker, tid, std::ref(thread_results[tid]),
-                                       std::ref(thread_vc_data[tid])));
+        futures.emplace_back(pool.push(worker, tid));
     }
 
     try {
@@ -1138,33 +1162,6 @@ void decode_samples_in_parallel(std::vector<ConsensusResult>& results_cons,
         throw std::runtime_error{std::string("Caught exception from inference task: ") + e.what()};
     }
 
-    // Flatten the results.
-    {
-        size_t total_size = 0;
-        for (const auto& vals : thread_results) {
-            total_size += std::size(vals);
-        }
-        results_cons.clear();
-        results_cons.reserve(total_size);
-        for (auto& vals : thread_results) {
-            results_cons.insert(std::end(results_cons), std::make_move_iterator(std::begin(vals)),
-                                std::make_move_iterator(std::end(vals)));
-        }
-    }
-    {
-        size_t total_size = 0;
-        for (const auto& vals : thread_vc_data) {
-            total_size += std::size(vals);
-        }
-        results_vc_data.clear();
-        results_vc_data.reserve(total_size);
-        for (auto& vals : thread_vc_data) {
-            results_vc_data.insert(std::end(results_vc_data),
-                                   std::make_move_iterator(std::begin(vals)),
-                                   std::make_move_iterator(std::end(vals)));
-        }
-    }
-
     spdlog::debug("[decode_samples_in_parallel] Finished decoding the output.");
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "consensus_result.h"
+#include "draft_results_collector.h"
 #include "polish/architectures/model_factory.h"
 #include "polish/features/decoder_factory.h"
 #include "polish/features/encoder_factory.h"
@@ -13,6 +14,7 @@
 #include "utils/timer_high_res.h"
 #include "variant_calling_sample.h"
 #include "window.h"
+#include "window_scheduler.h"
 
 #include <cstdint>
 #include <filesystem>
@@ -40,6 +42,7 @@ struct PolisherResources {
     std::unique_ptr<EncoderBase> encoder;
     std::unique_ptr<DecoderBase> decoder;
     std::vector<BamFile> bam_handles;
+    std::unique_ptr<WindowScheduler> scheduler;
     std::vector<DeviceInfo> devices;
     std::vector<std::shared_ptr<ModelTorchBase>> models;
 };
@@ -122,7 +125,7 @@ std::vector<ConsensusResult> stitch_sequence(
  * \param bam_regions BAM region coordinates. This is a Span to facilitate batching of BAM regions from the outside.
  * \param bam_region_intervals Range of IDs of window_samples which comprise this BAM region. E.g. BAM region 0 uses window_samples[0:5], BAM region 1 uses window_samples[5:9], etc.
  *                              This is a Span to facilitate batching of BAM regions from the outside and avoid copying vectors.
- * \param num_threads Number of threads for procesing.
+ * \param scheduler Persistent thread pool used to process the BAM regions.
  * \param window_len Length of the window to split the final samples into.
  * \param window_overlap Overlap between neighboring windows when splitting.
  * \param window_interval_offset Used for batching bam_region_intervals, because window_samples.size() matches the total size of bam_region_intervals,
@@ -133,22 +136,24 @@ std::pair<std::vector<Sample>, std::vector<TrimInfo>> merge_and_split_bam_region
         const EncoderBase& encoder,
         const Span<const Window> bam_regions,
         const Span<const Interval> bam_region_intervals,
-        const int32_t num_threads,
+        WindowScheduler& scheduler,
         const int32_t window_len,
         const int32_t window_overlap,
         const int32_t window_interval_offset);
 
 /**
  * \brief For each input window (region of the draft) runs the given encoder and produces a sample.
- *          The BamFile handels are used to fetch the pileup data and encode regions.
- *          Encoding is parallelized, where the actual number of threads is min(bam_handles.size(), num_threads, windows.size()).
+ *          The BamFile handels are used to fetch the pileup data and encode regions, one handle per scheduler thread.
+ *          Windows are scheduled individually, the most expensive ones first, according to window_costs
+ *          (e.g. computed by estimate_window_costs).
  */
 std::vector<Sample> encode_windows_in_parallel(
         std::vector<BamFile>& bam_handles,
         const EncoderBase& encoder,
         const std::vector<std::pair<std::string, int64_t>>& draft_lens,
         const dorado::Span<const Window> windows,
-        const int32_t num_threads);
+        const dorado::Span<const int64_t> window_costs,
+        WindowScheduler& scheduler);
 
 /**
  * \brief Creates windows from given input draft sequences or regions. If regions vector is empty, it will split all
@@ -161,19 +166,18 @@ std::vector<Window> create_windows_from_regions(
         const int32_t window_overlap);
 
 /**
- * \brief Fetches the decode data from an async queue, decodes the consensus and collects
- *          the consensus results. It also returns a vector of the decode data taken off of the queue
- *          (i.e. the input used for decoding). This will be needed downstream for variant calling.
- * \param results Return vector of consensus results.
- * \param decode_data Return vector of input data used for decoding, taken from the queue.
+ * \brief Fetches the decode data from an async queue, decodes the consensus and reports the consensus
+ *          results to the collector, per draft sequence. If collect_vc_data is true, it also reports the
+ *          decode data taken off of the queue (i.e. the input used for decoding), which is needed downstream
+ *          for variant calling.
+ * \param collector Receives the results of every decoded sample.
  * \param decode_queue Queue where messages will be received.
  * \param polish_stats Stats object, for the progress bar.
  * \param decoder Decoder to convert integers to bases.
  * \param num_threads Number of threads for processing.
  * \param min_depth Consensus sequences will be split in regions of insufficient depth.
  */
-void decode_samples_in_parallel(std::vector<ConsensusResult>& results_cons,
-                                std::vector<VariantCallingSample>& results_vc_data,
+void decode_samples_in_parallel(DraftResultsCollector& collector,
                                 utils::AsyncQueue<DecodeData>& decode_queue,
                                 PolishStats& polish_stats,
                                 const DecoderBase& decoder,
@@ -186,6 +190,12 @@ void infer_samples_in_parallel(utils::AsyncQueue<InferenceData>& batch_queue,
                                std::vector<std::shared_ptr<ModelTorchBase>>& models,
                                const EncoderBase& encoder);
 
+/**
+ * \brief Encodes the samples of the given BAM regions and pushes them in batches to the infer_data queue.
+ *          The samples of each draft are announced to the collector before they are pushed, and the draft
+ *          is sealed once its last BAM region has been processed. The queue is not terminated, so that
+ *          several batches of drafts can be streamed through the same queue.
+ */
 void sample_producer(PolisherResources& resources,
                      const std::vector<Window>& bam_regions,
                      const std::vector<std::pair<std::string, int64_t>>& draft_lens,
@@ -194,6 +204,7 @@ void sample_producer(PolisherResources& resources,
                      const int32_t window_len,
                      const int32_t window_overlap,
                      const int32_t bam_subchunk_len,
-                     utils::AsyncQueue<InferenceData>& infer_data);
+                     utils::AsyncQueue<InferenceData>& infer_data,
+                     DraftResultsCollector& collector);
 
 }  // namespace dorado::polisher
@@ -0,0 +1,184 @@
+#include "window_scheduler.h"
+
+#include "bam_file.h"
+
+#include <htslib/hts.h>
+#include <htslib/sam.h>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace dorado::polisher {
+
+WindowScheduler::WindowScheduler(const int32_t num_threads)
+        : m_queues(std::max(num_threads, 1)) {
+    if (num_threads <= 0) {
+        throw std::runtime_error{
+                "WindowScheduler needs at least one thread. Given: num_threads = " +
+                std::to_string(num_threads)};
+    }
+    m_threads.reserve(num_threads);
+    for (int32_t tid = 0; tid < num_threads; ++tid) {
+        m_threads.emplace_back([this, tid]() { worker_loop(tid); });
+    }
+}
+
+WindowScheduler::~WindowScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_terminate = true;
+    }
+    m_cv_start.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WindowScheduler::run(const Span<const int64_t> costs, const TaskFunction& task) {
+    if (std::size(costs) == 0) {
+        return;
+    }
+
+    // Longest-processing-time-first: deal the tasks in the order of descending cost, so that every
+    // thread starts with one of the most expensive tasks and the cheap ones fill in the gaps at the end.
+    std::vector<int32_t> order(std::size(costs));
+    std::iota(std::begin(order), std::end(order), 0);
+    std::stable_sort(std::begin(order), std::end(order),
+                     [&costs](const int32_t a, const int32_t b) { return costs[a] > costs[b]; });
+
+    // The workers are all idle at this point, and they only access the queues after being started below.
+    const size_t num_queues = std::size(m_queues);
+    for (size_t i = 0; i < std::size(order); ++i) {
+        m_queues[i % num_queues].tasks.emplace_back(order[i]);
+    }
+
+    std::exception_ptr exception;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_num_busy = num_threads();
+        m_exception = nullptr;
+        m_abort.store(false, std::memory_order_relaxed);
+        ++m_generation;
+        m_cv_start.notify_all();
+
+        m_cv_done.wait(lock, [this]() { return m_num_busy == 0; });
+        m_task = nullptr;
+        exception = std::exchange(m_exception, nullptr);
+    }
+
+    // Tasks left over after an abort.
+    for (auto& queue : m_queues) {
+        queue.tasks.clear();
+    }
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void WindowScheduler::worker_loop(const int32_t thread_id) {
+    uint64_t last_generation = 0;
+
+    while (true) {
+        const TaskFunction* task = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv_start.wait(lock,
+                            [&]() { return m_terminate || (m_generation != last_generation); });
+            if (m_terminate) {
+                return;
+            }
+            last_generation = m_generation;
+            task = m_task;
+        }
+
+        int32_t task_id = 0;
+        while (!m_abort.load(std::memory_order_relaxed) && take_task(thread_id, task_id)) {
+            try {
+                (*task)(thread_id, task_id);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_exception) {
+                    m_exception = std::current_exception();
+                }
+                m_abort.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_num_busy;
+            if (m_num_busy == 0) {
+                m_cv_done.notify_one();
+            }
+        }
+    }
+}
+
+bool WindowScheduler::take_task(const int32_t thread_id, int32_t& task_id) {
+    // Own queue first, from the front (most expensive first).
+    {
+        WorkerQueue& queue = m_queues[thread_id];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!std::empty(queue.tasks)) {
+            task_id = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+
+    // Steal from the back of the other queues, so that the owner keeps its expensive tasks.
+    const int32_t num_queues = static_cast<int32_t>(std::size(m_queues));
+    for (int32_t i = 1; i < num_queues; ++i) {
+        WorkerQueue& queue = m_queues[(thread_id + i) % num_queues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!std::empty(queue.tasks)) {
+            task_id = queue.tasks.back();
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<int64_t> estimate_window_costs(
+        const BamFile& bam_file,
+        const std::vector<std::pair<std::string, int64_t>>& draft_lens,
+        const Span<const Window> windows) {
+    // Number of mapped reads per base of each draft sequence, looked up lazily.
+    std::unordered_map<int32_t, double> read_density;
+
+    const auto get_read_density = [&](const int32_t seq_id) {
+        const auto it = read_density.find(seq_id);
+        if (it != std::end(read_density)) {
+            return it->second;
+        }
+        double density = 0.0;
+        const auto& [name, length] = draft_lens[seq_id];
+        const int32_t tid = sam_hdr_name2tid(bam_file.hdr(), name.c_str());
+        uint64_t mapped = 0;
+        uint64_t unmapped = 0;
+        if ((tid >= 0) && (length > 0) &&
+            (hts_idx_get_stat(bam_file.idx(), tid, &mapped, &unmapped) == 0)) {
+            density = static_cast<double>(mapped) / static_cast<double>(length);
+        }
+        read_density.emplace(seq_id, density);
+        return density;
+    };
+
+    std::vector<int64_t> costs(std::size(windows), 1);
+    for (size_t i = 0; i < std::size(windows); ++i) {
+        const Window& window = windows[i];
+        const double num_reads =
+                get_read_density(window.seq_id) * static_cast<double>(window.end - window.start);
+        costs[i] = std::max<int64_t>(1, static_cast<int64_t>(num_reads));
+    }
+
+    return costs;
+}
+
+}  // namespace dorado::polisher
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "utils/span.h"
+#include "window.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dorado::polisher {
+
+class BamFile;
+
+/**
+ * \brief Persistent pool of worker threads which schedules polishing work (e.g. windows) one item at a time.
+ *          On every run, items are sorted by descending estimated cost and dealt round-robin into per-thread
+ *          queues. Each thread processes its own queue from the most expensive item onwards, and a thread which
+ *          runs out of work steals from the back of the other queues. This keeps all threads busy when the cost
+ *          of items is very skewed (e.g. one deep-coverage window), unlike static contiguous partitions.
+ *          The threads are created once and reused across runs.
+ */
+class WindowScheduler {
+public:
+    /**
+     * \brief Task callback. The thread_id is in [0, num_threads()) and is unique among the concurrently
+     *          running tasks, so it can be used to index per-thread resources such as BAM handles.
+     */
+    using TaskFunction = std::function<void(int32_t thread_id, int32_t task_id)>;
+
+    explicit WindowScheduler(const int32_t num_threads);
+
+    ~WindowScheduler();
+
+    WindowScheduler(const WindowScheduler&) = delete;
+    WindowScheduler& operator=(const WindowScheduler&) = delete;
+
+    int32_t num_threads() const { return static_cast<int32_t>(std::size(m_threads)); }
+
+    /**
+     * \brief Runs the task for every task_id in [0, costs.size()) and blocks until all of them are done.
+     *          If a task throws, the tasks which have not yet started are skipped and the first exception
+     *          is rethrown. Not reentrant, only one run can be in progress at a time.
+     * \param costs Estimated relative cost of each task. Used only for ordering.
+     * \param task Function to run for each task.
+     */
+    void run(const Span<const int64_t> costs, const TaskFunction& task);
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<int32_t> tasks;
+    };
+
+    void worker_loop(const int32_t thread_id);
+
+    bool take_task(const int32_t thread_id, int32_t& task_id);
+
+    std::vector<WorkerQueue> m_queues;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv_start;
+    std::condition_variable m_cv_done;
+    const TaskFunction* m_task = nullptr;
+    uint64_t m_generation = 0;
+    int32_t m_num_busy = 0;
+    bool m_terminate = false;
+    std::exception_ptr m_exception;
+    std::atomic<bool> m_abort{false};
+
+    std::vector<std::thread> m_threads;
+};
+
+/**
+ * \brief Estimates the number of reads overlapping each window, used as the scheduling cost of the window.
+ *          The per-sequence counts of mapped reads are taken from the BAM index, and are spread uniformly
+ *          along each sequence. Sequences without index statistics count as having no reads.
+ *          Every window costs at least 1.
+ * \param bam_file BAM file with an index.
+ * \param draft_lens Names and lengths of the draft sequences, indexed by Window::seq_id.
+ * \param windows Windows to estimate the cost for.
+ * \returns Vector of costs, one per window.
+ */
+std::vector<int64_t> estimate_window_costs(
+        const BamFile& bam_file,
+        const std::vector<std::pair<std::string, int64_t>>& draft_lens,
+        const Span<const Window> windows);
+
+}  // namespace dorado::polisher
@@ -51,7 +51,12 @@ std::shared_ptr<const dorado::alignment::Minimap2Index> load_and_get_index(
 
 void update_bed_results(dorado::ReadCommon& read_common, const dorado::alignment::BedFile& bed) {
     for (auto& align_result : read_common.alignment_results) {
-        for (const auto& entry : bed.entries(align_result.genome)) {
+        const auto& entries = bed.entries(align_result.genome);
+        const auto hits = bed.overlapping_entries(align_result.genome,
+                                                  size_t(align_result.genome_start),
+                                                  size_t(align_result.genome_end));
+        for (const auto index : hits) {
+            const auto& entry = entries[index];
             if (!(entry.start > (size_t)align_result.genome_end ||
                   entry.end < (size_t)align_result.genome_start) &&
                 (entry.strand == align_result.direction || entry.strand == '.')) {
@@ -76,10 +81,25 @@ AlignerNode::AlignerNode(std::shared_ptr<alignment::IndexFileAccess> index_file_
                          const std::string& bed_file,
                          const alignment::Minimap2Options& options,
                          int threads)
+        : AlignerNode(std::move(index_file_access),
+                      std::move(bed_file_access),
+                      std::make_shared<utils::concurrency::MultiQueueThreadPool>(
+                              threads,
+                              "align_node_pool"),
+                      index_file,
+                      bed_file,
+                      options,
+                      threads) {}
+
+AlignerNode::AlignerNode(std::shared_ptr<alignment::IndexFileAccess> index_file_access,
+                         std::shared_ptr<alignment::BedFileAccess> bed_file_access,
+                         std::shared_ptr<utils::concurrency::MultiQueueThreadPool> thread_pool,
+                         const std::string& index_file,
+                         const std::string& bed_file,
+                         const alignment::Minimap2Options& options,
+                         int threads)
         : MessageSink(MAX_INPUT_QUEUE_SIZE, 1),
-          m_thread_pool(
-                  std::make_shared<utils::concurrency::MultiQueueThreadPool>(threads,
-                                                                             "align_node_pool")),
+          m_thread_pool(std::move(thread_pool)),
           m_index_for_bam_messages(
                   load_and_get_index(*index_file_access, index_file, options, threads)),
           m_index_file_access(std::move(index_file_access)),
@@ -238,7 +258,10 @@ void AlignerNode::add_bed_hits_to_record(const std::string& genome, bam1_t* reco
     size_t genome_end = bam_endpos(record);
     char direction = (bam_is_rev(record)) ? '-' : '+';
     int bed_hits = 0;
-    for (const auto& interval : m_bedfile_for_bam_messages->entries(genome)) {
+    const auto& entries = m_bedfile_for_bam_messages->entries(genome);
+    for (const auto index :
+         m_bedfile_for_bam_messages->overlapping_entries(genome, genome_start, genome_end)) {
+        const auto& interval = entries[index];
         if (!(interval.start >= genome_end || interval.end <= genome_start) &&
             (interval.strand == direction || interval.strand == '.')) {
             bed_hits++;
@@ -35,6 +35,15 @@ public:
                 const std::string& bed_file,
                 const alignment::Minimap2Options& options,
                 int threads);
+    // Aligns with |thread_pool|, which may be shared with the AlignerNodes of other pipelines
+    // so that several inputs can be aligned at once against the same index.
+    AlignerNode(std::shared_ptr<alignment::IndexFileAccess> index_file_access,
+                std::shared_ptr<alignment::BedFileAccess> bed_file_access,
+                std::shared_ptr<utils::concurrency::MultiQueueThreadPool> thread_pool,
+                const std::string& index_file,
+                const std::string& bed_file,
+                const alignment::Minimap2Options& options,
+                int threads);
     AlignerNode(std::shared_ptr<alignment::IndexFileAccess> index_file_access,
                 std::shared_ptr<alignment::BedFileAccess> bed_file_access,
                 std::shared_ptr<utils::concurrency::MultiQueueThreadPool> thread_pool,
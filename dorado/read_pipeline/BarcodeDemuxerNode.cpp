@@ -4,11 +4,17 @@
 #include "utils/SampleSheet.h"
 #include "utils/fastq_reader.h"
 #include "utils/hts_file.h"
+#include "utils/thread_naming.h"
 
 #include <htslib/bgzf.h>
 #include <htslib/sam.h>
+#include <htslib/thread_pool.h>
 
+#include <algorithm>
 #include <cassert>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 
@@ -17,6 +23,7 @@ namespace dorado {
 namespace {
 constexpr size_t BAM_BUFFER_SIZE =
         20000000;  // 20 MB per barcode classification. So roughly 2 GB for 96 barcodes.
+constexpr size_t SHARD_QUEUE_SIZE = 1000;
 
 std::string get_run_id_from_fq_tag(const bam1_t& record) {
     auto fastq_id_tag = bam_aux_get(&record, "fq");
@@ -52,6 +59,14 @@ std::string get_run_id(const bam1_t& record) {
     return run_id.empty() ? "unknown_run_id" : run_id;
 }
 
+// The htslib threads are split evenly between the writer shards.
+int get_shard_htslib_threads(size_t htslib_threads, size_t num_writer_shards) {
+    if (htslib_threads == 0) {
+        return 0;
+    }
+    return std::max(1, int(htslib_threads / std::max(num_writer_shards, size_t(1))));
+}
+
 void apply_sample_sheet_alias(const utils::SampleSheet& sample_sheet,
                               std::string& barcode,
                               bam1_t& record) {
@@ -69,45 +84,111 @@ BarcodeDemuxerNode::BarcodeDemuxerNode(const std::string& output_dir,
                                        size_t htslib_threads,
                                        bool write_fastq,
                                        std::unique_ptr<const utils::SampleSheet> sample_sheet,
-                                       bool sort_bam)
-        : MessageSink(10000, 1),
+                                       bool sort_bam,
+                                       size_t num_writer_shards)
+        : MessageSink(10000, 1, MessageQueueType::LockFree),
           m_output_dir(output_dir),
-          m_htslib_threads(int(htslib_threads)),
+          m_htslib_threads(get_shard_htslib_threads(htslib_threads, num_writer_shards)),
           m_write_fastq(write_fastq),
           m_sort_bam(sort_bam && !write_fastq),
           m_sample_sheet(std::move(sample_sheet)) {
     std::filesystem::create_directories(m_output_dir);
+    for (size_t i = 0; i < std::max(num_writer_shards, size_t(1)); ++i) {
+        auto shard = std::make_unique<WriterShard>(SHARD_QUEUE_SIZE);
+        if (m_htslib_threads > 0) {
+            shard->thread_pool.reset(hts_tpool_init(m_htslib_threads));
+            if (!shard->thread_pool) {
+                throw std::runtime_error("Could not create thread pool for demux writer.");
+            }
+        }
+        m_shards.push_back(std::move(shard));
+    }
 }
 
-BarcodeDemuxerNode::~BarcodeDemuxerNode() { stop_input_processing(); }
+BarcodeDemuxerNode::~BarcodeDemuxerNode() {
+    stop_input_processing();
+    stop_writer_shards();
+}
+
+void BarcodeDemuxerNode::restart() {
+    start_writer_shards();
+    start_input_processing([this] { input_thread_fn(); }, "brcd_demux");
+}
+
+void BarcodeDemuxerNode::start_writer_shards() {
+    // With a single shard the input thread writes the records itself.
+    if (m_shards.size() == 1) {
+        return;
+    }
+    for (auto& shard : m_shards) {
+        shard->queue.restart();
+        shard->thread = std::thread([this, &writer = *shard] { shard_thread_fn(writer); });
+    }
+}
+
+void BarcodeDemuxerNode::stop_writer_shards() {
+    // Shards write all their queued records before exiting.
+    for (auto& shard : m_shards) {
+        shard->queue.terminate();
+    }
+    for (auto& shard : m_shards) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+}
 
 void BarcodeDemuxerNode::input_thread_fn() {
     Message message;
     while (get_input_message(message)) {
         auto bam_message = std::move(std::get<BamMessage>(message));
-        write(*bam_message.bam_ptr);
+        auto& record = *bam_message.bam_ptr;
+
+        // Fetch the barcode name.
+        std::string barcode = UNCLASSIFIED;
+        auto bam_tag = bam_aux_get(&record, "BC");
+        if (bam_tag) {
+            barcode = std::string(bam_aux2Z(bam_tag));
+        }
+        if (m_sample_sheet) {
+            apply_sample_sheet_alias(*m_sample_sheet, barcode, record);
+        }
+        auto run_id = get_run_id(record);
+
+        if (m_shards.size() == 1) {
+            write(*m_shards.front(), run_id, barcode, record);
+            continue;
+        }
+
+        // Each barcode and run id is always written by the same shard.
+        auto& shard = *m_shards[std::hash<std::string>{}(run_id + barcode) % m_shards.size()];
+        shard.queue.try_push(
+                {std::move(run_id), std::move(barcode), std::move(bam_message.bam_ptr)});
+    }
+}
+
+void BarcodeDemuxerNode::shard_thread_fn(WriterShard& shard) {
+    utils::set_thread_name("brcd_demux_wr");
+    std::vector<PendingRecord> records;
+    while (shard.queue.try_pop_batch(records, MAX_INPUT_BURST) ==
+           utils::AsyncQueueStatus::Success) {
+        for (auto& pending : records) {
+            write(shard, pending.run_id, pending.barcode, *pending.record);
+        }
     }
 }
 
 // Each barcode is mapped to its own file. Depending
 // on the barcode assigned to each read, the read is
 // written to the corresponding barcode file.
-int BarcodeDemuxerNode::write(bam1_t& record) {
+int BarcodeDemuxerNode::write(WriterShard& shard,
+                              const std::string& run_id,
+                              const std::string& barcode,
+                              bam1_t& record) {
     assert(m_header);
-    // Fetch the barcode name.
-    std::string barcode = UNCLASSIFIED;
-    auto bam_tag = bam_aux_get(&record, "BC");
-    if (bam_tag) {
-        barcode = std::string(bam_aux2Z(bam_tag));
-    }
-    if (m_sample_sheet) {
-        apply_sample_sheet_alias(*m_sample_sheet, barcode, record);
-    }
-
-    const auto run_id = get_run_id(record);
 
     // Check for existence of file for that barcode and run id.
-    auto& file = m_files[run_id + barcode];
+    auto& file = shard.files[run_id + barcode];
     if (!file) {
         // For new barcodes, create a new HTS file (either fastq or BAM).
         const std::string filename = run_id + "_" + barcode + (m_write_fastq ? ".fastq" : ".bam");
@@ -117,7 +198,10 @@ int BarcodeDemuxerNode::write(bam1_t& record) {
         file = std::make_unique<utils::HtsFile>(
                 filepath_str,
                 m_write_fastq ? utils::HtsFile::OutputMode::FASTQ : utils::HtsFile::OutputMode::BAM,
-                m_htslib_threads, m_sort_bam);
+                0, m_sort_bam);
+        if (shard.thread_pool) {
+            file->set_thread_pool(shard.thread_pool.get());
+        }
         if (m_sort_bam) {
             file->set_buffer_size(BAM_BUFFER_SIZE);
         }
@@ -142,18 +226,47 @@ void BarcodeDemuxerNode::set_header(const sam_hdr_t* const header) {
 
 void BarcodeDemuxerNode::finalise_hts_files(
         const utils::HtsFile::ProgressCallback& progress_callback) {
-    const size_t num_files = m_files.size();
-    size_t current_file_idx = 0;
-    for (auto& [bc, hts_file] : m_files) {
-        hts_file->finalise([&](size_t progress) {
-            // Give each file/barcode the same contribution to the total progress.
-            const size_t total_progress = (current_file_idx * 100 + progress) / num_files;
-            progress_callback(total_progress);
-        });
-        ++current_file_idx;
-    }
-
-    m_files.clear();
+    std::vector<utils::HtsFile*> files;
+    for (auto& shard : m_shards) {
+        for (auto& [bc, hts_file] : shard->files) {
+            files.push_back(hts_file.get());
+        }
+    }
+
+    // Give each file/barcode the same contribution to the total progress.
+    const size_t num_files = files.size();
+    std::vector<size_t> file_progress(num_files, 0);
+    size_t summed_progress = 0;
+    std::mutex progress_mutex;
+    auto update_progress = [&](size_t file_idx, size_t progress) {
+        std::lock_guard lock(progress_mutex);
+        summed_progress += progress - file_progress[file_idx];
+        file_progress[file_idx] = progress;
+        progress_callback(summed_progress / num_files);
+    };
+
+    // Each worker sorts/indexes with the htslib threads of one shard, so the files are
+    // finalised with the same thread budget as they were written with.
+    std::atomic<size_t> next_file_idx{0};
+    auto finalise_files = [&] {
+        for (size_t file_idx = next_file_idx++; file_idx < num_files; file_idx = next_file_idx++) {
+            files[file_idx]->finalise(
+                    [&, file_idx](size_t progress) { update_progress(file_idx, progress); });
+        }
+    };
+    std::vector<std::future<void>> workers;
+    const size_t num_workers = std::min(m_shards.size(), num_files);
+    for (size_t i = 1; i < num_workers; ++i) {
+        workers.push_back(std::async(std::launch::async, finalise_files));
+    }
+    finalise_files();
+    for (auto& worker : workers) {
+        worker.get();
+    }
+
+    for (auto& shard : m_shards) {
+        shard->files.clear();
+    }
     progress_callback(100);
 }
 
@@ -163,6 +276,9 @@ stats::NamedStats BarcodeDemuxerNode::sample_stats() const {
     return stats;
 }
 
-void BarcodeDemuxerNode::terminate(const FlushOptions&) { stop_input_processing(); }
+void BarcodeDemuxerNode::terminate(const FlushOptions&) {
+    stop_input_processing();
+    stop_writer_shards();
+}
 
 }  // namespace dorado
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MessageSink.h"
+#include "utils/MPMCQueue.h"
 #include "utils/hts_file.h"
 #include "utils/stats.h"
 #include "utils/types.h"
@@ -9,7 +10,9 @@
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 struct bam1_t;
 
@@ -27,30 +30,57 @@ public:
                        size_t htslib_threads,
                        bool write_fastq,
                        std::unique_ptr<const utils::SampleSheet> sample_sheet,
-                       bool sort_bam);
+                       bool sort_bam,
+                       size_t num_writer_shards = 1);
     ~BarcodeDemuxerNode();
     std::string get_name() const override { return "BarcodeDemuxerNode"; }
     stats::NamedStats sample_stats() const override;
     void terminate(const FlushOptions&) override;
-    void restart() override {
-        start_input_processing([this] { input_thread_fn(); }, "brcd_demux");
-    }
+    void restart() override;
 
     void set_header(const sam_hdr_t* header);
 
     // Finalisation must occur before destruction of this node.
     // Note that this isn't safe to call until after this node has been terminated.
+    // Files are finalised in parallel, one per writer shard at a time.
     void finalise_hts_files(const utils::HtsFile::ProgressCallback& progress_callback);
 
 private:
+    // A record waiting to be written by a writer shard.
+    struct PendingRecord {
+        std::string run_id;
+        std::string barcode;
+        BamPtr record;
+    };
+
+    // Each shard owns the files of a disjoint set of barcodes, and writes them from its own
+    // thread. Its files share a thread pool holding the shard's share of the htslib threads. With
+    // a single shard the records are written directly from the input thread.
+    struct WriterShard {
+        explicit WriterShard(size_t queue_size) : queue(queue_size) {}
+
+        utils::MPMCQueue<PendingRecord> queue;
+        // Declared before the files, which must be closed before their thread pool is destroyed.
+        HtsThreadPoolPtr thread_pool;
+        HtsFiles files;
+        std::thread thread;
+    };
+
     const std::filesystem::path m_output_dir;
+    // Size of each shard's htslib thread pool, or 0 to write without htslib threads.
     const int m_htslib_threads;
     SamHdrPtr m_header;
     std::atomic<int> m_processed_reads{0};
 
-    HtsFiles m_files;
+    std::vector<std::unique_ptr<WriterShard>> m_shards;
     void input_thread_fn();
-    int write(bam1_t& record);
+    void shard_thread_fn(WriterShard& shard);
+    void start_writer_shards();
+    void stop_writer_shards();
+    int write(WriterShard& shard,
+              const std::string& run_id,
+              const std::string& barcode,
+              bam1_t& record);
     const bool m_write_fastq;
     const bool m_sort_bam;
     const std::unique_ptr<const utils::SampleSheet> m_sample_sheet;
@@ -60,13 +60,13 @@ bool populate_alignments(dorado::CorrectionAlignments& alignments,
 
     // Might be worthwhile generating dense vectors with some index mapping to save memory
     // as using filtering of useful overlaps makes these vectors sparse.
-    auto num_qnames = alignments.qnames.size();
+    auto num_qnames = alignments.qids.size();
     alignments.seqs.resize(num_qnames);
     alignments.quals.resize(num_qnames);
     alignments.cigars.resize(num_qnames);
 
     for (const size_t i : useful_overlap_idxs) {
-        const std::string& qname = alignments.qnames[i];
+        const std::string qname(alignments.qname(i));
         alignments.seqs[i] = reader->fetch_seq(qname);
         if ((int)alignments.seqs[i].length() != alignments.overlaps[i].qlen) {
             spdlog::error("qlen from before {} and qlen from after {} don't match for {}",
@@ -133,25 +133,26 @@ void CorrectionInferenceNode::decode_fn() {
     while (m_inferred_features_queue.try_pop(item) != utils::AsyncQueueStatus::Terminate) {
         utils::ScopedProfileRange spr("decode_loop", 1);
         auto read_name = item.read_name;
+        const int32_t read_id = item.read_id;
         std::vector<std::string> to_decode;
         auto pos = item.window_idx;
         auto corrected_seq = decode_window(item);
         {
             std::lock_guard<std::mutex> lock(m_features_mutex);
-            auto find_iter = m_features_by_id.find(read_name);
+            auto find_iter = m_features_by_id.find(read_id);
             if (find_iter == m_features_by_id.end()) {
                 spdlog::error("Decoded feature list not found for {}.", read_name);
                 continue;
             }
             auto& output_features = find_iter->second;
             output_features[pos] = std::move(corrected_seq);
-            auto& pending = m_pending_features_by_id.find(read_name)->second;
+            auto& pending = m_pending_features_by_id.find(read_id)->second;
             pending--;
             if (pending == 0) {
                 // Got all features!
                 to_decode = std::move(output_features);
-                m_features_by_id.erase(read_name);
-                m_pending_features_by_id.erase(read_name);
+                m_features_by_id.erase(read_id);
+                m_pending_features_by_id.erase(read_id);
             }
         }
 
@@ -161,7 +162,7 @@ void CorrectionInferenceNode::decode_fn() {
     }
 }
 
-void CorrectionInferenceNode::infer_fn(const std::string& device_str, int mtx_idx, int batch_size) {
+void CorrectionInferenceNode::infer_fn(const std::string& device_str, int mtx_idx) {
     utils::set_thread_name("corr_infer");
     spdlog::debug("Starting process thread for {}!", device_str);
     m_num_active_infer_threads++;
@@ -190,14 +191,9 @@ void CorrectionInferenceNode::infer_fn(const std::string& device_str, int mtx_id
     }
     module.eval();
 
-    std::vector<at::Tensor> bases_batch;
-    std::vector<at::Tensor> quals_batch;
     std::vector<int> lengths;
     std::vector<int64_t> sizes;
     std::vector<at::Tensor> indices_batch;
-    std::vector<WindowFeatures> wfs;
-    // If there are any windows > 5120, then reduce batch size by 1
-    int remaining_batch_slots = batch_size;
 
     auto decode_preds = [](const at::Tensor& preds) {
         std::vector<char> bases;
@@ -210,21 +206,27 @@ void CorrectionInferenceNode::infer_fn(const std::string& device_str, int mtx_id
         return bases;
     };
 
-    auto batch_infer = [&]() {
+    auto batch_infer = [&](FeatureBatch& batch) {
         utils::ScopedProfileRange infer("infer", 1);
-        // Run inference on batch
+        auto& wfs = batch.windows;
+        for (const auto& wf : wfs) {
+            lengths.push_back(wf.length);
+            sizes.push_back(wf.length);
+            indices_batch.push_back(wf.indices);
+        }
+
+        // Run inference on batch. The features were written straight into the batch tensors
+        // by the feature arena, so there's nothing to collate.
         auto length_tensor =
                 at::from_blob(lengths.data(), {(int)lengths.size()},
                               at::TensorOptions().dtype(torch::kInt32).device(torch::kCPU));
-        const at::Tensor batched_bases = collate<int>(bases_batch, (int)11, torch::kInt32);
-        const at::Tensor batched_quals = collate<float>(quals_batch, 0.f, torch::kFloat32);
 
         std::unique_lock<std::mutex> lock(m_gpu_mutexes[mtx_idx]);
         std::vector<torch::jit::IValue> inputs;
         {
             utils::ScopedProfileRange move_to_device("move_to_device", 1);
-            inputs.push_back(batched_bases.to(device));
-            inputs.push_back(batched_quals.to(device));
+            inputs.push_back(batch.bases.to(device));
+            inputs.push_back(batch.quals.to(device));
             inputs.push_back(length_tensor.to(device));
             std::for_each(indices_batch.begin(), indices_batch.end(),
                           [device](at::Tensor& t) { t.to(device); });
@@ -259,58 +261,35 @@ void CorrectionInferenceNode::infer_fn(const std::string& device_str, int mtx_id
             m_inferred_features_queue.try_push(std::move(wf));
         }
 
-        bases_batch.clear();
-        quals_batch.clear();
         lengths.clear();
         sizes.clear();
-        wfs.clear();
         indices_batch.clear();
-        remaining_batch_slots = batch_size;
     };
 
-    WindowFeatures item;
+    FeatureBatch batch;
     auto last_chunk_reserve_time = std::chrono::system_clock::now();
     while (true) {
-        const auto pop_status = m_features_queue.try_pop_until(
-                item, last_chunk_reserve_time + std::chrono::milliseconds(10000));
+        const auto pop_status = m_batch_queue.try_pop_until(
+                batch, last_chunk_reserve_time + std::chrono::milliseconds(10000));
 
         if (pop_status == utils::AsyncQueueStatus::Terminate) {
             break;
         }
 
         if (pop_status == utils::AsyncQueueStatus::Timeout) {
-            // Ended with a timeout, so run inference if there are samples.
-            if (bases_batch.size() > 0) {
-                batch_infer();
+            // Ended with a timeout, so run inference on any partially filled batches.
+            for (auto& partial_batch : m_feature_arena->flush()) {
+                batch_infer(partial_batch);
             }
             last_chunk_reserve_time = std::chrono::system_clock::now();
             continue;
         }
 
-        utils::ScopedProfileRange spr("collect_features", 1);
-        int required_batch_slots = ((int)item.bases.sizes()[1] / 5120) + 1;
-        if (required_batch_slots > remaining_batch_slots) {
-            batch_infer();
-        }
-        wfs.push_back(std::move(item));
-        auto& wf = wfs.back();
-
-        auto b = wf.bases.transpose(0, 1);
-        auto q = wf.quals.transpose(0, 1);
-
-        bases_batch.push_back(b);
-        quals_batch.push_back(q);
-        lengths.push_back(wf.length);
-        sizes.push_back(wf.length);
-        indices_batch.push_back(wf.indices);
-        remaining_batch_slots -= required_batch_slots;
+        batch_infer(batch);
+        batch = {};
         last_chunk_reserve_time = std::chrono::system_clock::now();
     }
 
-    if (bases_batch.size() > 0) {
-        batch_infer();
-    }
-
     auto remaining_threads = --m_num_active_infer_threads;
     if (remaining_threads == 0) {
         m_inferred_features_queue.terminate();
@@ -359,7 +338,7 @@ void CorrectionInferenceNode::input_thread_fn() {
             }
 
             // Get the filtered features
-            auto wfs = extract_features(windows, alignments, m_window_size);
+            auto wfs = extract_features(windows, alignments, m_window_size, *m_feature_arena);
 
             std::vector<std::string> corrected_seqs;
             corrected_seqs.resize(wfs.size());
@@ -372,6 +351,7 @@ void CorrectionInferenceNode::input_thread_fn() {
                     features_to_infer.push_back(std::move(wfs[w]));
                 } else {
                     corrected_seqs[w] = decode_window(wfs[w]);
+                    m_feature_arena->release(wfs[w]);
                 }
             }
             if (features_to_infer.empty()) {
@@ -379,18 +359,23 @@ void CorrectionInferenceNode::input_thread_fn() {
                 concat_features_and_send(corrected_seqs, tname);
             } else {
                 std::lock_guard<std::mutex> lock(m_features_mutex);
-                if (m_features_by_id.find(tname) == m_features_by_id.end()) {
-                    m_features_by_id.insert({tname, std::move(corrected_seqs)});
-                    m_pending_features_by_id.insert({tname, (int)features_to_infer.size()});
+                const int32_t read_id = alignments.read_id;
+                if (m_features_by_id.find(read_id) == m_features_by_id.end()) {
+                    m_features_by_id.insert({read_id, std::move(corrected_seqs)});
+                    m_pending_features_by_id.insert({read_id, (int)features_to_infer.size()});
                 } else {
                     spdlog::error("Features for {} already exist! Skipping.", tname);
+                    for (auto& wf : features_to_infer) {
+                        m_feature_arena->release(wf);
+                    }
                     continue;
                 }
             }
-            // Push the ones that need inference to another thread.
+            // Hand the ones that need inference to the arena, which batches them for
+            // the inference threads.
             for (auto& wf : features_to_infer) {
-                LOG_TRACE("Pushing window idx {} to features queue", wf.window_idx);
-                m_features_queue.try_push(std::move(wf));
+                LOG_TRACE("Committing window idx {} for inference", wf.window_idx);
+                m_feature_arena->commit(std::move(wf));
             }
             num_reads++;
 
@@ -407,7 +392,11 @@ void CorrectionInferenceNode::input_thread_fn() {
 
     auto remaining_threads = --m_num_active_feature_threads;
     if (remaining_threads == 0) {
-        m_features_queue.terminate();
+        // No more windows will be committed, so send the partially filled batches.
+        for (auto& batch : m_feature_arena->flush()) {
+            m_batch_queue.try_push(std::move(batch));
+        }
+        m_batch_queue.terminate();
     }
 }
 
@@ -420,10 +409,8 @@ CorrectionInferenceNode::CorrectionInferenceNode(const std::string& fastq,
         : MessageSink(1000, threads),
           m_fastq(fastq),
           m_model_config(parse_model_config(model_dir / "config.toml")),
-          m_features_queue(1000),
-          m_inferred_features_queue(500),
-          m_bases_manager(batch_size),
-          m_quals_manager(batch_size) {
+          m_batch_queue(8),
+          m_inferred_features_queue(500) {
     m_window_size = m_model_config.window_size;
 
     std::vector<std::string> devices;
@@ -443,21 +430,32 @@ CorrectionInferenceNode::CorrectionInferenceNode(const std::string& fastq,
         throw std::runtime_error("Unsupported device: " + device);
     }
 #endif
+    // Batches are built by the feature arena before being handed to an inference thread,
+    // so they all use the smallest batch size of the devices.
+    int arena_batch_size = batch_size;
+    if (batch_size == 0) {
+        const float batch_factor = (utils::starts_with(device, "cuda")) ? 0.4f : 0.8f;
+        for (const auto& dev : devices) {
+            const int device_batch_size = calculate_batch_size(dev, batch_factor);
+            if (device_batch_size == 0) {
+                throw std::runtime_error("Insufficient memory to run inference on " + dev);
+            }
+            arena_batch_size = (arena_batch_size == 0)
+                                       ? device_batch_size
+                                       : std::min(arena_batch_size, device_batch_size);
+        }
+    }
+    spdlog::info("Using batch size {} on device {}.", arena_batch_size, device);
+    const bool pin_memory = utils::starts_with(device, "cuda");
+    m_feature_arena = std::make_unique<FeatureArena>(
+            arena_batch_size, pin_memory,
+            [this](FeatureBatch&& batch) { m_batch_queue.try_push(std::move(batch)); });
+
     for (size_t d = 0; d < devices.size(); d++) {
         const auto& dev = devices[d];
-        const float batch_factor = (utils::starts_with(device, "cuda")) ? 0.4f : 0.8f;
         for (int i = 0; i < infer_threads; i++) {
-            int device_batch_size = batch_size;
-            if (batch_size == 0) {
-                device_batch_size = calculate_batch_size(dev, batch_factor);
-                if (device_batch_size == 0) {
-                    throw std::runtime_error("Insufficient memory to run inference on " + dev);
-                }
-            }
-            spdlog::info("Using batch size {} on device {} in inference thread {}.",
-                         device_batch_size, dev, i);
-            m_infer_threads.push_back(std::thread(&CorrectionInferenceNode::infer_fn, this, dev,
-                                                  (int)d, device_batch_size));
+            m_infer_threads.push_back(
+                    std::thread(&CorrectionInferenceNode::infer_fn, this, dev, (int)d));
         }
     }
     for (int i = 0; i < 4; i++) {
@@ -492,6 +490,9 @@ stats::NamedStats CorrectionInferenceNode::sample_stats() const {
     stats::NamedStats stats = stats::from_obj(m_work_queue);
     stats["num_reads_corrected"] = double(num_reads.load());
     stats["total_reads_in_input"] = total_reads_in_input;
+    for (const auto& [name, value] : m_feature_arena->sample_stats()) {
+        stats[name] = value;
+    }
     return stats;
 }
 
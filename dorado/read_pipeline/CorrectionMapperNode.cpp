@@ -20,14 +20,17 @@
 #include <spdlog/spdlog.h>
 
 #include <cassert>
+#include <cstdint>
 #include <filesystem>
+#include <stdexcept>
 
 namespace dorado {
 
 void CorrectionMapperNode::extract_alignments(const mm_reg1_t* reg,
                                               int hits,
                                               const std::string& qread,
-                                              const std::string& qname) {
+                                              const std::string& qname,
+                                              const int32_t qid) {
     for (int j = 0; j < hits; j++) {
         // mapping region
         auto aln = &reg[j];
@@ -37,35 +40,24 @@ void CorrectionMapperNode::extract_alignments(const mm_reg1_t* reg,
         }
 
         const auto& ref = m_index->index()->seq[aln->rid];
-        const std::string tname(ref.name);
+        const int32_t tid = m_target_ids[aln->rid];
 
-        // Skip self alignment.
-        if (qname == tname) {
+        // Skip self alignment, and targets which can't be fetched for inference.
+        if ((qid == tid) || (tid < 0)) {
             continue;
         }
 
-        std::unique_lock<std::mutex> lock(m_correction_mtx);
-        if (m_read_mutex.find(tname) == m_read_mutex.end()) {
-            m_read_mutex.emplace(tname, std::make_unique<std::mutex>());
-            CorrectionAlignments new_aln;
-            new_aln.read_name = tname;
-            m_correction_records.emplace(tname, std::move(new_aln));
-            m_processed_queries_per_target.emplace(tname, std::unordered_set<std::string>());
-        }
-        auto& mtx = *m_read_mutex[tname];
-        auto& processed_queries = m_processed_queries_per_target[tname];
-        auto& alignments = m_correction_records[tname];
-        lock.unlock();
+        auto& mtx = m_target_mutexes[aln->rid % NUM_TARGET_MUTEXES];
+        auto& processed_queries = m_processed_queries_per_target[aln->rid];
+        auto& alignments = m_correction_records[aln->rid];
 
         {
             std::lock_guard<std::mutex> aln_lock(mtx);
-            if (processed_queries.find(qname) != processed_queries.end()) {
+            if (!processed_queries.insert(qid).second) {
                 // Query/target pair has been processed before. Assume that
                 // the first one processed is the best one, and ignore
                 // the rest.
                 continue;
-            } else {
-                processed_queries.insert(qname);
             }
         }
 
@@ -82,7 +74,7 @@ void CorrectionMapperNode::extract_alignments(const mm_reg1_t* reg,
             spdlog::warn(
                     "Inconsistent query alignment detected: tname {} tlen {} tstart {} tend {} "
                     "qname {} qlen {} qstart {} qend {}",
-                    tname, ovlp.tlen, ovlp.tstart, ovlp.tend, qname, ovlp.qlen, ovlp.qstart,
+                    ref.name, ovlp.tlen, ovlp.tstart, ovlp.tend, qname, ovlp.qlen, ovlp.qstart,
                     ovlp.qend);
             continue;
         }
@@ -91,7 +83,7 @@ void CorrectionMapperNode::extract_alignments(const mm_reg1_t* reg,
             spdlog::warn(
                     "Inconsistent target alignment detected: tname {} tlen {} tstart {} tend {} "
                     "qname {} qlen {} qstart {} qend {}",
-                    tname, ovlp.tlen, ovlp.tstart, ovlp.tend, qname, ovlp.qlen, ovlp.qstart,
+                    ref.name, ovlp.tlen, ovlp.tstart, ovlp.tend, qname, ovlp.qlen, ovlp.qstart,
                     ovlp.qend);
             continue;
         }
@@ -102,7 +94,12 @@ void CorrectionMapperNode::extract_alignments(const mm_reg1_t* reg,
         {
             std::lock_guard<std::mutex> aln_lock(mtx);
 
-            alignments.qnames.push_back(qname);
+            if (std::empty(alignments.qids)) {
+                alignments.read_name = ref.name;
+                alignments.read_id = tid;
+                alignments.read_names = m_read_names;
+            }
+            alignments.qids.push_back(qid);
             alignments.cigars.push_back(std::move(cigar));
             alignments.overlaps.push_back(std::move(ovlp));
         }
@@ -115,18 +112,23 @@ void CorrectionMapperNode::input_thread_fn() {
     MmTbufPtr tbuf(mm_tbuf_init());
     while (m_reads_queue.try_pop(read) != utils::AsyncQueueStatus::Terminate) {
         const std::string read_name = bam_get_qname(read.get());
+        const int32_t read_id = m_read_names->find(read_name);
+        if (read_id < 0) {
+            spdlog::warn("Read '{}' is not in the index of the input reads, skipping.", read_name);
+            continue;
+        }
         const std::string read_seq = utils::extract_sequence(read.get());
         std::tuple<mm_reg1_t*, int> mapping = m_aligner->get_mapping(read.get(), tbuf.get());
         mm_reg1_t* reg = std::get<0>(mapping);
         int hits = std::get<1>(mapping);
-        extract_alignments(reg, hits, read_seq, read_name);
+        extract_alignments(reg, hits, read_seq, read_name, read_id);
         m_alignments_processed++;
         // TODO: Remove and move to ProgressTracker
         if (m_alignments_processed.load() % 10000 == 0) {
-            std::unique_lock<std::mutex> lock(m_correction_mtx);
             size_t total = 0;
-            for (auto& [_, r] : m_correction_records) {
-                total += r.size();
+            for (size_t rid = 0; rid < std::size(m_correction_records); ++rid) {
+                std::lock_guard<std::mutex> lock(m_target_mutexes[rid % NUM_TARGET_MUTEXES]);
+                total += m_correction_records[rid].size();
             }
             spdlog::debug("Alignments processed {}, total m_corrected_records size {} MB",
                           m_alignments_processed.load(), (float)total / (1024 * 1024));
@@ -165,12 +167,17 @@ void CorrectionMapperNode::send_data_fn(Pipeline& pipeline) {
         }
 
         for (auto& shadow_data : m_shadow_correction_records) {
-            spdlog::debug("Pushing {} records downstream of mapping.", shadow_data.size());
+            spdlog::debug("Pushing records of {} targets downstream of mapping.",
+                          shadow_data.size());
             int64_t num_pushed{0};
-            for (auto& [tname, r] : shadow_data) {
+            for (auto& r : shadow_data) {
+                // Skip targets without alignments.
+                if (std::empty(r.qids)) {
+                    continue;
+                }
                 // Skip reads which were already processed.
-                if (m_skip_set.count(tname) > 0) {
-                    spdlog::trace("Resuming in mapping: skipping read '{}'.", tname);
+                if (m_skip_set.count(r.read_name) > 0) {
+                    spdlog::trace("Resuming in mapping: skipping read '{}'.", r.read_name);
                     continue;
                 }
                 pipeline.push_message(std::move(r));
@@ -191,7 +198,32 @@ bool CorrectionMapperNode::load_next_index_block() {
     return false;
 }
 
+void CorrectionMapperNode::prepare_index_block() {
+    const mm_idx_t* index = m_index->index();
+    const size_t num_targets = index->n_seq;
+
+    // Intern the target names once per block, so the alignments only need to look up the IDs.
+    m_target_ids.resize(num_targets);
+    int64_t num_missing = 0;
+    for (size_t rid = 0; rid < num_targets; ++rid) {
+        m_target_ids[rid] = m_read_names->find(index->seq[rid].name);
+        num_missing += (m_target_ids[rid] < 0);
+    }
+    if (num_missing > 0) {
+        spdlog::warn("{} reads of index block {} are not in the index of the input reads.",
+                     num_missing, m_current_index);
+    }
+
+    m_correction_records.clear();
+    m_correction_records.resize(num_targets);
+    m_processed_queries_per_target.clear();
+    m_processed_queries_per_target.resize(num_targets);
+}
+
 void CorrectionMapperNode::process(Pipeline& pipeline) {
+    if (!m_read_names) {
+        throw std::runtime_error("CorrectionMapperNode needs the IDs of the input reads.");
+    }
     if (m_current_index < 0) {
         spdlog::debug(
                 "Not processing because selected block is out of bounds. m_current_index = {}",
@@ -248,6 +280,7 @@ void CorrectionMapperNode::process(Pipeline& pipeline) {
         m_reads_read.store(0);
         m_alignments_processed.store(0);
         m_reads_queue.restart();
+        prepare_index_block();
 
         // Create aligner.
         m_aligner = std::make_unique<alignment::Minimap2Aligner>(m_index);
@@ -277,8 +310,7 @@ void CorrectionMapperNode::process(Pipeline& pipeline) {
         m_copy_cv.notify_one();
 
         m_correction_records = {};
-        m_read_mutex.clear();
-        m_processed_queries_per_target.clear();
+        m_processed_queries_per_target = {};
         // 4. Load next index and loop
         m_current_index++;
     } while (m_index->load_next_chunk(m_num_threads) != alignment::IndexLoadResult::end_of_index);
@@ -291,6 +323,7 @@ void CorrectionMapperNode::process(Pipeline& pipeline) {
 }
 
 CorrectionMapperNode::CorrectionMapperNode(const std::string& index_file,
+                                           std::shared_ptr<const hts_io::ReadNameTable> read_names,
                                            int threads,
                                            uint64_t index_size,
                                            std::string furthest_skip_header,
@@ -298,6 +331,7 @@ CorrectionMapperNode::CorrectionMapperNode(const std::string& index_file,
                                            const int run_block_id)
         : MessageSink(10000, threads),
           m_index_file(index_file),
+          m_read_names(std::move(read_names)),
           m_num_threads(threads),
           m_reads_queue(5000),
           m_furthest_skip_header{std::move(furthest_skip_header)},
@@ -4,11 +4,13 @@
 #include "alignment/Minimap2Aligner.h"
 #include "alignment/Minimap2Index.h"
 #include "alignment/Minimap2IndexSupportTypes.h"
+#include "hts_io/ReadNameTable.h"
 #include "messages.h"
 #include "utils/AsyncQueue.h"
 #include "utils/stats.h"
 #include "utils/types.h"
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -18,7 +20,6 @@
 #include <mutex>
 #include <string>
 #include <thread>
-#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -28,7 +29,10 @@ class Pipeline;
 
 class CorrectionMapperNode : public MessageSink {
 public:
+    // |read_names| holds the IDs of the reads in |index_file|, and is only needed to process
+    // the alignments.
     CorrectionMapperNode(const std::string& index_file,
+                         std::shared_ptr<const hts_io::ReadNameTable> read_names,
                          int threads,
                          uint64_t index_size,
                          std::string furthest_skip_header,
@@ -49,6 +53,7 @@ public:
 
 private:
     std::string m_index_file;
+    std::shared_ptr<const hts_io::ReadNameTable> m_read_names;
     int m_num_threads;
 
     std::unique_ptr<alignment::Minimap2Aligner> m_aligner;
@@ -57,26 +62,33 @@ private:
     void input_thread_fn();
     void load_read_fn();
     void send_data_fn(Pipeline& pipeline);
+    void prepare_index_block();
 
     void extract_alignments(const mm_reg1_t* reg,
                             int hits,
                             const std::string& qread,
-                            const std::string& qname);
+                            const std::string& qname,
+                            int32_t qid);
 
     // Queue for reads being aligned.
     utils::AsyncQueue<BamPtr> m_reads_queue;
 
-    // Map to collects alignments by target id.
-    std::mutex m_correction_mtx;
-    std::unordered_map<std::string, CorrectionAlignments> m_correction_records;
-    std::unordered_map<std::string, std::unordered_set<std::string>> m_processed_queries_per_target;
+    // Read IDs of the targets in the current index block, by minimap2 sequence ID.
+    std::vector<int32_t> m_target_ids;
+
+    // Alignments collected for each target, and the IDs of the queries already aligned to it,
+    // by minimap2 sequence ID.
+    std::vector<CorrectionAlignments> m_correction_records;
+    std::vector<std::unordered_set<int32_t>> m_processed_queries_per_target;
 
     std::mutex m_copy_mtx;
     std::condition_variable m_copy_cv;
-    std::vector<std::unordered_map<std::string, CorrectionAlignments>> m_shadow_correction_records;
+    std::vector<std::vector<CorrectionAlignments>> m_shadow_correction_records;
 
-    // Mutex per target id to prevent a global lock across all targets.
-    std::unordered_map<std::string, std::unique_ptr<std::mutex>> m_read_mutex;
+    // Each target is guarded by one of a fixed set of mutexes, picked by its sequence ID, to
+    // prevent a global lock across all targets.
+    static constexpr size_t NUM_TARGET_MUTEXES = 64;
+    std::array<std::mutex, NUM_TARGET_MUTEXES> m_target_mutexes;
 
     int m_index_seqs{0};
     int m_current_index{0};
@@ -8,7 +8,10 @@
 
 #include <spdlog/spdlog.h>
 
-#include <fstream>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace dorado {
@@ -16,51 +19,68 @@ namespace dorado {
 void CorrectionPafReaderNode::process(Pipeline& pipeline) {
     timer::TimerHighRes timer;
 
-    std::ifstream file(m_paf_file);
-    if (!file.is_open()) {
-        throw std::runtime_error("Could not open PAF file " + m_paf_file);
-    }
+    utils::PafReader reader(m_paf_file);
 
     CorrectionAlignments alignments;
 
+    // Records are grouped by target, so only look up the skip set when the target changes.
+    std::optional<std::string> last_tname;
+    bool skip_target = false;
+    int32_t num_unknown_queries = 0;
+
     size_t count_records = 0;
-    std::string line;
-    while (std::getline(file, line)) {
-        utils::PafEntry entry = utils::parse_paf(line);
+    while (const auto entry = reader.next_record()) {
+        if (!last_tname || entry->tname != *last_tname) {
+            last_tname = entry->tname;
+            skip_target = m_skip_set.count(*last_tname) > 0;
+            if (!skip_target && (m_read_names->find(*last_tname) < 0)) {
+                spdlog::warn("Target read '{}' from the PAF is not in the input reads, skipping.",
+                             *last_tname);
+                skip_target = true;
+            }
+        }
 
         // Skip all blacklisted targets.
-        if (m_skip_set.count(entry.tname) > 0) {
+        if (skip_target) {
             continue;
         }
 
-        if (alignments.read_name != entry.tname) {
+        if (alignments.read_name != entry->tname) {
             if (m_reads_to_infer) {
                 spdlog::trace(
                         "Pushed {} alignments for correction for "
                         "target {}. Number of alignment piles pushed until now: {}.",
-                        std::size(alignments.qnames), alignments.read_name, m_reads_to_infer);
+                        std::size(alignments.qids), alignments.read_name, m_reads_to_infer);
                 pipeline.push_message(std::move(alignments));
             }
             alignments = CorrectionAlignments{};
-            alignments.read_name = std::move(entry.tname);
+            alignments.read_name = std::string(entry->tname);
+            alignments.read_id = m_read_names->find(alignments.read_name);
+            alignments.read_names = m_read_names;
             ++m_reads_to_infer;
         }
 
+        const int32_t qid = m_read_names->find(entry->qname);
+        if (qid < 0) {
+            // These would fail to be fetched for inference anyway.
+            ++num_unknown_queries;
+            continue;
+        }
+
         utils::Overlap ovlp;
-        ovlp.qstart = entry.qstart;
-        ovlp.qend = entry.qend;
-        ovlp.qlen = entry.qlen;
-        ovlp.fwd = entry.strand == '+';
-        ovlp.tstart = entry.tstart;
-        ovlp.tend = entry.tend;
-        ovlp.tlen = entry.tlen;
-
-        alignments.qnames.push_back(std::move(entry.qname));
+        ovlp.qstart = entry->qstart;
+        ovlp.qend = entry->qend;
+        ovlp.qlen = entry->qlen;
+        ovlp.fwd = entry->strand == '+';
+        ovlp.tstart = entry->tstart;
+        ovlp.tend = entry->tend;
+        ovlp.tlen = entry->tlen;
+
+        alignments.qids.emplace_back(qid);
         alignments.overlaps.push_back(ovlp);
 
-        const std::string_view cigar_str = utils::paf_aux_get(entry, "cg", 'Z');
-        std::vector<CigarOp> cigar = parse_cigar_from_string(cigar_str);
-        alignments.cigars.push_back(std::move(cigar));
+        const std::string_view cigar_str = utils::paf_aux_get(entry->aux, "cg", 'Z');
+        alignments.cigars.push_back(parse_cigar_from_string(cigar_str));
 
         ++count_records;
         if ((count_records % 1000000) == 0) {
@@ -70,23 +90,37 @@ void CorrectionPafReaderNode::process(Pipeline& pipeline) {
                     count_records, m_reads_to_infer, timer.GetElapsedMilliseconds() / 1000.0f);
         }
     }
-    if (!std::empty(alignments.qnames)) {
+    if (!std::empty(alignments.qids)) {
         spdlog::trace(
                 "Final pushed {} alignments for correction for "
                 "target {}. Number of piles pushed until now: {}.",
-                std::size(alignments.qnames), alignments.read_name, m_reads_to_infer);
+                std::size(alignments.qids), alignments.read_name, m_reads_to_infer);
         pipeline.push_message(std::move(alignments));
     }
 
-    spdlog::debug("PAF reading done in: {:.2f} s", timer.GetElapsedMilliseconds() / 1000.0f);
+    if (num_unknown_queries > 0) {
+        spdlog::warn("Skipped {} PAF records with query reads which are not in the input reads.",
+                     num_unknown_queries);
+    }
+
+    spdlog::debug("PAF reading done in: {:.2f} s, {} records, {} bytes",
+                  timer.GetElapsedMilliseconds() / 1000.0f, reader.num_records(),
+                  reader.num_bytes());
 }
 
-CorrectionPafReaderNode::CorrectionPafReaderNode(const std::string_view paf_file,
-                                                 std::unordered_set<std::string> skip_set)
+CorrectionPafReaderNode::CorrectionPafReaderNode(
+        const std::string_view paf_file,
+        std::shared_ptr<const hts_io::ReadNameTable> read_names,
+        std::unordered_set<std::string> skip_set)
         : MessageSink(1, 1),
           m_paf_file(paf_file),
+          m_read_names{std::move(read_names)},
           m_reads_to_infer{0},
-          m_skip_set{std::move(skip_set)} {}
+          m_skip_set{std::move(skip_set)} {
+    if (!m_read_names) {
+        throw std::runtime_error("CorrectionPafReaderNode needs the IDs of the input reads.");
+    }
+}
 
 stats::NamedStats CorrectionPafReaderNode::sample_stats() const {
     stats::NamedStats stats = stats::from_obj(m_work_queue);
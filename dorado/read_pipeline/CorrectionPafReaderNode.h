@@ -1,8 +1,10 @@
 #pragma once
 
 #include "MessageSink.h"
+#include "hts_io/ReadNameTable.h"
 #include "utils/stats.h"
 
+#include <memory>
 #include <string>
 #include <string_view>
 #include <unordered_set>
@@ -13,7 +15,9 @@ class Pipeline;
 
 class CorrectionPafReaderNode : public MessageSink {
 public:
-    CorrectionPafReaderNode(std::string_view paf_file, std::unordered_set<std::string> skip_set);
+    CorrectionPafReaderNode(std::string_view paf_file,
+                            std::shared_ptr<const hts_io::ReadNameTable> read_names,
+                            std::unordered_set<std::string> skip_set);
     ~CorrectionPafReaderNode() = default;
     std::string get_name() const override { return "CorrectionPafReaderNode"; }
     stats::NamedStats sample_stats() const override;
@@ -24,6 +28,7 @@ public:
 
 private:
     std::string m_paf_file;
+    std::shared_ptr<const hts_io::ReadNameTable> m_read_names;
     size_t m_reads_to_infer{0};
     std::unordered_set<std::string> m_skip_set;
 };
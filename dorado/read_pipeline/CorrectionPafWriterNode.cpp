@@ -11,6 +11,8 @@ CorrectionPafWriterNode::CorrectionPafWriterNode() : MessageSink(10000, 1) {}
 CorrectionPafWriterNode::~CorrectionPafWriterNode() { stop_input_processing(); }
 
 void CorrectionPafWriterNode::input_thread_fn() {
+    utils::PafWriter writer(std::cout);
+
     Message message;
     while (get_input_message(message)) {
         if (!std::holds_alternative<CorrectionAlignments>(message)) {
@@ -19,10 +21,9 @@ void CorrectionPafWriterNode::input_thread_fn() {
 
         const CorrectionAlignments alignments = std::get<CorrectionAlignments>(std::move(message));
 
-        for (size_t i = 0; i < std::size(alignments.qnames); ++i) {
-            utils::serialize_to_paf(std::cout, alignments.qnames[i], alignments.read_name,
-                                    alignments.overlaps[i], 0, 0, 60, alignments.cigars[i]);
-            std::cout << '\n';
+        for (size_t i = 0; i < std::size(alignments.qids); ++i) {
+            writer.write(alignments.qname(i), alignments.read_name, alignments.overlaps[i], 0, 0,
+                         60, alignments.cigars[i]);
         }
     }
 }
@@ -54,7 +54,7 @@ void DuplexReadTaggingNode::input_thread_fn() {
             send_message_to_sink(std::move(message));
 
             for (auto& rid : {template_read_id, complement_read_id}) {
-                if (m_parents_processed.find(rid) != m_parents_processed.end()) {
+                if (m_parents_processed.contains(rid)) {
                     // Parent read has already been processed. Do nothing.
                     continue;
                 }
@@ -72,14 +72,12 @@ void DuplexReadTaggingNode::input_thread_fn() {
                 }
             }
         } else {
-            auto find_read = m_parents_wanted.find(read_common.read_id);
-            if (find_read != m_parents_wanted.end()) {
+            if (m_parents_wanted.erase(read_common.read_id)) {
                 // If a read is in the parents wanted list, then sent it downstream
-                // and add it to the set of processed reads. It will also be removed
+                // and add it to the set of processed reads. It has also been removed
                 // from the parent reads being looked for.
                 m_parents_processed.insert(read_common.read_id);
                 send_message_to_sink(std::move(message));
-                m_parents_wanted.erase(find_read);
             } else {
                 // No duplex offspring is seen so far, so hold it and track
                 // it as available parents.
@@ -87,6 +85,7 @@ void DuplexReadTaggingNode::input_thread_fn() {
                 m_duplex_parents[read_common.read_id] = std::move(read);
             }
         }
+        update_read_id_stats();
     }
 
     for (auto& [k, v] : m_duplex_parents) {
@@ -95,17 +94,30 @@ void DuplexReadTaggingNode::input_thread_fn() {
     }
 }
 
+void DuplexReadTaggingNode::update_read_id_stats() {
+    m_read_id_bytes = m_parents_processed.memory_usage() + m_parents_wanted.memory_usage();
+    m_read_id_string_set_bytes = m_parents_processed.string_set_memory_usage() +
+                                 m_parents_wanted.string_set_memory_usage();
+}
+
 DuplexReadTaggingNode::DuplexReadTaggingNode() : MessageSink(1000, 1) {}
 
 void DuplexReadTaggingNode::restart() {
     m_duplex_parents.clear();
     m_parents_processed.clear();
     m_parents_wanted.clear();
+    update_read_id_stats();
     start_input_processing([this] { input_thread_fn(); }, "duplex_tagging");
 }
 
 stats::NamedStats DuplexReadTaggingNode::sample_stats() const {
-    return stats::from_obj(m_work_queue);
+    auto stats = stats::from_obj(m_work_queue);
+    const size_t read_id_bytes = m_read_id_bytes.load();
+    stats["read_ids_mb"] = static_cast<double>(read_id_bytes) / (1024 * 1024);
+    stats["read_ids_saved_mb"] = (static_cast<double>(m_read_id_string_set_bytes.load()) -
+                                  static_cast<double>(read_id_bytes)) /
+                                 (1024 * 1024);
+    return stats;
 }
 
 }  // namespace dorado
@@ -1,12 +1,14 @@
 #pragma once
 
 #include "ReadPipeline.h"
+#include "utils/read_id_set.h"
 #include "utils/stats.h"
 
+#include <atomic>
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 
 namespace dorado {
 
@@ -25,10 +27,15 @@ public:
 
 private:
     void input_thread_fn();
+    void update_read_id_stats();
 
     std::unordered_map<std::string, SimplexReadPtr> m_duplex_parents;
-    std::unordered_set<std::string> m_parents_processed;
-    std::unordered_set<std::string> m_parents_wanted;
+    utils::ReadIdSet m_parents_processed;
+    utils::ReadIdSet m_parents_wanted;
+
+    // Memory used by the read id sets, and the memory they would use if held as strings.
+    std::atomic<size_t> m_read_id_bytes{0};
+    std::atomic<size_t> m_read_id_string_set_bytes{0};
 };
 
 }  // namespace dorado
@@ -2,13 +2,18 @@
 
 #include "DefaultClientInfo.h"
 #include "ReadPipeline.h"
+#include "utils/AsyncQueue.h"
+#include "utils/PostCondition.h"
 #include "utils/bam_utils.h"
 #include "utils/fastq_reader.h"
+#include "utils/thread_naming.h"
 #include "utils/types.h"
 
 #include <htslib/sam.h>
 #include <spdlog/spdlog.h>
 
+#include <chrono>
+#include <exception>
 #include <filesystem>
 #include <functional>
 #include <memory>
@@ -16,6 +21,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
@@ -25,6 +31,17 @@ namespace {
 
 const std::string HTS_FORMAT_TEXT_FASTQ{"FASTQ sequence text"};
 
+// Records are handed from the read-ahead thread to the pipeline in batches of this size, and up
+// to READ_AHEAD_BATCHES batches can be waiting.
+constexpr std::size_t READ_AHEAD_BATCH_SIZE = 1000;
+constexpr std::size_t READ_AHEAD_BATCHES = 8;
+
+int64_t steady_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
 void write_bam_aux_tag_from_string(bam1_t& record, const std::string& bam_tag_string) {
     // Format TAG:TYPE:VALUE where TAG is a 2 char string, TYPE is a single char, and value
     std::istringstream tag_stream{bam_tag_string};
@@ -102,6 +119,9 @@ public:
 
     const std::string& format() const { return HTS_FORMAT_TEXT_FASTQ; }
 
+    // The FASTQ is parsed on the reader's thread.
+    void set_decode_threads(std::size_t) {}
+
     bool try_get_next_record(bam1_t& record) {
         auto fastq_record = m_fastq_reader.try_get_next_record();
         if (!fastq_record) {
@@ -140,6 +160,12 @@ public:
     sam_hdr_t* header() const { return m_header.get(); }
     const std::string& format() const { return m_format; }
 
+    void set_decode_threads(std::size_t threads) {
+        if (hts_set_threads(m_file.get(), static_cast<int>(threads)) < 0) {
+            throw std::runtime_error("Could not enable multi threading for HTS file reading.");
+        }
+    }
+
     bool try_get_next_record(bam1_t& record) {
         return sam_read1(m_file.get(), m_header.get(), &record) >= 0;
     }
@@ -167,6 +193,9 @@ bool HtsReader::try_initialise_generator(const std::string& filepath) {
     }
     m_header = generator->header();
     m_format = generator->format();
+    m_set_decode_threads = [generator](std::size_t threads) {
+        generator->set_decode_threads(threads);
+    };
     m_bam_record_generator = [generator_ = std::move(generator),
                               filename = std::filesystem::path(filepath).filename().string(),
                               this](bam1_t& bam_record) {
@@ -193,6 +222,12 @@ void HtsReader::set_record_mutator(std::function<void(BamPtr&)> mutator) {
     m_record_mutator = std::move(mutator);
 }
 
+void HtsReader::set_decode_threads(std::size_t threads) {
+    if (threads > 0) {
+        m_set_decode_threads(threads);
+    }
+}
+
 bool HtsReader::read() { return m_bam_record_generator(*record); }
 
 bool HtsReader::has_tag(const char* tagname) {
@@ -201,32 +236,103 @@ bool HtsReader::has_tag(const char* tagname) {
 }
 
 std::size_t HtsReader::read(Pipeline& pipeline, std::size_t max_reads) {
-    std::size_t num_reads = 0;
-    while (this->read()) {
-        if (m_read_list) {
-            std::string read_id = bam_get_qname(record.get());
-            if (m_read_list->find(read_id) == m_read_list->end()) {
-                continue;
+    m_read_start_ns = steady_clock_ns();
+    utils::AsyncQueue<std::vector<BamPtr>> read_ahead_queue(READ_AHEAD_BATCHES);
+
+    std::exception_ptr read_ahead_exception;
+    std::thread read_ahead_thread([&] {
+        utils::set_thread_name("hts_read_ahead");
+        try {
+            std::size_t num_selected = 0;
+            std::vector<BamPtr> batch;
+            auto push_batch = [&] {
+                ++m_batches_read_ahead;
+                if (read_ahead_queue.try_push(std::move(batch)) !=
+                    utils::AsyncQueueStatus::Success) {
+                    --m_batches_read_ahead;
+                    return false;
+                }
+                batch.clear();
+                batch.reserve(READ_AHEAD_BATCH_SIZE);
+                return true;
+            };
+            batch.reserve(READ_AHEAD_BATCH_SIZE);
+            while (max_reads == 0 || num_selected < max_reads) {
+                // Read each record straight into the record passed on to the pipeline.
+                BamPtr bam_record(bam_init1());
+                if (!m_bam_record_generator(*bam_record)) {
+                    break;
+                }
+                ++m_records_read;
+                if (m_read_list) {
+                    std::string read_id = bam_get_qname(bam_record.get());
+                    if (m_read_list->find(read_id) == m_read_list->end()) {
+                        continue;
+                    }
+                }
+                batch.push_back(std::move(bam_record));
+                ++num_selected;
+                if (batch.size() == READ_AHEAD_BATCH_SIZE && !push_batch()) {
+                    break;
+                }
             }
+            if (!batch.empty()) {
+                push_batch();
+            }
+        } catch (...) {
+            read_ahead_exception = std::current_exception();
         }
-        if (m_record_mutator) {
-            m_record_mutator(record);
+        read_ahead_queue.terminate();
+    });
+    // Stop reading ahead if pushing the records fails.
+    auto stop_read_ahead = utils::PostCondition([&] {
+        if (read_ahead_thread.joinable()) {
+            read_ahead_queue.terminate();
+            read_ahead_thread.join();
         }
+    });
 
-        BamMessage bam_message{BamPtr(bam_dup1(record.get())), m_client_info};
-        pipeline.push_message(std::move(bam_message));
-        ++num_reads;
-        if (max_reads > 0 && num_reads >= max_reads) {
-            break;
-        }
-        if (num_reads % 50000 == 0) {
-            spdlog::debug("Processed {} reads", num_reads);
+    std::size_t num_reads = 0;
+    std::vector<BamPtr> batch;
+    while (read_ahead_queue.try_pop(batch) == utils::AsyncQueueStatus::Success) {
+        --m_batches_read_ahead;
+        for (auto& bam_record : batch) {
+            if (m_record_mutator) {
+                m_record_mutator(bam_record);
+            }
+
+            BamMessage bam_message{std::move(bam_record), m_client_info};
+            pipeline.push_message(std::move(bam_message));
+            ++num_reads;
+            if (num_reads % 50000 == 0) {
+                spdlog::debug("Processed {} reads", num_reads);
+            }
         }
     }
+
+    read_ahead_thread.join();
+    if (read_ahead_exception) {
+        std::rethrow_exception(read_ahead_exception);
+    }
     spdlog::debug("Total reads processed: {}", num_reads);
     return num_reads;
 }
 
+stats::NamedStats HtsReader::sample_stats() const {
+    stats::NamedStats stats;
+    const auto records_read = m_records_read.load();
+    stats["records_read"] = static_cast<double>(records_read);
+    stats["batches_read_ahead"] = static_cast<double>(m_batches_read_ahead.load());
+    const auto read_start_ns = m_read_start_ns.load();
+    if (read_start_ns != 0) {
+        const double elapsed_s = static_cast<double>(steady_clock_ns() - read_start_ns) / 1e9;
+        if (elapsed_s > 0) {
+            stats["records_per_second"] = static_cast<double>(records_read) / elapsed_s;
+        }
+    }
+    return stats;
+}
+
 sam_hdr_t* HtsReader::header() { return m_header; }
 
 const std::string& HtsReader::format() const { return m_format; }
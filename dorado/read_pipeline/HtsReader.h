@@ -7,6 +7,7 @@
 
 #include <htslib/sam.h>
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -30,13 +31,21 @@ public:
     // if one isn't included in the data, but that can be disabled with this method.
     void set_add_filename_tag(bool should) { m_add_filename_tag = should; }
 
+    // Decompresses BGZF/CRAM input on |threads| htslib worker threads.
+    // Has no effect on inputs that htslib doesn't read, such as FASTQ containing Us.
+    void set_decode_threads(std::size_t threads);
+
     bool read();
 
     // If reading directly into a pipeline need to set the client info on the messages
     void set_client_info(std::shared_ptr<ClientInfo> client_info);
+    // Records are read and filtered in batches on a separate read-ahead thread, so that decoding
+    // the input overlaps with pushing records into the pipeline.
     std::size_t read(Pipeline& pipeline, std::size_t max_reads);
     template <typename T>
     T get_tag(const char* tagname);
+    template <typename T>
+    static T get_tag(const bam1_t* record, const char* tagname);
     bool has_tag(const char* tagname);
     void set_record_mutator(std::function<void(BamPtr&)> mutator);
 
@@ -47,6 +56,9 @@ public:
     const sam_hdr_t* header() const;
     const std::string& format() const;
 
+    std::string get_name() const { return "HtsReader"; }
+    stats::NamedStats sample_stats() const;
+
 private:
     sam_hdr_t* m_header{nullptr};  // non-owning
     std::string m_format;
@@ -56,16 +68,27 @@ private:
     std::optional<std::unordered_set<std::string>> m_read_list;
 
     std::function<bool(bam1_t&)> m_bam_record_generator;
+    std::function<void(std::size_t)> m_set_decode_threads;
     bool m_add_filename_tag{true};
 
+    // Reader throughput, for stats.
+    std::atomic<std::size_t> m_records_read{0};
+    std::atomic<std::size_t> m_batches_read_ahead{0};
+    std::atomic<int64_t> m_read_start_ns{0};
+
     template <typename T>
     bool try_initialise_generator(const std::string& filename);
 };
 
 template <typename T>
 T HtsReader::get_tag(const char* tagname) {
+    return get_tag<T>(record.get(), tagname);
+}
+
+template <typename T>
+T HtsReader::get_tag(const bam1_t* record, const char* tagname) {
     T tag_value{};
-    uint8_t* tag = bam_aux_get(record.get(), tagname);
+    const uint8_t* tag = bam_aux_get(record, tagname);
 
     if (!tag) {
         return tag_value;
@@ -12,13 +12,16 @@
 #include <cassert>
 #include <filesystem>
 #include <stdexcept>
+#include <vector>
 
 namespace dorado {
 
 using OutputMode = dorado::utils::HtsFile::OutputMode;
 
 HtsWriter::HtsWriter(utils::HtsFile& file, std::string gpu_names)
-        : MessageSink(10000, 1), m_file(file), m_gpu_names(std::move(gpu_names)) {
+        : MessageSink(10000, 1, MessageQueueType::LockFree),
+          m_file(file),
+          m_gpu_names(std::move(gpu_names)) {
     if (!m_gpu_names.empty()) {
         m_gpu_names = "gpu:" + m_gpu_names;
     }
@@ -38,55 +41,58 @@ OutputMode HtsWriter::get_output_mode(const std::string& mode) {
 }
 
 void HtsWriter::input_thread_fn() {
-    Message message;
-    while (get_input_message(message)) {
-        if (!std::holds_alternative<BamMessage>(message)) {
-            continue;
-        }
+    // Pop the messages in bursts, since writing each one is cheap compared to waking up for it.
+    std::vector<Message> messages;
+    while (get_input_messages(messages)) {
+        for (auto& message : messages) {
+            if (!std::holds_alternative<BamMessage>(message)) {
+                continue;
+            }
 
-        auto bam_message = std::move(std::get<BamMessage>(message));
-        BamPtr aln = std::move(bam_message.bam_ptr);
+            auto bam_message = std::move(std::get<BamMessage>(message));
+            BamPtr aln = std::move(bam_message.bam_ptr);
 
-        if (m_file.get_output_mode() == utils::HtsFile::OutputMode::FASTQ) {
-            if (!m_gpu_names.empty()) {
-                bam_aux_append(aln.get(), "DS", 'Z', int(m_gpu_names.length() + 1),
-                               (uint8_t*)m_gpu_names.c_str());
+            if (m_file.get_output_mode() == utils::HtsFile::OutputMode::FASTQ) {
+                if (!m_gpu_names.empty()) {
+                    bam_aux_append(aln.get(), "DS", 'Z', int(m_gpu_names.length() + 1),
+                                   (uint8_t*)m_gpu_names.c_str());
+                }
             }
-        }
 
-        auto res = write(aln.get());
-        if (res < 0) {
-            throw std::runtime_error("Failed to write SAM record, error code " +
-                                     std::to_string(res));
-        }
+            auto res = write(aln.get());
+            if (res < 0) {
+                throw std::runtime_error("Failed to write SAM record, error code " +
+                                         std::to_string(res));
+            }
 
-        // For the purpose of estimating write count, we ignore duplex reads
-        int64_t dx_tag = 0;
-        auto tag_str = bam_aux_get(aln.get(), "dx");
-        if (tag_str) {
-            dx_tag = bam_aux2i(tag_str);
-        }
+            // For the purpose of estimating write count, we ignore duplex reads
+            int64_t dx_tag = 0;
+            auto tag_str = bam_aux_get(aln.get(), "dx");
+            if (tag_str) {
+                dx_tag = bam_aux2i(tag_str);
+            }
 
-        bool ignore_read_id = dx_tag == 1;
-
-        if (ignore_read_id) {
-            // Read is a duplex read.
-            m_duplex_reads_written++;
-        } else {
-            std::string read_id;
-
-            // If read is a split read, use the parent read id
-            // to track write count since we don't know a priori
-            // how many split reads will be generated.
-            auto pid_tag = bam_aux_get(aln.get(), "pi");
-            if (pid_tag) {
-                read_id = std::string(bam_aux2Z(pid_tag));
-                m_split_reads_written++;
+            bool ignore_read_id = dx_tag == 1;
+
+            if (ignore_read_id) {
+                // Read is a duplex read.
+                m_duplex_reads_written++;
             } else {
-                read_id = bam_get_qname(aln.get());
+                std::string_view read_id;
+
+                // If read is a split read, use the parent read id
+                // to track write count since we don't know a priori
+                // how many split reads will be generated.
+                auto pid_tag = bam_aux_get(aln.get(), "pi");
+                if (pid_tag) {
+                    read_id = bam_aux2Z(pid_tag);
+                    m_split_reads_written++;
+                } else {
+                    read_id = bam_get_qname(aln.get());
+                }
+
+                m_processed_read_ids.add(read_id);
             }
-
-            m_processed_read_ids.add(std::move(read_id));
         }
     }
 }
@@ -120,6 +126,12 @@ stats::NamedStats HtsWriter::sample_stats() const {
     stats["unique_simplex_reads_written"] = static_cast<double>(m_processed_read_ids.size());
     stats["duplex_reads_written"] = static_cast<double>(m_duplex_reads_written.load());
     stats["split_reads_written"] = static_cast<double>(m_split_reads_written.load());
+    const auto read_id_bytes = m_processed_read_ids.memory_usage();
+    const auto string_set_bytes = m_processed_read_ids.string_set_memory_usage();
+    stats["read_ids_mb"] = static_cast<double>(read_id_bytes) / (1024 * 1024);
+    stats["read_ids_saved_mb"] =
+            (static_cast<double>(string_set_bytes) - static_cast<double>(read_id_bytes)) /
+            (1024 * 1024);
     return stats;
 }
 
@@ -127,9 +139,18 @@ void HtsWriter::terminate(const FlushOptions&) { stop_input_processing(); }
 
 std::size_t HtsWriter::ProcessedReadIds::size() const { return m_threadsafe_count_of_reads; }
 
-void HtsWriter::ProcessedReadIds::add(std::string read_id) {
-    read_ids.insert(std::move(read_id));
-    m_threadsafe_count_of_reads = read_ids.size();
+std::size_t HtsWriter::ProcessedReadIds::memory_usage() const { return m_threadsafe_memory_usage; }
+
+std::size_t HtsWriter::ProcessedReadIds::string_set_memory_usage() const {
+    return m_threadsafe_string_set_memory_usage;
+}
+
+void HtsWriter::ProcessedReadIds::add(std::string_view read_id) {
+    if (read_ids.insert(read_id)) {
+        m_threadsafe_count_of_reads = read_ids.size();
+        m_threadsafe_memory_usage = read_ids.memory_usage();
+        m_threadsafe_string_set_memory_usage = read_ids.string_set_memory_usage();
+    }
 }
 
 }  // namespace dorado
@@ -1,6 +1,7 @@
 #pragma once
 #include "MessageSink.h"
 #include "utils/hts_file.h"
+#include "utils/read_id_set.h"
 #include "utils/stats.h"
 
 #include <atomic>
@@ -8,8 +9,8 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <thread>
-#include <unordered_set>
 
 struct bam1_t;
 
@@ -52,15 +53,22 @@ private:
     //  single writer thread calling add()
     //  many threads may concurrently call size().
     class ProcessedReadIds {
-        std::unordered_set<std::string> read_ids;
+        utils::ReadIdSet read_ids;
         std::atomic<std::size_t> m_threadsafe_count_of_reads{};
+        std::atomic<std::size_t> m_threadsafe_memory_usage{};
+        std::atomic<std::size_t> m_threadsafe_string_set_memory_usage{};
 
     public:
         // Thread safe access to count of unique read-ids
         std::size_t size() const;
 
+        // Thread safe access to the memory used by the read-ids, and the memory they would
+        // take if held as strings.
+        std::size_t memory_usage() const;
+        std::size_t string_set_memory_usage() const;
+
         // Not thread safe for concurrent calls.
-        void add(std::string read_id);
+        void add(std::string_view read_id);
     } m_processed_read_ids;
 };
 
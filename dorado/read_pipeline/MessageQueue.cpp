@@ -0,0 +1,72 @@
+#include "MessageQueue.h"
+
+#include <utility>
+
+namespace dorado {
+
+MessageQueue::MessageQueue(size_t capacity, MessageQueueType type) : m_type(type) {
+    if (m_type == MessageQueueType::LockFree) {
+        m_lock_free_queue = std::make_unique<utils::MPMCQueue<Message>>(capacity);
+    } else {
+        m_locking_queue = std::make_unique<utils::AsyncQueue<Message>>(capacity);
+    }
+}
+
+MessageQueue::~MessageQueue() = default;
+
+template <class Fn>
+decltype(auto) MessageQueue::visit(Fn&& fn) {
+    if (m_lock_free_queue) {
+        return fn(*m_lock_free_queue);
+    }
+    return fn(*m_locking_queue);
+}
+
+template <class Fn>
+decltype(auto) MessageQueue::visit(Fn&& fn) const {
+    if (m_lock_free_queue) {
+        return fn(std::as_const(*m_lock_free_queue));
+    }
+    return fn(std::as_const(*m_locking_queue));
+}
+
+utils::AsyncQueueStatus MessageQueue::try_push(Message&& message) {
+    return visit([&message](auto& queue) { return queue.try_push(std::move(message)); });
+}
+
+utils::AsyncQueueStatus MessageQueue::try_push_batch(std::vector<Message>& messages) {
+    return visit([&messages](auto& queue) { return queue.try_push_batch(messages); });
+}
+
+utils::AsyncQueueStatus MessageQueue::try_pop(Message& message) {
+    return visit([&message](auto& queue) { return queue.try_pop(message); });
+}
+
+utils::AsyncQueueStatus MessageQueue::try_pop_batch(std::vector<Message>& messages,
+                                                    size_t max_count) {
+    return visit([&messages, max_count](auto& queue) {
+        return queue.try_pop_batch(messages, max_count);
+    });
+}
+
+void MessageQueue::terminate() {
+    visit([](auto& queue) { queue.terminate(); });
+}
+
+void MessageQueue::restart() {
+    visit([](auto& queue) { queue.restart(); });
+}
+
+size_t MessageQueue::capacity() const {
+    return visit([](const auto& queue) { return queue.capacity(); });
+}
+
+size_t MessageQueue::size() const {
+    return visit([](const auto& queue) { return queue.size(); });
+}
+
+std::unordered_map<std::string, double> MessageQueue::sample_stats() const {
+    return visit([](const auto& queue) { return queue.sample_stats(); });
+}
+
+}  // namespace dorado
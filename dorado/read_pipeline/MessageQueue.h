@@ -0,0 +1,57 @@
+#pragma once
+
+#include "messages.h"
+#include "utils/AsyncQueue.h"
+#include "utils/MPMCQueue.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dorado {
+
+// Implementation of the input queue of a MessageSink.
+enum class MessageQueueType {
+    // utils::AsyncQueue, guarded by a mutex and condition variables.
+    Locking,
+    // utils::MPMCQueue, which only takes a lock when a thread has to sleep. Suits nodes which do
+    // little work per message, where the queue itself is a significant part of the cost.
+    LockFree,
+};
+
+// Queue of messages with an implementation selected at construction, with the interface of
+// utils::AsyncQueue.
+class MessageQueue {
+public:
+    MessageQueue(size_t capacity, MessageQueueType type);
+    ~MessageQueue();
+
+    utils::AsyncQueueStatus try_push(Message&& message);
+    utils::AsyncQueueStatus try_push_batch(std::vector<Message>& messages);
+    utils::AsyncQueueStatus try_pop(Message& message);
+    utils::AsyncQueueStatus try_pop_batch(std::vector<Message>& messages, size_t max_count);
+
+    void terminate();
+    void restart();
+
+    size_t capacity() const;
+    size_t size() const;
+    MessageQueueType type() const { return m_type; }
+
+    std::string get_name() const { return "queue"; }
+    std::unordered_map<std::string, double> sample_stats() const;
+
+private:
+    // Calls fn with whichever queue is in use.
+    template <class Fn>
+    decltype(auto) visit(Fn&& fn);
+    template <class Fn>
+    decltype(auto) visit(Fn&& fn) const;
+
+    const MessageQueueType m_type;
+    std::unique_ptr<utils::AsyncQueue<Message>> m_locking_queue;
+    std::unique_ptr<utils::MPMCQueue<Message>> m_lock_free_queue;
+};
+
+}  // namespace dorado
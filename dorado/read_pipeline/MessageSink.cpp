@@ -6,8 +6,10 @@
 
 namespace dorado {
 
-MessageSink::MessageSink(size_t max_messages, int num_input_threads)
-        : m_work_queue(max_messages), m_num_input_threads(num_input_threads) {}
+MessageSink::MessageSink(size_t max_messages,
+                         int num_input_threads,
+                         MessageQueueType queue_type)
+        : m_work_queue(max_messages, queue_type), m_num_input_threads(num_input_threads) {}
 
 void MessageSink::push_message_internal(Message &&message) {
 #ifndef NDEBUG
@@ -19,6 +21,52 @@ void MessageSink::push_message_internal(Message &&message) {
     assert(status == utils::AsyncQueueStatus::Success);
 }
 
+void MessageSink::push_messages(std::vector<Message> &&messages) {
+    std::vector<Message> batch = std::move(messages);
+#ifndef NDEBUG
+    const auto status =
+#endif
+            m_work_queue.try_push_batch(batch);
+    // As in push_message_internal, we do not expect to be pushing to a terminated sink.
+    assert(status == utils::AsyncQueueStatus::Success);
+}
+
+bool MessageSink::get_input_messages(std::vector<Message> &messages, size_t max_count) {
+    while (m_work_queue.try_pop_batch(messages, max_count) == utils::AsyncQueueStatus::Success) {
+        if (m_sinks.empty() || !forward_on_disconnected()) {
+            return true;
+        }
+
+        // Pass on the reads of disconnected clients without processing them, as get_input_message
+        // does, keeping the order of the remaining messages.
+        std::vector<Message> disconnected;
+        auto is_disconnected = [](const Message &message) {
+            return is_read_message(message) && get_read_common_data(message).client_info &&
+                   get_read_common_data(message).client_info->is_disconnected();
+        };
+        size_t num_kept = 0;
+        for (size_t i = 0; i < messages.size(); ++i) {
+            if (is_disconnected(messages[i])) {
+                disconnected.push_back(std::move(messages[i]));
+            } else {
+                if (num_kept != i) {
+                    messages[num_kept] = std::move(messages[i]);
+                }
+                ++num_kept;
+            }
+        }
+        messages.resize(num_kept);
+        if (!disconnected.empty()) {
+            send_messages_to_sink(0, std::move(disconnected));
+        }
+        if (!messages.empty()) {
+            return true;
+        }
+    }
+    messages.clear();
+    return false;
+}
+
 void MessageSink::add_sink(MessageSink &sink) { m_sinks.push_back(std::ref(sink)); }
 
 void MessageSink::start_input_processing(const std::function<void()> &input_thread_fn,
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ClientInfo.h"
+#include "MessageQueue.h"
 #include "flush_options.h"
 #include "messages.h"
 #include "utils/AsyncQueue.h"
@@ -25,7 +26,9 @@ namespace dorado {
 // waits on the input queue before attempting to join input worker threads.
 class MessageSink {
 public:
-    MessageSink(size_t max_messages, int num_input_threads);
+    MessageSink(size_t max_messages,
+                int num_input_threads,
+                MessageQueueType queue_type = MessageQueueType::Locking);
 
     virtual ~MessageSink() = default;
 
@@ -43,6 +46,10 @@ public:
         push_message_internal(Message(std::move(msg)));
     }
 
+    // Adds a burst of messages to the input queue, in order.  This can block if the sink's
+    // queue is full.
+    void push_messages(std::vector<Message>&& messages);
+
     // Waits until work is finished and shuts down worker threads.
     // No work can be done by the node after this returns until
     // restart is subsequently called.
@@ -75,6 +82,19 @@ protected:
         send_message_to_sink(0, std::forward<Msg>(message));
     }
 
+    // Sends a burst of messages to the designated sink, in order.
+    void send_messages_to_sink(int sink_index, std::vector<Message>&& messages) {
+        m_sinks.at(sink_index).get().push_messages(std::move(messages));
+    }
+
+    // Version for nodes with a single sink that is implicit.
+    void send_messages_to_sink(std::vector<Message>&& messages) {
+        if (m_sinks.size() != 1) {
+            throw std::runtime_error("Invalid m_sinks size");
+        }
+        send_messages_to_sink(0, std::move(messages));
+    }
+
     // Pops the next input message, returning true on success.
     // If terminating, returns false.
     bool get_input_message(Message& message) {
@@ -90,8 +110,16 @@ protected:
         return status == utils::AsyncQueueStatus::Success;
     }
 
+    // Default maximum number of messages popped at once by get_input_messages.
+    static constexpr size_t MAX_INPUT_BURST = 64;
+
+    // Replaces the contents of messages with up to max_count input messages, taken from the
+    // queue at once, returning true on success.
+    // If terminating, returns false.
+    bool get_input_messages(std::vector<Message>& messages, size_t max_count = MAX_INPUT_BURST);
+
     // Queue of work items for this node.
-    utils::AsyncQueue<Message> m_work_queue;
+    MessageQueue m_work_queue;
 
     // Mark the input queue as active, and start input processing threads executing the
     // supplied functor.
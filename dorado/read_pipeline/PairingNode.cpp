@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <limits>
 
 namespace {
@@ -17,6 +18,8 @@ const int kMaxTimeDeltaMs = 10000;
 const int kMinOverlapLength = 50;
 const int kMinSeqLength = 500;
 const float kMinSimplexQScore = 8.f;
+// Number of read cache shards per worker thread, to keep lock contention between threads low.
+const size_t kCacheShardsPerThread = 4;
 
 size_t read_signal_bytes(const dorado::SimplexRead& read) {
     return read.read_common.raw_data.nbytes();
@@ -71,7 +74,7 @@ PairingNode::PairingResult PairingNode::is_within_time_and_length_criteria(
         const dorado::SimplexRead& comp,
         int tid) {
     if (!are_reads_adjacent(temp, comp)) {
-        return {false, 0, 0, 0, 0};
+        return {false, 0, 0, 0, 0, std::nullopt};
     }
 
     int delta = int(comp.read_common.start_time_ms - temp.get_end_time_ms());
@@ -84,7 +87,7 @@ PairingNode::PairingResult PairingNode::is_within_time_and_length_criteria(
 
     if ((delta < 0) || (delta >= kMaxTimeDeltaMs) || (min_seq_len < kMinSeqLength) ||
         (min_qscore < kMinSimplexQScore)) {
-        return {false, 0, 0, 0, 0};
+        return {false, 0, 0, 0, 0, std::nullopt};
     }
 
     const float kEarlyAcceptSeqLenRatio = 0.98f;
@@ -97,8 +100,9 @@ PairingNode::PairingResult PairingNode::is_within_time_and_length_criteria(
                       comp.read_common.seq.length(), temp.read_common.read_id,
                       comp.read_common.read_id);
         m_early_accepted_pairs++;
+        // The reads are near enough the same length that they should overlap end to end.
         return {true, 0, int(temp.read_common.seq.length() - 1), 0,
-                int(comp.read_common.seq.length() - 1)};
+                int(comp.read_common.seq.length() - 1), 0};
     }
 
     return is_within_alignment_criteria(temp, comp, delta, true, tid);
@@ -110,7 +114,7 @@ PairingNode::PairingResult PairingNode::is_within_alignment_criteria(
         int delta,
         bool allow_rejection,
         int tid) {
-    PairingResult pair_result = {false, 0, 0, 0, 0};
+    PairingResult pair_result = {false, 0, 0, 0, 0, std::nullopt};
     const std::string nvtx_id = "pairing_map_" + std::to_string(tid);
     nvtx3::scoped_range loop{nvtx_id};
 
@@ -155,7 +159,14 @@ PairingNode::PairingResult PairingNode::is_within_alignment_criteria(
 
         if (cond || !allow_rejection) {
             m_overlap_accepted_pairs++;
-            pair_result = {true, temp_start, temp_end, comp_start, comp_end};
+            // The stereo encoder aligns the complement's reverse complement from comp_start,
+            // and the overlap starts at the reverse complement of comp_end in it.
+            std::optional<int64_t> overlap_diagonal;
+            if (rev) {
+                overlap_diagonal = static_cast<int64_t>(comp.read_common.seq.length()) -
+                                   comp_end - comp_start;
+            }
+            pair_result = {true, temp_start, temp_end, comp_start, comp_end, overlap_diagonal};
         }
     }
 
@@ -224,13 +235,14 @@ void PairingNode::pair_list_worker_thread(int tid) {
 
                 int delta = int(complement_read->read_common.start_time_ms -
                                 template_read->get_end_time_ms());
-                auto [is_pair, qs, qe, rs, re] = is_within_alignment_criteria(
+                auto [is_pair, qs, qe, rs, re, overlap_diagonal] = is_within_alignment_criteria(
                         *template_read, *complement_read, delta, false, tid);
                 if (is_pair) {
                     ReadPair read_pair;
                     read_pair.template_read = ReadPair::ReadData::from_read(*template_read, qs, qe);
                     read_pair.complement_read =
                             ReadPair::ReadData::from_read(*complement_read, rs, re);
+                    read_pair.overlap_diagonal = overlap_diagonal;
 
                     template_read->is_duplex_parent = true;
                     complement_read->is_duplex_parent = true;
@@ -248,6 +260,137 @@ void PairingNode::pair_list_worker_thread(int tid) {
     --m_num_active_worker_threads;
 }
 
+size_t PairingNode::UniquePoreIdentifierKeyHash::operator()(
+        const UniquePoreIdentifierKey& key) const {
+    size_t hash = std::hash<int>{}(std::get<0>(key));
+    hash = hash * 31 + std::hash<std::string>{}(std::get<1>(key));
+    return hash * 31 + std::hash<std::string>{}(std::get<2>(key));
+}
+
+std::unique_lock<std::mutex> PairingNode::CacheShard::lock() {
+    std::unique_lock<std::mutex> shard_lock(mutex, std::try_to_lock);
+    if (!shard_lock.owns_lock()) {
+        ++lock_contentions;
+        shard_lock.lock();
+    }
+    ++lock_acquisitions;
+    return shard_lock;
+}
+
+PairingNode::PoreCacheKey PairingNode::get_pore_cache_key(const SimplexRead& read) {
+    UniquePoreIdentifierKey pore_key = std::make_tuple(read.read_common.attributes.channel_number,
+                                                       read.read_common.run_id,
+                                                       read.read_common.flowcell_id);
+    uint32_t pore_id = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_pore_ids_mutex);
+        auto it = m_pore_ids.find(pore_key);
+        if (it != m_pore_ids.end()) {
+            pore_id = it->second;
+        } else {
+            lock.unlock();
+            std::unique_lock<std::shared_mutex> unique_lock(m_pore_ids_mutex);
+            const auto next_id = static_cast<uint32_t>(m_pore_ids.size());
+            pore_id = m_pore_ids.emplace(std::move(pore_key), next_id).first->second;
+        }
+    }
+    const auto client_id = static_cast<uint32_t>(read.read_common.client_info->client_id());
+    return (static_cast<PoreCacheKey>(client_id) << 32) | pore_id;
+}
+
+PairingNode::CacheShard& PairingNode::get_cache_shard(PoreCacheKey key) {
+    // Mix the key so that the client_id also affects which shard is used.
+    const uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+    return *m_cache_shards[(hash >> 32) % m_cache_shards.size()];
+}
+
+void PairingNode::add_to_pore_order(PoreCacheKey key, uint64_t generation) {
+    std::pair<PoreCacheKey, uint64_t> oldest;
+    {
+        std::lock_guard<std::mutex> lock(m_pore_order_mutex);
+        auto& pore_order = m_pore_order[static_cast<int32_t>(key >> 32)];
+        pore_order.emplace_back(key, generation);
+        if (pore_order.size() <= m_max_num_keys) {
+            return;
+        }
+        // Remove the oldest key (front of the list)
+        oldest = pore_order.front();
+        pore_order.pop_front();
+    }
+    evict_pore(oldest.first, oldest.second);
+}
+
+void PairingNode::evict_pore(PoreCacheKey key, uint64_t generation) {
+    auto& shard = get_cache_shard(key);
+    auto lock = shard.lock();
+    auto pore_it = shard.pore_reads.find(key);
+    if (pore_it == shard.pore_reads.end() || pore_it->second.generation != generation) {
+        // The pore has already been removed from the cache.
+        return;
+    }
+
+    auto& reads = pore_it->second.reads;
+    shard.num_cached_reads -= reads.size();
+    --shard.num_cached_pores;
+    for (auto& read_ptr : reads) {
+        m_cache_signal_bytes -= read_signal_bytes(*read_ptr);
+        shard.reads_to_clear.insert(std::move(read_ptr));
+    }
+    shard.pore_reads.erase(pore_it);
+    clear_finished_reads(shard);
+}
+
+void PairingNode::clear_finished_reads(CacheShard& shard) {
+    for (auto to_clear_itr = shard.reads_to_clear.begin();
+         to_clear_itr != shard.reads_to_clear.end();) {
+        auto in_flight_itr = shard.reads_in_flight_ctr.find(to_clear_itr->get());
+        bool ok_to_clear = false;
+        // If a read to clear is not in-flight (not in the in-flight list
+        // or in-flight counter is 0), then clear it
+        // from the cache.
+        if (in_flight_itr == shard.reads_in_flight_ctr.end()) {
+            ok_to_clear = true;
+        } else if (in_flight_itr->second == 0) {
+            shard.reads_in_flight_ctr.erase(in_flight_itr);
+            ok_to_clear = true;
+        }
+        if (ok_to_clear) {
+            auto read_handle = shard.reads_to_clear.extract(*to_clear_itr++);
+            send_message_to_sink(std::move(read_handle.value()));
+        } else {
+            ++to_clear_itr;
+        }
+    }
+}
+
+void PairingNode::flush_cached_reads(std::optional<int32_t> client_id) {
+    for (auto& shard : m_cache_shards) {
+        auto lock = shard->lock();
+        for (auto pore_it = shard->pore_reads.begin(); pore_it != shard->pore_reads.end();) {
+            if (client_id && static_cast<int32_t>(pore_it->first >> 32) != *client_id) {
+                ++pore_it;
+                continue;
+            }
+            auto& reads = pore_it->second.reads;
+            shard->num_cached_reads -= reads.size();
+            --shard->num_cached_pores;
+            for (auto& read_ptr : reads) {
+                m_cache_signal_bytes -= read_signal_bytes(*read_ptr);
+                // Push each read message
+                send_message_to_sink(std::move(read_ptr));
+            }
+            pore_it = shard->pore_reads.erase(pore_it);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_pore_order_mutex);
+    if (client_id) {
+        m_pore_order.erase(*client_id);
+    } else {
+        m_pore_order.clear();
+    }
+}
+
 void PairingNode::pair_generating_worker_thread(int tid) {
     utils::set_thread_name("pair_gen_thrd");
     at::InferenceMode inference_mode_guard;
@@ -256,21 +399,13 @@ void PairingNode::pair_generating_worker_thread(int tid) {
         return read1->read_common.start_time_ms < read2->read_common.start_time_ms;
     };
 
+    const bool limit_num_keys = m_max_num_keys != std::numeric_limits<size_t>::max();
+
     Message message;
     while (get_input_message(message)) {
         if (std::holds_alternative<CacheFlushMessage>(message)) {
-            std::unique_lock<std::mutex> lock(m_pairing_mtx);
             auto flush_message = std::get<CacheFlushMessage>(message);
-            auto& read_cache = m_read_caches[flush_message.client_id];
-            for (auto& [key, reads_list] : read_cache.channel_read_map) {
-                // kv is a std::pair<UniquePoreIdentifierKey, std::list<std::shared_ptr<Read>>>
-                for (auto& read_ptr : reads_list) {
-                    // Push each read message
-                    m_cache_signal_bytes -= read_signal_bytes(*read_ptr);
-                    send_message_to_sink(std::move(read_ptr));
-                }
-            }
-            m_read_caches.erase(flush_message.client_id);
+            flush_cached_reads(flush_message.client_id);
             continue;
         }
 
@@ -285,165 +420,122 @@ void PairingNode::pair_generating_worker_thread(int tid) {
         // If this message isn't a read, we'll get a bad_variant_access exception.
         auto read = std::get<SimplexReadPtr>(std::move(message));
 
-        int channel = read->read_common.attributes.channel_number;
-        std::string run_id = read->read_common.run_id;
-        std::string flowcell_id = read->read_common.flowcell_id;
-        int32_t client_id = read->read_common.client_info->client_id();
-
-        std::unique_lock<std::mutex> lock(m_pairing_mtx);
-
-        auto& read_cache = m_read_caches[client_id];
-        UniquePoreIdentifierKey key = std::make_tuple(channel, run_id, flowcell_id);
-        auto read_list_iter = read_cache.channel_read_map.find(key);
-        // Check if the key is already in the list
-        if (read_list_iter == read_cache.channel_read_map.end()) {
-            // Key is not in the dequeue
-            // Add the new key to the end of the list
-            {
-                read_cache.working_channel_keys.push_back(key);
-                std::list<SimplexReadPtr> reads;
-                m_cache_signal_bytes += read_signal_bytes(*read);
-                reads.push_back(std::move(read));
-                read_cache.channel_read_map.emplace(key, std::move(reads));
-            }
+        const PoreCacheKey key = get_pore_cache_key(*read);
+        auto& shard = get_cache_shard(key);
+        auto lock = shard.lock();
 
-            if (read_cache.working_channel_keys.size() > m_max_num_keys) {
-                // Remove the oldest key (front of the list)
-                auto oldest_key = read_cache.working_channel_keys.front();
-                read_cache.working_channel_keys.pop_front();
-
-                auto oldest_key_it = read_cache.channel_read_map.find(oldest_key);
+        auto read_list_iter = shard.pore_reads.find(key);
+        // Check if the key is already in the cache
+        if (read_list_iter == shard.pore_reads.end()) {
+            const uint64_t generation = m_next_pore_generation++;
+            auto& pore = shard.pore_reads[key];
+            pore.generation = generation;
+            m_cache_signal_bytes += read_signal_bytes(*read);
+            pore.reads.push_back(std::move(read));
+            ++shard.num_cached_reads;
+            ++shard.num_cached_pores;
+            lock.unlock();
 
-                // Remove the oldest key from the map
-                for (auto& read_ptr : oldest_key_it->second) {
-                    m_cache_signal_bytes -= read_signal_bytes(*read_ptr);
-                    m_reads_to_clear.insert(std::move(read_ptr));
-                }
-                read_cache.channel_read_map.erase(oldest_key);
-                assert(read_cache.channel_read_map.size() ==
-                       read_cache.working_channel_keys.size());
-            }
-        } else {
-            auto& cached_read_list = read_list_iter->second;
-            // It's safe to take raw pointers of these reads since their ownership isn't released from this
-            // node until their counter in |m_reads_in_flight_ctr| hits 0.
-            SimplexRead* later_read = nullptr;
-            SimplexRead* earlier_read = nullptr;
-
-            auto later_read_iter = std::lower_bound(
-                    cached_read_list.begin(), cached_read_list.end(), read, compare_reads_by_time);
-            if (later_read_iter != cached_read_list.end()) {
-                later_read = later_read_iter->get();
-                m_reads_in_flight_ctr[later_read]++;
+            if (limit_num_keys) {
+                add_to_pore_order(key, generation);
             }
+            continue;
+        }
 
-            if (later_read_iter != cached_read_list.begin()) {
-                earlier_read = std::prev(later_read_iter)->get();
-                m_reads_in_flight_ctr[earlier_read]++;
-            }
+        auto& cached_read_list = read_list_iter->second.reads;
+        // It's safe to take raw pointers of these reads since their ownership isn't released from
+        // this node until their counter in |reads_in_flight_ctr| hits 0.
+        SimplexRead* later_read = nullptr;
+        SimplexRead* earlier_read = nullptr;
+
+        auto later_read_iter = std::lower_bound(cached_read_list.begin(), cached_read_list.end(),
+                                                read, compare_reads_by_time);
+        if (later_read_iter != cached_read_list.end()) {
+            later_read = later_read_iter->get();
+            shard.reads_in_flight_ctr[later_read]++;
+        }
 
-            SimplexRead* const read_ptr = read.get();
-            m_cache_signal_bytes += read_signal_bytes(*read);
-            cached_read_list.insert(later_read_iter, std::move(read));
-            m_reads_in_flight_ctr[read_ptr]++;
-
-            while (cached_read_list.size() > m_max_num_reads) {
-                m_cache_signal_bytes -= read_signal_bytes(*cached_read_list.front());
-                auto cached_read = std::move(cached_read_list.front());
-                cached_read_list.pop_front();
-                m_reads_to_clear.insert(std::move(cached_read));
-            }
+        if (later_read_iter != cached_read_list.begin()) {
+            earlier_read = std::prev(later_read_iter)->get();
+            shard.reads_in_flight_ctr[earlier_read]++;
+        }
 
-            // Release mutex around read cache to run pair evaluations.
-            lock.unlock();
+        SimplexRead* const read_ptr = read.get();
+        m_cache_signal_bytes += read_signal_bytes(*read);
+        cached_read_list.insert(later_read_iter, std::move(read));
+        ++shard.num_cached_reads;
+        shard.reads_in_flight_ctr[read_ptr]++;
+
+        while (cached_read_list.size() > m_max_num_reads) {
+            m_cache_signal_bytes -= read_signal_bytes(*cached_read_list.front());
+            auto cached_read = std::move(cached_read_list.front());
+            cached_read_list.pop_front();
+            --shard.num_cached_reads;
+            shard.reads_to_clear.insert(std::move(cached_read));
+        }
 
-            if (later_read) {
-                auto [is_pair, qs, qe, rs, re] =
-                        is_within_time_and_length_criteria(*read_ptr, *later_read, tid);
-                if (is_pair) {
-                    ReadPair pair;
-                    pair.template_read = ReadPair::ReadData::from_read(*read_ptr, qs, qe);
-                    pair.complement_read = ReadPair::ReadData::from_read(*later_read, rs, re);
-
-                    read_ptr->is_duplex_parent = true;
-                    later_read->is_duplex_parent = true;
-                    ++read_ptr->num_duplex_candidate_pairs;
-                    send_message_to_sink(std::move(pair));
-                }
+        // Release the shard lock to run pair evaluations.
+        lock.unlock();
+
+        if (later_read) {
+            auto [is_pair, qs, qe, rs, re, overlap_diagonal] =
+                    is_within_time_and_length_criteria(*read_ptr, *later_read, tid);
+            if (is_pair) {
+                ReadPair pair;
+                pair.template_read = ReadPair::ReadData::from_read(*read_ptr, qs, qe);
+                pair.complement_read = ReadPair::ReadData::from_read(*later_read, rs, re);
+                pair.overlap_diagonal = overlap_diagonal;
+
+                read_ptr->is_duplex_parent = true;
+                later_read->is_duplex_parent = true;
+                ++read_ptr->num_duplex_candidate_pairs;
+                send_message_to_sink(std::move(pair));
             }
+        }
 
-            if (earlier_read) {
-                auto [is_pair, qs, qe, rs, re] =
-                        is_within_time_and_length_criteria(*earlier_read, *read_ptr, tid);
-                if (is_pair) {
-                    ReadPair pair;
-                    pair.template_read = ReadPair::ReadData::from_read(*earlier_read, qs, qe);
-                    pair.complement_read = ReadPair::ReadData::from_read(*read_ptr, rs, re);
-
-                    earlier_read->is_duplex_parent = true;
-                    read_ptr->is_duplex_parent = true;
-                    ++earlier_read->num_duplex_candidate_pairs;
-                    send_message_to_sink(std::move(pair));
-                }
+        if (earlier_read) {
+            auto [is_pair, qs, qe, rs, re, overlap_diagonal] =
+                    is_within_time_and_length_criteria(*earlier_read, *read_ptr, tid);
+            if (is_pair) {
+                ReadPair pair;
+                pair.template_read = ReadPair::ReadData::from_read(*earlier_read, qs, qe);
+                pair.complement_read = ReadPair::ReadData::from_read(*read_ptr, rs, re);
+                pair.overlap_diagonal = overlap_diagonal;
+
+                earlier_read->is_duplex_parent = true;
+                read_ptr->is_duplex_parent = true;
+                ++earlier_read->num_duplex_candidate_pairs;
+                send_message_to_sink(std::move(pair));
             }
+        }
 
-            // Acquire read cache lock again to decrement in flight read counters.
-            lock.lock();
+        // Acquire the shard lock again to decrement in flight read counters.
+        lock.lock();
 
-            // Decrement in-flight counter for each read.
-            m_reads_in_flight_ctr[read_ptr]--;
-            if (earlier_read) {
-                m_reads_in_flight_ctr[earlier_read]--;
-            }
-            if (later_read) {
-                m_reads_in_flight_ctr[later_read]--;
-            }
+        // Decrement in-flight counter for each read.
+        shard.reads_in_flight_ctr[read_ptr]--;
+        if (earlier_read) {
+            shard.reads_in_flight_ctr[earlier_read]--;
+        }
+        if (later_read) {
+            shard.reads_in_flight_ctr[later_read]--;
         }
 
         // Once pairs have been evaluated, check if any of the in-flight reads
         // need to be purged from the cache.
-        for (auto to_clear_itr = m_reads_to_clear.begin();
-             to_clear_itr != m_reads_to_clear.end();) {
-            auto in_flight_itr = m_reads_in_flight_ctr.find(to_clear_itr->get());
-            bool ok_to_clear = false;
-            // If a read to clear is not in-flight (not in the in-flight list
-            // or in-flight counter is 0), then clear it
-            // from the cache.
-            if (in_flight_itr == m_reads_in_flight_ctr.end()) {
-                ok_to_clear = true;
-            } else if (in_flight_itr->second.load() == 0) {
-                m_reads_in_flight_ctr.erase(in_flight_itr);
-                ok_to_clear = true;
-            }
-            if (ok_to_clear) {
-                auto read_handle = m_reads_to_clear.extract(*to_clear_itr++);
-                send_message_to_sink(std::move(read_handle.value()));
-            } else {
-                ++to_clear_itr;
-            }
-        }
+        clear_finished_reads(shard);
     }
 
     if (--m_num_active_worker_threads == 0) {
         if (!m_preserve_cache_during_flush) {
-            std::unique_lock<std::mutex> lock(m_pairing_mtx);
-            // There are still reads in channel_read_map. Push them to the sink.
+            // There are still reads in the cache. Push them to the sink.
             // Last thread alive is responsible for cleaning up the cache.
-            for (auto& [client_id, read_cache] : m_read_caches) {
-                for (auto& kv : read_cache.channel_read_map) {
-                    // kv is a std::pair<UniquePoreIdentifierKey, std::list<std::shared_ptr<Read>>>
-                    auto& reads_list = kv.second;
-
-                    for (auto& read_ptr : reads_list) {
-                        m_cache_signal_bytes -= read_signal_bytes(*read_ptr);
-                        // Push each read message
-                        send_message_to_sink(std::move(read_ptr));
-                    }
-                }
-            }
-            m_read_caches.clear();
+            flush_cached_reads(std::nullopt);
+        }
+        for (auto& shard : m_cache_shards) {
+            auto lock = shard->lock();
+            shard->reads_in_flight_ctr.clear();
         }
-        m_reads_in_flight_ctr.clear();
     }
 }
 
@@ -487,6 +579,12 @@ PairingNode::PairingNode(DuplexPairingParameters pairing_params,
         throw std::runtime_error("Unsupported read order detected: " +
                                  dorado::to_string(pairing_params.read_order));
     }
+
+    const size_t num_shards = size_t(std::max(num_worker_threads, 1)) * kCacheShardsPerThread;
+    m_cache_shards.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i) {
+        m_cache_shards.push_back(std::make_unique<CacheShard>());
+    }
     m_pairing_func = &PairingNode::pair_generating_worker_thread;
 }
 
@@ -526,6 +624,14 @@ stats::NamedStats PairingNode::sample_stats() const {
     stats["overlap_accepted_pairs"] = m_overlap_accepted_pairs.load();
     stats["cached_signal_mb"] =
             static_cast<double>(m_cache_signal_bytes) / static_cast<double>(1024 * 1024);
+    for (size_t i = 0; i < m_cache_shards.size(); ++i) {
+        const auto& shard = *m_cache_shards[i];
+        const std::string prefix = "shard." + std::to_string(i) + ".";
+        stats[prefix + "lock_acquisitions"] = static_cast<double>(shard.lock_acquisitions.load());
+        stats[prefix + "lock_contentions"] = static_cast<double>(shard.lock_contentions.load());
+        stats[prefix + "cached_reads"] = static_cast<double>(shard.num_cached_reads.load());
+        stats[prefix + "cached_pores"] = static_cast<double>(shard.num_cached_pores.load());
+    }
     return stats;
 }
 
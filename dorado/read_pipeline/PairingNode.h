@@ -11,10 +11,13 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <string>
 #include <thread>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace dorado {
@@ -24,9 +27,41 @@ class PairingNode : public MessageSink {
     // The values are channel, run_id, flowcell_id
     using UniquePoreIdentifierKey = std::tuple<int, std::string, std::string>;
 
-    struct ReadCache {
-        std::map<UniquePoreIdentifierKey, std::list<SimplexReadPtr>> channel_read_map;
-        std::deque<UniquePoreIdentifierKey> working_channel_keys;
+    struct UniquePoreIdentifierKeyHash {
+        size_t operator()(const UniquePoreIdentifierKey& key) const;
+    };
+
+    // Key of a pore within the read cache: the client_id in the upper 32 bits and the
+    // interned UniquePoreIdentifierKey in the lower 32 bits.
+    using PoreCacheKey = uint64_t;
+
+    struct PoreReads {
+        std::list<SimplexReadPtr> reads;
+        // Unique per insertion of the pore into the cache, so that an eviction request for a
+        // pore that has since been evicted and re-added can be recognised as stale.
+        uint64_t generation = 0;
+    };
+
+    // The read cache is split into shards by pore, each with its own lock, so that worker
+    // threads only contend when they are handling reads from pores in the same shard.
+    struct CacheShard {
+        std::mutex mutex;
+        std::unordered_map<PoreCacheKey, PoreReads> pore_reads;
+
+        // Track reads which need to be emptied from the cache but are still being
+        // evaluated for pairs by other threads. Reads are only ever paired with reads
+        // from the same pore, so this can be tracked per shard.
+        std::unordered_map<const SimplexRead*, int> reads_in_flight_ctr;
+        std::unordered_set<SimplexReadPtr> reads_to_clear;
+
+        // Stats for the shard.
+        std::atomic<size_t> lock_acquisitions{0};
+        std::atomic<size_t> lock_contentions{0};
+        std::atomic<size_t> num_cached_reads{0};
+        std::atomic<size_t> num_cached_pores{0};
+
+        // Lock the shard, recording whether the lock was contended.
+        std::unique_lock<std::mutex> lock();
     };
 
 public:
@@ -84,10 +119,32 @@ private:
 
     // Members for pair_generating method
 
-    std::mutex m_pairing_mtx;
+    PoreCacheKey get_pore_cache_key(const SimplexRead& read);
+    CacheShard& get_cache_shard(PoreCacheKey key);
+
+    // Record a newly cached pore in the per-client pore order, evicting the oldest pore for
+    // the client if this takes it over m_max_num_keys.
+    void add_to_pore_order(PoreCacheKey key, uint64_t generation);
+    void evict_pore(PoreCacheKey key, uint64_t generation);
 
-    // individual read caches per client, keyed by client_id
-    std::unordered_map<int32_t, ReadCache> m_read_caches;
+    // Pass on any reads waiting to be cleared that are no longer in flight. Requires the
+    // shard lock to be held.
+    void clear_finished_reads(CacheShard& shard);
+
+    // Push all cached reads for the client, or for every client if client_id is empty.
+    void flush_cached_reads(std::optional<int32_t> client_id);
+
+    std::vector<std::unique_ptr<CacheShard>> m_cache_shards;
+
+    // Interned pore identifiers, only taking a unique lock when a pore is first seen.
+    std::shared_mutex m_pore_ids_mutex;
+    std::unordered_map<UniquePoreIdentifierKey, uint32_t, UniquePoreIdentifierKeyHash> m_pore_ids;
+
+    // Order in which pores were added to the cache for each client, keyed by client_id.
+    // Only maintained when the number of pores in the cache is limited.
+    std::mutex m_pore_order_mutex;
+    std::unordered_map<int32_t, std::deque<std::pair<PoreCacheKey, uint64_t>>> m_pore_order;
+    std::atomic<uint64_t> m_next_pore_generation{0};
 
     /**
      * The maximum number of different channels (pores) to keep in memory concurrently. 
@@ -105,7 +162,10 @@ private:
      */
     size_t m_max_num_reads;
 
-    using PairingResult = std::tuple<bool, uint32_t, uint32_t, uint32_t, uint32_t>;
+    // Whether the reads pair, the template and complement ranges to use for the pair, and the
+    // diagonal of the overlap between them (see ReadPair::overlap_diagonal).
+    using PairingResult =
+            std::tuple<bool, uint32_t, uint32_t, uint32_t, uint32_t, std::optional<int64_t>>;
     PairingResult is_within_time_and_length_criteria(const dorado::SimplexRead& read1,
                                                      const dorado::SimplexRead& read2,
                                                      int tid);
@@ -119,11 +179,6 @@ private:
     // Store the minimap2 buffers used for mapping. One buffer per thread.
     std::vector<MmTbufPtr> m_tbufs;
 
-    // Track reads which need to be emptied from the cache but are still being
-    // evaluated for pairs by other threads.
-    std::unordered_map<const SimplexRead*, std::atomic<int>> m_reads_in_flight_ctr;
-    std::unordered_set<SimplexReadPtr> m_reads_to_clear;
-
     // Stats tracking for pairing node.
     std::atomic<int> m_early_accepted_pairs{0};
     std::atomic<int> m_overlap_accepted_pairs{0};
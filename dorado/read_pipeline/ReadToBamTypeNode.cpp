@@ -5,6 +5,7 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <vector>
 
 namespace dorado {
 
@@ -38,11 +39,15 @@ void ReadToBamTypeNode::input_thread_fn() {
 
         auto alns = read_common_data.extract_sam_lines(m_emit_moves, m_modbase_threshold,
                                                        is_duplex_parent);
+        // Send all the records of the read in one burst.
+        std::vector<Message> bam_messages;
+        bam_messages.reserve(alns.size());
         for (auto& aln : alns) {
             BamMessage bam_msg{std::move(aln), read_common_data.client_info};
             bam_msg.sequencing_kit = read_common_data.sequencing_kit;
-            send_message_to_sink(std::move(bam_msg));
+            bam_messages.emplace_back(std::move(bam_msg));
         }
+        send_messages_to_sink(std::move(bam_messages));
     }
 }
 
@@ -51,7 +56,7 @@ ReadToBamTypeNode::ReadToBamTypeNode(bool emit_moves,
                                      float modbase_threshold_frac,
                                      std::unique_ptr<const utils::SampleSheet> sample_sheet,
                                      size_t max_reads)
-        : MessageSink(max_reads, static_cast<int>(num_worker_threads)),
+        : MessageSink(max_reads, static_cast<int>(num_worker_threads), MessageQueueType::LockFree),
           m_emit_moves(emit_moves),
           m_modbase_threshold(
                   static_cast<uint8_t>(std::min(modbase_threshold_frac * 256.0f, 255.0f))),
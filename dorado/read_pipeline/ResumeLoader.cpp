@@ -10,6 +10,7 @@
 
 #include <filesystem>
 #include <memory>
+#include <string_view>
 
 namespace dorado {
 
@@ -45,13 +46,13 @@ void ResumeLoader::copy_completed_reads() {
     // Iterate over all reads and write to sink.
     try {
         while (reader.read()) {
-            std::string read_id;
+            std::string_view read_id;
             // If a split read is found, use the parent read id to
             // resume basecalling since that's the read id found in
             // the raw dataset.
             auto pid_tag = bam_aux_get(reader.record.get(), "pi");
             if (pid_tag) {
-                read_id = std::string(bam_aux2Z(pid_tag));
+                read_id = bam_aux2Z(pid_tag);
             } else {
                 read_id = bam_get_qname(reader.record);
             }
@@ -72,7 +73,7 @@ void ResumeLoader::copy_completed_reads() {
     hts_set_log_level(initial_hts_log_level);
 }
 
-std::unordered_set<std::string> ResumeLoader::get_processed_read_ids() const {
+const utils::ReadIdSet& ResumeLoader::get_processed_read_ids() const {
     return m_processed_read_ids;
 }
 
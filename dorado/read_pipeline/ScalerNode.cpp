@@ -27,23 +27,21 @@ using Slice = at::indexing::Slice;
 
 namespace {
 
-std::pair<float, float> med_mad(const at::Tensor& x) {
+std::pair<float, float> med_mad(const int16_t* x, size_t count) {
     // See https://en.wikipedia.org/wiki/Median_absolute_deviation
     //  (specifically the "Relation to standard deviation" section)
     constexpr float factor = 1.4826f;
     //Calculate signal median and median absolute deviation
-    auto med = x.median();
-    auto mad = at::median(at::abs(x - med)) * factor + EPS;
-    return {med.item<float>(), mad.item<float>()};
+    auto [med, mad] = dorado::utils::median_and_mad_int16(x, count);
+    return {med, mad * factor + EPS};
 }
 
 std::pair<float, float> normalisation(const dorado::basecall::QuantileScalingParams& params,
-                                      const at::Tensor& x) {
+                                      const int16_t* x,
+                                      size_t count) {
     // Calculate shift and scale factors for normalisation.
-    auto quantiles =
-            dorado::utils::quantile_counting(x, at::tensor({params.quantile_a, params.quantile_b}));
-    float q_a = quantiles[0].item<float>();
-    float q_b = quantiles[1].item<float>();
+    auto [q_a, q_b] =
+            dorado::utils::quantiles_int16(x, count, params.quantile_a, params.quantile_b);
     float shift = std::max(10.0f, params.shift_multiplier * (q_a + q_b));
     float scale = std::max(1.0f, params.scale_multiplier * (q_b - q_a));
     return {shift, scale};
@@ -163,6 +161,7 @@ void ScalerNode::input_thread_fn() {
         }
 
         assert(read->read_common.raw_data.dtype() == at::kShort);
+        assert(read->read_common.raw_data.is_contiguous());
 
         float scale = 1.0f;
         float shift = 0.0f;
@@ -186,18 +185,25 @@ void ScalerNode::input_thread_fn() {
             }
         } else {
             // Ignore the RNA adapter. If this is DNA or we've already trimmed the adapter, this will be zero
-            auto scaling_data = read->read_common.raw_data.index(
-                    {Slice(read->read_common.rna_adapter_end_signal_pos, at::indexing::None)});
+            const auto num_samples = read->read_common.get_raw_data_samples();
+            const auto scaling_start =
+                    std::min(size_t(read->read_common.rna_adapter_end_signal_pos), num_samples);
+            const auto* scaling_data =
+                    read->read_common.raw_data.data_ptr<int16_t>() + scaling_start;
+            const auto scaling_count = num_samples - scaling_start;
             std::tie(shift, scale) =
                     m_scaling_params.strategy == ScalingStrategy::QUANTILE
-                            ? normalisation(m_scaling_params.quantile, scaling_data)
-                            : med_mad(scaling_data);
+                            ? normalisation(m_scaling_params.quantile, scaling_data, scaling_count)
+                            : med_mad(scaling_data, scaling_count);
         }
 
         // raw_data comes from DataLoader with dtype int16.  We send it on as float16 after
-        // shifting/scaling in float32 form.
-        read->read_common.raw_data = ((read->read_common.raw_data.to(at::kFloat) - shift) / scale)
-                                             .to(at::ScalarType::Half);
+        // shifting/scaling in float32 form, which is done in a single pass.
+        const auto& raw_data = read->read_common.raw_data;
+        auto scaled_data = at::empty(raw_data.sizes(), raw_data.options().dtype(at::kHalf));
+        utils::normalise_int16(scaled_data.data_ptr<c10::Half>(), raw_data.data_ptr<int16_t>(),
+                               raw_data.numel(), shift, scale);
+        read->read_common.raw_data = std::move(scaled_data);
 
         // move the shift and scale into pA.
         read->read_common.scale = read->scaling * scale;
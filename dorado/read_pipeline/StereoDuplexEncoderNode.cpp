@@ -1,14 +1,47 @@
 #include "StereoDuplexEncoderNode.h"
 
 #include "torch_utils/duplex_utils.h"
+#include "utils/alignment_utils.h"
 #include "utils/sequence_utils.h"
 
 #include <ATen/Functions.h>
 #include <edlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <optional>
+#include <vector>
+
+namespace {
+
+// Margin either side of the pairing overlap within which the strands are aligned.
+constexpr int64_t kBandMargin = 256;
+// Wider bands than this use the full alignment instead.
+constexpr int64_t kMaxBandWidth = 1024;
+
+// Aligns the strands within a band around the diagonal of the overlap found while pairing them,
+// which scales linearly with the strand length. Returns std::nullopt if the band is too wide,
+// or too narrow to be sure of having found the best alignment.
+std::optional<std::vector<uint8_t>> align_around_overlap(std::string_view temp_strand,
+                                                         std::string_view comp_strand,
+                                                         int64_t overlap_diagonal) {
+    // The band has to cover both ends of the strands as well as the overlap between them.
+    const int64_t end_diagonal =
+            static_cast<int64_t>(comp_strand.length()) - static_cast<int64_t>(temp_strand.length());
+    const auto diagonals = {int64_t{0}, end_diagonal, overlap_diagonal,
+                            overlap_diagonal + end_diagonal};
+    const int64_t min_diagonal = std::min(diagonals) - kBandMargin;
+    const int64_t max_diagonal = std::max(diagonals) + kBandMargin;
+    if (max_diagonal - min_diagonal > kMaxBandWidth) {
+        return std::nullopt;
+    }
+    return dorado::utils::banded_global_alignment(temp_strand, comp_strand, min_diagonal,
+                                                  max_diagonal);
+}
+
+}  // namespace
 
 namespace dorado {
 
@@ -39,22 +72,37 @@ DuplexReadPtr StereoDuplexEncoderNode::stereo_encode(ReadPair read_pair) {
     auto comp_strand = std::string_view{complement_sequence_reverse_complement}.substr(
             complement_read.seq_start, complement_read.seq_end - complement_read.seq_start);
 
-    EdlibAlignResult edlib_result =
-            edlibAlign(temp_strand.data(), static_cast<int>(temp_strand.length()),
-                       comp_strand.data(), static_cast<int>(comp_strand.length()), align_config);
-
     // Store the alignment result, along with other inputs necessary for generating the stereo input
     // features, in DuplexRead.
     auto read = std::make_unique<DuplexRead>();
     DuplexRead::StereoFeatureInputs& stereo_feature_inputs = read->stereo_feature_inputs;
     stereo_feature_inputs.signal_stride = m_input_signal_stride;
 
-    const auto alignment_size =
-            static_cast<size_t>(edlib_result.endLocations[0] - edlib_result.startLocations[0]);
-    stereo_feature_inputs.alignment.resize(alignment_size);
-    std::memcpy(stereo_feature_inputs.alignment.data(),
-                &edlib_result.alignment[edlib_result.startLocations[0]], alignment_size);
-    edlibFreeAlignResult(edlib_result);
+    std::optional<std::vector<uint8_t>> banded_alignment;
+    if (read_pair.overlap_diagonal.has_value()) {
+        banded_alignment =
+                align_around_overlap(temp_strand, comp_strand, *read_pair.overlap_diagonal);
+    }
+
+    if (banded_alignment.has_value() && !comp_strand.empty()) {
+        // Take the same span of the alignment as from the edlib result below, which ends at
+        // the last base of the complement strand.
+        banded_alignment->resize(comp_strand.length() - 1);
+        stereo_feature_inputs.alignment = std::move(*banded_alignment);
+        ++m_num_banded_alignments;
+    } else {
+        EdlibAlignResult edlib_result = edlibAlign(
+                temp_strand.data(), static_cast<int>(temp_strand.length()), comp_strand.data(),
+                static_cast<int>(comp_strand.length()), align_config);
+
+        const auto alignment_size =
+                static_cast<size_t>(edlib_result.endLocations[0] - edlib_result.startLocations[0]);
+        stereo_feature_inputs.alignment.resize(alignment_size);
+        std::memcpy(stereo_feature_inputs.alignment.data(),
+                    &edlib_result.alignment[edlib_result.startLocations[0]], alignment_size);
+        edlibFreeAlignResult(edlib_result);
+        ++m_num_full_alignments;
+    }
 
     stereo_feature_inputs.template_seq_start = template_read.seq_start;
     stereo_feature_inputs.template_seq = std::move(template_read.read_common.seq);
@@ -115,6 +163,8 @@ StereoDuplexEncoderNode::StereoDuplexEncoderNode(int input_signal_stride)
 stats::NamedStats StereoDuplexEncoderNode::sample_stats() const {
     stats::NamedStats stats = m_work_queue.sample_stats();
     stats["encoded_pairs"] = static_cast<double>(m_num_encoded_pairs);
+    stats["banded_alignments"] = static_cast<double>(m_num_banded_alignments);
+    stats["full_alignments"] = static_cast<double>(m_num_full_alignments);
     return stats;
 }
 
@@ -30,6 +30,8 @@ private:
 
     // Performance monitoring stats.
     std::atomic<int64_t> m_num_encoded_pairs{0};
+    std::atomic<int64_t> m_num_banded_alignments{0};
+    std::atomic<int64_t> m_num_full_alignments{0};
 };
 
 }  // namespace dorado
@@ -0,0 +1,59 @@
+#include "SummaryWriterNode.h"
+
+#include "messages.h"
+#include "summary/summary.h"
+#include "utils/bam_utils.h"
+
+#include <htslib/sam.h>
+
+#include <variant>
+
+namespace {
+
+constexpr std::streamoff ROWS_FLUSH_SIZE = 1 << 20;
+
+}  // namespace
+
+namespace dorado {
+
+SummaryWriterNode::SummaryWriterNode(std::shared_ptr<SummaryWriter> writer)
+        : MessageSink(10000, 1), m_writer(std::move(writer)) {}
+
+void SummaryWriterNode::set_header(const sam_hdr_t* header) {
+    m_header.reset(sam_hdr_dup(header));
+    m_read_group_exp_start_time = utils::get_read_group_info(m_header.get(), "DT");
+}
+
+void SummaryWriterNode::input_thread_fn() {
+    Message message;
+    while (get_input_message(message)) {
+        if (std::holds_alternative<BamMessage>(message)) {
+            const auto& bam_message = std::get<BamMessage>(message);
+            if (m_writer->summary().write_record(m_rows, bam_message.bam_ptr.get(),
+                                                 m_header.get(), m_read_group_exp_start_time)) {
+                ++m_num_rows;
+            }
+            if (m_rows.tellp() >= ROWS_FLUSH_SIZE) {
+                flush_rows();
+            }
+        }
+        send_message_to_sink(std::move(message));
+    }
+    flush_rows();
+}
+
+void SummaryWriterNode::flush_rows() {
+    const auto rows = m_rows.str();
+    if (!rows.empty()) {
+        m_writer->write_rows(rows);
+    }
+    m_rows.str({});
+}
+
+stats::NamedStats SummaryWriterNode::sample_stats() const {
+    auto stats = stats::from_obj(m_work_queue);
+    stats["summary_rows_written"] = static_cast<double>(m_num_rows.load());
+    return stats;
+}
+
+}  // namespace dorado
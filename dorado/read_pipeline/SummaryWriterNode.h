@@ -0,0 +1,51 @@
+#pragma once
+
+#include "MessageSink.h"
+#include "utils/stats.h"
+#include "utils/types.h"
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+
+struct sam_hdr_t;
+
+namespace dorado {
+
+class SummaryWriter;
+
+/// Writes a summary row for each BAM record that passes through the node, then passes every
+/// message on unchanged. This gives the same summary as SummaryData::process_tree() without
+/// reading the output files back in once they've been written.
+class SummaryWriterNode : public MessageSink {
+public:
+    /// |writer| may be shared with the SummaryWriterNodes of other pipelines.
+    explicit SummaryWriterNode(std::shared_ptr<SummaryWriter> writer);
+    ~SummaryWriterNode() { stop_input_processing(); }
+    std::string get_name() const override { return "SummaryWriterNode"; }
+    stats::NamedStats sample_stats() const override;
+    void terminate(const FlushOptions&) override { stop_input_processing(); }
+    void restart() override {
+        start_input_processing([this] { input_thread_fn(); }, "summary_writer");
+    }
+
+    /// The header of the records, which must be set before any are sent to the node.
+    void set_header(const sam_hdr_t* header);
+
+private:
+    void input_thread_fn();
+    void flush_rows();
+
+    std::shared_ptr<SummaryWriter> m_writer;
+    SamHdrPtr m_header;
+    std::map<std::string, std::string> m_read_group_exp_start_time;
+
+    // Rows are formatted here and handed to the writer in large blocks.
+    std::ostringstream m_rows;
+    std::atomic<std::size_t> m_num_rows{0};
+};
+
+}  // namespace dorado
@@ -69,7 +69,7 @@ std::tuple<bool, bool, Interval> get_trim_interval(dorado::ClientInfo& client_in
 namespace dorado {
 
 // This Node is responsible for trimming adapters, primers, and barcodes.
-TrimmerNode::TrimmerNode(int threads) : MessageSink(10000, threads) {}
+TrimmerNode::TrimmerNode(int threads) : MessageSink(10000, threads, MessageQueueType::LockFree) {}
 
 void TrimmerNode::input_thread_fn() {
     Message message;
@@ -102,16 +102,17 @@ void TrimmerNode::process_read(BamMessage& bam_message) {
             get_trim_interval(*bam_message.client_info, seqlen, bam_message.adapter_trim_interval,
                               bam_message.barcode_trim_interval, bam_get_qname(irecord));
 
+    // The record is trimmed in place, since it isn't shared with anything else.
     if (trim_adapter || trim_barcodes) {
-        bam_message.bam_ptr = Trimmer::trim_sequence(irecord, trim_interval);
+        Trimmer::trim_sequence_in_place(irecord, trim_interval);
         if (bam_message.primer_classification.primer_name != UNCLASSIFIED) {
             auto sense_data = uint8_t(to_char(bam_message.primer_classification.orientation));
-            bam_aux_append(bam_message.bam_ptr.get(), "TS", 'A', 1, &sense_data);
+            bam_aux_append(irecord, "TS", 'A', 1, &sense_data);
         }
     } else {
         // Even if we don't trim this read, we need to strip any alignment details, since the BAM header
         // will not contain any alignment information anymore.
-        bam_message.bam_ptr = utils::new_unmapped_record(irecord, {}, {});
+        utils::make_record_unmapped(irecord);
         return;
     }
 }
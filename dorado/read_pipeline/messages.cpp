@@ -2,12 +2,27 @@
 
 #include "modbase/ModBaseContext.h"
 #include "stereo_features.h"
+#include "utils/bam_aux_builder.h"
 #include "utils/bam_utils.h"
 #include "utils/sequence_utils.h"
 #include "utils/types.h"
 
 #include <htslib/sam.h>
 
+#include <charconv>
+
+namespace {
+
+// Appends ",<count>" to an MM tag without creating a temporary string.
+void append_skip_count(std::string &mm_tag, int count) {
+    char digits[16];
+    const auto result = std::to_chars(std::begin(digits), std::end(digits), count);
+    mm_tag += ',';
+    mm_tag.append(digits, result.ptr);
+}
+
+}  // namespace
+
 namespace dorado {
 
 bool is_read_message(const Message &message) {
@@ -37,104 +52,74 @@ std::string ReadCommon::generate_read_group() const {
     return read_group;
 }
 
-void ReadCommon::generate_read_tags(bam1_t *aln, bool emit_moves, bool is_duplex_parent) const {
-    float qs = calculate_mean_qscore();
-    bam_aux_append(aln, "qs", 'f', sizeof(qs), (uint8_t *)&qs);
-
-    float du = (float)(get_raw_data_samples() + num_trimmed_samples) / (float)sample_rate;
-    bam_aux_append(aln, "du", 'f', sizeof(du), (uint8_t *)&du);
-
-    int ns = int(get_raw_data_samples() + num_trimmed_samples);
-    bam_aux_append(aln, "ns", 'i', sizeof(ns), (uint8_t *)&ns);
-
-    int ts = int(num_trimmed_samples);
-    bam_aux_append(aln, "ts", 'i', sizeof(ts), (uint8_t *)&ts);
+void ReadCommon::generate_read_tags(utils::BamAuxBuilder &aux,
+                                    bool emit_moves,
+                                    bool is_duplex_parent) const {
+    aux.append_float("qs", calculate_mean_qscore());
 
-    int mx = attributes.mux;
-    bam_aux_append(aln, "mx", 'i', sizeof(mx), (uint8_t *)&mx);
-
-    int ch = attributes.channel_number;
-    bam_aux_append(aln, "ch", 'i', sizeof(ch), (uint8_t *)&ch);
-
-    bam_aux_append(aln, "st", 'Z', int(attributes.start_time.length() + 1),
-                   (uint8_t *)attributes.start_time.c_str());
+    const auto num_samples = get_raw_data_samples() + num_trimmed_samples;
+    aux.append_float("du", (float)num_samples / (float)sample_rate);
+    aux.append_int("ns", int(num_samples));
+    aux.append_int("ts", int(num_trimmed_samples));
+    aux.append_int("mx", int(attributes.mux));
+    aux.append_int("ch", attributes.channel_number);
+    aux.append_string("st", attributes.start_time);
 
     // For reads which are the result of read splitting, the read number will be set to -1
-    int rn = attributes.read_number;
-    bam_aux_append(aln, "rn", 'i', sizeof(rn), (uint8_t *)&rn);
-
-    bam_aux_append(aln, "fn", 'Z', int(attributes.filename.length() + 1),
-                   (uint8_t *)attributes.filename.c_str());
-
-    float sm = shift;
-    bam_aux_append(aln, "sm", 'f', sizeof(sm), (uint8_t *)&sm);
-
-    float sd = scale;
-    bam_aux_append(aln, "sd", 'f', sizeof(sd), (uint8_t *)&sd);
-
-    bam_aux_append(aln, "sv", 'Z', int(scaling_method.size() + 1),
-                   (uint8_t *)scaling_method.c_str());
-
-    int32_t dx = (is_duplex_parent ? -1 : 0);
-    bam_aux_append(aln, "dx", 'i', sizeof(dx), (uint8_t *)&dx);
+    aux.append_int("rn", attributes.read_number);
+    aux.append_string("fn", attributes.filename);
+    aux.append_float("sm", shift);
+    aux.append_float("sd", scale);
+    aux.append_string("sv", scaling_method);
+    aux.append_int("dx", is_duplex_parent ? -1 : 0);
 
     auto rg = generate_read_group();
     if (!rg.empty()) {
-        bam_aux_append(aln, "RG", 'Z', int(rg.length() + 1), (uint8_t *)rg.c_str());
+        aux.append_string("RG", rg);
     }
 
     if (!parent_read_id.empty()) {
-        bam_aux_append(aln, "pi", 'Z', int(parent_read_id.size() + 1),
-                       (uint8_t *)parent_read_id.c_str());
+        aux.append_string("pi", parent_read_id);
         // For split reads, also store the start coordinate of the new read
         // in the original signal.
-        bam_aux_append(aln, "sp", 'i', sizeof(split_point), (uint8_t *)&split_point);
+        aux.append_int("sp", int32_t(split_point));
     }
 
     if (emit_moves) {
-        std::vector<uint8_t> m(moves.size() + 1, 0);
-        m[0] = uint8_t(model_stride);
+        thread_local std::vector<int8_t> m;
+        m.resize(moves.size() + 1);
+        m[0] = int8_t(model_stride);
 
         for (size_t idx = 0; idx < moves.size(); idx++) {
-            m[idx + 1] = static_cast<uint8_t>(moves[idx]);
+            m[idx + 1] = static_cast<int8_t>(moves[idx]);
         }
 
-        bam_aux_update_array(aln, "mv", 'c', int(m.size()), (uint8_t *)m.data());
+        aux.append_array("mv", m.data(), m.size());
     }
 
     if (rna_poly_tail_length >= 0) {
-        bam_aux_append(aln, "pt", 'i', sizeof(rna_poly_tail_length),
-                       (uint8_t *)&rna_poly_tail_length);
+        aux.append_int("pt", rna_poly_tail_length);
     }
 }
 
-void ReadCommon::generate_duplex_read_tags(bam1_t *aln) const {
-    float qs = calculate_mean_qscore();
-    bam_aux_append(aln, "qs", 'f', sizeof(qs), (uint8_t *)&qs);
-    uint32_t duplex = 1;
-    bam_aux_append(aln, "dx", 'i', sizeof(duplex), (uint8_t *)&duplex);
-
-    int mx = attributes.mux;
-    bam_aux_append(aln, "mx", 'i', sizeof(mx), (uint8_t *)&mx);
-
-    int ch = attributes.channel_number;
-    bam_aux_append(aln, "ch", 'i', sizeof(ch), (uint8_t *)&ch);
-
-    bam_aux_append(aln, "st", 'Z', int(attributes.start_time.length() + 1),
-                   (uint8_t *)attributes.start_time.c_str());
+void ReadCommon::generate_duplex_read_tags(utils::BamAuxBuilder &aux) const {
+    aux.append_float("qs", calculate_mean_qscore());
+    aux.append_int("dx", 1);
+    aux.append_int("mx", int(attributes.mux));
+    aux.append_int("ch", attributes.channel_number);
+    aux.append_string("st", attributes.start_time);
 
     auto rg = generate_read_group();
     if (!rg.empty()) {
-        bam_aux_append(aln, "RG", 'Z', int(rg.length() + 1), (uint8_t *)rg.c_str());
+        aux.append_string("RG", rg);
     }
 
     if (!parent_read_id.empty()) {
-        bam_aux_append(aln, "pi", 'Z', int(parent_read_id.size() + 1),
-                       (uint8_t *)parent_read_id.c_str());
+        aux.append_string("pi", parent_read_id);
     }
 }
 
-void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
+void ReadCommon::generate_modbase_tags(utils::BamAuxBuilder &aux, uint8_t threshold) const {
     if (!mod_base_info) {
         return;
     }
@@ -148,8 +133,11 @@ void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
                 "modbase_alphabet!");
     }
 
-    std::string modbase_string = "";
-    std::vector<uint8_t> modbase_prob;
+    // The tags are built in scratch buffers which are reused by each thread.
+    thread_local std::string modbase_string;
+    thread_local std::vector<uint8_t> modbase_prob;
+    modbase_string.clear();
+    modbase_prob.clear();
 
     // Create a mask indicating which bases are modified.
     std::unordered_map<char, bool> base_has_context = {
@@ -213,19 +201,21 @@ void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
             current_cardinal = mod_base_info->alphabet[channel_idx][0];
         } else {
             // A modification on the previous cardinal base
-            std::string bam_name = mod_base_info->alphabet[channel_idx];
+            const std::string &bam_name = mod_base_info->alphabet[channel_idx];
             if (!utils::validate_bam_tag_code(bam_name)) {
                 return;
             }
 
             // Write out the results we found
-            modbase_string += std::string(1, current_cardinal) + "+" + bam_name;
-            modbase_string += base_has_context[current_cardinal] ? "?" : ".";
+            modbase_string += current_cardinal;
+            modbase_string += '+';
+            modbase_string += bam_name;
+            modbase_string += base_has_context[current_cardinal] ? '?' : '.';
             int skipped_bases = 0;
             for (size_t base_idx = 0; base_idx < seq.size(); base_idx++) {
                 if (seq[base_idx] == current_cardinal) {
                     if (modbase_mask[base_idx]) {
-                        modbase_string += "," + std::to_string(skipped_bases);
+                        append_skip_count(modbase_string, skipped_bases);
                         skipped_bases = 0;
                         modbase_prob.push_back(
                                 base_mod_probs[base_idx * num_channels + channel_idx]);
@@ -235,7 +225,7 @@ void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
                     }
                 }
             }
-            modbase_string += ";";
+            modbase_string += ';';
         }
     }
 
@@ -249,18 +239,20 @@ void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
             } else {
                 auto cardinal_complement = utils::complement_table[current_cardinal];
                 // A modification on the previous cardinal base
-                std::string bam_name = mod_base_info->alphabet[channel_idx];
+                const std::string &bam_name = mod_base_info->alphabet[channel_idx];
                 if (!utils::validate_bam_tag_code(bam_name)) {
                     return;
                 }
 
-                modbase_string += std::string(1, cardinal_complement) + "-" + bam_name;
-                modbase_string += base_has_context[current_cardinal] ? "?" : ".";
+                modbase_string += cardinal_complement;
+                modbase_string += '-';
+                modbase_string += bam_name;
+                modbase_string += base_has_context[current_cardinal] ? '?' : '.';
                 int skipped_bases = 0;
                 for (size_t base_idx = 0; base_idx < seq.size(); base_idx++) {
                     if (seq[base_idx] == cardinal_complement) {  // complement
                         if (modbase_mask[base_idx]) {            // Not sure this one is right
-                            modbase_string += "," + std::to_string(skipped_bases);
+                            append_skip_count(modbase_string, skipped_bases);
                             skipped_bases = 0;
                             modbase_prob.push_back(
                                     base_mod_probs[base_idx * num_channels + channel_idx]);
@@ -270,16 +262,14 @@ void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
                         }
                     }
                 }
-                modbase_string += ";";
+                modbase_string += ';';
             }
         }
     }
 
-    int seq_len = int(seq.length());
-    bam_aux_append(aln, "MN", 'i', sizeof(seq_len), (uint8_t *)&seq_len);
-    bam_aux_append(aln, "MM", 'Z', int(modbase_string.length() + 1),
-                   (uint8_t *)modbase_string.c_str());
-    bam_aux_update_array(aln, "ML", 'C', int(modbase_prob.size()), (uint8_t *)modbase_prob.data());
+    aux.append_int("MN", int(seq.length()));
+    aux.append_string("MM", modbase_string);
+    aux.append_array("ML", modbase_prob.data(), modbase_prob.size());
 }
 
 float ReadCommon::calculate_mean_qscore() const {
@@ -315,34 +305,43 @@ std::vector<BamPtr> ReadCommon::extract_sam_lines(bool emit_moves,
         throw std::runtime_error("Empty sequence and qstring provided for read id " + read_id);
     }
 
+    // Serialise the tags up front so that the record can be allocated once with exactly the
+    // space it needs. The scratch buffers are reused by each thread.
+    thread_local utils::BamAuxBuilder aux;
+    aux.clear();
+
+    if (!barcode.empty() && barcode != UNCLASSIFIED) {
+        aux.append_string("BC", barcode);
+    }
+
+    if (is_duplex) {
+        generate_duplex_read_tags(aux);
+    } else {
+        generate_read_tags(aux, emit_moves, is_duplex_parent);
+    }
+    generate_modbase_tags(aux, modbase_threshold);
+
     std::vector<BamPtr> alns;
 
-    bam1_t *aln = bam_init1();
     uint32_t flags = 4;     // 4 = UNMAPPED
     int leftmost_pos = -1;  // UNMAPPED - will be written as 0
     int map_q = 0;          // UNMAPPED
     int next_pos = -1;      // UNMAPPED - will be written as 0
 
     // Convert string qscore to phred vector.
-    std::vector<uint8_t> qscore;
-    std::transform(qstring.begin(), qstring.end(), std::back_inserter(qscore),
+    thread_local std::vector<uint8_t> qscore;
+    qscore.resize(qstring.size());
+    std::transform(qstring.begin(), qstring.end(), qscore.begin(),
                    [](char c) { return (uint8_t)(c)-33; });
 
-    bam_set1(aln, read_id.length(), read_id.c_str(), uint16_t(flags), -1, leftmost_pos,
-             uint8_t(map_q), 0, nullptr, -1, next_pos, 0, seq.length(), seq.c_str(),
-             (char *)qscore.data(), 0);
-
-    if (!barcode.empty() && barcode != UNCLASSIFIED) {
-        bam_aux_append(aln, "BC", 'Z', int(barcode.length() + 1), (uint8_t *)barcode.c_str());
-    }
-
-    if (is_duplex) {
-        generate_duplex_read_tags(aln);
-    } else {
-        generate_read_tags(aln, emit_moves, is_duplex_parent);
+    BamPtr aln(bam_init1());
+    if (bam_set1(aln.get(), read_id.length(), read_id.c_str(), uint16_t(flags), -1, leftmost_pos,
+                 uint8_t(map_q), 0, nullptr, -1, next_pos, 0, seq.length(), seq.c_str(),
+                 (char *)qscore.data(), aux.size()) < 0) {
+        throw std::runtime_error("Failed to create BAM record for read id " + read_id);
     }
-    generate_modbase_tags(aln, modbase_threshold);
-    alns.push_back(BamPtr(aln));
+    aux.write_to(aln.get());
+    alns.push_back(std::move(aln));
 
     return alns;
 }
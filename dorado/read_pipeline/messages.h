@@ -1,5 +1,6 @@
 #pragma once
 
+#include "hts_io/ReadNameTable.h"
 #include "models/kits.h"
 #include "utils/cigar.h"
 #include "utils/overlap.h"
@@ -11,7 +12,9 @@
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -35,6 +38,10 @@ struct Attributes {
 
 }  // namespace details
 
+namespace utils {
+class BamAuxBuilder;
+}  // namespace utils
+
 class ClientInfo;
 
 class ReadCommon {
@@ -131,9 +138,11 @@ public:
     float model_q_scale{0.0f};
 
 private:
-    void generate_duplex_read_tags(bam1_t*) const;
-    void generate_read_tags(bam1_t* aln, bool emit_moves, bool is_duplex_parent) const;
-    void generate_modbase_tags(bam1_t* aln, uint8_t threshold) const;
+    void generate_duplex_read_tags(utils::BamAuxBuilder& aux) const;
+    void generate_read_tags(utils::BamAuxBuilder& aux,
+                            bool emit_moves,
+                            bool is_duplex_parent) const;
+    void generate_modbase_tags(utils::BamAuxBuilder& aux, uint8_t threshold) const;
     std::string generate_read_group() const;
 };
 
@@ -204,6 +213,11 @@ struct ReadPair {
     };
     ReadData template_read;
     ReadData complement_read;
+    // Diagonal of the overlap that paired the reads, as the offset of the aligned position in
+    // the complement strand from that in the template strand, where the strands are the
+    // seq_start to seq_end ranges with the complement reverse complemented. Unset if the pair
+    // wasn't accepted from an overlap.
+    std::optional<int64_t> overlap_diagonal;
 };
 
 class CacheFlushMessage {
@@ -226,7 +240,10 @@ public:
 struct CorrectionAlignments {
     // Populated in CorrectionMapperNode::extract_alignments
     std::string read_name;
-    std::vector<std::string> qnames;
+    // IDs of the target read and of the query read of each overlap in |read_names|.
+    int32_t read_id = -1;
+    std::vector<int32_t> qids;
+    std::shared_ptr<const hts_io::ReadNameTable> read_names;
     std::vector<std::vector<CigarOp>> cigars;
     std::vector<utils::Overlap> overlaps;
 
@@ -253,6 +270,8 @@ struct CorrectionAlignments {
         return true;
     }
 
+    std::string_view qname(size_t i) const { return read_names->name(qids[i]); }
+
     size_t size() {
         size_t si = read_name.length() + read_seq.length() + read_qual.size();
         for (auto& o : overlaps) {
@@ -267,9 +286,7 @@ struct CorrectionAlignments {
         for (auto& v : quals) {
             si += v.size();
         }
-        for (auto& s : qnames) {
-            si += s.length();
-        }
+        si += qids.size() * sizeof(int32_t);
 
         return si;
     }
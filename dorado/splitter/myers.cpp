@@ -2,6 +2,7 @@
 
 #include "utils/PostCondition.h"
 #include "utils/alignment_utils.h"
+#include "utils/simd.h"
 
 #include <algorithm>
 #include <cassert>
@@ -9,6 +10,7 @@
 #include <iomanip>
 #include <optional>
 #include <ostream>
+#include <stdexcept>
 
 namespace dorado::splitter {
 
@@ -50,6 +52,86 @@ std::vector<size_t> d_myers(const char* pattern, size_t m, const char* text, siz
     return D;
 }
 
+// Number of patterns processed together by global_edists_impl().
+constexpr size_t PATTERNS_PER_GROUP = 4;
+
+// Runs Myers' algorithm for global alignment of each pattern against the text, given as rows of
+// |match_masks|, writing the final edit distance of each pattern to |edists|.
+// The top row of the DP matrix increases by one per column, which is the carry in to the
+// horizontal deltas.
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void global_edists_impl(const uint64_t* match_masks,
+                        size_t stride,
+                        const std::vector<uint8_t>& text_rows,
+                        size_t pattern_length,
+                        size_t num_patterns,
+                        int* edists) {
+    const uint64_t high_bit = uint64_t{1} << (pattern_length - 1);
+    for (size_t k = 0; k < num_patterns; ++k) {
+        uint64_t VP = ~uint64_t{0};
+        uint64_t VN = 0;
+        int score = static_cast<int>(pattern_length);
+        for (const uint8_t row : text_rows) {
+            const uint64_t EQ = match_masks[row * stride + k];
+            const uint64_t XV = EQ | VN;
+            const uint64_t XH = (((EQ & VP) + VP) ^ VP) | EQ;
+            uint64_t HP = VN | ~(XH | VP);
+            uint64_t HN = VP & XH;
+            score += (HP & high_bit) ? 1 : 0;
+            score -= (HN & high_bit) ? 1 : 0;
+            HP = (HP << 1) | 1;
+            HN <<= 1;
+            VP = HN | ~(XV | HP);
+            VN = HP & XV;
+        }
+        edists[k] = score;
+    }
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2"))) void global_edists_impl(const uint64_t* match_masks,
+                                                        size_t stride,
+                                                        const std::vector<uint8_t>& text_rows,
+                                                        size_t pattern_length,
+                                                        size_t num_patterns,
+                                                        int* edists) {
+    const __m256i all_ones = _mm256_set1_epi64x(-1);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i high_bit = _mm256_set1_epi64x(int64_t(uint64_t{1} << (pattern_length - 1)));
+    for (size_t k = 0; k < num_patterns; k += PATTERNS_PER_GROUP) {
+        __m256i VP = all_ones;
+        __m256i VN = _mm256_setzero_si256();
+        __m256i score = _mm256_set1_epi64x(static_cast<int64_t>(pattern_length));
+        for (const uint8_t row : text_rows) {
+            const __m256i EQ = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(match_masks + row * stride + k));
+            const __m256i XV = _mm256_or_si256(EQ, VN);
+            const __m256i XH = _mm256_or_si256(
+                    _mm256_xor_si256(_mm256_add_epi64(_mm256_and_si256(EQ, VP), VP), VP), EQ);
+            __m256i HP =
+                    _mm256_or_si256(VN, _mm256_andnot_si256(_mm256_or_si256(XH, VP), all_ones));
+            __m256i HN = _mm256_and_si256(VP, XH);
+            // The comparisons give -1 in lanes where the high bit is set.
+            score = _mm256_sub_epi64(score,
+                                     _mm256_cmpeq_epi64(_mm256_and_si256(HP, high_bit), high_bit));
+            score = _mm256_add_epi64(score,
+                                     _mm256_cmpeq_epi64(_mm256_and_si256(HN, high_bit), high_bit));
+            HP = _mm256_or_si256(_mm256_slli_epi64(HP, 1), one);
+            HN = _mm256_slli_epi64(HN, 1);
+            VP = _mm256_or_si256(HN, _mm256_andnot_si256(_mm256_or_si256(XV, HP), all_ones));
+            VN = _mm256_and_si256(HP, XV);
+        }
+        alignas(32) int64_t scores[PATTERNS_PER_GROUP];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(scores), score);
+        for (size_t lane = 0; lane < PATTERNS_PER_GROUP && k + lane < num_patterns; ++lane) {
+            edists[k + lane] = static_cast<int>(scores[lane]);
+        }
+    }
+}
+#endif
+
 }  // namespace
 
 std::vector<EdistResult> myers_align(std::string_view query,
@@ -149,6 +231,62 @@ std::vector<EdistResult> myers_align(std::string_view query,
     return ranges;
 }
 
+MultiPatternMyers::MultiPatternMyers(const std::vector<std::string>& patterns)
+        : m_num_patterns(patterns.size()) {
+    if (patterns.empty()) {
+        throw std::invalid_argument("MultiPatternMyers requires at least one pattern.");
+    }
+    m_pattern_length = patterns.front().size();
+    if (m_pattern_length == 0 || m_pattern_length > MAX_PATTERN_LENGTH) {
+        throw std::invalid_argument("MultiPatternMyers pattern length must be between 1 and " +
+                                    std::to_string(MAX_PATTERN_LENGTH) + ".");
+    }
+
+    // Assign a row to each distinct character in the patterns.
+    constexpr uint8_t UNASSIGNED = 0xff;
+    m_symbol_rows.fill(UNASSIGNED);
+    uint8_t num_symbols = 0;
+    for (const auto& pattern : patterns) {
+        if (pattern.size() != m_pattern_length) {
+            throw std::invalid_argument("MultiPatternMyers patterns must all be the same length.");
+        }
+        for (const char c : pattern) {
+            auto& row = m_symbol_rows[static_cast<uint8_t>(c)];
+            if (row == UNASSIGNED) {
+                row = num_symbols++;
+            }
+        }
+    }
+    // Anything else maps to the row of zeros after the assigned symbols.
+    for (auto& row : m_symbol_rows) {
+        if (row == UNASSIGNED) {
+            row = num_symbols;
+        }
+    }
+
+    m_padded_num_patterns =
+            (m_num_patterns + PATTERNS_PER_GROUP - 1) / PATTERNS_PER_GROUP * PATTERNS_PER_GROUP;
+    m_match_masks.assign((num_symbols + 1) * m_padded_num_patterns, 0);
+    for (size_t k = 0; k < m_num_patterns; ++k) {
+        for (size_t i = 0; i < m_pattern_length; ++i) {
+            const auto row = m_symbol_rows[static_cast<uint8_t>(patterns[k][i])];
+            m_match_masks[row * m_padded_num_patterns + k] |= uint64_t{1} << i;
+        }
+    }
+}
+
+std::vector<int> MultiPatternMyers::global_edists(std::string_view text) const {
+    std::vector<uint8_t> text_rows(text.size());
+    std::transform(text.begin(), text.end(), text_rows.begin(),
+                   [this](char c) { return m_symbol_rows[static_cast<uint8_t>(c)]; });
+
+    std::vector<int> edists(m_padded_num_patterns);
+    global_edists_impl(m_match_masks.data(), m_padded_num_patterns, text_rows, m_pattern_length,
+                       m_num_patterns, edists.data());
+    edists.resize(m_num_patterns);
+    return edists;
+}
+
 void print_edists(std::ostream& os, std::string_view seq, const std::vector<size_t>& edists) {
     assert(edists.size() == seq.size() + 1);
 
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <iosfwd>
+#include <string>
 #include <string_view>
 #include <vector>
 
@@ -17,4 +20,32 @@ std::vector<EdistResult> myers_align(std::string_view query,
 
 void print_edists(std::ostream& os, std::string_view seq, const std::vector<size_t>& edists);
 
+// Computes the global (NW) edit distances of a set of equal length patterns against a text in a
+// single pass over the text, using Myers' bit-vector algorithm with one 64-bit word per pattern.
+// The patterns are processed side by side, using SIMD lanes where available.
+class MultiPatternMyers {
+public:
+    static constexpr std::size_t MAX_PATTERN_LENGTH = 64;
+
+    // Throws std::invalid_argument if the patterns are empty, differ in length, or are longer
+    // than MAX_PATTERN_LENGTH.
+    explicit MultiPatternMyers(const std::vector<std::string>& patterns);
+
+    std::size_t num_patterns() const { return m_num_patterns; }
+    std::size_t pattern_length() const { return m_pattern_length; }
+
+    // Returns the edit distance of each pattern against the whole of |text|.
+    std::vector<int> global_edists(std::string_view text) const;
+
+private:
+    std::size_t m_num_patterns = 0;
+    std::size_t m_pattern_length = 0;
+    // Number of patterns rounded up to the SIMD width, which is the stride of m_match_masks.
+    std::size_t m_padded_num_patterns = 0;
+    // Maps each character to its row in m_match_masks. Characters that don't appear in any
+    // pattern map to a final row of zeros.
+    std::array<uint8_t, 256> m_symbol_rows{};
+    std::vector<uint64_t> m_match_masks;
+};
+
 }  // namespace dorado::splitter
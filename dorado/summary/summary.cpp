@@ -6,6 +6,7 @@
 #include "utils/log_utils.h"
 #include "utils/time_utils.h"
 
+#include <htslib/sam.h>
 #include <spdlog/spdlog.h>
 
 #include <cctype>
@@ -126,7 +127,7 @@ bool SummaryData::process_tree(const std::string& folder, std::ostream& writer)
     return true;
 }
 
-void SummaryData::write_header(std::ostream& writer) {
+void SummaryData::write_header(std::ostream& writer) const {
     for (size_t i = 0; i < s_required_fields.size(); ++i) {
         if (i > 0) {
             writer << m_separator;
@@ -156,130 +157,147 @@ void SummaryData::write_rows_from_reader(
         std::ostream& writer,
         const std::map<std::string, std::string>& read_group_exp_start_time) {
     while (reader.read() && !SigIntHandler::interrupt) {
-        if (reader.record->core.flag & (BAM_FSECONDARY | BAM_FSUPPLEMENTARY)) {
-            continue;
-        }
+        write_record(writer, reader.record.get(), reader.header(), read_group_exp_start_time);
+    }
+}
 
-        std::string run_id = "unknown";
-        std::string model = "unknown";
+bool SummaryData::write_record(
+        std::ostream& writer,
+        const bam1_t* record,
+        const sam_hdr_t* header,
+        const std::map<std::string, std::string>& read_group_exp_start_time) const {
+    if (record->core.flag & (BAM_FSECONDARY | BAM_FSUPPLEMENTARY)) {
+        return false;
+    }
+    const bool is_aligned = header && header->n_targets > 0;
+    std::string run_id = "unknown";
+    std::string model = "unknown";
+
+    auto rg_value = HtsReader::get_tag<std::string>(record, "RG");
+    if (rg_value.length() > 0) {
+        auto rg_split = rg_value.find('_');
+        run_id = rg_value.substr(0, rg_split);
+        model = rg_value.substr(rg_split + 1, rg_value.length());
+    }
 
-        auto rg_value = reader.get_tag<std::string>("RG");
-        if (rg_value.length() > 0) {
-            auto rg_split = rg_value.find('_');
-            run_id = rg_value.substr(0, rg_split);
-            model = rg_value.substr(rg_split + 1, rg_value.length());
-        }
+    auto filename = HtsReader::get_tag<std::string>(record, "f5");
+    if (filename.empty()) {
+        filename = HtsReader::get_tag<std::string>(record, "fn");
+    }
+    auto read_id = bam_get_qname(record);
+    auto channel = HtsReader::get_tag<int>(record, "ch");
+    auto mux = HtsReader::get_tag<int>(record, "mx");
 
-        auto filename = reader.get_tag<std::string>("f5");
-        if (filename.empty()) {
-            filename = reader.get_tag<std::string>("fn");
-        }
-        auto read_id = bam_get_qname(reader.record);
-        auto channel = reader.get_tag<int>("ch");
-        auto mux = reader.get_tag<int>("mx");
+    auto start_time_dt = HtsReader::get_tag<std::string>(record, "st");
+    auto duration = HtsReader::get_tag<float>(record, "du");
 
-        auto start_time_dt = reader.get_tag<std::string>("st");
-        auto duration = reader.get_tag<float>("du");
+    auto seqlen = record->core.l_qseq;
+    auto mean_qscore = HtsReader::get_tag<float>(record, "qs");
 
-        auto seqlen = reader.record->core.l_qseq;
-        auto mean_qscore = reader.get_tag<float>("qs");
+    auto num_samples = HtsReader::get_tag<int>(record, "ns");
+    auto trim_samples = HtsReader::get_tag<int>(record, "ts");
 
-        auto num_samples = reader.get_tag<int>("ns");
-        auto trim_samples = reader.get_tag<int>("ts");
+    auto barcode = HtsReader::get_tag<std::string>(record, "BC");
+    if (barcode.empty()) {
+        barcode = UNCLASSIFIED;
+    }
 
-        auto barcode = reader.get_tag<std::string>("BC");
-        if (barcode.empty()) {
-            barcode = UNCLASSIFIED;
-        }
+    float template_duration = duration;
+    if (num_samples > 0 && duration > 0) {
+        // If either num_samples or duration are 0 (due to missing tags), then
+        // we can't properly compute template_duration.
+        float sample_rate = num_samples / duration;
+        template_duration = (num_samples - trim_samples) / sample_rate;
+    }
+    auto start_time = 0.0;
+    auto exp_start_time_iter = read_group_exp_start_time.find(rg_value);
+    if (exp_start_time_iter != read_group_exp_start_time.end()) {
+        auto exp_start_dt = exp_start_time_iter->second;
+        start_time = utils::time_difference_seconds(start_time_dt, exp_start_dt);
+    }
+    auto template_start_time = start_time + (duration - template_duration);
 
-        float template_duration = duration;
-        if (num_samples > 0 && duration > 0) {
-            // If either num_samples or duration are 0 (due to missing tags), then
-            // we can't properly compute template_duration.
-            float sample_rate = num_samples / duration;
-            template_duration = (num_samples - trim_samples) / sample_rate;
-        }
-        auto start_time = 0.0;
-        auto exp_start_time_iter = read_group_exp_start_time.find(rg_value);
-        if (exp_start_time_iter != read_group_exp_start_time.end()) {
-            auto exp_start_dt = exp_start_time_iter->second;
-            start_time = utils::time_difference_seconds(start_time_dt, exp_start_dt);
-        }
-        auto template_start_time = start_time + (duration - template_duration);
+    writer << filename << m_separator << read_id;
 
-        writer << filename << m_separator << read_id;
+    if (m_field_flags & GENERAL_FIELDS) {
+        writer << m_separator << run_id << m_separator << channel << m_separator << mux
+               << m_separator << start_time << m_separator << duration << m_separator
+               << template_start_time << m_separator << template_duration << m_separator << seqlen
+               << m_separator << mean_qscore;
+    }
 
-        if (m_field_flags & GENERAL_FIELDS) {
-            writer << m_separator << run_id << m_separator << channel << m_separator << mux
-                   << m_separator << start_time << m_separator << duration << m_separator
-                   << template_start_time << m_separator << template_duration << m_separator
-                   << seqlen << m_separator << mean_qscore;
-        }
+    if (m_field_flags & BARCODING_FIELDS) {
+        writer << m_separator << barcode;
+    }
 
-        if (m_field_flags & BARCODING_FIELDS) {
-            writer << m_separator << barcode;
+    if (m_field_flags & ALIGNMENT_FIELDS) {
+        std::string alignment_genome = "*";
+        int32_t alignment_genome_start = -1;
+        int32_t alignment_genome_end = -1;
+        int32_t alignment_strand_start = -1;
+        int32_t alignment_strand_end = -1;
+        std::string alignment_direction = "*";
+        int32_t alignment_length = 0;
+        int32_t alignment_mapq = 0;
+        int alignment_num_aligned = 0;
+        int alignment_num_correct = 0;
+        int alignment_num_insertions = 0;
+        int alignment_num_deletions = 0;
+        int alignment_num_substitutions = 0;
+        float strand_coverage = 0.0;
+        float alignment_identity = 0.0;
+        float alignment_accurary = 0.0;
+        int alignment_bed_hits = 0;
+
+        if (is_aligned && !(record->core.flag & BAM_FUNMAP)) {
+            alignment_mapq = static_cast<int>(record->core.qual);
+            alignment_genome = header->target_name[record->core.tid];
+
+            alignment_genome_start = int32_t(record->core.pos);
+            alignment_genome_end = int32_t(bam_endpos(record));
+            alignment_direction = bam_is_rev(record) ? "-" : "+";
+
+            auto alignment_counts = utils::get_alignment_op_counts(record);
+            alignment_num_aligned = int(alignment_counts.matches);
+            alignment_num_correct = int(alignment_counts.matches - alignment_counts.substitutions);
+            alignment_num_insertions = int(alignment_counts.insertions);
+            alignment_num_deletions = int(alignment_counts.deletions);
+            alignment_num_substitutions = int(alignment_counts.substitutions);
+            alignment_length = int(alignment_counts.matches + alignment_counts.insertions +
+                                   alignment_counts.deletions);
+            alignment_strand_start = int(alignment_counts.softclip_start);
+            alignment_strand_end = int(seqlen - alignment_counts.softclip_end);
+
+            strand_coverage =
+                    (alignment_strand_end - alignment_strand_start) / static_cast<float>(seqlen);
+            alignment_identity =
+                    alignment_num_correct / static_cast<float>(alignment_counts.matches);
+            alignment_accurary = alignment_num_correct / static_cast<float>(alignment_length);
+            alignment_bed_hits = HtsReader::get_tag<int>(record, "bh");
         }
 
-        if (m_field_flags & ALIGNMENT_FIELDS) {
-            std::string alignment_genome = "*";
-            int32_t alignment_genome_start = -1;
-            int32_t alignment_genome_end = -1;
-            int32_t alignment_strand_start = -1;
-            int32_t alignment_strand_end = -1;
-            std::string alignment_direction = "*";
-            int32_t alignment_length = 0;
-            int32_t alignment_mapq = 0;
-            int alignment_num_aligned = 0;
-            int alignment_num_correct = 0;
-            int alignment_num_insertions = 0;
-            int alignment_num_deletions = 0;
-            int alignment_num_substitutions = 0;
-            float strand_coverage = 0.0;
-            float alignment_identity = 0.0;
-            float alignment_accurary = 0.0;
-            int alignment_bed_hits = 0;
-
-            if (reader.is_aligned && !(reader.record->core.flag & BAM_FUNMAP)) {
-                alignment_mapq = static_cast<int>(reader.record->core.qual);
-                alignment_genome = reader.header()->target_name[reader.record->core.tid];
-
-                alignment_genome_start = int32_t(reader.record->core.pos);
-                alignment_genome_end = int32_t(bam_endpos(reader.record.get()));
-                alignment_direction = bam_is_rev(reader.record) ? "-" : "+";
-
-                auto alignment_counts = utils::get_alignment_op_counts(reader.record.get());
-                alignment_num_aligned = int(alignment_counts.matches);
-                alignment_num_correct =
-                        int(alignment_counts.matches - alignment_counts.substitutions);
-                alignment_num_insertions = int(alignment_counts.insertions);
-                alignment_num_deletions = int(alignment_counts.deletions);
-                alignment_num_substitutions = int(alignment_counts.substitutions);
-                alignment_length = int(alignment_counts.matches + alignment_counts.insertions +
-                                       alignment_counts.deletions);
-                alignment_strand_start = int(alignment_counts.softclip_start);
-                alignment_strand_end = int(seqlen - alignment_counts.softclip_end);
-
-                strand_coverage = (alignment_strand_end - alignment_strand_start) /
-                                  static_cast<float>(seqlen);
-                alignment_identity =
-                        alignment_num_correct / static_cast<float>(alignment_counts.matches);
-                alignment_accurary = alignment_num_correct / static_cast<float>(alignment_length);
-                alignment_bed_hits = reader.get_tag<int>("bh");
-            }
-
-            writer << m_separator << alignment_genome << m_separator << alignment_genome_start
-                   << m_separator << alignment_genome_end << m_separator << alignment_strand_start
-                   << m_separator << alignment_strand_end << m_separator << alignment_direction
-                   << m_separator << alignment_length << m_separator << alignment_num_aligned
-                   << m_separator << alignment_num_correct << m_separator
-                   << alignment_num_insertions << m_separator << alignment_num_deletions
-                   << m_separator << alignment_num_substitutions << m_separator << alignment_mapq
-                   << m_separator << strand_coverage << m_separator << alignment_identity
-                   << m_separator << alignment_accurary << m_separator << alignment_bed_hits;
-            ;
-        }
-        writer << '\n';
+        writer << m_separator << alignment_genome << m_separator << alignment_genome_start
+               << m_separator << alignment_genome_end << m_separator << alignment_strand_start
+               << m_separator << alignment_strand_end << m_separator << alignment_direction
+               << m_separator << alignment_length << m_separator << alignment_num_aligned
+               << m_separator << alignment_num_correct << m_separator << alignment_num_insertions
+               << m_separator << alignment_num_deletions << m_separator
+               << alignment_num_substitutions << m_separator << alignment_mapq << m_separator
+               << strand_coverage << m_separator << alignment_identity << m_separator
+               << alignment_accurary << m_separator << alignment_bed_hits;
     }
+    writer << '\n';
+    return true;
+}
+
+SummaryWriter::SummaryWriter(std::ostream& writer, SummaryData summary)
+        : m_writer(writer), m_summary(std::move(summary)) {
+    m_summary.write_header(m_writer);
+}
+
+void SummaryWriter::write_rows(std::string_view rows) {
+    std::lock_guard lock(m_mutex);
+    m_writer.write(rows.data(), rows.size());
 }
 
 }  // namespace dorado
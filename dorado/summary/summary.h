@@ -1,10 +1,15 @@
 #pragma once
 
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
+struct bam1_t;
+struct sam_hdr_t;
+
 namespace dorado {
 
 class HtsReader;
@@ -28,14 +33,41 @@ public:
     /// For this method the fields must already be set.
     bool process_tree(const std::string& folder, std::ostream& writer);
 
+    void write_header(std::ostream& writer) const;
+
+    /// Writes the row for a record using |header|, which must have the read groups of
+    /// |read_group_exp_start_time|. Secondary and supplementary records are skipped, in which
+    /// case this returns false.
+    bool write_record(std::ostream& writer,
+                      const bam1_t* record,
+                      const sam_hdr_t* header,
+                      const std::map<std::string, std::string>& read_group_exp_start_time) const;
+
 private:
     char m_separator{'\t'};
     FieldFlags m_field_flags{};
 
-    void write_header(std::ostream& writer);
     void write_rows_from_reader(HtsReader& reader,
                                 std::ostream& writer,
                                 const std::map<std::string, std::string>& rgst);
 };
 
+/// Writes summary rows to a stream as they're produced, rather than by reading back the output
+/// files. Rows are handed over in blocks, and the writer can be shared by several pipelines.
+class SummaryWriter {
+public:
+    /// Writes the header for |summary| straight away.
+    SummaryWriter(std::ostream& writer, SummaryData summary);
+
+    const SummaryData& summary() const { return m_summary; }
+
+    /// Thread safe. |rows| must be a whole number of rows.
+    void write_rows(std::string_view rows);
+
+private:
+    std::mutex m_mutex;
+    std::ostream& m_writer;
+    const SummaryData m_summary;
+};
+
 }  // namespace dorado
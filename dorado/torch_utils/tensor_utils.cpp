@@ -5,9 +5,12 @@
 #include <torch/csrc/jit/serialization/pickle.h>
 #include <torch/torch.h>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <limits>
 #include <sstream>
 #include <vector>
 
@@ -75,6 +78,126 @@ void convert_f32_to_f16_impl(c10::Half* const dest, const float* const src, std:
 }
 #endif  // ENABLE_AVX2_IMPL || ENABLE_NEON_IMPL
 
+#if !ENABLE_NEON_IMPL
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void normalise_int16_to_f32_impl(float* const dest,
+                                 const int16_t* const src,
+                                 std::size_t count,
+                                 float shift,
+                                 float scale) {
+    for (std::size_t i = 0; i < count; ++i) {
+        dest[i] = (float(src[i]) - shift) / scale;
+    }
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void normalise_int16_to_f16_impl(c10::Half* const dest,
+                                 const int16_t* const src,
+                                 std::size_t count,
+                                 float shift,
+                                 float scale) {
+    for (std::size_t i = 0; i < count; ++i) {
+        dest[i] = c10::Half((float(src[i]) - shift) / scale);
+    }
+}
+#endif  // ENABLE_NEON_IMPL
+
+#if ENABLE_AVX2_IMPL || ENABLE_NEON_IMPL
+// The scaling divides rather than multiplying by the reciprocal so that the results match
+// the tensor ops this replaces exactly.
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2")))
+#endif
+void normalise_int16_to_f32_impl(float* const dest,
+                                 const int16_t* const src,
+                                 std::size_t count,
+                                 float shift,
+                                 float scale) {
+    const simd::FloatRegister shift_reg = simd_set1_32(shift);
+    const simd::FloatRegister scale_reg = simd_set1_32(scale);
+
+    const std::size_t vector_count = count - count % simd::kFloatsPerRegister;
+    for (std::size_t i = 0; i < vector_count; i += simd::kFloatsPerRegister) {
+        const simd::FloatRegister elems = simd_load_i16_32(&src[i]);
+        simd_store_32(&dest[i], simd_div_32(simd_sub_32(elems, shift_reg), scale_reg));
+    }
+    for (std::size_t i = vector_count; i < count; ++i) {
+        dest[i] = (float(src[i]) - shift) / scale;
+    }
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2,f16c")))
+#endif
+void normalise_int16_to_f16_impl(c10::Half* const dest,
+                                 const int16_t* const src,
+                                 std::size_t count,
+                                 float shift,
+                                 float scale) {
+    const simd::FloatRegister shift_reg = simd_set1_32(shift);
+    const simd::FloatRegister scale_reg = simd_set1_32(scale);
+
+    const std::size_t vector_count = count - count % simd::kFloatsPerRegister;
+    for (std::size_t i = 0; i < vector_count; i += simd::kFloatsPerRegister) {
+        const simd::FloatRegister elems = simd_load_i16_32(&src[i]);
+        const simd::FloatRegister scaled = simd_div_32(simd_sub_32(elems, shift_reg), scale_reg);
+        simd_store_16(&dest[i], simd_convert_32_16(scaled));
+    }
+    for (std::size_t i = vector_count; i < count; ++i) {
+        const float scaled = (float(src[i]) - shift) / scale;
+        const simd::HalfRegister elem_f16 = simd_convert_32_16(simd_load1_32(&scaled));
+        simd_store1_16(&dest[i], elem_f16);
+    }
+}
+#endif  // ENABLE_AVX2_IMPL || ENABLE_NEON_IMPL
+
+// Counts of each int16 value, indexed by the value minus INT16_MIN, along with the range of bins
+// that were counted. A table is reused by each thread, and only the range of bins used by the
+// previous signal is cleared, so that the counts can be gathered in a single pass without first
+// finding the range of the signal.
+struct Int16Histogram {
+    std::vector<uint32_t> counts = std::vector<uint32_t>(std::size_t(1) << 16, 0);
+    int min_bin{0};
+    int max_bin{-1};
+};
+
+const Int16Histogram& count_int16(const int16_t* data, std::size_t count) {
+    thread_local Int16Histogram histogram;
+    auto* const counts = histogram.counts.data();
+    if (histogram.min_bin <= histogram.max_bin) {
+        std::fill(counts + histogram.min_bin, counts + histogram.max_bin + 1, 0);
+    }
+
+    int min_bin = std::numeric_limits<uint16_t>::max();
+    int max_bin = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const int bin = data[i] - std::numeric_limits<int16_t>::min();
+        ++counts[bin];
+        min_bin = std::min(min_bin, bin);
+        max_bin = std::max(max_bin, bin);
+    }
+    histogram.min_bin = min_bin;
+    histogram.max_bin = max_bin;
+    return histogram;
+}
+
+// Returns the first bin in [first_bin, last_bin] at which the running total of the counts
+// exceeds rank, i.e. the bin holding the element at that rank in sorted order.
+int find_ranked_bin(const uint32_t* counts, int first_bin, int last_bin, std::size_t rank) {
+    std::size_t total = 0;
+    for (int bin = first_bin; bin < last_bin; ++bin) {
+        total += counts[bin];
+        if (total > rank) {
+            return bin;
+        }
+    }
+    return last_bin;
+}
+
 }  // namespace
 
 void serialise_tensor(const at::Tensor& t, const std::string& path) {
@@ -146,6 +269,60 @@ at::Tensor quantile_counting(const at::Tensor& t, const at::Tensor& q) {
     return res;
 }
 
+std::pair<float, float> quantiles_int16(const int16_t* data,
+                                        std::size_t count,
+                                        float quantile_a,
+                                        float quantile_b) {
+    if (count == 0) {
+        return {0.f, 0.f};
+    }
+
+    const auto& histogram = count_int16(data, count);
+    auto quantile = [&](float q) {
+        // Rank the quantile in the same way as quantile_counting().
+        const int threshold = int(q * (count - 1));
+        const int bin = find_ranked_bin(histogram.counts.data(), histogram.min_bin,
+                                        histogram.max_bin, std::size_t(threshold));
+        return float(bin + std::numeric_limits<int16_t>::min());
+    };
+    return {quantile(quantile_a), quantile(quantile_b)};
+}
+
+std::pair<float, float> median_and_mad_int16(const int16_t* data, std::size_t count) {
+    if (count == 0) {
+        return {0.f, 0.f};
+    }
+
+    const auto& histogram = count_int16(data, count);
+    const std::size_t median_rank = (count - 1) / 2;
+    const int median_bin = find_ranked_bin(histogram.counts.data(), histogram.min_bin,
+                                           histogram.max_bin, median_rank);
+
+    // Count the absolute deviations from the value counts rather than going back to the data.
+    const int max_deviation =
+            std::max(median_bin - histogram.min_bin, histogram.max_bin - median_bin);
+    thread_local std::vector<uint32_t> deviations;
+    deviations.assign(max_deviation + 1, 0);
+    for (int bin = histogram.min_bin; bin <= histogram.max_bin; ++bin) {
+        deviations[std::abs(bin - median_bin)] += histogram.counts[bin];
+    }
+    const int mad = find_ranked_bin(deviations.data(), 0, max_deviation, median_rank);
+
+    return {float(median_bin + std::numeric_limits<int16_t>::min()), float(mad)};
+}
+
+void normalise_int16(float* dest, const int16_t* src, std::size_t count, float shift, float scale) {
+    normalise_int16_to_f32_impl(dest, src, count, shift, scale);
+}
+
+void normalise_int16(c10::Half* dest,
+                     const int16_t* src,
+                     std::size_t count,
+                     float shift,
+                     float scale) {
+    normalise_int16_to_f16_impl(dest, src, count, shift, scale);
+}
+
 // Multiversioned function dispatch doesn't work across the dorado_lib linking
 // boundary.  Without this wrapper, AVX machines still only execute the default
 // version.
@@ -3,8 +3,10 @@
 #include <ATen/core/TensorBody.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace dorado::utils {
@@ -25,6 +27,26 @@ at::Tensor quantile(const at::Tensor& t, const at::Tensor& q);
 // Only `interpolation='lower'` is currently implemented.
 at::Tensor quantile_counting(const at::Tensor& t, const at::Tensor& q);
 
+// Computes the quantile_a and quantile_b quantiles of count int16 elements, giving the same
+// results as quantile_counting() but without creating any tensors.
+std::pair<float, float> quantiles_int16(const int16_t* data,
+                                        std::size_t count,
+                                        float quantile_a,
+                                        float quantile_b);
+
+// Computes the median of count int16 elements and the median of their absolute deviations from
+// it, giving the same results as at::median(), which takes the lower of the two middle values.
+std::pair<float, float> median_and_mad_int16(const int16_t* data, std::size_t count);
+
+// Writes (src[i] - shift) / scale for count int16 elements to dest, converting to float32 or
+// float16 in the same pass rather than going through a float32 temporary.
+void normalise_int16(float* dest, const int16_t* src, std::size_t count, float shift, float scale);
+void normalise_int16(c10::Half* dest,
+                     const int16_t* src,
+                     std::size_t count,
+                     float shift,
+                     float scale);
+
 // Converts count float elements pointed to by src to half precision, with
 // the result pointed to by dest.
 void convert_f32_to_f16(c10::Half* dest, const float* src, std::size_t count);
@@ -3,11 +3,15 @@
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <queue>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <vector>
 
 namespace dorado::utils {
 
@@ -38,6 +42,38 @@ class AsyncQueue {
     // Stats for monitoring queue usage.
     int64_t m_num_pushes = 0;
     int64_t m_num_pops = 0;
+    // Number of times the mutex was already held when pushing/popping.
+    int64_t m_num_push_contended = 0;
+    int64_t m_num_pop_contended = 0;
+    // Number of times pushes/pops had to wait for space/items, and the total time spent waiting.
+    int64_t m_num_push_waits = 0;
+    int64_t m_num_pop_waits = 0;
+    std::chrono::steady_clock::duration m_push_wait_time{0};
+    std::chrono::steady_clock::duration m_pop_wait_time{0};
+
+    // Takes the mutex, counting the times it was already held by another thread.
+    std::unique_lock<std::mutex> lock_mutex(int64_t& num_contended) {
+        std::unique_lock lock(m_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            lock.lock();
+            ++num_contended;
+        }
+        return lock;
+    }
+
+    // Waits until the queue has space for an item or we are asked to terminate.
+    // Should only be called with the mutex held via lock.
+    void wait_for_space(std::unique_lock<std::mutex>& lock) {
+        assert(lock.owns_lock());
+        auto has_space = [this] { return m_items.size() < m_capacity || m_terminate; };
+        if (has_space()) {
+            return;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        m_not_full_cv.wait(lock, has_space);
+        ++m_num_push_waits;
+        m_push_wait_time += std::chrono::steady_clock::now() - start;
+    }
 
     // Sets item to the next element in the queue and
     // notifies a waiting thread that the queue is not full.
@@ -78,8 +114,14 @@ class AsyncQueue {
     // Waits until the queue is not empty or we are asked to terminate.
     // Returns a unique_lock holding m_mutex.
     std::unique_lock<std::mutex> wait_for_item() {
-        std::unique_lock lock(m_mutex);
-        m_not_empty_cv.wait(lock, [this] { return !m_items.empty() || m_terminate; });
+        auto lock = lock_mutex(m_num_pop_contended);
+        auto has_item = [this] { return !m_items.empty() || m_terminate; };
+        if (!has_item()) {
+            const auto start = std::chrono::steady_clock::now();
+            m_not_empty_cv.wait(lock, has_item);
+            ++m_num_pop_waits;
+            m_pop_wait_time += std::chrono::steady_clock::now() - start;
+        }
         // Note: don't use std::move, so we have the opportunity of NRVO on lock.
         return lock;
     }
@@ -88,9 +130,15 @@ class AsyncQueue {
     template <class Clock, class Duration>
     std::tuple<std::unique_lock<std::mutex>, bool> wait_for_item_or_timeout(
             const std::chrono::time_point<Clock, Duration>& timeout_time) {
-        std::unique_lock lock(m_mutex);
-        bool wait_status = m_not_empty_cv.wait_until(
-                lock, timeout_time, [this] { return !m_items.empty() || m_terminate; });
+        auto lock = lock_mutex(m_num_pop_contended);
+        auto has_item = [this] { return !m_items.empty() || m_terminate; };
+        if (has_item()) {
+            return {std::move(lock), true};
+        }
+        const auto start = std::chrono::steady_clock::now();
+        bool wait_status = m_not_empty_cv.wait_until(lock, timeout_time, has_item);
+        ++m_num_pop_waits;
+        m_pop_wait_time += std::chrono::steady_clock::now() - start;
         return {std::move(lock), wait_status};
     }
 
@@ -117,10 +165,10 @@ public:
     // is returned.
     // Items pushed must be rvalues, since we assume sole ownership.
     AsyncQueueStatus try_push(Item&& item) {
-        std::unique_lock lock(m_mutex);
+        auto lock = lock_mutex(m_num_push_contended);
 
         // Ensure there is space for the new item, given our limit on capacity.
-        m_not_full_cv.wait(lock, [this] { return m_items.size() < m_capacity || m_terminate; });
+        wait_for_space(lock);
 
         // We hold the mutex, and either there is space in the queue, or we have been
         // asked to terminate.
@@ -138,6 +186,40 @@ public:
         return AsyncQueueStatus::Success;
     }
 
+    // Adds all the items to the queue, in order, taking the mutex once for as many items as
+    // there is space for, and blocking while the queue is full.
+    // On success the vector is cleared. If terminate() was called, AsyncQueueStatus::Terminate
+    // is returned and the items which weren't added are left in the vector.
+    AsyncQueueStatus try_push_batch(std::vector<Item>& items) {
+        size_t num_pushed = 0;
+        while (num_pushed < items.size()) {
+            auto lock = lock_mutex(m_num_push_contended);
+            wait_for_space(lock);
+            if (m_terminate) {
+                items.erase(items.begin(), items.begin() + num_pushed);
+                return AsyncQueueStatus::Terminate;
+            }
+
+            const size_t count =
+                    std::min(items.size() - num_pushed, m_capacity - m_items.size());
+            for (size_t i = 0; i < count; ++i) {
+                m_items.push(std::move(items[num_pushed + i]));
+            }
+            num_pushed += count;
+            m_num_pushes += count;
+
+            // Inform waiting threads that there are now items available.
+            lock.unlock();
+            if (count == 1) {
+                m_not_empty_cv.notify_one();
+            } else {
+                m_not_empty_cv.notify_all();
+            }
+        }
+        items.clear();
+        return AsyncQueueStatus::Success;
+    }
+
     // Obtains the next item in the queue, potentially timing out.
     // If queue is empty:
     // If timeout is reached, but we are not terminating, returns AsyncQueueStatus::Timeout.
@@ -201,6 +283,15 @@ public:
         return AsyncQueueStatus::Success;
     }
 
+    // Replaces the contents of items with up to max_count items from the front of the queue,
+    // blocking until at least one is available.
+    // If queue is empty and we are terminating, returns AsyncQueueStatus::Terminate.
+    AsyncQueueStatus try_pop_batch(std::vector<Item>& items, size_t max_count) {
+        items.clear();
+        return process_and_pop_n([&items](Item&& item) { items.push_back(std::move(item)); },
+                                 std::max(max_count, size_t(1)));
+    }
+
     // Like process_and_pop_n, except it also has a timeout.  If the queue is empty
     // and we time out before an item is added, returns AsyncQueueStatus::Timeout.
     template <class ProcessFn, class Clock, class Duration>
@@ -266,6 +357,13 @@ public:
         stats["items"] = double(m_items.size());
         stats["pushes"] = double(m_num_pushes);
         stats["pops"] = double(m_num_pops);
+        stats["push_contention"] = double(m_num_push_contended);
+        stats["pop_contention"] = double(m_num_pop_contended);
+        stats["push_waits"] = double(m_num_push_waits);
+        stats["pop_waits"] = double(m_num_pop_waits);
+        stats["push_wait_ms"] =
+                std::chrono::duration<double, std::milli>(m_push_wait_time).count();
+        stats["pop_wait_ms"] = std::chrono::duration<double, std::milli>(m_pop_wait_time).count();
         return stats;
     }
 };
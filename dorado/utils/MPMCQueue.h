@@ -0,0 +1,372 @@
+#pragma once
+
+#include "AsyncQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dorado::utils {
+
+// Bounded lock-free multi-producer/multi-consumer queue, with the same blocking and
+// termination semantics as AsyncQueue.
+// Items are held in a ring buffer of slots, each of which has a sequence number that tells
+// producers and consumers whose turn it is to use the slot (after D. Vyukov's bounded MPMC
+// queue). Claiming slots is a single CAS on the push or pop ticket, so no lock is taken while
+// items are moved in or out, and batch pushes and pops claim as many consecutive slots as are
+// available at once.
+// A thread which finds the queue full or empty polls it briefly, and then sleeps on a condition
+// variable. The condition variable is only signalled if a thread is actually asleep on it, so
+// the futex traffic of AsyncQueue is only paid when the queue really fills up or runs dry.
+// Items must be movable.
+template <class Item>
+class MPMCQueue {
+    // Number of times a blocked thread polls the queue before going to sleep.
+    static constexpr int SPIN_COUNT = 64;
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        // Equal to the push ticket when the slot is free for it, and to the pop ticket + 1
+        // once the item has been pushed.
+        std::atomic<size_t> sequence{0};
+        alignas(Item) unsigned char storage[sizeof(Item)];
+
+        Item* item() { return std::launder(reinterpret_cast<Item*>(storage)); }
+    };
+
+    // State of the push or the pop side of the queue, kept apart to avoid false sharing.
+    struct alignas(CACHE_LINE_SIZE) Side {
+        // Next ticket to be claimed.
+        std::atomic<size_t> ticket{0};
+        // Number of threads asleep waiting for the other side to free or fill a slot.
+        std::atomic<int> num_sleeping{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        // Stats for monitoring queue usage.
+        std::atomic<int64_t> num_items{0};
+        std::atomic<int64_t> num_contended{0};
+        std::atomic<int64_t> num_waits{0};
+        std::atomic<int64_t> wait_time_ns{0};
+    };
+
+    const size_t m_capacity;
+    std::unique_ptr<Slot[]> m_slots;
+    Side m_push;
+    Side m_pop;
+    // If true, waits should terminate regardless of other state.
+    // Pending attempts to push or pop items will fail.
+    std::atomic<bool> m_terminate{false};
+
+    Slot& slot(size_t ticket) { return m_slots[ticket % m_capacity]; }
+
+    // Returns true if the slot of the next ticket of the side is ready for it. Only a hint,
+    // since another thread may claim the ticket first.
+    bool is_next_ready(Side& side, size_t ready_offset) {
+        const size_t ticket = side.ticket.load(std::memory_order_relaxed);
+        return slot(ticket).sequence.load(std::memory_order_acquire) == ticket + ready_offset;
+    }
+
+    // Claims up to max_count consecutive tickets of the side whose slots are ready for it, i.e.
+    // free ones for pushes (ready_offset 0) and filled ones for pops (ready_offset 1).
+    // Returns the number of tickets claimed, starting at first_ticket, or 0 if the next slot
+    // isn't ready.
+    size_t claim(Side& side, size_t ready_offset, size_t max_count, size_t& first_ticket) {
+        size_t ticket = side.ticket.load(std::memory_order_relaxed);
+        while (true) {
+            // A slot which is ready can't be taken by anyone else without claiming its ticket,
+            // so once the CAS succeeds all of the counted slots are ours.
+            size_t count = 0;
+            while (count < max_count &&
+                   slot(ticket + count).sequence.load(std::memory_order_acquire) ==
+                           ticket + count + ready_offset) {
+                ++count;
+            }
+            if (count == 0) {
+                const size_t current = side.ticket.load(std::memory_order_relaxed);
+                if (current == ticket) {
+                    return 0;
+                }
+                // Another thread claimed the ticket first.
+                ticket = current;
+                side.num_contended.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (side.ticket.compare_exchange_weak(ticket, ticket + count,
+                                                  std::memory_order_relaxed)) {
+                first_ticket = ticket;
+                return count;
+            }
+            side.num_contended.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void push_claimed(size_t ticket, Item&& item) {
+        Slot& s = slot(ticket);
+        new (s.storage) Item(std::move(item));
+        s.sequence.store(ticket + 1, std::memory_order_release);
+    }
+
+    Item pop_claimed(size_t ticket) {
+        Slot& s = slot(ticket);
+        Item item(std::move(*s.item()));
+        s.item()->~Item();
+        s.sequence.store(ticket + m_capacity, std::memory_order_release);
+        return item;
+    }
+
+    // Wakes the threads sleeping on the side, if there are any.
+    void notify(Side& side, bool notify_all) {
+        // Pairs with the increment in wait_until. Read-modify-writes always see the latest value,
+        // so either we see the sleeper here, or the sleeper's increment synchronises with ours and
+        // it sees our update to the slots before sleeping.
+        if (side.num_sleeping.fetch_add(0, std::memory_order_acq_rel) == 0) {
+            return;
+        }
+        // Taking the mutex ensures a sleeper which hasn't started waiting yet checks the
+        // slots after our update.
+        { std::lock_guard lock(side.mutex); }
+        if (notify_all) {
+            side.cv.notify_all();
+        } else {
+            side.cv.notify_one();
+        }
+    }
+
+    // Waits on the side until is_ready returns true, returning false if the timeout is
+    // reached first. Waits indefinitely if timeout_time is null.
+    template <class IsReady, class Clock, class Duration>
+    bool wait_until(Side& side,
+                    IsReady is_ready,
+                    const std::chrono::time_point<Clock, Duration>* timeout_time) {
+        for (int i = 0; i < SPIN_COUNT; ++i) {
+            if (is_ready()) {
+                return true;
+            }
+            std::this_thread::yield();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        side.num_sleeping.fetch_add(1, std::memory_order_acq_rel);
+        bool ready = true;
+        {
+            std::unique_lock lock(side.mutex);
+            if (timeout_time) {
+                ready = side.cv.wait_until(lock, *timeout_time, is_ready);
+            } else {
+                side.cv.wait(lock, is_ready);
+            }
+        }
+        side.num_sleeping.fetch_sub(1, std::memory_order_relaxed);
+
+        const auto wait_time = std::chrono::steady_clock::now() - start;
+        side.num_waits.fetch_add(1, std::memory_order_relaxed);
+        side.wait_time_ns.fetch_add(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(wait_time).count(),
+                std::memory_order_relaxed);
+        return ready;
+    }
+
+    template <class IsReady>
+    void wait(Side& side, IsReady is_ready) {
+        wait_until(side, is_ready,
+                   static_cast<const std::chrono::steady_clock::time_point*>(nullptr));
+    }
+
+    bool can_push() { return is_next_ready(m_push, 0) || m_terminate.load(); }
+    bool can_pop() { return is_next_ready(m_pop, 1) || m_terminate.load(); }
+
+    // Pops the next item, returning Timeout if timeout_time is reached first.
+    template <class Clock, class Duration>
+    AsyncQueueStatus pop_until(Item& item,
+                               const std::chrono::time_point<Clock, Duration>* timeout_time) {
+        while (true) {
+            // Termination takes effect once all items have been popped from the queue.
+            const bool terminating = m_terminate.load();
+            size_t ticket = 0;
+            if (claim(m_pop, 1, 1, ticket) == 1) {
+                item = pop_claimed(ticket);
+                m_pop.num_items.fetch_add(1, std::memory_order_relaxed);
+                notify(m_push, false);
+                return AsyncQueueStatus::Success;
+            }
+            if (terminating) {
+                return AsyncQueueStatus::Terminate;
+            }
+            if (!wait_until(m_pop, [this] { return can_pop(); }, timeout_time)) {
+                return AsyncQueueStatus::Timeout;
+            }
+        }
+    }
+
+public:
+    // Attempts to push items beyond capacity will block.
+    explicit MPMCQueue(size_t capacity) : m_capacity(capacity) {
+        if (m_capacity == 0) {
+            throw std::runtime_error("MPMCQueue capacity must be positive");
+        }
+        m_slots = std::make_unique<Slot[]>(m_capacity);
+        for (size_t i = 0; i < m_capacity; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MPMCQueue() {
+        terminate();
+        // Destroy any items which were never popped.
+        const size_t end = m_push.ticket.load();
+        for (size_t ticket = m_pop.ticket.load(); ticket != end; ++ticket) {
+            if (slot(ticket).sequence.load() == ticket + 1) {
+                slot(ticket).item()->~Item();
+            }
+        }
+    }
+
+    // Contains atomics, std::mutex and std::condition_variable, so is not copyable or movable.
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue(MPMCQueue&&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(MPMCQueue&&) = delete;
+
+    // Attempts to add an item to the queue.
+    // If the queue is full, blocks until there is space or terminate() is called.
+    // If terminate() was called, the item is not added and AsyncQueueStatus::Terminate
+    // is returned.
+    AsyncQueueStatus try_push(Item&& item) {
+        while (true) {
+            if (m_terminate.load()) {
+                return AsyncQueueStatus::Terminate;
+            }
+            size_t ticket = 0;
+            if (claim(m_push, 0, 1, ticket) == 1) {
+                push_claimed(ticket, std::move(item));
+                m_push.num_items.fetch_add(1, std::memory_order_relaxed);
+                notify(m_pop, false);
+                return AsyncQueueStatus::Success;
+            }
+            wait(m_push, [this] { return can_push(); });
+        }
+    }
+
+    // Adds all the items to the queue, in order, blocking while the queue is full.
+    // The items are moved in bursts of as many consecutive free slots as are available.
+    // On success the vector is cleared. If terminate() was called, AsyncQueueStatus::Terminate
+    // is returned and the items which weren't added are left in the vector.
+    AsyncQueueStatus try_push_batch(std::vector<Item>& items) {
+        size_t num_pushed = 0;
+        while (num_pushed < items.size()) {
+            if (m_terminate.load()) {
+                items.erase(items.begin(), items.begin() + num_pushed);
+                return AsyncQueueStatus::Terminate;
+            }
+            size_t ticket = 0;
+            const size_t count = claim(m_push, 0, items.size() - num_pushed, ticket);
+            if (count == 0) {
+                wait(m_push, [this] { return can_push(); });
+                continue;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                push_claimed(ticket + i, std::move(items[num_pushed + i]));
+            }
+            num_pushed += count;
+            m_push.num_items.fetch_add(count, std::memory_order_relaxed);
+            notify(m_pop, count > 1);
+        }
+        items.clear();
+        return AsyncQueueStatus::Success;
+    }
+
+    // Obtains the next item in the queue.
+    // If queue is empty:
+    // If we are terminating, returns AsyncQueueStatus::Terminate.
+    // Otherwise block until an item is added, upon which AsyncQueueStatus::Success
+    // is returned.
+    AsyncQueueStatus try_pop(Item& item) {
+        return pop_until(item, static_cast<const std::chrono::steady_clock::time_point*>(nullptr));
+    }
+
+    // As try_pop, but returns AsyncQueueStatus::Timeout if the queue is still empty once
+    // timeout_time is reached.
+    template <class Clock, class Duration>
+    AsyncQueueStatus try_pop_until(Item& item,
+                                   const std::chrono::time_point<Clock, Duration>& timeout_time) {
+        return pop_until(item, &timeout_time);
+    }
+
+    // Replaces the contents of items with up to max_count items from the front of the queue,
+    // blocking until at least one is available, claiming all those available at once.
+    // If queue is empty and we are terminating, returns AsyncQueueStatus::Terminate.
+    AsyncQueueStatus try_pop_batch(std::vector<Item>& items, size_t max_count) {
+        items.clear();
+        while (true) {
+            const bool terminating = m_terminate.load();
+            size_t ticket = 0;
+            const size_t count = claim(m_pop, 1, std::max(max_count, size_t(1)), ticket);
+            if (count > 0) {
+                items.reserve(count);
+                for (size_t i = 0; i < count; ++i) {
+                    items.push_back(pop_claimed(ticket + i));
+                }
+                m_pop.num_items.fetch_add(count, std::memory_order_relaxed);
+                notify(m_push, count > 1);
+                return AsyncQueueStatus::Success;
+            }
+            if (terminating) {
+                return AsyncQueueStatus::Terminate;
+            }
+            wait(m_pop, [this] { return can_pop(); });
+        }
+    }
+
+    // Tells the queue to terminate any waits.
+    // Pushes will fail and return return AsyncQueueStatus::Terminate until restart is called.
+    // Pops will return AsyncQueueStatus::Terminate once the queue is empty.
+    void terminate() {
+        m_terminate.store(true);
+        notify(m_push, true);
+        notify(m_pop, true);
+    }
+
+    // Resets state to active following a terminate call.
+    void restart() { m_terminate.store(false); }
+
+    // Maximum number of items the queue can contain.
+    size_t capacity() const { return m_capacity; }
+
+    // Current number of items in the queue, including those still being pushed or popped.
+    // Only useful for stats sampling and testing.
+    size_t size() const {
+        const size_t pop_ticket = m_pop.ticket.load();
+        return m_push.ticket.load() - pop_ticket;
+    }
+
+    std::string get_name() const { return "queue"; }
+
+    std::unordered_map<std::string, double> sample_stats() const {
+        std::unordered_map<std::string, double> stats;
+        stats["items"] = double(size());
+        stats["pushes"] = double(m_push.num_items.load());
+        stats["pops"] = double(m_pop.num_items.load());
+        stats["push_contention"] = double(m_push.num_contended.load());
+        stats["pop_contention"] = double(m_pop.num_contended.load());
+        stats["push_waits"] = double(m_push.num_waits.load());
+        stats["pop_waits"] = double(m_pop.num_waits.load());
+        stats["push_wait_ms"] = double(m_push.wait_time_ns.load()) / 1e6;
+        stats["pop_wait_ms"] = double(m_pop.wait_time_ns.load()) / 1e6;
+        return stats;
+    }
+};
+
+}  // namespace dorado::utils
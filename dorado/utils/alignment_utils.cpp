@@ -2,9 +2,22 @@
 
 #include <minimap.h>
 
+#include <algorithm>
+#include <limits>
 #include <ostream>
 #include <sstream>
 
+namespace {
+
+// Traceback moves for the banded alignment, packed four to a byte.
+enum BandedMove : uint8_t {
+    MOVE_DIAGONAL = 0,  // Consumes a base of both sequences.
+    MOVE_UP = 1,        // Consumes a base of the query only.
+    MOVE_LEFT = 2,      // Consumes a base of the target only.
+};
+
+}  // namespace
+
 namespace dorado::utils {
 
 std::string alignment_to_str(const char* query,
@@ -51,4 +64,104 @@ std::string alignment_to_str(const char* query,
     return ss.str();
 }
 
+std::optional<std::vector<uint8_t>> banded_global_alignment(std::string_view query,
+                                                            std::string_view target,
+                                                            int64_t min_diagonal,
+                                                            int64_t max_diagonal) {
+    const auto query_len = static_cast<int64_t>(query.size());
+    const auto target_len = static_cast<int64_t>(target.size());
+    const int64_t end_diagonal = target_len - query_len;
+    if (min_diagonal > std::min<int64_t>(0, end_diagonal) ||
+        max_diagonal < std::max<int64_t>(0, end_diagonal)) {
+        return std::nullopt;
+    }
+    // Diagonals beyond the matrix can't be used by any path.
+    min_diagonal = std::max(min_diagonal, -query_len);
+    max_diagonal = std::min(max_diagonal, target_len);
+
+    const int64_t band_width = max_diagonal - min_diagonal + 1;
+    const int64_t bytes_per_row = (band_width + 3) / 4;
+    std::vector<uint8_t> moves((query_len + 1) * bytes_per_row, 0);
+    auto set_move = [&](int64_t row, int64_t band_idx, uint8_t move) {
+        moves[row * bytes_per_row + band_idx / 4] |= uint8_t(move << (2 * (band_idx % 4)));
+    };
+    auto get_move = [&](int64_t row, int64_t band_idx) {
+        return (moves[row * bytes_per_row + band_idx / 4] >> (2 * (band_idx % 4))) & 3;
+    };
+
+    // Edit distances of the previous and current rows, indexed by (diagonal - min_diagonal + 1)
+    // so that there's an out of band sentinel at either end.
+    constexpr int32_t OUT_OF_BAND = std::numeric_limits<int32_t>::max() / 2;
+    std::vector<int32_t> prev_row(band_width + 2, OUT_OF_BAND);
+    std::vector<int32_t> curr_row(band_width + 2, OUT_OF_BAND);
+
+    for (int64_t col = 0; col <= max_diagonal; ++col) {
+        const int64_t band_idx = col - min_diagonal;
+        prev_row[band_idx + 1] = static_cast<int32_t>(col);
+        set_move(0, band_idx, MOVE_LEFT);
+    }
+
+    for (int64_t row = 1; row <= query_len; ++row) {
+        std::fill(curr_row.begin(), curr_row.end(), OUT_OF_BAND);
+        const int64_t first_col = std::max<int64_t>(0, row + min_diagonal);
+        const int64_t last_col = std::min(target_len, row + max_diagonal);
+        const char query_base = query[row - 1];
+        for (int64_t col = first_col; col <= last_col; ++col) {
+            const int64_t band_idx = col - row - min_diagonal;
+            if (col == 0) {
+                curr_row[band_idx + 1] = static_cast<int32_t>(row);
+                set_move(row, band_idx, MOVE_UP);
+                continue;
+            }
+            // The cell above is on the next diagonal, the cell to the left on the previous one.
+            const int32_t diagonal =
+                    prev_row[band_idx + 1] + (query_base != target[col - 1] ? 1 : 0);
+            const int32_t up = prev_row[band_idx + 2] + 1;
+            const int32_t left = curr_row[band_idx] + 1;
+            const int32_t best = std::min({diagonal, up, left});
+            // Ties are broken as in edlib's traceback: up, then left, then diagonal.
+            uint8_t move = MOVE_DIAGONAL;
+            if (up == best) {
+                move = MOVE_UP;
+            } else if (left == best) {
+                move = MOVE_LEFT;
+            }
+            curr_row[band_idx + 1] = best;
+            set_move(row, band_idx, move);
+        }
+        std::swap(prev_row, curr_row);
+    }
+
+    std::vector<uint8_t> alignment;
+    alignment.reserve(std::max(query_len, target_len));
+    int64_t row = query_len;
+    int64_t col = target_len;
+    while (row > 0 || col > 0) {
+        const int64_t band_idx = col - row - min_diagonal;
+        // Cells on the edges of the band have neighbours outside of it, which could have
+        // given a better path.
+        if ((band_idx == 0 && col > 0) || (band_idx == band_width - 1 && row > 0)) {
+            return std::nullopt;
+        }
+        switch (get_move(row, band_idx)) {
+        case MOVE_DIAGONAL:
+            alignment.push_back(query[row - 1] == target[col - 1] ? EDLIB_EDOP_MATCH
+                                                                  : EDLIB_EDOP_MISMATCH);
+            --row;
+            --col;
+            break;
+        case MOVE_UP:
+            alignment.push_back(EDLIB_EDOP_INSERT);
+            --row;
+            break;
+        default:
+            alignment.push_back(EDLIB_EDOP_DELETE);
+            --col;
+            break;
+        }
+    }
+    std::reverse(alignment.begin(), alignment.end());
+    return alignment;
+}
+
 }  // namespace dorado::utils
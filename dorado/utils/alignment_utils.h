@@ -3,7 +3,11 @@
 
 #include <edlib.h>
 
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace dorado::utils {
 
@@ -28,4 +32,23 @@ namespace dorado::utils {
 
 std::string alignment_to_str(const char* query, const char* target, const EdlibAlignResult& result);
 
+/**
+ * @brief Globally aligns `query` to `target` within a band of diagonals of the DP matrix.
+ *
+ * Only cells whose diagonal (target position - query position) lies within
+ * [`min_diagonal`, `max_diagonal`] are computed, so the cost is linear in the sequence length
+ * for a fixed band. The band must contain both corners of the matrix, i.e. diagonals 0 and
+ * `target.size() - query.size()`. Among equally good paths, the one edlib's traceback would
+ * give is chosen.
+ *
+ * @return The edit operations of the alignment, as EDLIB_EDOP_* codes in the same form as an
+ *         edlib path, or std::nullopt if the band doesn't contain both corners or if the best
+ *         path within the band touches its edges, in which case a better alignment may lie
+ *         outside of it.
+ */
+std::optional<std::vector<uint8_t>> banded_global_alignment(std::string_view query,
+                                                            std::string_view target,
+                                                            int64_t min_diagonal,
+                                                            int64_t max_diagonal);
+
 }  // namespace dorado::utils
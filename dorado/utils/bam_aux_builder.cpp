@@ -0,0 +1,73 @@
+#include "bam_aux_builder.h"
+
+#include <htslib/sam.h>
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace dorado::utils {
+
+void BamAuxBuilder::append_header(const char tag[2], char type) {
+    const uint8_t header[3] = {uint8_t(tag[0]), uint8_t(tag[1]), uint8_t(type)};
+    append_bytes(header, sizeof(header));
+}
+
+void BamAuxBuilder::append_bytes(const void* bytes, size_t count) {
+    const auto* begin = static_cast<const uint8_t*>(bytes);
+    m_data.insert(m_data.end(), begin, begin + count);
+}
+
+void BamAuxBuilder::append_int(const char tag[2], int32_t value) {
+    append_header(tag, 'i');
+    append_bytes(&value, sizeof(value));
+}
+
+void BamAuxBuilder::append_float(const char tag[2], float value) {
+    append_header(tag, 'f');
+    append_bytes(&value, sizeof(value));
+}
+
+void BamAuxBuilder::append_string(const char tag[2], std::string_view value) {
+    append_header(tag, 'Z');
+    append_bytes(value.data(), value.size());
+    m_data.push_back(0);
+}
+
+void BamAuxBuilder::append_byte_array(const char tag[2],
+                                      char subtype,
+                                      const void* values,
+                                      size_t count) {
+    if (count > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Too many elements for BAM array tag");
+    }
+    append_header(tag, 'B');
+    m_data.push_back(uint8_t(subtype));
+    const auto num_elements = static_cast<uint32_t>(count);
+    append_bytes(&num_elements, sizeof(num_elements));
+    append_bytes(values, count);
+}
+
+void BamAuxBuilder::append_array(const char tag[2], const int8_t* values, size_t count) {
+    append_byte_array(tag, 'c', values, count);
+}
+
+void BamAuxBuilder::append_array(const char tag[2], const uint8_t* values, size_t count) {
+    append_byte_array(tag, 'C', values, count);
+}
+
+void BamAuxBuilder::write_to(bam1_t* record) const {
+    const size_t required = size_t(record->l_data) + m_data.size();
+    if (required > size_t(std::numeric_limits<int>::max())) {
+        throw std::runtime_error("BAM record too large for its aux tags");
+    }
+    if (required > record->m_data && sam_realloc_bam_data(record, required) < 0) {
+        throw std::runtime_error("Failed to allocate BAM record aux tags");
+    }
+    if (!m_data.empty()) {
+        std::memcpy(record->data + record->l_data, m_data.data(), m_data.size());
+    }
+    record->l_data = int(required);
+}
+
+}  // namespace dorado::utils
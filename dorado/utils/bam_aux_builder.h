@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+struct bam1_t;
+
+namespace dorado::utils {
+
+// Serialises BAM aux tags into a single buffer, in the same layout that bam_aux_append() and
+// bam_aux_update_array() would write them, so that a record can be created with exactly enough
+// room for all of its tags rather than growing it once per tag.
+// The buffer keeps its capacity when cleared, so a reused builder doesn't allocate per record.
+class BamAuxBuilder {
+public:
+    void clear() { m_data.clear(); }
+
+    void append_int(const char tag[2], int32_t value);
+    void append_float(const char tag[2], float value);
+    // Written as a NUL terminated 'Z' tag.
+    void append_string(const char tag[2], std::string_view value);
+    // Written as a 'B' tag with an element type of 'c' or 'C' respectively.
+    void append_array(const char tag[2], const int8_t* values, size_t count);
+    void append_array(const char tag[2], const uint8_t* values, size_t count);
+
+    const uint8_t* data() const { return m_data.data(); }
+    size_t size() const { return m_data.size(); }
+
+    // Copies the tags onto the end of |record|'s data. The space should already have been
+    // reserved by passing size() as the l_aux argument of bam_set1(), otherwise the record's
+    // data is reallocated. Throws if the record can't be grown.
+    void write_to(bam1_t* record) const;
+
+private:
+    void append_header(const char tag[2], char type);
+    void append_bytes(const void* bytes, size_t count);
+    void append_byte_array(const char tag[2], char subtype, const void* values, size_t count);
+
+    std::vector<uint8_t> m_data;
+};
+
+}  // namespace dorado::utils
@@ -4,13 +4,17 @@
 #include "barcode_kits.h"
 #include "sequence_utils.h"
 
+#include <htslib/hts_endian.h>
 #include <htslib/sam.h>
 
 #include <algorithm>
+#include <array>
 #include <cctype>
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 
@@ -24,6 +28,37 @@ namespace dorado::utils {
 
 namespace {
 
+// Complement of each 4 bit encoded base, which is the base with its bits reversed.
+constexpr std::array<uint8_t, 16> NT16_COMPLEMENT{0, 8, 4, 12, 2, 10, 6, 14,
+                                                  1, 9, 5, 13, 3, 11, 7, 15};
+
+// Reverse complement the 4 bit encoded sequence in a bam1_t structure in place.
+void reverse_complement_nt16(uint8_t* bseq, int slen) {
+    for (int i = 0, j = slen - 1; i <= j; ++i, --j) {
+        const uint8_t base_i = bam_seqi(bseq, i);
+        const uint8_t base_j = bam_seqi(bseq, j);
+        bam_set_seqi(bseq, i, NT16_COMPLEMENT[base_j]);
+        bam_set_seqi(bseq, j, NT16_COMPLEMENT[base_i]);
+    }
+}
+
+int aux_array_element_size(uint8_t type) {
+    switch (type) {
+    case 'c':
+    case 'C':
+        return 1;
+    case 's':
+    case 'S':
+        return 2;
+    case 'i':
+    case 'I':
+    case 'f':
+        return 4;
+    default:
+        throw std::runtime_error("Unknown BAM aux array type " + std::string(1, char(type)));
+    }
+}
+
 // Convert the 4bit encoded sequence in a bam1_t structure
 // into a string.
 std::string convert_nt16_to_str(uint8_t* bseq, size_t slen) {
@@ -191,10 +226,10 @@ std::map<std::string, std::string> get_read_group_info(sam_hdr_t* header, const
     return read_group_info;
 }
 
-AlignmentOps get_alignment_op_counts(bam1_t* record) {
+AlignmentOps get_alignment_op_counts(const bam1_t* record) {
     AlignmentOps counts = {};
 
-    uint32_t* cigar = bam_get_cigar(record);
+    const uint32_t* cigar = bam_get_cigar(record);
     int n_cigar = record->core.n_cigar;
 
     if (bam_cigar_op(cigar[0]) == BAM_CSOFT_CLIP) {
@@ -224,12 +259,12 @@ AlignmentOps get_alignment_op_counts(bam1_t* record) {
         }
     }
 
-    uint8_t* md_ptr = bam_aux_get(record, "MD");
+    const uint8_t* md_ptr = bam_aux_get(record, "MD");
 
     if (md_ptr) {
         int i = 0;
         int md_length = 0;
-        char* md = bam_aux2Z(md_ptr);
+        const char* md = bam_aux2Z(md_ptr);
 
         while (md[i]) {
             if (std::isdigit(md[i])) {
@@ -501,14 +536,14 @@ BamPtr new_unmapped_record(bam1_t* input_record, std::string seq, std::vector<ui
 void remove_alignment_tags_from_record(bam1_t* record) {
     // Iterate through all tags and check against known set
     // of tags to remove.
-    static const std::set<std::string> tags_to_remove = {"SA", "NM", "ms", "AS", "nn", "de",
-                                                         "dv", "tp", "cm", "s1", "s2", "MD",
-                                                         "zd", "rl", "bh", "cs", "TS"};
+    static const std::set<std::string_view> tags_to_remove = {
+            "SA", "NM", "ms", "AS", "nn", "de", "dv", "tp", "cm",
+            "s1", "s2", "MD", "zd", "rl", "bh", "cs", "TS"};
 
     uint8_t* aux_ptr = bam_aux_first(record);
     while (aux_ptr != NULL) {
         auto tag_ptr = bam_aux_tag(aux_ptr);
-        std::string tag = std::string(tag_ptr, tag_ptr + 2);
+        const std::string_view tag(tag_ptr, 2);
         if (tags_to_remove.find(tag) != tags_to_remove.end()) {
             aux_ptr = bam_aux_remove(record, aux_ptr);
         } else {
@@ -517,4 +552,95 @@ void remove_alignment_tags_from_record(bam1_t* record) {
     }
 }
 
+void make_record_unmapped(bam1_t* record) {
+    auto& core = record->core;
+
+    // Drop the CIGAR by shifting everything after it down.
+    if (core.n_cigar > 0) {
+        auto cigar = reinterpret_cast<uint8_t*>(bam_get_cigar(record));
+        const int cigar_size = int(core.n_cigar * sizeof(uint32_t));
+        std::memmove(cigar, cigar + cigar_size, record->l_data - core.l_qname - cigar_size);
+        record->l_data -= cigar_size;
+        core.n_cigar = 0;
+    }
+
+    if (bam_is_rev(record)) {
+        reverse_complement_nt16(bam_get_seq(record), core.l_qseq);
+        auto qual = bam_get_qual(record);
+        std::reverse(qual, qual + core.l_qseq);
+    }
+
+    // Same as bam_set1 gives an unmapped record.
+    core.flag = BAM_FUNMAP;
+    core.tid = -1;
+    core.pos = -1;
+    core.bin = uint16_t(hts_reg2bin(-1, 0, 14, 5));
+    core.qual = 0;
+    core.mtid = -1;
+    core.mpos = -1;
+    core.isize = 0;
+
+    remove_alignment_tags_from_record(record);
+}
+
+void trim_record_sequence(bam1_t* record, const std::pair<int, int>& trim_interval) {
+    auto& core = record->core;
+    const auto [start, end] = trim_interval;
+    if (start < 0 || start >= core.l_qseq || end > core.l_qseq || end < start) {
+        throw std::invalid_argument("Trim interval " + std::to_string(start) + "-" +
+                                    std::to_string(end) + " is invalid for sequence of length " +
+                                    std::to_string(core.l_qseq));
+    }
+
+    const int old_len = core.l_qseq;
+    const int new_len = end - start;
+    const int new_seq_size = (new_len + 1) / 2;
+    uint8_t* seq = bam_get_seq(record);
+    const uint8_t* qual = bam_get_qual(record);
+    const uint8_t* aux = bam_get_aux(record);
+    const int aux_size = int(bam_get_l_aux(record));
+
+    // Each byte holds two bases, so the kept bases are either whole bytes, or straddle them.
+    const uint8_t* kept_seq = seq + start / 2;
+    if (start % 2 == 0) {
+        std::memmove(seq, kept_seq, new_seq_size);
+        if (new_len % 2 != 0) {
+            // Clear the padding base.
+            seq[new_seq_size - 1] &= 0xf0;
+        }
+    } else {
+        for (int i = 0; i < new_seq_size; ++i) {
+            const bool has_next_base = start + 2 * i + 1 < end;
+            seq[i] = uint8_t((kept_seq[i] << 4) | (has_next_base ? kept_seq[i + 1] >> 4 : 0));
+        }
+    }
+
+    uint8_t* new_qual = seq + new_seq_size;
+    std::memmove(new_qual, qual + start, new_len);
+    std::memmove(new_qual + new_len, aux, aux_size);
+
+    record->l_data -= ((old_len + 1) / 2 - new_seq_size) + (old_len - new_len);
+    core.l_qseq = new_len;
+}
+
+void remove_aux_array_elements(bam1_t* record, uint8_t* aux, uint32_t first, uint32_t count) {
+    const uint32_t len = bam_auxB_len(aux);
+    if (first > len || count > len - first) {
+        throw std::out_of_range("Cannot remove elements " + std::to_string(first) + "-" +
+                                std::to_string(first + count) + " from aux array of length " +
+                                std::to_string(len));
+    }
+    if (count == 0) {
+        return;
+    }
+
+    // The array is stored as 'B', the element type, the element count, then the elements.
+    const int element_size = aux_array_element_size(aux[1]);
+    uint8_t* removed_begin = aux + 6 + first * element_size;
+    uint8_t* removed_end = removed_begin + count * element_size;
+    std::memmove(removed_begin, removed_end, record->data + record->l_data - removed_end);
+    record->l_data -= int(count * element_size);
+    u32_to_le(len - count, aux + 2);
+}
+
 }  // namespace dorado::utils
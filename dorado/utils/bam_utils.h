@@ -86,7 +86,7 @@ std::map<std::string, std::string> get_read_group_info(sam_hdr_t* header, const
  * @param record Pointer to a bam1_t structure representing a BAM record.
  * @return AlignmentOps structure containing counts of soft clipping, matches, insertions, deletions, and substitutions in the alignment.
  */
-AlignmentOps get_alignment_op_counts(bam1_t* record);
+AlignmentOps get_alignment_op_counts(const bam1_t* record);
 
 /**
  * Extract keys for PG header from BAM header.
@@ -217,4 +217,36 @@ BamPtr new_unmapped_record(bam1_t* record, std::string seq, std::vector<uint8_t>
  */
 void remove_alignment_tags_from_record(bam1_t* record);
 
+/*
+ * Strip any alignment data from a BAM record in place.
+ *
+ * @param record BAM record.
+ *
+ * The record ends up the same as new_unmapped_record(record, {}, {}) would be: the CIGAR and
+ * alignment tags are removed, and a reverse strand record is reverse complemented back to the
+ * original read orientation. No memory is allocated.
+ */
+void make_record_unmapped(bam1_t* record);
+
+/*
+ * Trim the sequence and qualities of a BAM record in place.
+ *
+ * @param record Unmapped BAM record.
+ * @param trim_interval Interval of the sequence to keep.
+ *
+ * The packed sequence, qualities and aux data are shifted down within the record's data, so
+ * nothing is decoded or allocated. Aux tags which depend on the sequence aren't updated.
+ */
+void trim_record_sequence(bam1_t* record, const std::pair<int, int>& trim_interval);
+
+/*
+ * Remove a range of elements from a B-type array aux tag in place.
+ *
+ * @param record BAM record.
+ * @param aux Array tag, as returned by bam_aux_get.
+ * @param first Index of the first element to remove.
+ * @param count Number of elements to remove.
+ */
+void remove_aux_array_elements(bam1_t* record, uint8_t* aux, uint32_t first, uint32_t count);
+
 }  // namespace dorado::utils
@@ -0,0 +1,66 @@
+#include "chunked_line_reader.h"
+
+#include <cstring>
+#include <string>
+
+namespace dorado::utils {
+
+ChunkedLineReader::ChunkedLineReader(std::istream& input_stream, std::size_t chunk_size)
+        : m_input_stream(input_stream), m_chunk_size(chunk_size) {}
+
+bool ChunkedLineReader::read_chunk() {
+    if (!m_input_stream.good()) {
+        return false;
+    }
+    // Move any partial line to the front, so that the buffer only grows for long lines.
+    if (m_begin > 0) {
+        std::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+        m_end -= m_begin;
+        m_begin = 0;
+    }
+    if (m_buffer.size() < m_end + m_chunk_size) {
+        m_buffer.resize(m_end + m_chunk_size);
+    }
+    m_input_stream.read(m_buffer.data() + m_end, static_cast<std::streamsize>(m_chunk_size));
+    const auto num_read = static_cast<std::size_t>(m_input_stream.gcount());
+    m_end += num_read;
+    return num_read > 0;
+}
+
+bool ChunkedLineReader::get_non_empty_line(std::string_view& line) {
+    std::size_t searched = m_begin;
+    for (;;) {
+        const auto* newline =
+                searched < m_end ? static_cast<const char*>(std::memchr(
+                                           m_buffer.data() + searched, '\n', m_end - searched))
+                                 : nullptr;
+        if (newline) {
+            const auto line_end = static_cast<std::size_t>(newline - m_buffer.data());
+            line = std::string_view(m_buffer.data() + m_begin, line_end - m_begin);
+            m_begin = line_end + 1;
+            return !line.empty();
+        }
+        // Reading the next chunk can move the data, so keep track of the position by offset.
+        searched = m_end - m_begin;
+        if (!read_chunk()) {
+            break;
+        }
+        searched += m_begin;
+    }
+    // The last line doesn't need to end with a newline.
+    if (m_begin == m_end) {
+        return false;
+    }
+    line = std::string_view(m_buffer.data() + m_begin, m_end - m_begin);
+    m_begin = m_end;
+    return true;
+}
+
+int ChunkedLineReader::peek() {
+    if (at_end()) {
+        return std::char_traits<char>::eof();
+    }
+    return std::char_traits<char>::to_int_type(m_buffer[m_begin]);
+}
+
+}  // namespace dorado::utils
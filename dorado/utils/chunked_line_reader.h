@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <string_view>
+#include <vector>
+
+namespace dorado::utils {
+
+// Splits a stream into lines, reading it a chunk at a time and using memchr to find the line
+// ends rather than extracting a character at a time as std::getline does.
+class ChunkedLineReader {
+public:
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+    explicit ChunkedLineReader(std::istream& input_stream,
+                               std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    // Gets the next line, without its newline. Returns false at the end of the input or if the
+    // line is empty. The line is only valid until the next call to the reader.
+    bool get_non_empty_line(std::string_view& line);
+
+    // Returns the next character without consuming it, or EOF at the end of the input.
+    int peek();
+
+    bool at_end() { return m_begin == m_end && !read_chunk(); }
+
+private:
+    // Reads the next chunk into the buffer after any unconsumed data, returning false if there
+    // was nothing left to read.
+    bool read_chunk();
+
+    std::istream& m_input_stream;
+    std::vector<char> m_buffer;
+    std::size_t m_chunk_size;
+    std::size_t m_begin{0};
+    std::size_t m_end{0};
+};
+
+}  // namespace dorado::utils
@@ -10,15 +10,6 @@ AsyncTaskExecutor::AsyncTaskExecutor(MultiQueueThreadPool& thread_pool,
 
 AsyncTaskExecutor::~AsyncTaskExecutor() { flush(); }
 
-void AsyncTaskExecutor::send_impl(TaskType task) {
-    increment_tasks_in_flight();
-
-    m_thread_pool_queue.push([task_ = std::move(task), this] {
-        task_();
-        decrement_tasks_in_flight();
-    });
-}
-
 std::unique_ptr<std::thread> AsyncTaskExecutor::send_async(TaskType task) {
     increment_tasks_in_flight();
 
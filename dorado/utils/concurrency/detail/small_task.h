@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace dorado::utils::concurrency::detail {
+
+// Move-only type erased void() callable, used in place of std::function for thread pool tasks.
+// Callables of up to INLINE_SIZE bytes which can be moved without throwing are stored inline,
+// so wrapping a task doesn't allocate unless it captures a lot of state, while std::function
+// allocates for anything bigger than a couple of pointers. Callables needn't be copyable.
+class SmallTask {
+public:
+    static constexpr std::size_t INLINE_SIZE = 96;
+
+    SmallTask() = default;
+    SmallTask(std::nullptr_t) {}
+
+    template <typename Fn,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<Fn>, SmallTask> &&
+                                          std::is_invocable_v<std::decay_t<Fn>&>>>
+    SmallTask(Fn&& fn) {
+        using Callable = std::decay_t<Fn>;
+        if constexpr (fits_inline<Callable>()) {
+            new (m_storage) Callable(std::forward<Fn>(fn));
+            m_ops = &INLINE_OPS<Callable>;
+        } else {
+            new (m_storage) Callable*(new Callable(std::forward<Fn>(fn)));
+            m_ops = &HEAP_OPS<Callable>;
+        }
+    }
+
+    SmallTask(SmallTask&& other) noexcept { take(other); }
+
+    SmallTask& operator=(SmallTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    SmallTask(const SmallTask&) = delete;
+    SmallTask& operator=(const SmallTask&) = delete;
+
+    ~SmallTask() { reset(); }
+
+    // Const like std::function::operator(), so that mutable callables can be invoked through
+    // a const task.
+    void operator()() const {
+        if (!m_ops) {
+            throw std::bad_function_call();
+        }
+        m_ops->invoke(m_storage);
+    }
+
+    explicit operator bool() const { return m_ops != nullptr; }
+
+    // True if the callable is held in the inline buffer rather than on the heap.
+    bool is_inline() const { return m_ops && m_ops->is_inline; }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        // Moves the callable from src to the uninitialised dst, and destroys what's left in src.
+        void (*relocate)(void* dst, void* src);
+        void (*destroy)(void* storage);
+        bool is_inline;
+    };
+
+    template <typename Callable>
+    static constexpr bool fits_inline() {
+        return sizeof(Callable) <= INLINE_SIZE && alignof(Callable) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Callable>;
+    }
+
+    template <typename Callable>
+    static Callable* inline_callable(void* storage) {
+        return std::launder(reinterpret_cast<Callable*>(storage));
+    }
+
+    template <typename Callable>
+    static Callable*& heap_callable(void* storage) {
+        return *std::launder(reinterpret_cast<Callable**>(storage));
+    }
+
+    template <typename Callable>
+    static void invoke_inline(void* storage) {
+        (*inline_callable<Callable>(storage))();
+    }
+
+    template <typename Callable>
+    static void relocate_inline(void* dst, void* src) {
+        Callable* callable = inline_callable<Callable>(src);
+        new (dst) Callable(std::move(*callable));
+        callable->~Callable();
+    }
+
+    template <typename Callable>
+    static void destroy_inline(void* storage) {
+        inline_callable<Callable>(storage)->~Callable();
+    }
+
+    template <typename Callable>
+    static void invoke_heap(void* storage) {
+        (*heap_callable<Callable>(storage))();
+    }
+
+    template <typename Callable>
+    static void relocate_heap(void* dst, void* src) {
+        new (dst) Callable*(heap_callable<Callable>(src));
+    }
+
+    template <typename Callable>
+    static void destroy_heap(void* storage) {
+        delete heap_callable<Callable>(storage);
+    }
+
+    template <typename Callable>
+    static constexpr Ops INLINE_OPS{&invoke_inline<Callable>, &relocate_inline<Callable>,
+                                    &destroy_inline<Callable>, true};
+
+    template <typename Callable>
+    static constexpr Ops HEAP_OPS{&invoke_heap<Callable>, &relocate_heap<Callable>,
+                                  &destroy_heap<Callable>, false};
+
+    void take(SmallTask& other) noexcept {
+        if (other.m_ops) {
+            other.m_ops->relocate(m_storage, other.m_storage);
+            m_ops = other.m_ops;
+            other.m_ops = nullptr;
+        }
+    }
+
+    void reset() noexcept {
+        if (m_ops) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+    const Ops* m_ops{nullptr};
+    // Mutable so that the callable can be invoked from the const operator().
+    alignas(std::max_align_t) mutable unsigned char m_storage[INLINE_SIZE];
+};
+
+using TaskType = SmallTask;
+
+}  // namespace dorado::utils::concurrency::detail
@@ -6,6 +6,24 @@
 
 namespace dorado::utils::concurrency {
 
+namespace {
+
+constexpr std::uint64_t HIGH_PRIO_SHIFT = 32;
+constexpr std::uint64_t NORMAL_PRIO_MASK = (std::uint64_t(1) << HIGH_PRIO_SHIFT) - 1;
+
+// Order in which workers look for tasks.
+constexpr std::array<TaskPriority, 2> PRIORITY_ORDER{TaskPriority::high, TaskPriority::normal};
+
+std::size_t priority_index(TaskPriority priority) {
+    return priority == TaskPriority::high ? 1 : 0;
+}
+
+std::uint64_t in_flight_increment(TaskPriority priority) {
+    return priority == TaskPriority::high ? (std::uint64_t(1) << HIGH_PRIO_SHIFT) : 1;
+}
+
+}  // namespace
+
 MultiQueueThreadPool::MultiQueueThreadPool(std::size_t num_threads)
         : m_num_threads{num_threads},
           m_num_expansion_low_prio_threads(std::max(static_cast<std::size_t>(1),
@@ -22,137 +40,222 @@ MultiQueueThreadPool::MultiQueueThreadPool(std::size_t num_threads, std::string
 }
 
 void MultiQueueThreadPool::initialise() {
-    // Total number of threads are m_num_threads + expansion space for the
-    // same number of high prio tasks, in case all threads are busy with a
-    //// normal prio task when a high prio task arrives.
-    for (std::size_t i{0}; i < m_num_threads * 2; ++i) {
-        m_threads.emplace_back([this] { process_task_queue(); });
+    // There are only deques for the N core threads. The expansion threads, for when all of
+    // them are busy, take tasks from those.
+    for (std::size_t i{0}; i < std::max(m_num_threads, static_cast<std::size_t>(1)); ++i) {
+        m_workers.emplace_back(std::make_unique<Worker>());
+    }
+    for (std::size_t i{0}; i < m_num_threads; ++i) {
+        start_worker_thread();
     }
 }
 
 MultiQueueThreadPool::~MultiQueueThreadPool() { join(); }
 
 void MultiQueueThreadPool::join() {
-    // post as many done messages as there are threads to make sure all waiting threads will receive a wakeup
-    detail::PriorityTaskQueue::TaskQueue* terminate_task_queue;
+    std::vector<std::thread> threads;
     {
-        std::lock_guard lock(m_mutex);
-        terminate_task_queue = &m_priority_task_queue.create_task_queue(TaskPriority::normal);
-    }
-    for (uint32_t thread_index{0}; thread_index < m_num_threads * 2; ++thread_index) {
-        {
-            std::lock_guard lock(m_mutex);
-            terminate_task_queue->push([this] { m_done.store(true, std::memory_order_relaxed); });
-        }
-        m_message_received.notify_one();
+        std::lock_guard lock(m_threads_mutex);
+        m_done.store(true);
+        threads = std::move(m_threads);
     }
-    for (auto& worker : m_threads) {
+    // Taking the mutex ensures workers about to sleep see the flag.
+    { std::lock_guard lock(m_sleep_mutex); }
+    m_task_available.notify_all();
+
+    // Workers only exit once there are no tasks left which they could run.
+    for (auto& worker : threads) {
         if (worker.joinable()) {
             worker.join();
         }
     }
 }
 
-void MultiQueueThreadPool::send(TaskType task, detail::PriorityTaskQueue::TaskQueue& task_queue) {
-    {
-        std::lock_guard lock(m_mutex);
-        task_queue.push(std::move(task));
+void MultiQueueThreadPool::start_worker_thread() {
+    std::lock_guard lock(m_threads_mutex);
+    if (m_done.load() || m_threads.size() >= 2 * m_num_threads) {
+        return;
     }
-    m_message_received.notify_one();
+    const std::size_t worker_index = m_threads.size();
+    ++m_num_idle;
+    m_threads.emplace_back([this, worker_index] { process_task_queue(worker_index); });
 }
 
-std::size_t MultiQueueThreadPool::num_tasks_in_flight() {
-    return m_normal_prio_tasks_in_flight + m_high_prio_tasks_in_flight;
+void MultiQueueThreadPool::send(TaskType task, TaskPriority priority, std::size_t worker_index) {
+    const std::size_t index = priority_index(priority);
+    Worker& worker = *m_workers[worker_index];
+    {
+        std::lock_guard lock(worker.mutex);
+        auto& tasks = worker.tasks[index];
+        tasks.push_back(std::move(task));
+        worker.num_tasks[index].store(tasks.size(), std::memory_order_release);
+        // Counted under the lock, so that it can't be decremented by a pop first.
+        m_num_queued[index].fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    // Pairs with the increment in process_task_queue: either we see the sleeping worker, or
+    // it sees the new task before it goes to sleep.
+    if (m_num_sleeping.fetch_add(0, std::memory_order_acq_rel) > 0) {
+        wake_one_worker();
+    } else if (m_num_idle.load() == 0 && is_runnable(priority, m_in_flight.load())) {
+        // All of the threads are busy, but the task is allowed to run alongside them.
+        start_worker_thread();
+    }
 }
 
-bool MultiQueueThreadPool::try_pop_next_task(detail::WaitingTask& next_task) {
-    if (m_priority_task_queue.empty()) {
-        return false;
+bool MultiQueueThreadPool::is_runnable(TaskPriority priority, std::uint64_t in_flight) const {
+    const std::uint64_t num_normal = in_flight & NORMAL_PRIO_MASK;
+    const std::uint64_t num_high = in_flight >> HIGH_PRIO_SHIFT;
+    if (num_normal + num_high < m_num_threads) {
+        return true;
+    }
+    if (priority == TaskPriority::high) {
+        return num_high < m_num_threads;
     }
-    if (num_tasks_in_flight() < m_num_threads) {
-        next_task = m_priority_task_queue.pop();
-        if (next_task.priority == TaskPriority::normal) {
-            ++m_normal_prio_tasks_in_flight;
-        } else {
-            ++m_high_prio_tasks_in_flight;
+    return num_normal < m_num_expansion_low_prio_threads;
+}
+
+bool MultiQueueThreadPool::try_start_task(TaskPriority priority) {
+    std::uint64_t in_flight = m_in_flight.load();
+    while (is_runnable(priority, in_flight)) {
+        if (m_in_flight.compare_exchange_weak(in_flight,
+                                              in_flight + in_flight_increment(priority))) {
+            return true;
         }
-        return true;
     }
+    return false;
+}
 
-    if (m_high_prio_tasks_in_flight < m_num_threads &&
-        !m_priority_task_queue.empty(TaskPriority::high)) {
-        next_task = m_priority_task_queue.pop(TaskPriority::high);
-        ++m_high_prio_tasks_in_flight;
-        return true;
+void MultiQueueThreadPool::finish_task(TaskPriority priority) {
+    m_in_flight.fetch_sub(in_flight_increment(priority));
+}
+
+bool MultiQueueThreadPool::try_pop_front(Worker& worker, std::size_t index, TaskType& task) {
+    // A task pushed after this check is still seen, as m_num_queued keeps the worker looking.
+    if (worker.num_tasks[index].load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    std::lock_guard lock(worker.mutex);
+    auto& tasks = worker.tasks[index];
+    if (tasks.empty()) {
+        return false;
     }
+    task = std::move(tasks.front());
+    tasks.pop_front();
+    worker.num_tasks[index].store(tasks.size(), std::memory_order_release);
+    m_num_queued[index].fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
 
-    if (m_normal_prio_tasks_in_flight < m_num_expansion_low_prio_threads &&
-        !m_priority_task_queue.empty(TaskPriority::normal)) {
-        next_task = m_priority_task_queue.pop(TaskPriority::normal);
-        ++m_normal_prio_tasks_in_flight;
+bool MultiQueueThreadPool::try_pop_task(std::size_t worker_index,
+                                        std::size_t& next_victim,
+                                        TaskPriority priority,
+                                        TaskType& task) {
+    const std::size_t index = priority_index(priority);
+    const std::size_t num_workers = m_workers.size();
+    // Core threads run their own tasks first. Expansion threads have no deque of their own.
+    if (worker_index < num_workers && try_pop_front(*m_workers[worker_index], index, task)) {
         return true;
     }
-
+    for (std::size_t i{0}; i < num_workers; ++i) {
+        const std::size_t victim = (next_victim + i) % num_workers;
+        if (victim == worker_index) {
+            continue;
+        }
+        if (try_pop_front(*m_workers[victim], index, task)) {
+            // Start from the following deque next time, so that every deque gets a turn.
+            next_victim = victim + 1;
+            return true;
+        }
+    }
     return false;
 }
 
-void MultiQueueThreadPool::decrement_in_flight_tasks(TaskPriority priority) {
-    if (priority == TaskPriority::normal) {
-        --m_normal_prio_tasks_in_flight;
-    } else {
-        --m_high_prio_tasks_in_flight;
+bool MultiQueueThreadPool::try_get_next_task(std::size_t worker_index,
+                                             std::size_t& next_victim,
+                                             TaskType& task,
+                                             TaskPriority& priority) {
+    for (const auto next_priority : PRIORITY_ORDER) {
+        if (m_num_queued[priority_index(next_priority)].load() == 0 ||
+            !try_start_task(next_priority)) {
+            continue;
+        }
+        if (try_pop_task(worker_index, next_victim, next_priority, task)) {
+            priority = next_priority;
+            return true;
+        }
+        // Another worker took the task first.
+        finish_task(next_priority);
     }
+    return false;
 }
 
-detail::WaitingTask MultiQueueThreadPool::decrement_in_flight_and_wait_on_next_task(
-        std::optional<TaskPriority> last_task_priority) {
-    // Design flaw: doing both decrement and wait, an SRP violation - weak cohesion, because we don't
-    // want to unlock between the decrement and the wait, and it is a lesser "evil" than the
-    // alternative design flaw of passing a lock between functions, high coupling, as threading is
-    // easier to reason about if the locking is encapsulated.
-    std::unique_lock lock(m_mutex);
-    if (last_task_priority) {
-        decrement_in_flight_tasks(*last_task_priority);
-    }
-    detail::WaitingTask next_task{};
-    m_message_received.wait(lock, [this, &next_task] { return try_pop_next_task(next_task); });
-    return next_task;
+bool MultiQueueThreadPool::has_runnable_task() const {
+    const std::uint64_t in_flight = m_in_flight.load();
+    return std::any_of(PRIORITY_ORDER.begin(), PRIORITY_ORDER.end(),
+                       [this, in_flight](TaskPriority priority) {
+                           return m_num_queued[priority_index(priority)].load() > 0 &&
+                                  is_runnable(priority, in_flight);
+                       });
 }
 
-void MultiQueueThreadPool::process_task_queue() {
+void MultiQueueThreadPool::wake_one_worker() {
+    // Taking the mutex ensures a worker about to sleep either sees the new state, or is
+    // already waiting.
+    { std::lock_guard lock(m_sleep_mutex); }
+    m_task_available.notify_one();
+}
+
+void MultiQueueThreadPool::process_task_queue(std::size_t worker_index) {
     set_thread_name(m_name);
-    detail::WaitingTask waiting_task{};
-    std::optional<TaskPriority> last_task_priority{std::nullopt};
-    while (!m_done.load(std::memory_order_relaxed)) {
-        waiting_task = decrement_in_flight_and_wait_on_next_task(last_task_priority);
-        last_task_priority = waiting_task.priority;
-        waiting_task.task();
-    }
-    if (last_task_priority) {
-        std::lock_guard lock(m_mutex);
-        decrement_in_flight_tasks(*last_task_priority);
-        // Signal so that the condition variable will be checked by waiting threads
-        // This is necessary since it is possible join() was called before all the threads
-        // in the thread pool had begun waiting on the condition variable, in which case
-        // the notify_one() calls in the joining code would have had no effect.
-        m_message_received.notify_one();
+    TaskType task{};
+    TaskPriority priority{TaskPriority::normal};
+    std::size_t next_victim = worker_index + 1;
+    while (true) {
+        if (try_get_next_task(worker_index, next_victim, task, priority)) {
+            --m_num_idle;
+            // Hand on any further tasks to a sleeping worker, so they run in parallel.
+            if (m_num_sleeping.load(std::memory_order_relaxed) > 0 && has_runnable_task()) {
+                wake_one_worker();
+            }
+            task();
+            // Release whatever the task holds before it's counted as finished.
+            task = nullptr;
+            finish_task(priority);
+            ++m_num_idle;
+            continue;
+        }
+
+        if (m_done.load()) {
+            break;
+        }
+
+        m_num_sleeping.fetch_add(1, std::memory_order_acq_rel);
+        {
+            std::unique_lock lock(m_sleep_mutex);
+            m_task_available.wait(lock, [this] { return m_done.load() || has_runnable_task(); });
+        }
+        m_num_sleeping.fetch_sub(1, std::memory_order_acq_rel);
     }
 }
 
-MultiQueueThreadPool::ThreadPoolQueue::ThreadPoolQueue(
-        MultiQueueThreadPool* parent,
-        detail::PriorityTaskQueue::TaskQueue& task_queue)
-        : m_parent(parent), m_task_queue(task_queue) {}
+MultiQueueThreadPool::ThreadPoolQueue::ThreadPoolQueue(MultiQueueThreadPool* parent,
+                                                       TaskPriority priority,
+                                                       std::size_t first_worker)
+        : m_parent(parent), m_priority(priority), m_next_worker(first_worker) {}
 
 void MultiQueueThreadPool::ThreadPoolQueue::push(TaskType task) {
-    m_parent->send(std::move(task), m_task_queue);
+    const std::size_t worker_index =
+            m_next_worker.fetch_add(1, std::memory_order_relaxed) % m_parent->m_workers.size();
+    m_parent->send(std::move(task), m_priority, worker_index);
 }
 
 MultiQueueThreadPool::ThreadPoolQueue& MultiQueueThreadPool::create_task_queue(
         TaskPriority priority) {
-    std::lock_guard lock(m_mutex);
-    auto& task_queue = m_priority_task_queue.create_task_queue(priority);
-    return *m_queues.emplace_back(new ThreadPoolQueue(this, task_queue));
+    std::lock_guard lock(m_queues_mutex);
+    // Start each queue on a different deque, so that queues with few tasks don't all use the first.
+    const std::size_t first_worker = m_queues.size() % m_workers.size();
+    return *m_queues.emplace_back(new ThreadPoolQueue(this, priority, first_worker));
 }
 
 }  // namespace dorado::utils::concurrency
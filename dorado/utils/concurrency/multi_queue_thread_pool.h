@@ -1,14 +1,16 @@
 #pragma once
 
-#include "detail/priority_task_queue.h"
+#include "detail/small_task.h"
 #include "synchronisation.h"
 #include "task_priority.h"
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <mutex>
-#include <optional>
 #include <string>
 #include <thread>
 #include <vector>
@@ -17,20 +19,29 @@ namespace dorado::utils::concurrency {
 
 using TaskType = detail::TaskType;
 
-// Thread pool which pops tasks from multiple queues. Each queue is processed FIFO
-// however the queues are popped from in a cyclic fashion so that a new queue will not
-// be waiting behind an existing queue having all it's tasks popped.
-// Suitable for usecases where a producer thread should not be allowed to
-// enqueue a large amount of tasks ahead of a second producer thread
-// beginning to enqueue tasks.
+// Work-stealing thread pool which tasks are pushed to through queues created for each
+// producer, which set the priority of their tasks.
+// Each core worker thread has its own deque of tasks per priority, guarded by its own mutex.
+// Each queue deals its tasks out to the deques in turn, so even the tasks of a single queue are
+// spread over the workers rather than all going through one lock. A worker runs the tasks in
+// its own deque, and once that is empty it steals from the other deques. Deques are always
+// popped from the front, so tasks start roughly in the order they were pushed, but neither the
+// order of a queue's tasks nor fairness between queues is guaranteed: each producer's backlog
+// is bounded by its AsyncTaskExecutor instead. Empty deques are skipped without taking their
+// mutex. Idle workers sleep, and are only signalled if there are sleeping workers.
+// Tasks are held in a SmallTask, which doesn't allocate for tasks which capture little state.
 //
-// N.B. If the pool is initialised with N threads then the actual number of
-// threads managed by the pool will be 2*N, allowing the pool to expand under
-// certain circumstances.
+// When tasks of both priorities are allowed to start, high priority tasks are started first.
+// While fewer than N tasks are running a task starts as soon as it's pushed, so this only
+// decides the order of tasks which are left waiting together.
+//
+// N.B. If the pool is initialised with N threads then the pool is allowed to expand up to
+// 2*N threads under certain circumstances.
 //
 // This is to support the usecase where N threads are under full load running
 // normal priority tasks and then high priority tasks start to be received.
 // Instead of blocking these high prio tasks the pool is allowed to expand up to 2*N.
+// The expansion threads are only started once they are needed, and are kept from then on.
 //
 // There is a similar behaviour for normal tasks but only N/4 expansion threads are
 // allowed, this is to ensure normal pipelines aren't "frozen" while high prioity
@@ -41,6 +52,7 @@ public:
     MultiQueueThreadPool(std::size_t num_threads, std::string name);
     ~MultiQueueThreadPool();
 
+    // Waits for all the pushed tasks to be run, and stops the threads.
     void join();
 
     class ThreadPoolQueue;
@@ -50,10 +62,13 @@ public:
         friend class MultiQueueThreadPool;
 
         MultiQueueThreadPool* m_parent;
-        detail::PriorityTaskQueue::TaskQueue& m_task_queue;
+        TaskPriority m_priority;
+        // Counts the pushed tasks, to pick the worker deque which the next one goes to.
+        std::atomic<std::size_t> m_next_worker;
 
         ThreadPoolQueue(MultiQueueThreadPool* parent,
-                        detail::PriorityTaskQueue::TaskQueue& task_queue);
+                        TaskPriority priority,
+                        std::size_t first_worker);
 
         ThreadPoolQueue(const ThreadPoolQueue&) = delete;
         ThreadPoolQueue& operator=(const ThreadPoolQueue&) = delete;
@@ -63,28 +78,59 @@ public:
     };
 
 private:
-    void send(TaskType task, detail::PriorityTaskQueue::TaskQueue& task_queue);
+    static constexpr std::size_t NUM_PRIORITIES = 2;
+
+    struct Worker {
+        std::mutex mutex;
+        // Queued tasks, indexed by priority.
+        std::array<std::deque<TaskType>, NUM_PRIORITIES> tasks;
+        // Sizes of the deques, so that they can be checked without taking the mutex.
+        std::array<std::atomic<std::size_t>, NUM_PRIORITIES> num_tasks{};
+    };
+
+    void initialise();
+    void send(TaskType task, TaskPriority priority, std::size_t worker_index);
+
+    bool is_runnable(TaskPriority priority, std::uint64_t in_flight) const;
+    bool try_start_task(TaskPriority priority);
+    void finish_task(TaskPriority priority);
+    bool try_pop_front(Worker& worker, std::size_t index, TaskType& task);
+    bool try_pop_task(std::size_t worker_index,
+                      std::size_t& next_victim,
+                      TaskPriority priority,
+                      TaskType& task);
+    bool try_get_next_task(std::size_t worker_index,
+                           std::size_t& next_victim,
+                           TaskType& task,
+                           TaskPriority& priority);
+    bool has_runnable_task() const;
+    void wake_one_worker();
+    void start_worker_thread();
+    void process_task_queue(std::size_t worker_index);
 
     std::string m_name{"async_task_exec"};
     const std::size_t m_num_threads;
     const std::size_t m_num_expansion_low_prio_threads;
+
+    // One per core thread. Expansion threads only steal.
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::array<std::atomic<std::size_t>, NUM_PRIORITIES> m_num_queued{};
+    // Number of normal priority tasks in flight in the low 32 bits, and of high priority tasks
+    // in the high 32 bits, so that both can be checked and updated together.
+    std::atomic<std::uint64_t> m_in_flight{0};
+    // Number of started threads which aren't running a task.
+    std::atomic<std::size_t> m_num_idle{0};
+
+    std::mutex m_threads_mutex;
     std::vector<std::thread> m_threads;
-    std::atomic_bool m_done{false};  // Note that this flag is only accessed by the managed threads.
+    std::atomic_bool m_done{false};
 
-    std::mutex m_mutex;
-    std::vector<std::unique_ptr<ThreadPoolQueue>> m_queues;
-    detail::PriorityTaskQueue m_priority_task_queue;
-    std::condition_variable m_message_received;
-    std::size_t m_normal_prio_tasks_in_flight{};
-    std::size_t m_high_prio_tasks_in_flight{};
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_task_available;
+    std::atomic<std::size_t> m_num_sleeping{0};
 
-    void decrement_in_flight_tasks(TaskPriority priority);
-    void initialise();
-    detail::WaitingTask decrement_in_flight_and_wait_on_next_task(
-            std::optional<TaskPriority> last_task_priority);
-    void process_task_queue();
-    bool try_pop_next_task(detail::WaitingTask& next_task);
-    std::size_t num_tasks_in_flight();
+    std::mutex m_queues_mutex;
+    std::vector<std::unique_ptr<ThreadPoolQueue>> m_queues;
 };
 
 }  // namespace dorado::utils::concurrency
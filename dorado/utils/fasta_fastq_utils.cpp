@@ -3,9 +3,14 @@
 namespace dorado::utils {
 
 bool validate_sequence_and_replace_us(std::string& field) {
+    return validate_sequence_and_replace_us(field, 0);
+}
+
+bool validate_sequence_and_replace_us(std::string& field, std::size_t start) {
     bool contains_t{};
     bool contains_u{};
-    for (auto& element : field) {
+    for (auto element_it = field.begin() + start; element_it != field.end(); ++element_it) {
+        auto& element = *element_it;
         switch (element) {
         case 'A':
         case 'C':
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "chunked_line_reader.h"
+
+#include <cstddef>
 #include <istream>
 #include <sstream>
 #include <string>
@@ -8,6 +11,8 @@
 namespace dorado::utils {
 
 bool validate_sequence_and_replace_us(std::string& field);
+// Validates the characters of |field| from |start| onwards.
+bool validate_sequence_and_replace_us(std::string& field, std::size_t start);
 
 bool get_non_empty_line(std::istream& input_stream, std::string& line);
 
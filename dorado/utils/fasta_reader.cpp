@@ -7,6 +7,7 @@
 #include <fstream>
 #include <limits>
 #include <sstream>
+#include <string_view>
 
 namespace dorado::utils {
 
@@ -28,6 +29,23 @@ bool get_wrapped_sequence_line(std::istream& input_stream, std::string& wrapped_
     return !wrapped_line.empty();
 }
 
+bool get_wrapped_sequence_line(ChunkedLineReader& line_reader, std::string& wrapped_line) {
+    wrapped_line.clear();
+    std::string_view line;
+    while (line_reader.peek() != '>') {
+        if (!line_reader.get_non_empty_line(line)) {
+            break;
+        }
+        // Each line is validated separately, as when reading from a stream.
+        const auto line_start = wrapped_line.size();
+        wrapped_line.append(line);
+        if (!validate_sequence_and_replace_us(wrapped_line, line_start)) {
+            return false;
+        }
+    }
+    return !wrapped_line.empty();
+}
+
 }  // namespace
 
 std::string FastaRecord::record_name() const {
@@ -64,11 +82,33 @@ std::optional<FastaRecord> FastaRecord::try_create(std::istream& input_stream,
     return result;
 }
 
+std::optional<FastaRecord> FastaRecord::try_create(ChunkedLineReader& line_reader,
+                                                   std::string& error_message) {
+    if (line_reader.at_end()) {
+        return std::nullopt;
+    }
+    FastaRecord result;
+    std::string_view line;
+    if (!line_reader.get_non_empty_line(line)) {
+        return std::nullopt;
+    }
+    if (!result.set_header(std::string(line))) {
+        error_message = "Invalid header line.";
+        return std::nullopt;
+    }
+    if (!get_wrapped_sequence_line(line_reader, result.m_sequence)) {
+        error_message = "Invalid sequence.";
+        return std::nullopt;
+    }
+    return result;
+}
+
 FastaReader::FastaReader(std::string input_file) : m_input_file(std::move(input_file)) {
     if (!is_fasta(m_input_file)) {
         return;
     }
     m_input_stream = std::make_unique<std::ifstream>(m_input_file);
+    m_line_reader = std::make_unique<ChunkedLineReader>(*m_input_stream);
 }
 
 FastaReader::FastaReader(std::unique_ptr<std::istream> input_stream)
@@ -80,17 +120,18 @@ FastaReader::FastaReader(std::unique_ptr<std::istream> input_stream)
     input_stream->clear();
     input_stream->seekg(0);
     m_input_stream = std::move(input_stream);
+    m_line_reader = std::make_unique<ChunkedLineReader>(*m_input_stream);
 }
 
 bool FastaReader::is_valid() const { return m_input_stream && m_input_stream->good(); }
 
 std::optional<FastaRecord> FastaReader::try_get_next_record() {
-    if (!m_input_stream) {
+    if (!m_line_reader) {
         return std::nullopt;
     }
     ++m_record_count;
     std::string error_message{};
-    auto next_fasta_record = FastaRecord::try_create(*m_input_stream, error_message);
+    auto next_fasta_record = FastaRecord::try_create(*m_line_reader, error_message);
     if (!error_message.empty()) {
         spdlog::warn("Failed to read record #{} from {}. {}", m_record_count, m_input_file,
                      error_message);
@@ -29,6 +29,8 @@ public:
 
     static std::optional<FastaRecord> try_create(std::istream& input_stream,
                                                  std::string& error_message);
+    static std::optional<FastaRecord> try_create(ChunkedLineReader& line_reader,
+                                                 std::string& error_message);
 
 private:
     FastaFastqHeader m_header;
@@ -45,6 +47,7 @@ public:
 private:
     std::string m_input_file;
     std::unique_ptr<std::istream> m_input_stream{};
+    std::unique_ptr<ChunkedLineReader> m_line_reader{};
     std::size_t m_record_count{};
 };
 
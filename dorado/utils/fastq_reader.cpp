@@ -12,6 +12,7 @@
 #include <fstream>
 #include <limits>
 #include <sstream>
+#include <string_view>
 
 namespace dorado::utils {
 
@@ -110,12 +111,12 @@ std::unique_ptr<std::istream> create_input_stream(const std::string& input_file)
     return {};
 }
 
-bool is_valid_separator_field(const std::string& field) {
+bool is_valid_separator_field(std::string_view field) {
     assert(!field.empty());
     return field.at(0) == '+';
 }
 
-bool is_valid_quality_field(const std::string& field) {
+bool is_valid_quality_field(std::string_view field) {
     //0x21 (lowest quality; '!' in ASCII) to 0x7e (highest quality; '~' in ASCII)
     return std::none_of(field.begin(), field.end(), [](char c) { return c < 0x21 || c > 0x7e; });
 }
@@ -140,6 +141,20 @@ bool get_wrapped_qstring_line(std::istream& input_stream,
     return wrapped_line.size() == sequence_size;
 }
 
+bool get_wrapped_qstring_line(ChunkedLineReader& line_reader,
+                              std::size_t sequence_size,
+                              std::string& wrapped_line) {
+    wrapped_line.clear();
+    std::string_view line;
+    while (wrapped_line.size() < sequence_size && line_reader.get_non_empty_line(line)) {
+        if (!is_valid_quality_field(line) || wrapped_line.size() + line.size() > sequence_size) {
+            return false;
+        }
+        wrapped_line.append(line);
+    }
+    return wrapped_line.size() == sequence_size;
+}
+
 bool get_wrapped_sequence_line(std::istream& input_stream, std::string& wrapped_line) {
     std::string line;
     std::ostringstream line_builder{};
@@ -153,6 +168,23 @@ bool get_wrapped_sequence_line(std::istream& input_stream, std::string& wrapped_
     return !wrapped_line.empty();
 }
 
+bool get_wrapped_sequence_line(ChunkedLineReader& line_reader, std::string& wrapped_line) {
+    wrapped_line.clear();
+    std::string_view line;
+    while (line_reader.peek() != '+') {
+        if (!line_reader.get_non_empty_line(line)) {
+            return false;
+        }
+        // Each line is validated separately, as when reading from a stream.
+        const auto line_start = wrapped_line.size();
+        wrapped_line.append(line);
+        if (!validate_sequence_and_replace_us(wrapped_line, line_start)) {
+            return false;
+        }
+    }
+    return !wrapped_line.empty();
+}
+
 }  // namespace
 
 const std::string& FastqRecord::header() const { return m_header.header(); }
@@ -233,6 +265,36 @@ std::optional<FastqRecord> FastqRecord::try_create(std::istream& input_stream,
     return result;
 }
 
+std::optional<FastqRecord> FastqRecord::try_create(ChunkedLineReader& line_reader,
+                                                   std::string& error_message) {
+    if (line_reader.at_end()) {
+        return std::nullopt;
+    }
+    FastqRecord result;
+    std::string_view line;
+    if (!line_reader.get_non_empty_line(line)) {
+        return std::nullopt;
+    }
+    if (!result.set_header(std::string(line))) {
+        error_message = "Invalid header line.";
+        return std::nullopt;
+    }
+    if (!get_wrapped_sequence_line(line_reader, result.m_sequence)) {
+        error_message = "Invalid sequence.";
+        return std::nullopt;
+    }
+    if (!line_reader.get_non_empty_line(line) || !is_valid_separator_field(line)) {
+        error_message = "Invalid separator.";
+        return std::nullopt;
+    }
+    if (!get_wrapped_qstring_line(line_reader, result.sequence().size(), result.m_qstring)) {
+        error_message = "Invalid qstring.";
+        return std::nullopt;
+    }
+
+    return result;
+}
+
 bool operator==(const FastqRecord& lhs, const FastqRecord& rhs) {
     return std::tie(lhs.header(), lhs.sequence(), lhs.qstring()) ==
            std::tie(rhs.header(), rhs.sequence(), rhs.qstring());
@@ -248,6 +310,9 @@ FastqReader::FastqReader(std::string input_file) : m_input_file(std::move(input_
     // Simplest to create another input stream after the is_fastq check because our
     // gzip istream has not implemented seek.
     m_input_stream = create_input_stream(m_input_file);
+    if (m_input_stream) {
+        m_line_reader = std::make_unique<ChunkedLineReader>(*m_input_stream);
+    }
 }
 
 FastqReader::FastqReader(std::unique_ptr<std::istream> input_stream)
@@ -259,17 +324,18 @@ FastqReader::FastqReader(std::unique_ptr<std::istream> input_stream)
     input_stream->clear();
     input_stream->seekg(0);
     m_input_stream = std::move(input_stream);
+    m_line_reader = std::make_unique<ChunkedLineReader>(*m_input_stream);
 }
 
 bool FastqReader::is_valid() const { return m_input_stream && m_input_stream->good(); }
 
 std::optional<FastqRecord> FastqReader::try_get_next_record() {
-    if (!m_input_stream) {
+    if (!m_line_reader) {
         return std::nullopt;
     }
     ++m_record_count;
     std::string error_message{};
-    auto next_fastq_record = FastqRecord::try_create(*m_input_stream, error_message);
+    auto next_fastq_record = FastqRecord::try_create(*m_line_reader, error_message);
     if (!error_message.empty()) {
         spdlog::warn("Failed to read record #{} from {}. {}", m_record_count, m_input_file,
                      error_message);
@@ -6,12 +6,13 @@
 #include <htslib/bgzf.h>
 #include <htslib/hts.h>
 #include <htslib/sam.h>
+#include <htslib/thread_pool.h>
 #include <spdlog/spdlog.h>
 
 #include <array>
 #include <cassert>
 #include <filesystem>
-#include <map>
+#include <limits>
 #include <stdexcept>
 
 namespace {
@@ -20,6 +21,7 @@ constexpr size_t MINIMUM_BUFFER_SIZE{100000};  // The smallest allowed buffer si
 constexpr size_t DEFAULT_BUFFER_SIZE{
         20000000};  // Arbitrary 20 MB. Can be overridden by application code.
 constexpr size_t MAX_FILES_FOR_MERGE{512};  // Maximum number of files to merge at once.
+constexpr size_t MERGE_PREFETCH_RECORDS{64};  // Records read ahead per input file when merging.
 
 bool compare_headers(const dorado::SamHdrPtr& header1, const dorado::SamHdrPtr& header2) {
     return (strcmp(sam_hdr_str(header1.get()), sam_hdr_str(header2.get())) == 0);
@@ -28,6 +30,163 @@ bool compare_headers(const dorado::SamHdrPtr& header1, const dorado::SamHdrPtr&
 // BAM tags to add to the read header for fastx output
 constexpr std::array fastq_aux_tags{"RG", "st", "DS", "qs"};
 
+using SortEntry = std::pair<uint64_t, int64_t>;
+
+// Stable LSD radix sort of the entries on their 64-bit sorting key. Passes over bytes which are
+// the same for every key (e.g. the upper bytes of the reference id) are skipped.
+void radix_sort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch) {
+    if (entries.size() < 2) {
+        return;
+    }
+    constexpr size_t NUM_PASSES = sizeof(uint64_t);
+    std::array<std::array<size_t, 256>, NUM_PASSES> counts{};
+    for (const auto& entry : entries) {
+        for (size_t pass = 0; pass < NUM_PASSES; ++pass) {
+            ++counts[pass][(entry.first >> (8 * pass)) & 0xff];
+        }
+    }
+
+    scratch.resize(entries.size());
+    for (size_t pass = 0; pass < NUM_PASSES; ++pass) {
+        const auto shift = 8 * pass;
+        auto& offsets = counts[pass];
+        if (offsets[(entries.front().first >> shift) & 0xff] == entries.size()) {
+            continue;
+        }
+        size_t total = 0;
+        for (auto& offset : offsets) {
+            total += std::exchange(offset, total);
+        }
+        for (const auto& entry : entries) {
+            scratch[offsets[(entry.first >> shift) & 0xff]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
+
+// Tournament tree of losers used for the k-way merge of sorted temporary files. Each internal
+// node holds the input which lost the match at that node, so replacing the winner only replays
+// the matches on its path to the root. Ties are broken on the input index.
+class LoserTree {
+public:
+    explicit LoserTree(size_t num_inputs)
+            : m_keys(num_inputs, std::numeric_limits<uint64_t>::max()),
+              m_active(num_inputs, false),
+              m_tree(num_inputs, 0) {}
+
+    void set(size_t input, uint64_t key) {
+        m_keys[input] = key;
+        m_active[input] = true;
+    }
+    void set_exhausted(size_t input) { m_active[input] = false; }
+
+    // Play the initial tournament once all inputs have been set.
+    void build() {
+        if (!m_tree.empty()) {
+            m_tree[0] = play(1);
+        }
+    }
+
+    // Replay the matches of the winner after its key has been updated.
+    void replay() {
+        const size_t num_inputs = m_tree.size();
+        size_t winner = m_tree[0];
+        for (size_t node = (winner + num_inputs) / 2; node > 0; node /= 2) {
+            if (beats(m_tree[node], winner)) {
+                std::swap(m_tree[node], winner);
+            }
+        }
+        m_tree[0] = winner;
+    }
+
+    size_t winner() const { return m_tree[0]; }
+    bool done() const { return m_tree.empty() || !m_active[m_tree[0]]; }
+
+private:
+    std::vector<uint64_t> m_keys;
+    std::vector<bool> m_active;
+    std::vector<size_t> m_tree;
+
+    bool beats(size_t a, size_t b) const {
+        if (m_active[a] != m_active[b]) {
+            return m_active[a];
+        }
+        return m_keys[a] != m_keys[b] ? m_keys[a] < m_keys[b] : a < b;
+    }
+
+    // Nodes [1, n) are internal and nodes [n, 2n) are the leaves for inputs [0, n).
+    size_t play(size_t node) {
+        const size_t num_inputs = m_tree.size();
+        if (node >= num_inputs) {
+            return node - num_inputs;
+        }
+        const size_t left = play(2 * node);
+        const size_t right = play(2 * node + 1);
+        if (beats(left, right)) {
+            m_tree[node] = right;
+            return left;
+        }
+        m_tree[node] = left;
+        return right;
+    }
+};
+
+// Reads records from a sorted temporary file in batches, reusing the record allocations. The
+// underlying BGZF stream decompresses ahead of the reader on the shared htslib thread pool.
+class PrefetchingReader {
+public:
+    PrefetchingReader() = default;
+
+    bool open(const std::string& filename, htsThreadPool* thread_pool) {
+        m_file.reset(hts_open(filename.c_str(), "rb"));
+        if (!m_file) {
+            spdlog::error("Could not open temporary file {} for merging.", filename);
+            return false;
+        }
+        if (hts_set_thread_pool(m_file.get(), thread_pool) < 0) {
+            spdlog::error("Could not enable multi threading for BAM reading.");
+            return false;
+        }
+        return true;
+    }
+
+    htsFile* file() const { return m_file.get(); }
+
+    // Returns the number of records available, or a negative htslib error code.
+    int fill(sam_hdr_t* header) {
+        if (m_records.empty()) {
+            m_records.resize(MERGE_PREFETCH_RECORDS);
+            for (auto& record : m_records) {
+                record.reset(bam_init1());
+            }
+        }
+        m_next = 0;
+        m_count = 0;
+        while (m_count < m_records.size()) {
+            auto res = sam_read1(m_file.get(), header, m_records[m_count].get());
+            if (res == -1) {
+                break;
+            }
+            if (res < -1) {
+                return res;
+            }
+            ++m_count;
+        }
+        return int(m_count);
+    }
+
+    bool empty() const { return m_next == m_count; }
+    const bam1_t* front() const { return m_records[m_next].get(); }
+    void pop() { ++m_next; }
+    void close() { m_file.reset(); }
+
+private:
+    dorado::HtsFilePtr m_file;
+    std::vector<dorado::BamPtr> m_records;
+    size_t m_next{0};
+    size_t m_count{0};
+};
+
 }  // namespace
 
 namespace dorado::utils {
@@ -109,11 +268,22 @@ void HtsFile::initialise_threads() {
         throw std::runtime_error("Could not open file: " + m_filename);
     }
 
-    if (m_file->format.compression == bgzf) {
-        auto res = bgzf_mt(m_file->fp.bgzf, m_threads, 128);
-        if (res < 0) {
-            throw std::runtime_error("Could not enable multi threading for BAM generation.");
-        }
+    enable_compression_threads(m_file.get());
+}
+
+void HtsFile::enable_compression_threads(htsFile* file) const {
+    if (file->format.compression != bgzf) {
+        return;
+    }
+    int res = 0;
+    if (m_thread_pool) {
+        htsThreadPool thread_pool{m_thread_pool, 0};
+        res = hts_set_thread_pool(file, &thread_pool);
+    } else {
+        res = bgzf_mt(file->fp.bgzf, m_threads, 128);
+    }
+    if (res < 0) {
+        throw std::runtime_error("Could not enable multi threading for BAM generation.");
     }
 }
 
@@ -130,7 +300,20 @@ void HtsFile::set_num_threads(std::size_t threads) {
     initialise_threads();
 }
 
+void HtsFile::set_thread_pool(hts_tpool* thread_pool) {
+    if (m_threads > 0) {
+        throw std::runtime_error(
+                "HtsFile thread pool cannot be set if threads are already initialised");
+    }
+    m_thread_pool = thread_pool;
+    m_threads = hts_tpool_size(thread_pool);
+    initialise_threads();
+}
+
 HtsFile::~HtsFile() {
+    if (m_spill_result.valid()) {
+        m_spill_result.wait();
+    }
     if (!m_finalised) {
         spdlog::error("finalise() not called on a HtsFile.");
     }
@@ -146,63 +329,85 @@ void HtsFile::set_buffer_size(size_t buff_size) {
                                  std::to_string(MINIMUM_BUFFER_SIZE) + " (" +
                                  std::to_string(MINIMUM_BUFFER_SIZE / 1000) + " KB).");
     }
-    m_bam_buffer.resize(buff_size);
+    // The memory is split between the buffer being filled and the one being written out.
+    m_buffer_size = buff_size / 2;
+    m_active_buffer.data.resize(m_buffer_size);
 }
 
-void HtsFile::flush_temp_file(const bam1_t* last_record) {
-    if (m_current_buffer_offset == 0 && !last_record) {
+void HtsFile::spill_active_buffer() {
+    if (m_active_buffer.index.empty()) {
         // This handles the case that the last read passed in before calling finalise() has already triggered
-        // a flush, or that finalise() was called without ever passing any reads.
+        // a spill, or that finalise() was called without ever passing any reads.
         return;
     }
+
+    // Only one spill can be in flight, and its buffer is the one we're about to start filling.
+    wait_for_spill();
+    auto file_index = m_temp_files.size();
+    auto tempfilename = m_filename + "." + std::to_string(file_index) + ".tmp";
+    m_temp_files.push_back(tempfilename);
+
+    std::swap(m_active_buffer, m_spill_buffer);
+    m_active_buffer.data.resize(m_buffer_size);
+    m_spill_result = std::async(std::launch::async, [this, tempfilename] {
+        write_temp_file(m_spill_buffer, tempfilename, nullptr);
+    });
+}
+
+void HtsFile::wait_for_spill() {
+    if (m_spill_result.valid()) {
+        // Rethrows any error from writing the temporary file.
+        m_spill_result.get();
+    }
+}
+
+void HtsFile::write_temp_file(SortBuffer& buffer,
+                              const std::string& filename,
+                              const bam1_t* last_record) const {
     if (last_record) {
-        // We add last_record to our buffer map with offset -1, so that we know where it should be sorted into
+        // We add last_record to our buffer index with offset -1, so that we know where it should be sorted into
         // the output.
         auto sorting_key = calculate_sorting_key(last_record);
-        m_buffer_map.insert({sorting_key, -1});
+        buffer.index.emplace_back(sorting_key, -1);
     }
+    radix_sort(buffer.index, buffer.sort_scratch);
 
     // Open the file for writing, and write the header. Note that all temp files will have the same header.
-    auto file_index = m_temp_files.size();
-    auto tempfilename = m_filename + "." + std::to_string(file_index) + ".tmp";
-    m_temp_files.push_back(tempfilename);
-    m_file.reset(hts_open(tempfilename.c_str(), "wb"));
-    if (m_file->format.compression == bgzf) {
-        auto res = bgzf_mt(m_file->fp.bgzf, m_threads, 128);
-        if (res < 0) {
-            throw std::runtime_error("Could not enable multi threading for BAM generation.");
-        }
+    HtsFilePtr file(hts_open(filename.c_str(), "wb"));
+    if (!file) {
+        throw std::runtime_error("Could not open temporary file " + filename + " for writing.");
     }
+    enable_compression_threads(file.get());
     if (m_mode != OutputMode::FASTQ && m_mode != OutputMode::FASTA) {
-        if (sam_hdr_write(m_file.get(), m_header.get()) != 0) {
+        if (sam_hdr_write(file.get(), m_header.get()) != 0) {
             throw std::runtime_error("Could not write header to temp file.");
         }
     }
 
-    for (const auto& item : m_buffer_map) {
+    for (const auto& item : buffer.index) {
         // This will give us the offsets into the buffer in sorted order.
         int64_t offset = item.second;
         const bam1_t* record{nullptr};
         if (offset == -1) {
             record = last_record;
         } else {
-            if (size_t(offset) + sizeof(bam1_t) > m_bam_buffer.size()) {
+            if (size_t(offset) + sizeof(bam1_t) > buffer.data.size()) {
                 throw std::out_of_range("Index out of bounds in BAM record buffer.");
             }
-            record = std::launder(reinterpret_cast<bam1_t*>(m_bam_buffer.data() + offset));
-            if (size_t(offset) + sizeof(bam1_t) + size_t(record->l_data) > m_bam_buffer.size()) {
+            record = std::launder(reinterpret_cast<bam1_t*>(buffer.data.data() + offset));
+            if (size_t(offset) + sizeof(bam1_t) + size_t(record->l_data) > buffer.data.size()) {
                 throw std::out_of_range("Index out of bounds in BAM record buffer.");
             }
         }
-        auto res = write_to_file(record);
+        auto res = sam_write1(file.get(), m_header.get(), record);
         if (res < 0) {
             throw std::runtime_error("Error writing to BAM temporary file, error code " +
                                      std::to_string(res));
         }
     }
-    m_file.reset();
-    m_current_buffer_offset = 0;
-    m_buffer_map.clear();
+    file.reset();
+    buffer.offset = 0;
+    buffer.index.clear();
 }
 
 // If we are doing sorted BAM output, then when we are done we will have sorted temporary files
@@ -228,7 +433,8 @@ void HtsFile::finalise(const ProgressCallback& progress_callback) {
     }
 
     // If any reads are cached for writing, write out the final temporary file.
-    flush_temp_file(nullptr);
+    spill_active_buffer();
+    wait_for_spill();
 
     bool file_is_mapped = (sam_hdr_nref(m_header.get()) > 0);
     m_header.reset();
@@ -298,32 +504,40 @@ int HtsFile::write_to_file(const bam1_t* record) {
 
 void HtsFile::cache_record(const bam1_t* record) {
     size_t bytes_required = sizeof(bam1_t) + size_t(record->l_data);
-    if (m_current_buffer_offset + bytes_required > m_bam_buffer.size()) {
-        // This record won't fit in the buffer, so flush the current buffer, plus this record, to the file.
-        flush_temp_file(record);
-        return;
+    auto& buffer = m_active_buffer;
+    if (buffer.offset + bytes_required > buffer.data.size()) {
+        // This record won't fit in the buffer, so hand the current buffer off to be written out.
+        spill_active_buffer();
+        if (bytes_required > buffer.data.size()) {
+            // The record won't fit in an empty buffer either, so write it to its own temp file.
+            wait_for_spill();
+            auto tempfilename = m_filename + "." + std::to_string(m_temp_files.size()) + ".tmp";
+            m_temp_files.push_back(tempfilename);
+            write_temp_file(buffer, tempfilename, record);
+            return;
+        }
     }
     auto sorting_key = calculate_sorting_key(record);
-    m_buffer_map.insert({sorting_key, m_current_buffer_offset});
+    buffer.index.emplace_back(sorting_key, buffer.offset);
 
     // Copy the contents of the bam1_t struct into the memory buffer.
-    auto record_buff = m_bam_buffer.data() + m_current_buffer_offset;
+    auto record_buff = buffer.data.data() + buffer.offset;
     memcpy(record_buff, record, sizeof(bam1_t));
-    m_current_buffer_offset += sizeof(bam1_t);
+    buffer.offset += sizeof(bam1_t);
 
     // The data pointed to by the bam1_t::data field is then copied immediately after the struct contents.
-    memcpy(m_bam_buffer.data() + m_current_buffer_offset, record->data, record->l_data);
+    memcpy(buffer.data.data() + buffer.offset, record->data, record->l_data);
 
     // We have to tell our buffered object where its copy of the data is.
     bam1_t* buffer_entry = std::launder(reinterpret_cast<bam1_t*>(record_buff));
     buffer_entry->data =
-            std::launder(reinterpret_cast<uint8_t*>(m_bam_buffer.data() + m_current_buffer_offset));
+            std::launder(reinterpret_cast<uint8_t*>(buffer.data.data() + buffer.offset));
 
     // When we write the cached records, we will use a pointer cast to treat the cached record as a bam1_t
     // object, so we need to round up our buffer offset so that the next entry will be properly aligned.
-    m_current_buffer_offset += size_t(record->l_data);
+    buffer.offset += size_t(record->l_data);
     auto alignment = alignof(bam1_t);
-    m_current_buffer_offset = ((m_current_buffer_offset + alignment - 1) / alignment) * alignment;
+    buffer.offset = ((buffer.offset + alignment - 1) / alignment) * alignment;
 }
 
 bool HtsFile::merge_temp_files_iteratively(const ProgressCallback& progress_callback) const {
@@ -351,17 +565,24 @@ bool HtsFile::merge_temp_files(ProgressUpdater& update_progress,
     // true if the temp-files were created by this class, but it means that this
     // function is not suitable for generic merging of BAM files.
     const size_t num_temp_files = temp_files.size();
-    std::vector<HtsFilePtr> in_files(num_temp_files);
-    std::vector<BamPtr> top_records(num_temp_files);
-    std::vector<uint64_t> top_record_scores(num_temp_files);
+
+    // All of the inputs and the output share one thread pool for BGZF (de)compression, rather
+    // than each file spinning up its own.
+    HtsThreadPoolPtr pool(hts_tpool_init(std::max(m_threads, 1)));
+    if (!pool) {
+        spdlog::error("Could not create thread pool for merging.");
+        return false;
+    }
+    htsThreadPool thread_pool{pool.get(), 0};
+
+    std::vector<PrefetchingReader> in_files(num_temp_files);
+    LoserTree tree(num_temp_files);
     SamHdrPtr header{};
     for (size_t i = 0; i < num_temp_files; ++i) {
-        in_files[i].reset(hts_open(temp_files[i].c_str(), "rb"));
-        if (bgzf_mt(in_files[i]->fp.bgzf, m_threads, 128) < 0) {
-            spdlog::error("Could not enable multi threading for BAM reading.");
+        if (!in_files[i].open(temp_files[i], &thread_pool)) {
             return false;
         }
-        SamHdrPtr current_header(sam_hdr_read(in_files[i].get()));
+        SamHdrPtr current_header(sam_hdr_read(in_files[i].file()));
         if (i == 0) {
             header = std::move(current_header);
         } else {
@@ -373,19 +594,19 @@ bool HtsFile::merge_temp_files(ProgressUpdater& update_progress,
             }
             current_header.reset();
         }
-        top_records[i].reset(bam_init1());
-        auto res = sam_read1(in_files[i].get(), header.get(), top_records[i].get());
-        if (res < 0) {
+        auto res = in_files[i].fill(header.get());
+        if (res <= 0) {
             spdlog::error("Could not read first record from file {}, error code {}", temp_files[i],
                           res);
             return false;
         }
-        top_record_scores[i] = calculate_sorting_key(top_records[i].get());
+        tree.set(i, calculate_sorting_key(in_files[i].front()));
     }
+    tree.build();
 
     // Open the output file, and write the header.
     HtsFilePtr out_file(hts_open(merged_filename.c_str(), "wb"));
-    if (bgzf_mt(out_file->fp.bgzf, m_threads, 128) < 0) {
+    if (hts_set_thread_pool(out_file.get(), &thread_pool) < 0) {
         spdlog::error("Could not enable multi threading for BAM generation.");
         return false;
     }
@@ -409,27 +630,13 @@ bool HtsFile::merge_temp_files(ProgressUpdater& update_progress,
     }
 
     size_t processed_records = 0;
-    size_t files_done = 0;
-    while (files_done < num_temp_files) {
-        // Find the next file to write a record from.
-        uint64_t best_score = std::numeric_limits<uint64_t>::max();
-        int best_index = -1;
-        for (size_t i = 0; i < num_temp_files; ++i) {
-            if (top_records[i]) {
-                auto score = top_record_scores[i];
-                if (best_index == -1 || score < best_score) {
-                    best_score = score;
-                    best_index = int(i);
-                }
-            }
-        }
-        if (best_index == -1) {
-            spdlog::error("Logic error in merging algorithm.");
-            return false;
-        }
+    while (!tree.done()) {
+        // The root of the tree is the next file to write a record from.
+        const size_t best_index = tree.winner();
+        auto& input = in_files[best_index];
 
         // Write the record.
-        auto res = sam_write1(out_file.get(), out_header.get(), top_records[best_index].get());
+        auto res = sam_write1(out_file.get(), out_header.get(), input.front());
         if (res < 0) {
             spdlog::error("Failed to write to sorted file {}, error code {}", out_file->fn, res);
             return false;
@@ -438,20 +645,23 @@ bool HtsFile::merge_temp_files(ProgressUpdater& update_progress,
         update_progress(processed_records);
 
         // Load the next record for the file.
-        top_records[best_index].reset(bam_init1());
-        res = sam_read1(in_files[best_index].get(), header.get(), top_records[best_index].get());
-        if (res >= 0) {
-            top_record_scores[best_index] = calculate_sorting_key(top_records[best_index].get());
-        } else if (res == -1) {
+        input.pop();
+        if (input.empty()) {
+            res = input.fill(header.get());
+            if (res < 0) {
+                spdlog::error("Error reading record from file {}, error code {}",
+                              temp_files[best_index], res);
+                return false;
+            }
+        }
+        if (!input.empty()) {
+            tree.set(best_index, calculate_sorting_key(input.front()));
+        } else {
             // EOF reached. Close the file and mark that this file is done.
-            top_records[best_index].reset();
-            in_files[best_index].reset();
-            ++files_done;
-        } else if (res < -1) {
-            spdlog::error("Error reading record from file {}, error code {}",
-                          in_files[best_index]->fn, res);
-            return false;
+            input.close();
+            tree.set_exhausted(best_index);
         }
+        tree.replay();
     }
 
     if (final_iteration) {
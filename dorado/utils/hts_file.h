@@ -5,8 +5,10 @@
 #include <algorithm>
 #include <filesystem>
 #include <functional>
-#include <map>
+#include <future>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace dorado::utils {
 
@@ -29,6 +31,9 @@ public:
 
     // Support for setting threads after construction
     void set_num_threads(std::size_t threads);
+    // Compresses on a thread pool shared with other files instead of threads of its own. The
+    // pool must outlive this file.
+    void set_thread_pool(hts_tpool* thread_pool);
 
     void set_buffer_size(size_t buff_size);
     int set_header(const sam_hdr_t* header);
@@ -46,19 +51,35 @@ private:
     SamHdrPtr m_header;
     size_t m_num_records{0};
     int m_threads{0};
+    hts_tpool* m_thread_pool{nullptr};
     bool m_finalised{false};
     bool m_finalise_is_noop;
     bool m_sort_bam;
     const OutputMode m_mode;
 
-    std::vector<std::byte> m_bam_buffer;
-    std::multimap<uint64_t, int64_t> m_buffer_map;
+    // Records cached for sorted output. Each record is stored as a bam1_t followed by its data,
+    // and |index| holds the sorting key and buffer offset of each record.
+    struct SortBuffer {
+        std::vector<std::byte> data;
+        std::vector<std::pair<uint64_t, int64_t>> index;
+        std::vector<std::pair<uint64_t, int64_t>> sort_scratch;
+        int64_t offset{0};
+    };
+
+    // Sorted output is double-buffered: records are cached in m_active_buffer while
+    // m_spill_buffer is sorted and written to a temporary file in the background.
+    size_t m_buffer_size{0};
+    SortBuffer m_active_buffer;
+    SortBuffer m_spill_buffer;
     std::vector<std::string> m_temp_files;
-    int64_t m_current_buffer_offset{0};
 
     struct ProgressUpdater;
 
-    void flush_temp_file(const bam1_t* last_record);
+    void spill_active_buffer();
+    void wait_for_spill();
+    void write_temp_file(SortBuffer& buffer,
+                         const std::string& filename,
+                         const bam1_t* last_record) const;
     int write_to_file(const bam1_t* record);
     void cache_record(const bam1_t* record);
     bool merge_temp_files_iteratively(const ProgressCallback& progress_callback) const;
@@ -66,6 +87,10 @@ private:
                           const std::vector<std::string>& temp_files,
                           const std::string& merged_filename) const;
     void initialise_threads();
+    void enable_compression_threads(htsFile* file) const;
+
+    // Declared last so that any in-flight spill completes before the buffers are destroyed.
+    std::future<void> m_spill_result;
 };
 
 class FileMergeBatcher {
@@ -5,12 +5,60 @@
 
 #include <spdlog/spdlog.h>
 
+#include <cassert>
+#include <charconv>
+#include <cstring>
 #include <iostream>
 #include <ostream>
 #include <sstream>
+#include <stdexcept>
 
 namespace dorado::utils {
 
+namespace {
+
+// Splits the next tab separated field off the front of |row|.
+std::string_view next_field(std::string_view& row) {
+    const auto end = row.find('\t');
+    const auto field = row.substr(0, end);
+    row.remove_prefix(end == std::string_view::npos ? row.size() : end + 1);
+    return field;
+}
+
+bool parse_int_field(std::string_view& row, int& value) {
+    const auto field = next_field(row);
+    const auto* const end = field.data() + field.size();
+    const auto [ptr, ec] = std::from_chars(field.data(), end, value);
+    return ec == std::errc() && ptr == end && !field.empty();
+}
+
+}  // namespace
+
+std::optional<PafEntryView> parse_paf_view(std::string_view paf_row) {
+    PafEntryView entry;
+    entry.qname = next_field(paf_row);
+    if (entry.qname.empty() || !parse_int_field(paf_row, entry.qlen) ||
+        !parse_int_field(paf_row, entry.qstart) || !parse_int_field(paf_row, entry.qend)) {
+        return std::nullopt;
+    }
+    const auto strand = next_field(paf_row);
+    if (strand.size() != 1) {
+        return std::nullopt;
+    }
+    entry.strand = strand[0];
+    entry.tname = next_field(paf_row);
+    if (entry.tname.empty() || !parse_int_field(paf_row, entry.tlen) ||
+        !parse_int_field(paf_row, entry.tstart) || !parse_int_field(paf_row, entry.tend) ||
+        !parse_int_field(paf_row, entry.num_residue_matches) ||
+        !parse_int_field(paf_row, entry.alignment_block_length) ||
+        !parse_int_field(paf_row, entry.mapq)) {
+        return std::nullopt;
+    }
+    // The rest of the line is auxiliary data.
+    entry.aux = paf_row;
+    return entry;
+}
+
 PafEntry parse_paf(std::istringstream& ss) {
     PafEntry entry;
     // Read the fields from the stringstream
@@ -63,13 +111,16 @@ void serialize_to_paf(std::ostream& os,
 }
 
 std::string_view paf_aux_get(const PafEntry& paf_entry, const char tag[2], const char type) {
-    const std::string t = std::string(tag) + ":" + std::string(1, type) + ":";
-    const std::string_view aux(paf_entry.aux);
-    size_t pos = aux.find(t.c_str());
+    return paf_aux_get(std::string_view(paf_entry.aux), tag, type);
+}
+
+std::string_view paf_aux_get(const std::string_view aux, const char tag[2], const char type) {
+    const char t[] = {tag[0], tag[1], ':', type, ':'};
+    size_t pos = aux.find(std::string_view(t, sizeof(t)));
     if (pos == std::string::npos) {
         return {};
     }
-    pos += 5;
+    pos += sizeof(t);
     const size_t end = aux.find('\t', pos);
     if (end == std::string::npos) {
         return aux.substr(pos);
@@ -78,4 +129,96 @@ std::string_view paf_aux_get(const PafEntry& paf_entry, const char tag[2], const
     return aux.substr(pos, end - pos);
 }
 
+PafReader::PafReader(const std::string& paf_file)
+        : m_paf_file(paf_file), m_file(paf_file), m_line_reader(m_file, CHUNK_SIZE) {
+    if (!m_file.is_open()) {
+        throw std::runtime_error("Could not open PAF file " + paf_file);
+    }
+}
+
+std::optional<PafEntryView> PafReader::next_record() {
+    std::string_view line;
+    while (!m_line_reader.at_end()) {
+        const bool non_empty = m_line_reader.get_non_empty_line(line);
+        ++m_num_lines;
+        m_num_bytes += line.size() + 1;
+        // Strip the carriage return of CRLF line endings, which would otherwise end up in the
+        // last field of the record.
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (!non_empty || line.empty()) {
+            continue;
+        }
+        auto entry = parse_paf_view(line);
+        if (!entry) {
+            spdlog::warn("Skipping invalid PAF record on line {} of {}", m_num_lines, m_paf_file);
+            continue;
+        }
+        ++m_num_records;
+        return entry;
+    }
+    return std::nullopt;
+}
+
+PafWriter::PafWriter(std::ostream& os, const std::size_t flush_size)
+        : m_os(os), m_flush_size(flush_size) {
+    m_buffer.reserve(flush_size);
+}
+
+PafWriter::~PafWriter() { flush(); }
+
+void PafWriter::append_int(const int64_t value) {
+    char digits[24];
+    const auto [end, ec] = std::to_chars(std::begin(digits), std::end(digits), value);
+    assert(ec == std::errc());
+    m_buffer.append(digits, end);
+}
+
+void PafWriter::write(const std::string_view qname,
+                      const std::string_view tname,
+                      const Overlap& ovl,
+                      const int num_residue_matches,
+                      const int alignment_block_length,
+                      const int mapq,
+                      const std::vector<CigarOp>& cigar) {
+    m_buffer.append(qname);
+    for (const int64_t value : {ovl.qlen, ovl.qstart, ovl.qend}) {
+        m_buffer += '\t';
+        append_int(value);
+    }
+    m_buffer += '\t';
+    m_buffer += ovl.fwd ? '+' : '-';
+    m_buffer += '\t';
+    m_buffer.append(tname);
+    for (const int64_t value : {ovl.tlen, ovl.tstart, ovl.tend}) {
+        m_buffer += '\t';
+        append_int(value);
+    }
+    for (const int64_t value : {num_residue_matches, alignment_block_length, mapq}) {
+        m_buffer += '\t';
+        append_int(value);
+    }
+    if (!std::empty(cigar)) {
+        m_buffer.append("\tcg:Z:");
+        for (const auto& op : cigar) {
+            append_int(op.len);
+            m_buffer += convert_cigar_op_to_char(op.op);
+        }
+    }
+    m_buffer += '\n';
+
+    if (m_buffer.size() >= m_flush_size) {
+        flush();
+    }
+}
+
+void PafWriter::flush() {
+    if (m_buffer.empty()) {
+        return;
+    }
+    m_os.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_buffer.clear();
+}
+
 }  // namespace dorado::utils
@@ -1,8 +1,12 @@
 #pragma once
 
+#include "chunked_line_reader.h"
 #include "cigar.h"
 
+#include <cstddef>
+#include <fstream>
 #include <iosfwd>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -36,6 +40,27 @@ struct PafEntry {
     }
 };
 
+// A PAF record whose names and aux data point into the line it was parsed from.
+struct PafEntryView {
+    std::string_view qname;
+    int qlen = 0;
+    int qstart = 0;
+    int qend = 0;
+    char strand{'*'};
+    std::string_view tname;
+    int tlen = 0;
+    int tstart = 0;
+    int tend = 0;
+    int num_residue_matches = 0;
+    int alignment_block_length = 0;
+    int mapq = 0;
+    std::string_view aux;
+};
+
+// Parses a PAF line, without its newline. Returns std::nullopt if any of the 12 mandatory
+// fields is missing or invalid.
+std::optional<PafEntryView> parse_paf_view(std::string_view paf_row);
+
 PafEntry parse_paf(const std::string& paf_row);
 PafEntry parse_paf(std::istringstream& paf_row);
 
@@ -51,5 +76,62 @@ void serialize_to_paf(std::ostream& os,
                       const std::vector<CigarOp>& cigar);
 
 std::string_view paf_aux_get(const PafEntry& paf_entry, const char tag[2], char type);
+std::string_view paf_aux_get(std::string_view aux, const char tag[2], char type);
+
+// Streams the records of a PAF file, reading it in large blocks and parsing each record in
+// place rather than copying its fields.
+class PafReader {
+public:
+    static constexpr std::size_t CHUNK_SIZE = 4 << 20;
+
+    // Throws std::runtime_error if the file can't be opened.
+    explicit PafReader(const std::string& paf_file);
+
+    // Returns the next record, which is only valid until the next call. Invalid lines are
+    // skipped with a warning.
+    std::optional<PafEntryView> next_record();
+
+    std::size_t num_records() const { return m_num_records; }
+    std::size_t num_bytes() const { return m_num_bytes; }
+
+private:
+    std::string m_paf_file;
+    std::ifstream m_file;
+    ChunkedLineReader m_line_reader;
+    std::size_t m_num_lines{0};
+    std::size_t m_num_records{0};
+    std::size_t m_num_bytes{0};
+};
+
+// Writes PAF records to a stream. Records are formatted into a buffer that's reused between
+// writes and only written to the stream once it holds |flush_size| bytes.
+class PafWriter {
+public:
+    static constexpr std::size_t DEFAULT_FLUSH_SIZE = 1 << 20;
+
+    explicit PafWriter(std::ostream& os, std::size_t flush_size = DEFAULT_FLUSH_SIZE);
+    ~PafWriter();
+
+    PafWriter(const PafWriter&) = delete;
+    PafWriter& operator=(const PafWriter&) = delete;
+
+    // Writes the same record as serialize_to_paf(), followed by a newline.
+    void write(std::string_view qname,
+               std::string_view tname,
+               const Overlap& overlap,
+               int num_residue_matches,
+               int alignment_block_length,
+               int mapq,
+               const std::vector<CigarOp>& cigar);
+
+    void flush();
+
+private:
+    void append_int(int64_t value);
+
+    std::ostream& m_os;
+    std::string m_buffer;
+    std::size_t m_flush_size;
+};
 
 }  // namespace dorado::utils
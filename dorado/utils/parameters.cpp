@@ -19,10 +19,11 @@ ThreadAllocations default_thread_allocations(int num_devices,
     allocs.scaler_node_threads = num_devices * 4;
     allocs.splitter_node_threads = num_devices;
     allocs.loader_threads = num_devices;
+    allocs.trimmer_threads = (enable_barcoder || adapter_trimming) ? num_devices * 2 : 0;
     int total_threads_used =
             (allocs.writer_threads + allocs.read_converter_threads + allocs.read_filter_threads +
              allocs.modbase_threads + allocs.scaler_node_threads + allocs.loader_threads +
-             allocs.splitter_node_threads);
+             allocs.splitter_node_threads + allocs.trimmer_threads);
     int remaining_threads = max_threads - total_threads_used;
     remaining_threads = std::max(num_devices * 10, remaining_threads);
     // Divide up work equally between the aligner, barcoder, and adapter-trimming nodes, or whatever
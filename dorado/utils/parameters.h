@@ -27,6 +27,7 @@ struct ThreadAllocations {
     int aligner_threads{0};
     int barcoder_threads{0};
     int adapter_threads{0};
+    int trimmer_threads{0};
 };
 
 ThreadAllocations default_thread_allocations(int num_devices,
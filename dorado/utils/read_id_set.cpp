@@ -0,0 +1,230 @@
+#include "read_id_set.h"
+
+#include <cstring>
+
+namespace {
+
+// Length of a UUID in its string form, e.g. 002bd127-db82-436f-b828-28567c3d505d.
+constexpr size_t UUID_STRING_LEN = 36;
+
+// Initial number of slots in the table, and the maximum load before growing it.
+constexpr size_t INITIAL_NUM_SLOTS = 64;
+constexpr size_t MAX_LOAD_NUMERATOR = 3;
+constexpr size_t MAX_LOAD_DENOMINATOR = 4;
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+bool is_empty(const std::array<uint64_t, 2>& slot) { return slot[0] == 0 && slot[1] == 0; }
+
+// Approximate heap memory of an entry in an std::unordered_set<std::string>: a node holding the
+// next pointer, the string and its cached hash, plus any heap allocation for the characters.
+size_t string_node_bytes(size_t length) {
+    static const size_t short_string_capacity = std::string().capacity();
+    size_t bytes = sizeof(void*) + sizeof(std::string) + sizeof(size_t);
+    if (length > short_string_capacity) {
+        bytes += length + 1;
+    }
+    return bytes;
+}
+
+}  // namespace
+
+namespace dorado::utils {
+
+ReadIdSet::ReadIdSet(const std::unordered_set<std::string>& read_ids) {
+    for (const auto& read_id : read_ids) {
+        insert(read_id);
+    }
+}
+
+bool ReadIdSet::pack(std::string_view read_id, PackedReadId& packed) {
+    if (read_id.size() != UUID_STRING_LEN) {
+        return false;
+    }
+    size_t byte = 0;
+    for (size_t i = 0; i < UUID_STRING_LEN;) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (read_id[i] != '-') {
+                return false;
+            }
+            ++i;
+            continue;
+        }
+        const int hi = hex_value(read_id[i]);
+        const int lo = hex_value(read_id[i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        packed[byte++] = static_cast<uint8_t>((hi << 4) | lo);
+        i += 2;
+    }
+    return true;
+}
+
+ReadIdSet::Slot ReadIdSet::to_slot(const PackedReadId& read_id) {
+    Slot slot;
+    std::memcpy(slot.data(), read_id.data(), sizeof(slot));
+    return slot;
+}
+
+size_t ReadIdSet::home_index(const Slot& slot) const {
+    // UUIDs are mostly random bits, but mix both halves in case they aren't.
+    const uint64_t hash = (slot[0] ^ (slot[1] * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull;
+    return static_cast<size_t>(hash >> m_index_shift);
+}
+
+size_t ReadIdSet::find_index(const Slot& slot) const {
+    const size_t mask = m_slots.size() - 1;
+    size_t index = home_index(slot);
+    while (!is_empty(m_slots[index]) && m_slots[index] != slot) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+void ReadIdSet::grow() {
+    std::vector<Slot> old_slots(m_slots.empty() ? INITIAL_NUM_SLOTS : m_slots.size() * 2);
+    std::swap(old_slots, m_slots);
+    m_index_shift = 64;
+    for (size_t num_slots = m_slots.size(); num_slots > 1; num_slots >>= 1) {
+        --m_index_shift;
+    }
+    for (const auto& slot : old_slots) {
+        if (!is_empty(slot)) {
+            m_slots[find_index(slot)] = slot;
+        }
+    }
+}
+
+bool ReadIdSet::insert_slot(const Slot& slot) {
+    if (is_empty(slot)) {
+        if (m_contains_zero_id) {
+            return false;
+        }
+        m_contains_zero_id = true;
+        ++m_num_packed_ids;
+        return true;
+    }
+    if ((m_num_packed_ids + 1) * MAX_LOAD_DENOMINATOR > m_slots.size() * MAX_LOAD_NUMERATOR) {
+        grow();
+    }
+    auto& entry = m_slots[find_index(slot)];
+    if (!is_empty(entry)) {
+        return false;
+    }
+    entry = slot;
+    ++m_num_packed_ids;
+    return true;
+}
+
+bool ReadIdSet::erase_slot(const Slot& slot) {
+    if (is_empty(slot)) {
+        if (!m_contains_zero_id) {
+            return false;
+        }
+        m_contains_zero_id = false;
+        --m_num_packed_ids;
+        return true;
+    }
+    if (m_slots.empty()) {
+        return false;
+    }
+    size_t hole = find_index(slot);
+    if (is_empty(m_slots[hole])) {
+        return false;
+    }
+
+    // Shift back any following entries in the probe sequence that would no longer be
+    // reachable from their home slot once the hole is emptied.
+    const size_t mask = m_slots.size() - 1;
+    for (size_t next = (hole + 1) & mask; !is_empty(m_slots[next]); next = (next + 1) & mask) {
+        const size_t home = home_index(m_slots[next]);
+        const bool home_in_range = hole <= next ? (hole < home && home <= next)
+                                                : (hole < home || home <= next);
+        if (!home_in_range) {
+            m_slots[hole] = m_slots[next];
+            hole = next;
+        }
+    }
+    m_slots[hole] = Slot{};
+    --m_num_packed_ids;
+    return true;
+}
+
+bool ReadIdSet::contains_slot(const Slot& slot) const {
+    if (is_empty(slot)) {
+        return m_contains_zero_id;
+    }
+    return !m_slots.empty() && !is_empty(m_slots[find_index(slot)]);
+}
+
+bool ReadIdSet::insert(std::string_view read_id) {
+    PackedReadId packed;
+    if (pack(read_id, packed)) {
+        return insert(packed);
+    }
+    if (!m_other_ids.emplace(read_id).second) {
+        return false;
+    }
+    m_other_id_bytes += string_node_bytes(read_id.size());
+    return true;
+}
+
+bool ReadIdSet::insert(const PackedReadId& read_id) { return insert_slot(to_slot(read_id)); }
+
+bool ReadIdSet::erase(std::string_view read_id) {
+    PackedReadId packed;
+    if (pack(read_id, packed)) {
+        return erase_slot(to_slot(packed));
+    }
+    if (m_other_ids.erase(std::string(read_id)) == 0) {
+        return false;
+    }
+    m_other_id_bytes -= string_node_bytes(read_id.size());
+    return true;
+}
+
+bool ReadIdSet::contains(std::string_view read_id) const {
+    PackedReadId packed;
+    if (pack(read_id, packed)) {
+        return contains(packed);
+    }
+    return m_other_ids.find(std::string(read_id)) != m_other_ids.end();
+}
+
+bool ReadIdSet::contains(const PackedReadId& read_id) const {
+    return contains_slot(to_slot(read_id));
+}
+
+void ReadIdSet::clear() {
+    m_slots = {};
+    m_num_packed_ids = 0;
+    m_index_shift = 64;
+    m_contains_zero_id = false;
+    m_other_ids.clear();
+    m_other_id_bytes = 0;
+}
+
+size_t ReadIdSet::memory_usage() const {
+    return m_slots.capacity() * sizeof(Slot) + other_ids_memory_usage();
+}
+
+size_t ReadIdSet::string_set_memory_usage() const {
+    // Each UUID would also need one bucket pointer, at the default max load factor.
+    const size_t uuid_entry_bytes = string_node_bytes(UUID_STRING_LEN) + sizeof(void*);
+    return m_num_packed_ids * uuid_entry_bytes + other_ids_memory_usage();
+}
+
+size_t ReadIdSet::other_ids_memory_usage() const {
+    return m_other_ids.bucket_count() * sizeof(void*) + m_other_id_bytes;
+}
+
+}  // namespace dorado::utils
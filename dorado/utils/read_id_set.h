@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace dorado::utils {
+
+/**
+ * @brief A set of read ids, optimised for the UUID read ids used by POD5.
+ *
+ * Read ids in the canonical lowercase UUID form are packed into 16 bytes and held in an
+ * open-addressing hash table, which takes roughly 20-40 bytes per read rather than the ~90
+ * bytes per read of an std::unordered_set<std::string>. Any other read id is held in a
+ * fallback string set, so the set behaves exactly as a set of strings would.
+ *
+ * Not thread safe for concurrent modification.
+ */
+class ReadIdSet {
+public:
+    // The 16 bytes of a UUID, in the order they appear in the string form.
+    using PackedReadId = std::array<uint8_t, 16>;
+
+    ReadIdSet() = default;
+    explicit ReadIdSet(const std::unordered_set<std::string>& read_ids);
+
+    // Returns true if the read id was not already in the set.
+    bool insert(std::string_view read_id);
+    bool insert(const PackedReadId& read_id);
+
+    // Returns true if the read id was in the set.
+    bool erase(std::string_view read_id);
+
+    bool contains(std::string_view read_id) const;
+    bool contains(const PackedReadId& read_id) const;
+    size_t count(std::string_view read_id) const { return contains(read_id) ? 1 : 0; }
+
+    size_t size() const { return m_num_packed_ids + m_other_ids.size(); }
+    bool empty() const { return size() == 0; }
+    void clear();
+
+    // Approximate heap memory used by the set, in bytes.
+    size_t memory_usage() const;
+
+    // Approximate heap memory the same read ids would use in an std::unordered_set<std::string>.
+    size_t string_set_memory_usage() const;
+
+    // Packs a read id if it's a canonical lowercase UUID, returning false otherwise.
+    static bool pack(std::string_view read_id, PackedReadId& packed);
+
+private:
+    using Slot = std::array<uint64_t, 2>;
+
+    static Slot to_slot(const PackedReadId& read_id);
+    size_t home_index(const Slot& slot) const;
+    // Index of the slot holding the id, or of the empty slot where it would be inserted.
+    size_t find_index(const Slot& slot) const;
+    void grow();
+    size_t other_ids_memory_usage() const;
+
+    bool insert_slot(const Slot& slot);
+    bool erase_slot(const Slot& slot);
+    bool contains_slot(const Slot& slot) const;
+
+    // Open-addressing table using linear probing. An all-zero slot marks an empty entry, so
+    // the all-zero UUID is tracked separately.
+    std::vector<Slot> m_slots;
+    size_t m_num_packed_ids{0};
+    int m_index_shift{64};
+    bool m_contains_zero_id{false};
+
+    std::unordered_set<std::string> m_other_ids;
+    size_t m_other_id_bytes{0};
+};
+
+}  // namespace dorado::utils
@@ -40,6 +40,16 @@ using HalfRegister = float16x4_t;
 #define simd_store_16(ptr, reg) vst1_f16(reinterpret_cast<float16_t *>(ptr), reg)
 #define simd_store1_16(ptr, reg) *ptr = c10::Half(vget_lane_u16(reg, 0), c10::Half::from_bits())
 
+#define simd_set1_32(val) vdupq_n_f32(val)
+#define simd_add_32(regA, regB) vaddq_f32(regA, regB)
+#define simd_sub_32(regA, regB) vsubq_f32(regA, regB)
+#define simd_mul_32(regA, regB) vmulq_f32(regA, regB)
+#define simd_div_32(regA, regB) vdivq_f32(regA, regB)
+#define simd_max_32(regA, regB) vmaxq_f32(regA, regB)
+
+// Loads kFloatsPerRegister int16 values, widened to float.
+#define simd_load_i16_32(ptr) vcvtq_f32_s32(vmovl_s16(vld1_s16(ptr)))
+
 #elif ENABLE_AVX2_IMPL
 
 // AVX registers have 8 floats.
@@ -58,6 +68,19 @@ using HalfRegister = __m128i;
     _mm_storeu_si128(reinterpret_cast<dorado::utils::simd::HalfRegister *>(ptr), reg)
 #define simd_store1_16(ptr, reg) *ptr = c10::Half(_mm_extract_epi16(reg, 0), c10::Half::from_bits())
 
+#define simd_store_32(ptr, reg) _mm256_storeu_ps(ptr, reg)
+#define simd_set1_32(val) _mm256_set1_ps(val)
+#define simd_add_32(regA, regB) _mm256_add_ps(regA, regB)
+#define simd_sub_32(regA, regB) _mm256_sub_ps(regA, regB)
+#define simd_mul_32(regA, regB) _mm256_mul_ps(regA, regB)
+#define simd_div_32(regA, regB) _mm256_div_ps(regA, regB)
+#define simd_max_32(regA, regB) _mm256_max_ps(regA, regB)
+
+// Loads kFloatsPerRegister int16 values, widened to float.
+#define simd_load_i16_32(ptr)                 \
+    _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32( \
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr))))
+
 #endif
 
 }  // namespace dorado::utils::simd
@@ -11,6 +11,7 @@
 
 struct bam1_t;
 struct htsFile;
+struct hts_tpool;
 struct mm_tbuf_s;
 struct sam_hdr_t;
 struct kstring_t;
@@ -162,6 +163,11 @@ struct HtsFileDestructor {
 };
 using HtsFilePtr = std::unique_ptr<htsFile, HtsFileDestructor>;
 
+struct HtsThreadPoolDestructor {
+    void operator()(hts_tpool *);
+};
+using HtsThreadPoolPtr = std::unique_ptr<hts_tpool, HtsThreadPoolDestructor>;
+
 /// Wrapper for htslib kstring_t struct.
 class KString {
 public:
@@ -140,4 +140,29 @@ TEST_CASE(TEST_GROUP ": process_and_pop_n") {
     std::iota(expected.begin(), expected.end(), 0);
     CHECK(popped_items == expected);
     CHECK(queue.size() == 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE(TEST_GROUP ": BatchPushPop") {
+    AsyncQueue<int> queue(4);
+    std::vector<int> pushed(10);
+    std::iota(pushed.begin(), pushed.end(), 0);
+
+    // The batch is larger than the queue, so it can only be pushed while another thread pops.
+    std::vector<int> popped;
+    auto popping_thread = std::thread([&]() {
+        std::vector<int> batch;
+        while (popped.size() < 10 && queue.try_pop_batch(batch, 3) == AsyncQueueStatus::Success) {
+            popped.insert(popped.end(), batch.begin(), batch.end());
+        }
+    });
+    auto batch = pushed;
+    const auto status = queue.try_push_batch(batch);
+    popping_thread.join();
+
+    CHECK(status == AsyncQueueStatus::Success);
+    CHECK(batch.empty());
+    CHECK(popped == pushed);
+    const auto stats = queue.sample_stats();
+    CHECK(stats.at("pushes") == 10);
+    CHECK(stats.at("pops") == 10);
+}
@@ -7,6 +7,7 @@
 #include <htslib/sam.h>
 
 #include <filesystem>
+#include <optional>
 #include <unordered_set>
 
 #define TEST_GROUP "[bam_utils][hts_reader]"
@@ -148,4 +149,31 @@ TEST_CASE("HtsReaderTest: filename tag added if missing", TEST_GROUP) {
     }
 }
 
+TEST_CASE("HtsReaderTest: Read SAM to sink with read limit and read list", TEST_GROUP) {
+    fs::path aligner_test_dir = fs::path(get_data_dir("bam_reader"));
+    auto sam = aligner_test_dir / "small.sam";
+    const auto [read_list, max_reads, expected_reads] =
+            GENERATE(table<std::optional<std::unordered_set<std::string>>, size_t, size_t>({
+                    {std::nullopt, 5, 5},
+                    {std::unordered_set<std::string>{"d7500028-dfcc-4404-b636-13edae804c55",
+                                                     "60588a89-f191-414e-b444-ad0815b7d9c9"},
+                     0, 2},
+            }));
+
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> bam_records;
+    pipeline_desc.add_node<MessageSinkToVector>({}, 100, bam_records);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+    dorado::HtsReader reader(sam.string(), read_list);
+    reader.set_decode_threads(2);
+    CHECK(reader.read(*pipeline, max_reads) == expected_reads);
+    pipeline.reset();
+    CHECK(bam_records.size() == expected_reads);
+
+    const auto stats = reader.sample_stats();
+    CHECK(stats.at("records_read") >= expected_reads);
+    CHECK(stats.at("batches_read_ahead") == 0);
+}
+
 }  // namespace dorado::hts_reader::test
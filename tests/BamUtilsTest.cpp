@@ -7,9 +7,11 @@
 #include <catch2/catch.hpp>
 #include <htslib/sam.h>
 
+#include <cstdint>
 #include <filesystem>
 #include <numeric>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -302,3 +304,94 @@ TEST_CASE("BamUtilsTest: Remove all alignment tags", TEST_GROUP) {
 
     CHECK(bam_aux_first(record) == nullptr);
 }
+
+TEST_CASE("BamUtilsTest: make_record_unmapped matches new_unmapped_record", TEST_GROUP) {
+    fs::path bam_utils_test_dir = fs::path(get_data_dir("bam_utils"));
+    auto sam = bam_utils_test_dir / "aligned_record.bam";
+
+    HtsReader reader(sam.string(), std::nullopt);
+    reader.set_add_filename_tag(false);
+    REQUIRE(reader.read());
+    auto record = reader.record.get();
+    REQUIRE(record->core.n_cigar > 0);
+
+    auto expected = utils::new_unmapped_record(record, {}, {});
+    utils::make_record_unmapped(record);
+
+    CHECK(record->core.flag == expected->core.flag);
+    CHECK(record->core.tid == expected->core.tid);
+    CHECK(record->core.pos == expected->core.pos);
+    CHECK(record->core.bin == expected->core.bin);
+    CHECK(record->core.qual == expected->core.qual);
+    CHECK(record->core.n_cigar == 0);
+    CHECK(record->core.mtid == expected->core.mtid);
+    CHECK(record->core.mpos == expected->core.mpos);
+    CHECK(record->core.isize == expected->core.isize);
+    CHECK(std::string(bam_get_qname(record)) == bam_get_qname(expected.get()));
+    CHECK(utils::extract_sequence(record) == utils::extract_sequence(expected.get()));
+    CHECK(utils::extract_quality(record) == utils::extract_quality(expected.get()));
+    CHECK(record->l_data == expected->l_data);
+}
+
+TEST_CASE("BamUtilsTest: trim_record_sequence trims in place", TEST_GROUP) {
+    const std::string seq = "ACGTTGCANCGTA";
+    const std::vector<uint8_t> qual = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13};
+    const std::string name = "read";
+    const int32_t tag_value = 42;
+
+    BamPtr record(bam_init1());
+    bam_set1(record.get(), name.size(), name.c_str(), 4, -1, -1, 0, 0, nullptr, -1, -1, 0,
+             seq.size(), seq.c_str(), reinterpret_cast<const char*>(qual.data()), 0);
+    bam_aux_append(record.get(), "xx", 'i', sizeof(tag_value),
+                   reinterpret_cast<const uint8_t*>(&tag_value));
+
+    // Intervals starting on both odd and even bases, and of both odd and even lengths.
+    const auto [start, end] = GENERATE(table<int, int>({{0, 13}, {0, 6}, {2, 9}, {1, 13}, {3, 8}}));
+    CAPTURE(start, end);
+    const auto data = record->data;
+    utils::trim_record_sequence(record.get(), {start, end});
+
+    CHECK(record->data == data);
+    CHECK(record->core.l_qseq == end - start);
+    CHECK(utils::extract_sequence(record.get()) == seq.substr(start, end - start));
+    CHECK(utils::extract_quality(record.get()) ==
+          std::vector<uint8_t>(qual.begin() + start, qual.begin() + end));
+    if ((end - start) % 2 != 0) {
+        // The unused half of the last byte is cleared.
+        CHECK((bam_get_seq(record.get())[(end - start) / 2] & 0xf) == 0);
+    }
+    auto tag = bam_aux_get(record.get(), "xx");
+    REQUIRE(tag != nullptr);
+    CHECK(bam_aux2i(tag) == tag_value);
+
+    CHECK_THROWS_AS(utils::trim_record_sequence(record.get(), {0, end - start + 1}),
+                    std::invalid_argument);
+}
+
+TEST_CASE("BamUtilsTest: remove_aux_array_elements", TEST_GROUP) {
+    BamPtr record(bam_init1());
+    const std::string name = "read";
+    bam_set1(record.get(), name.size(), name.c_str(), 4, -1, -1, 0, 0, nullptr, -1, -1, 0, 4,
+             "ACGT", nullptr, 0);
+    std::vector<int16_t> values = {0, 1, 2, 3, 4, 5};
+    bam_aux_update_array(record.get(), "xa", 's', uint32_t(values.size()), values.data());
+    const std::string trailing = "after";
+    bam_aux_append(record.get(), "xz", 'Z', int(trailing.size() + 1),
+                   reinterpret_cast<const uint8_t*>(trailing.c_str()));
+    const int l_data = record->l_data;
+
+    auto array = bam_aux_get(record.get(), "xa");
+    utils::remove_aux_array_elements(record.get(), array, 1, 2);
+    utils::remove_aux_array_elements(record.get(), array, 3, 0);
+
+    REQUIRE(bam_auxB_len(array) == 4);
+    std::vector<int64_t> remaining;
+    for (uint32_t i = 0; i < bam_auxB_len(array); ++i) {
+        remaining.push_back(bam_auxB2i(array, i));
+    }
+    CHECK(remaining == std::vector<int64_t>{0, 3, 4, 5});
+    CHECK(record->l_data == l_data - 2 * int(sizeof(int16_t)));
+    CHECK(std::string(bam_aux2Z(bam_aux_get(record.get(), "xz"))) == trailing);
+
+    CHECK_THROWS_AS(utils::remove_aux_array_elements(record.get(), array, 3, 2), std::out_of_range);
+}
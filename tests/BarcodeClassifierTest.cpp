@@ -530,4 +530,41 @@ TEST_CASE("BarcodeClassifier: test custom kit with double ended barcode", TEST_G
     }
 }
 
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE("BarcodeClassifier: classification throughput by kit size", TEST_GROUP) {
+    // Each kit is benchmarked against reads from its own family so that the per-read cost
+    // reflects the number of barcodes in the kit.
+    const auto [kit_name, data_subdir, barcode_both_ends] =
+            GENERATE(table<std::string, std::string, bool>({
+                    {"SQK-RBK114-24", "barcode_demux/single_end", false},
+                    {"SQK-RBK114-96", "barcode_demux/single_end", false},
+                    {"EXP-PBC001", "barcode_demux/double_end_variant", true},
+                    {"EXP-PBC096", "barcode_demux/double_end_variant", true},
+            }));
+    CAPTURE(kit_name);
+
+    std::vector<std::string> reads;
+    for (const auto& entry : fs::directory_iterator(get_data_dir(data_subdir))) {
+        if (entry.path().extension() != ".fastq") {
+            continue;
+        }
+        HtsReader reader(entry.path().string(), std::nullopt);
+        while (reader.read()) {
+            reads.push_back(utils::extract_sequence(reader.record.get()));
+        }
+    }
+    REQUIRE(!reads.empty());
+
+    demux::BarcodeClassifier classifier(kit_name);
+    BENCHMARK(kit_name + ": " + std::to_string(reads.size()) + " reads") {
+        size_t num_classified = 0;
+        for (const auto& seq : reads) {
+            auto res = classifier.barcode(seq, barcode_both_ends, std::nullopt);
+            num_classified += res.barcode_name != dorado::UNCLASSIFIED;
+        }
+        return num_classified;
+    };
+}
+#endif  // CATCH_CONFIG_ENABLE_BENCHMARKING
+
 }  // namespace dorado::barcode_classifier_test
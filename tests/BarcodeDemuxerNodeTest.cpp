@@ -12,6 +12,7 @@
 #include <catch2/catch.hpp>
 #include <htslib/sam.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <filesystem>
 #include <string>
@@ -89,3 +90,55 @@ TEST_CASE("BarcodeDemuxerNode: check correct output files are created", TEST_GRO
         }
     }
 }
+
+TEST_CASE("BarcodeDemuxerNode: sharded writers write every record to its barcode's file",
+          TEST_GROUP) {
+    auto tmp_dir = make_temp_dir("dorado_demuxer_sharded");
+    const std::vector<std::string> barcodes = {"bc01", "bc02", "bc03", "bc04", "bc05", "bc06"};
+    const int records_per_barcode = 10;
+
+    {
+        dorado::PipelineDescriptor pipeline_desc;
+        auto demuxer = pipeline_desc.add_node<BarcodeDemuxerNode>({}, tmp_dir.m_path.string(), 8,
+                                                                  false, nullptr, true, 3);
+
+        auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+        SamHdrPtr hdr(sam_hdr_init());
+        sam_hdr_add_line(hdr.get(), "SQ", "ID", "foo", "LN", "100", "SN", "ref", NULL);
+
+        auto& demux_writer_ref = dynamic_cast<BarcodeDemuxerNode&>(pipeline->get_node_ref(demuxer));
+        demux_writer_ref.set_header(hdr.get());
+
+        auto client_info = std::make_shared<dorado::DefaultClientInfo>();
+        for (int i = 0; i < records_per_barcode; ++i) {
+            for (const auto& bc : barcodes) {
+                for (auto& rec : create_bam_reader(bc)) {
+                    pipeline->push_message(BamMessage{std::move(rec), client_info});
+                }
+            }
+        }
+
+        pipeline->terminate(DefaultFlushOptions());
+
+        std::vector<size_t> progress_updates;
+        demux_writer_ref.finalise_hts_files(
+                [&progress_updates](size_t progress) { progress_updates.push_back(progress); });
+        CHECK(std::is_sorted(progress_updates.begin(), progress_updates.end()));
+        CHECK(progress_updates.back() == 100);
+    }
+
+    for (const auto& bc : barcodes) {
+        const auto filename = tmp_dir.m_path / ("unknown_run_id_" + bc + ".bam");
+        REQUIRE(fs::exists(filename));
+        CHECK(fs::exists(filename.string() + ".bai"));
+
+        HtsReader reader(filename.string(), std::nullopt);
+        int num_records = 0;
+        while (reader.read()) {
+            CHECK(bam_aux2Z(bam_aux_get(reader.record.get(), "BC")) == bc);
+            ++num_records;
+        }
+        CHECK(num_records == records_per_barcode);
+    }
+}
@@ -0,0 +1,49 @@
+#include "basecall/decode/CPUDecoder.h"
+
+#include <torch/torch.h>
+// Catch2 must come after torch since both define CHECK()
+#include <catch2/catch.hpp>
+
+#define CUT_TAG "[CPUDecoder]"
+
+using namespace dorado::basecall::decode;
+
+namespace {
+
+at::Tensor random_scores(int64_t num_timesteps, int64_t batch_size, int state_len) {
+    const int64_t num_states = int64_t(1) << (2 * state_len);
+    return torch::randn({num_timesteps, batch_size, num_states * 4}, {torch::kFloat}) * 2.f;
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": scan matches ATen reference", CUT_TAG) {
+    torch::manual_seed(42);
+    auto state_len = GENERATE(3, 4);
+    auto stay_score = GENERATE(0.f, 2.f);
+    CAPTURE(state_len, stay_score);
+
+    const auto scores = random_scores(100, 3, state_len);
+
+    auto fwd = inner::forward_scores(scores, stay_score);
+    auto fwd_ref = inner::forward_scores_aten(scores, stay_score);
+    REQUIRE(fwd.sizes() == fwd_ref.sizes());
+    CHECK(torch::allclose(fwd, fwd_ref, 1e-4, 1e-3));
+
+    auto bwd = inner::backward_scores(scores, stay_score);
+    auto bwd_ref = inner::backward_scores_aten(scores, stay_score);
+    REQUIRE(bwd.sizes() == bwd_ref.sizes());
+    CHECK(torch::allclose(bwd, bwd_ref, 1e-4, 1e-3));
+}
+
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE(CUT_TAG ": scan benchmark", CUT_TAG) {
+    torch::manual_seed(42);
+    const auto scores = random_scores(1000, 1, 5);
+
+    BENCHMARK("forward_scores") { return inner::forward_scores(scores, 2.f); };
+    BENCHMARK("forward_scores_aten") { return inner::forward_scores_aten(scores, 2.f); };
+    BENCHMARK("backward_scores") { return inner::backward_scores(scores, 2.f); };
+    BENCHMARK("backward_scores_aten") { return inner::backward_scores_aten(scores, 2.f); };
+}
+#endif  // CATCH_CONFIG_ENABLE_BENCHMARKING
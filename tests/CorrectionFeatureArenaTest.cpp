@@ -0,0 +1,168 @@
+#include "correct/feature_arena.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define TEST_GROUP "[CorrectionFeatureArena]"
+
+namespace dorado::correction::feature_arena_test {
+
+namespace {
+
+struct BatchCollector {
+    void operator()(FeatureBatch&& batch) {
+        std::lock_guard<std::mutex> lock(mutex);
+        batches.push_back(std::move(batch));
+    }
+    std::mutex mutex;
+    std::vector<FeatureBatch> batches;
+};
+
+}  // namespace
+
+TEST_CASE(TEST_GROUP ": Windows are written straight into padded batches") {
+    BatchCollector collector;
+    FeatureArena arena(4, false, std::ref(collector));
+
+    const int length = 300;
+    const int padded_length = 512;
+    std::vector<WindowFeatures> windows(4);
+    for (int i = 0; i < 4; ++i) {
+        arena.acquire(windows[i], length);
+        REQUIRE(windows[i].bases.sizes()[0] == length);
+        REQUIRE(windows[i].bases.sizes()[1] == NUM_FEATURE_ROWS);
+        windows[i].window_idx = i;
+        windows[i].bases.data_ptr<int>()[0] = i;
+        windows[i].quals.data_ptr<float>()[0] = float(i);
+    }
+    // The columns beyond the end of the window are padded.
+    CHECK(windows[0].bases.data_ptr<int>()[length * NUM_FEATURE_ROWS] == FEATURE_BASES_PAD);
+    CHECK(windows[0].quals.data_ptr<float>()[length * NUM_FEATURE_ROWS] == FEATURE_QUALS_PAD);
+
+    for (int i = 0; i < 3; ++i) {
+        arena.commit(std::move(windows[i]));
+    }
+    CHECK(collector.batches.empty());
+    arena.commit(std::move(windows[3]));
+
+    REQUIRE(collector.batches.size() == 1);
+    const auto& batch = collector.batches.front();
+    REQUIRE(batch.windows.size() == 4);
+    REQUIRE(batch.bases.sizes() == std::vector<int64_t>{4, padded_length, NUM_FEATURE_ROWS});
+    REQUIRE(batch.quals.sizes() == std::vector<int64_t>{4, padded_length, NUM_FEATURE_ROWS});
+    for (int i = 0; i < 4; ++i) {
+        CHECK(batch.windows[i].window_idx == i);
+        CHECK(batch.bases.data_ptr<int>()[i * padded_length * NUM_FEATURE_ROWS] == i);
+        CHECK(batch.quals.data_ptr<float>()[i * padded_length * NUM_FEATURE_ROWS] == float(i));
+    }
+
+    const auto stats = arena.sample_stats();
+    CHECK(stats.at("feature_arena_batches") == 1);
+    CHECK(stats.at("feature_arena_batch_occupancy") == 1.0);
+}
+
+TEST_CASE(TEST_GROUP ": Released windows are left out of the batch") {
+    BatchCollector collector;
+    FeatureArena arena(4, false, std::ref(collector));
+
+    std::vector<WindowFeatures> windows(4);
+    for (int i = 0; i < 4; ++i) {
+        arena.acquire(windows[i], 100);
+        windows[i].window_idx = i;
+        windows[i].bases.data_ptr<int>()[0] = i;
+    }
+    arena.commit(std::move(windows[0]));
+    arena.release(windows[1]);
+    CHECK_FALSE(windows[1].bases.defined());
+    arena.commit(std::move(windows[3]));
+    arena.commit(std::move(windows[2]));
+
+    REQUIRE(collector.batches.size() == 1);
+    const auto& batch = collector.batches.front();
+    REQUIRE(batch.windows.size() == 3);
+    REQUIRE(batch.bases.sizes()[0] == 3);
+    const std::vector<int> expected{0, 2, 3};
+    for (int i = 0; i < 3; ++i) {
+        CHECK(batch.windows[i].window_idx == expected[i]);
+        CHECK(batch.bases.data_ptr<int>()[i * 256 * NUM_FEATURE_ROWS] == expected[i]);
+    }
+}
+
+TEST_CASE(TEST_GROUP ": Flushing returns the partially filled batches") {
+    BatchCollector collector;
+    FeatureArena arena(4, false, std::ref(collector));
+
+    WindowFeatures committed;
+    arena.acquire(committed, 1000);
+    arena.commit(std::move(committed));
+
+    WindowFeatures in_flight;
+    arena.acquire(in_flight, 3000);
+
+    auto batches = arena.flush();
+    REQUIRE(batches.size() == 1);
+    CHECK(batches.front().windows.size() == 1);
+    CHECK(batches.front().bases.sizes()[1] == 1024);
+
+    // The window still being written is sent once it's committed.
+    CHECK(collector.batches.empty());
+    arena.commit(std::move(in_flight));
+    REQUIRE(collector.batches.size() == 1);
+    CHECK(collector.batches.front().bases.sizes()[1] == 3072);
+}
+
+TEST_CASE(TEST_GROUP ": Slabs are reused once their batches are dropped") {
+    BatchCollector collector;
+    FeatureArena arena(2, false, std::ref(collector));
+
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 2; ++i) {
+            WindowFeatures wf;
+            arena.acquire(wf, 500);
+            arena.commit(std::move(wf));
+        }
+        REQUIRE(collector.batches.size() == 1);
+        collector.batches.clear();
+    }
+    CHECK(arena.sample_stats().at("feature_arena_slabs") == 1);
+}
+
+TEST_CASE(TEST_GROUP ": Concurrent windows are all batched") {
+    std::atomic<size_t> num_batched{0};
+    FeatureArena arena(8, false, [&num_batched](FeatureBatch&& batch) {
+        num_batched += batch.windows.size();
+    });
+
+    const int num_threads = 4;
+    const int num_windows = 500;
+    std::atomic<size_t> num_committed{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < num_windows; ++i) {
+                WindowFeatures wf;
+                arena.acquire(wf, 100 + (i * 37 + t) % 900);
+                if (i % 5 == 0) {
+                    arena.release(wf);
+                } else {
+                    arena.commit(std::move(wf));
+                    ++num_committed;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& batch : arena.flush()) {
+        num_batched += batch.windows.size();
+    }
+    CHECK(num_batched == num_committed);
+}
+
+}  // namespace dorado::correction::feature_arena_test
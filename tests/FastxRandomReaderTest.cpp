@@ -1,4 +1,5 @@
 #include "hts_io/FastxRandomReader.h"
+#include "hts_io/ReadNameTable.h"
 
 #include "TestUtils.h"
 #include "read_pipeline/HtsWriter.h"
@@ -68,3 +69,36 @@ TEST_CASE("Check if a read can be loaded correctly from FASTQ input.", "FastxRan
     CHECK(reader.fetch_seq(read_id) == seq);
     CHECK(reader.fetch_qual(read_id) == qscore);
 }
+
+TEST_CASE("Check that reads are given IDs in the order of the index.", "FastxRandomReader") {
+    auto temp_dir = tests::make_temp_dir("fastx_random_reader_test");
+    auto temp_input_file = temp_dir.m_path / "input.fq";
+
+    const std::vector<std::string> read_ids = {"read1", "read0", "read2"};
+    const std::string seq = "ACTGATCG";
+    const std::vector<uint8_t> qscore = {20, 20, 30, 30, 20, 20, 40, 40};
+
+    // Write temporary file.
+    {
+        utils::HtsFile hts_file(temp_input_file.string(), utils::HtsFile::OutputMode::FASTQ, 2,
+                                false);
+        HtsWriter writer(hts_file, "");
+        for (const auto& read_id : read_ids) {
+            auto rec = generate_bam_entry(read_id, seq, qscore);
+            writer.write(rec.get());
+        }
+        hts_file.finalise([](size_t) { /* noop */ });
+    }
+
+    hts_io::FastxRandomReader reader(temp_input_file.string());
+    hts_io::ReadNameTable read_names(temp_input_file.string());
+    REQUIRE(read_names.size() == 3);
+    for (int32_t id = 0; id < 3; ++id) {
+        CHECK(reader.read_name(id) == read_ids[id]);
+        CHECK(read_names.name(id) == read_ids[id]);
+        CHECK(read_names.find(read_ids[id]) == id);
+    }
+    CHECK(read_names.find("read3") == -1);
+    CHECK_THROWS_AS(read_names.name(3), std::out_of_range);
+    CHECK_THROWS_AS(reader.read_name(-1), std::out_of_range);
+}
@@ -146,6 +146,19 @@ TEST_CASE("HtsFileTest: Write to multiple sorted files, and merge", TEST_GROUP)
     tester.check_output(true);
 }
 
+TEST_CASE("HtsFileTest: Write sorted files with records larger than the buffer, and merge",
+          TEST_GROUP) {
+    Tester tester;
+    tester.read_input_records();
+
+    // The minimum 100 KB buffer is split between the filling and spilling halves, so some of the
+    // test records won't fit in a buffer and are written to temp files of their own.
+    int callback_calls = tester.write_output_records(100000);
+    REQUIRE(callback_calls > 4);
+
+    tester.check_output(true);
+}
+
 TEST_CASE("HtsFileTest: construct with zero threads for sorted BAM does not throw", TEST_GROUP) {
     Tester tester;
     std::unique_ptr<HtsFile> cut{};
@@ -0,0 +1,207 @@
+#include "utils/MPMCQueue.h"
+
+#include <catch2/catch.hpp>
+
+#define TEST_GROUP "MPMCQueue "
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using dorado::utils::AsyncQueueStatus;
+using dorado::utils::MPMCQueue;
+
+TEST_CASE(TEST_GROUP ": InputsMatchOutputs") {
+    const int n = 10;
+    MPMCQueue<int> queue(n);
+
+    for (int i = 0; i < n; ++i) {
+        int ii = i;
+        const auto status = queue.try_push(std::move(ii));
+        REQUIRE(status == AsyncQueueStatus::Success);
+    }
+    CHECK(queue.size() == n);
+    for (int i = 0; i < n; ++i) {
+        int val = -1;
+        const auto status = queue.try_pop(val);
+        REQUIRE(status == AsyncQueueStatus::Success);
+        CHECK(val == i);
+    }
+    CHECK(queue.size() == 0);
+}
+
+TEST_CASE(TEST_GROUP ": PushFailsIfTerminating") {
+    MPMCQueue<int> queue(1);
+    queue.terminate();
+    const auto status = queue.try_push(42);
+    CHECK(status == AsyncQueueStatus::Terminate);
+}
+
+TEST_CASE(TEST_GROUP ": PopSucceedsUntilEmptyIfTerminating") {
+    MPMCQueue<int> queue(2);
+    REQUIRE(queue.try_push(42) == AsyncQueueStatus::Success);
+    queue.terminate();
+    int val = -1;
+    CHECK(queue.try_pop(val) == AsyncQueueStatus::Success);
+    CHECK(val == 42);
+    CHECK(queue.try_pop(val) == AsyncQueueStatus::Terminate);
+}
+
+TEST_CASE(TEST_GROUP ": PushPopSucceedAfterRestarting") {
+    MPMCQueue<int> queue(1);
+    queue.terminate();
+    queue.restart();
+    const auto push_status = queue.try_push(42);
+    CHECK(push_status == AsyncQueueStatus::Success);
+    int val;
+    const auto pop_status = queue.try_pop(val);
+    CHECK(pop_status == AsyncQueueStatus::Success);
+}
+
+TEST_CASE(TEST_GROUP ": PopTimesOut") {
+    MPMCQueue<int> queue(1);
+    int val = -1;
+    const auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+    CHECK(queue.try_pop_until(val, timeout) == AsyncQueueStatus::Timeout);
+}
+
+// Spawned thread sits waiting for an item.
+// Main thread terminates wait.
+TEST_CASE(TEST_GROUP ": TerminateFromOtherThread") {
+    MPMCQueue<int> queue(1);
+    std::atomic_bool thread_started{false};
+    AsyncQueueStatus pop_status;
+
+    auto popping_thread = std::thread([&]() {
+        thread_started.store(true);
+        int val = -1;
+        // catch2 isn't thread safe so we have to check this on the main thread
+        pop_status = queue.try_pop(val);
+    });
+
+    // Wait for thread to start, and give it time to go to sleep.
+    while (!thread_started.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    queue.terminate();
+    popping_thread.join();
+    CHECK(pop_status == AsyncQueueStatus::Terminate);
+}
+
+TEST_CASE(TEST_GROUP ": BatchPushPop") {
+    MPMCQueue<int> queue(8);
+    std::vector<int> pushed(5);
+    std::iota(pushed.begin(), pushed.end(), 0);
+
+    auto batch = pushed;
+    REQUIRE(queue.try_push_batch(batch) == AsyncQueueStatus::Success);
+    CHECK(batch.empty());
+
+    // Batch pops take as many items as are available, up to the limit.
+    std::vector<int> popped;
+    REQUIRE(queue.try_pop_batch(popped, 3) == AsyncQueueStatus::Success);
+    CHECK(popped == std::vector<int>{0, 1, 2});
+    REQUIRE(queue.try_pop_batch(popped, 3) == AsyncQueueStatus::Success);
+    CHECK(popped == std::vector<int>{3, 4});
+
+    queue.terminate();
+    CHECK(queue.try_pop_batch(popped, 3) == AsyncQueueStatus::Terminate);
+    CHECK(popped.empty());
+}
+
+TEST_CASE(TEST_GROUP ": UnpoppedItemsAreDestroyed") {
+    auto item = std::make_shared<int>(42);
+    {
+        MPMCQueue<std::shared_ptr<int>> queue(4);
+        auto copy = item;
+        REQUIRE(queue.try_push(std::move(copy)) == AsyncQueueStatus::Success);
+        CHECK(item.use_count() == 2);
+    }
+    CHECK(item.use_count() == 1);
+}
+
+TEST_CASE(TEST_GROUP ": ConcurrentProducersAndConsumers") {
+    // A small queue, so that both producers and consumers have to wait.
+    MPMCQueue<int> queue(7);
+    const int num_producers = 4;
+    const int num_consumers = 3;
+    const int num_items = 20000;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p) {
+        producers.emplace_back([&queue, p]() {
+            std::vector<int> batch;
+            for (int i = 0; i < num_items; ++i) {
+                // Mix single and batch pushes.
+                const int item = p * num_items + i;
+                if (p % 2 == 0) {
+                    int ii = item;
+                    queue.try_push(std::move(ii));
+                } else {
+                    batch.push_back(item);
+                    if (batch.size() == 5 || i == num_items - 1) {
+                        queue.try_push_batch(batch);
+                    }
+                }
+            }
+        });
+    }
+
+    std::vector<std::vector<int>> consumed(num_consumers);
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < num_consumers; ++c) {
+        consumers.emplace_back([&queue, &items = consumed[c], c]() {
+            std::vector<int> batch;
+            int item = -1;
+            while (true) {
+                if (c == 0) {
+                    if (queue.try_pop(item) != AsyncQueueStatus::Success) {
+                        break;
+                    }
+                    items.push_back(item);
+                } else {
+                    if (queue.try_pop_batch(batch, 4) != AsyncQueueStatus::Success) {
+                        break;
+                    }
+                    items.insert(items.end(), batch.begin(), batch.end());
+                }
+            }
+        });
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    queue.terminate();
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    // Every item is popped exactly once, and each consumer sees the items of each producer
+    // in the order they were pushed.
+    std::vector<int> all_items;
+    for (const auto& items : consumed) {
+        std::vector<int> last_seen(num_producers, -1);
+        bool in_order = true;
+        for (const int item : items) {
+            in_order &= item > last_seen[item / num_items];
+            last_seen[item / num_items] = item;
+        }
+        CHECK(in_order);
+        all_items.insert(all_items.end(), items.begin(), items.end());
+    }
+    std::sort(all_items.begin(), all_items.end());
+    std::vector<int> expected(num_producers * num_items);
+    std::iota(expected.begin(), expected.end(), 0);
+    CHECK(all_items == expected);
+
+    const auto stats = queue.sample_stats();
+    CHECK(stats.at("pushes") == num_producers * num_items);
+    CHECK(stats.at("pops") == num_producers * num_items);
+}
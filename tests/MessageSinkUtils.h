@@ -2,6 +2,7 @@
 
 #include "data_loader/DataLoader.h"
 #include "read_pipeline/ReadPipeline.h"
+#include "utils/read_id_set.h"
 
 #include <memory>
 #include <stdexcept>
@@ -62,8 +63,12 @@ inline size_t CountSinkReads(const std::filesystem::path& data_path,
     pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
     auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
 
+    std::optional<dorado::utils::ReadIdSet> read_id_list;
+    if (read_list.has_value()) {
+        read_id_list.emplace(*read_list);
+    }
     dorado::DataLoader loader(*pipeline, device, num_worker_threads, max_reads,
-                              std::move(read_list), std::move(read_ignore_list));
+                              std::move(read_id_list), dorado::utils::ReadIdSet(read_ignore_list));
     auto input_files = dorado::DataLoader::InputFiles::search(data_path, false);
     if (!input_files.has_value()) {
         throw std::runtime_error("No files in " + data_path.string());
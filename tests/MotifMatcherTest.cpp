@@ -4,6 +4,10 @@
 
 #include <catch2/catch.hpp>
 
+#include <random>
+#include <regex>
+#include <unordered_map>
+
 #define TEST_GROUP "[modbase_motif_matcher]"
 
 using std::make_tuple;
@@ -21,6 +25,48 @@ const std::string SEQ = "AACCGGTTACGTGGACTGACACTAAA";
 //                      "            DRACH         "
 //                      "                DRACH     "
 // clang-format on
+
+// Reference implementation using std::regex, matching the original motif search.
+std::vector<size_t> regex_motif_hits(const std::string& motif,
+                                     size_t motif_offset,
+                                     std::string_view seq) {
+    const std::unordered_map<char, std::string> iupac_codes = {
+            // clang-format off
+            {'A', "A"}, {'C', "C"}, {'G', "G"}, {'T', "T"}, {'U', "T"},
+            {'R', "[AG]"}, {'Y', "[CT]"}, {'S', "[GC]"}, {'W', "[AT]"}, {'K', "[GT]"}, {'M', "[AC]"},
+            {'B', "[CGT]"}, {'D', "[AGT]"}, {'H', "[ACT]"}, {'V', "[ACG]"}, {'N', "[ACGT]"},
+            // clang-format on
+    };
+    std::string motif_regex = "(";
+    for (auto base : motif) {
+        motif_regex += iupac_codes.at(base);
+    }
+    motif_regex += ")";
+
+    std::vector<size_t> context_hits;
+    std::regex regex(motif_regex);
+    auto start = std::cbegin(seq);
+    auto end = std::cend(seq);
+    auto pos = start;
+    std::match_results<decltype(pos)> motif_match;
+    while (std::regex_search(pos, end, motif_match, regex)) {
+        auto hit = std::distance(start, pos) + motif_match.position(0) + motif_offset;
+        context_hits.push_back(hit);
+        pos += motif_match.position(0) + 1;
+    }
+    return context_hits;
+}
+
+std::string random_sequence(size_t length, std::string_view alphabet, uint32_t seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> dist(0, alphabet.size() - 1);
+    std::string seq(length, 'A');
+    for (auto& base : seq) {
+        base = alphabet[dist(gen)];
+    }
+    return seq;
+}
+
 }  // namespace
 
 TEST_CASE(TEST_GROUP ": test motifs", TEST_GROUP) {
@@ -42,3 +88,42 @@ TEST_CASE(TEST_GROUP ": test motifs", TEST_GROUP) {
     auto hits = matcher.get_motif_hits(SEQ);
     CHECK(hits == expected_results);
 }
+
+TEST_CASE(TEST_GROUP ": matches regex reference", TEST_GROUP) {
+    auto [motif, motif_offset] = GENERATE(table<std::string, size_t>({
+            make_tuple("CG", 0),
+            make_tuple("A", 0),
+            make_tuple("AA", 1),
+            make_tuple("GATC", 1),
+            make_tuple("DRACH", 2),
+            make_tuple("NNCGNN", 2),
+            make_tuple("UA", 0),
+    }));
+    // Include non-ACGT characters to check they never match.
+    const auto seq = random_sequence(5000, "ACGTACGTACGTN", 42);
+
+    CAPTURE(motif);
+    CAPTURE(motif_offset);
+    dorado::modbase::MotifMatcher matcher(motif, motif_offset);
+    CHECK(matcher.get_motif_hits(seq) == regex_motif_hits(motif, motif_offset, seq));
+}
+
+TEST_CASE(TEST_GROUP ": invalid motifs", TEST_GROUP) {
+    CHECK_THROWS(dorado::modbase::MotifMatcher("", 0));
+    CHECK_THROWS(dorado::modbase::MotifMatcher(std::string(65, 'A'), 0));
+    CHECK_THROWS(dorado::modbase::MotifMatcher("CX", 0));
+}
+
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE(TEST_GROUP ": motif matcher benchmark", TEST_GROUP) {
+    const auto size = GENERATE(1'000, 10'000, 100'000);
+    CAPTURE(size);
+
+    const auto seq = random_sequence(size, "ACGT", 42);
+    const std::string motif = "DRACH";
+    dorado::modbase::MotifMatcher matcher(motif, 2);
+
+    BENCHMARK("regex " + std::to_string(size)) { return regex_motif_hits(motif, 2, seq); };
+    BENCHMARK("shift-and " + std::to_string(size)) { return matcher.get_motif_hits(seq); };
+}
+#endif  // CATCH_CONFIG_ENABLE_BENCHMARKING
@@ -96,3 +96,185 @@ TEST_CASE("PafUtilsTest: Test serialize_to_paf", TEST_GROUP) {
         CHECK(expected == oss.str());
     }
 }
+
+TEST_CASE("PafUtilsTest: Test parse_paf_view matches parse_paf", TEST_GROUP) {
+    const std::filesystem::path paf_utils_test_dir = get_data_dir("paf_utils");
+    const std::filesystem::path paf = paf_utils_test_dir / "test.paf";
+
+    std::ifstream file(paf.string());
+    REQUIRE(file.is_open());
+    dorado::utils::PafReader reader(paf.string());
+
+    std::string line;
+    size_t num_lines = 0;
+    while (std::getline(file, line)) {
+        const dorado::utils::PafEntry expected = dorado::utils::parse_paf(line);
+        const auto view = reader.next_record();
+        REQUIRE(view.has_value());
+        CHECK(view->qname == expected.qname);
+        CHECK(view->qlen == expected.qlen);
+        CHECK(view->qstart == expected.qstart);
+        CHECK(view->qend == expected.qend);
+        CHECK(view->strand == expected.strand);
+        CHECK(view->tname == expected.tname);
+        CHECK(view->tlen == expected.tlen);
+        CHECK(view->tstart == expected.tstart);
+        CHECK(view->tend == expected.tend);
+        CHECK(view->num_residue_matches == expected.num_residue_matches);
+        CHECK(view->alignment_block_length == expected.alignment_block_length);
+        CHECK(view->mapq == expected.mapq);
+        CHECK(view->aux == expected.aux);
+        CHECK(dorado::utils::paf_aux_get(view->aux, "cg", 'Z') ==
+              dorado::utils::paf_aux_get(expected, "cg", 'Z'));
+        ++num_lines;
+    }
+    CHECK_FALSE(reader.next_record().has_value());
+    CHECK(reader.num_records() == num_lines);
+}
+
+TEST_CASE("PafUtilsTest: Test PafReader with CRLF line endings", TEST_GROUP) {
+    const auto temp_dir = make_temp_dir("paf_utils_crlf");
+    const auto paf_path = temp_dir.m_path / "crlf.paf";
+    std::ofstream(paf_path.string(), std::ios::binary)
+            << "q1\t200\t0\t100\t+\tt\t500\t300\t400\t1\t2\t3\r\n"
+            << "\r\n"
+            << "q2\t200\t0\t100\t-\tt\t500\t300\t400\t1\t2\t60\tcg:Z:100=\r\n";
+
+    dorado::utils::PafReader reader(paf_path.string());
+    auto entry = reader.next_record();
+    REQUIRE(entry.has_value());
+    CHECK(entry->qname == "q1");
+    CHECK(entry->mapq == 3);
+    CHECK(entry->aux.empty());
+
+    entry = reader.next_record();
+    REQUIRE(entry.has_value());
+    CHECK(entry->qname == "q2");
+    CHECK(entry->mapq == 60);
+    CHECK(entry->aux == "cg:Z:100=");
+
+    CHECK_FALSE(reader.next_record().has_value());
+    CHECK(reader.num_records() == 2);
+}
+
+TEST_CASE("PafUtilsTest: Test parse_paf_view rejects invalid records", TEST_GROUP) {
+    const std::string valid = "q\t200\t0\t100\t+\tt\t500\t300\t400\t1\t2\t3";
+    CHECK(dorado::utils::parse_paf_view(valid).has_value());
+    CHECK(dorado::utils::parse_paf_view(valid + "\tcg:Z:100=")->aux == "cg:Z:100=");
+
+    const auto invalid = GENERATE(as<std::string>{}, "",
+                                  "q\t200\t0\t100\t+\tt\t500\t300\t400\t1\t2",
+                                  "q\t200\t0\t1x0\t+\tt\t500\t300\t400\t1\t2\t3",
+                                  "q\t200\t0\t100\t+-\tt\t500\t300\t400\t1\t2\t3",
+                                  "\t200\t0\t100\t+\tt\t500\t300\t400\t1\t2\t3");
+    CAPTURE(invalid);
+    CHECK_FALSE(dorado::utils::parse_paf_view(invalid).has_value());
+}
+
+TEST_CASE("PafUtilsTest: Test PafWriter matches serialize_to_paf", TEST_GROUP) {
+    dorado::utils::Overlap ovl;
+    ovl.qstart = 0;
+    ovl.qend = 100;
+    ovl.qlen = 200;
+    ovl.tstart = 300;
+    ovl.tend = 400;
+    ovl.tlen = 500;
+
+    const std::vector<dorado::CigarOp> cigar = {
+            {dorado::CigarOpType::EQ, 50},
+            {dorado::CigarOpType::I, 1},
+            {dorado::CigarOpType::X, 49},
+    };
+
+    // A small flush size means the buffer is written out part way through.
+    const auto flush_size =
+            GENERATE(size_t{1}, size_t{100}, dorado::utils::PafWriter::DEFAULT_FLUSH_SIZE);
+    CAPTURE(flush_size);
+
+    std::ostringstream expected;
+    std::ostringstream oss;
+    {
+        dorado::utils::PafWriter writer(oss, flush_size);
+        for (int i = 0; i < 10; ++i) {
+            ovl.fwd = (i % 2) == 0;
+            const auto& record_cigar = (i % 3) == 0 ? std::vector<dorado::CigarOp>{} : cigar;
+            const std::string qname = "query" + std::to_string(i);
+            dorado::utils::serialize_to_paf(expected, qname, "target", ovl, i, 2 * i, 60,
+                                            record_cigar);
+            expected << '\n';
+            writer.write(qname, "target", ovl, i, 2 * i, 60, record_cigar);
+        }
+    }
+    CHECK(oss.str() == expected.str());
+}
+
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE("PafUtilsTest: PAF parsing and writing throughput", TEST_GROUP) {
+    // Build a PAF of alignments with realistic CIGAR strings in memory, so that the benchmark
+    // measures parsing and formatting rather than the disk.
+    constexpr int num_records = 20000;
+    std::vector<dorado::CigarOp> cigar;
+    for (uint32_t i = 0; i < 200; ++i) {
+        cigar.push_back({dorado::CigarOpType::EQ, 40 + (i % 7)});
+        cigar.push_back({(i % 2) ? dorado::CigarOpType::I : dorado::CigarOpType::X, 1 + (i % 3)});
+    }
+    dorado::utils::Overlap ovl{};
+    ovl.qlen = 12000;
+    ovl.qend = 11000;
+    ovl.tlen = 15000;
+    ovl.tstart = 2000;
+    ovl.tend = 13000;
+
+    std::ostringstream paf_stream;
+    for (int i = 0; i < num_records; ++i) {
+        ovl.fwd = (i % 2) == 0;
+        dorado::utils::serialize_to_paf(paf_stream, "query_" + std::to_string(i),
+                                        "target_" + std::to_string(i / 100), ovl, 0, 0, 60,
+                                        cigar);
+        paf_stream << '\n';
+    }
+    const std::string paf = paf_stream.str();
+    const auto temp_dir = make_temp_dir("paf_utils_benchmark");
+    const auto paf_path = temp_dir.m_path / "bench.paf";
+    std::ofstream(paf_path.string()) << paf;
+
+    BENCHMARK("parse_paf: " + std::to_string(num_records) + " records") {
+        std::istringstream file(paf);
+        std::string line;
+        size_t num_cigar_ops = 0;
+        while (std::getline(file, line)) {
+            const auto entry = dorado::utils::parse_paf(line);
+            num_cigar_ops += dorado::utils::paf_aux_get(entry, "cg", 'Z').size();
+        }
+        return num_cigar_ops;
+    };
+
+    BENCHMARK("PafReader: " + std::to_string(num_records) + " records") {
+        dorado::utils::PafReader reader(paf_path.string());
+        size_t num_cigar_ops = 0;
+        while (const auto entry = reader.next_record()) {
+            num_cigar_ops += dorado::utils::paf_aux_get(entry->aux, "cg", 'Z').size();
+        }
+        return num_cigar_ops;
+    };
+
+    BENCHMARK("serialize_to_paf: " + std::to_string(num_records) + " records") {
+        std::ostringstream oss;
+        for (int i = 0; i < num_records; ++i) {
+            dorado::utils::serialize_to_paf(oss, "query", "target", ovl, 0, 0, 60, cigar);
+            oss << '\n';
+        }
+        return oss.tellp();
+    };
+
+    BENCHMARK("PafWriter: " + std::to_string(num_records) + " records") {
+        std::ostringstream oss;
+        dorado::utils::PafWriter writer(oss);
+        for (int i = 0; i < num_records; ++i) {
+            writer.write("query", "target", ovl, 0, 0, 60, cigar);
+        }
+        writer.flush();
+        return oss.tellp();
+    };
+}
+#endif  // CATCH_CONFIG_ENABLE_BENCHMARKING
@@ -97,3 +97,39 @@ TEST_CASE("Split read pairing", TEST_GROUP) {
             });
     CHECK(num_pairs == 2);
 }
+
+TEST_CASE("Multi-threaded pairing across channels", TEST_GROUP) {
+    // Each channel gets a pair of reads that meet the early acceptance criteria, so that the
+    // pairs are found whichever order the worker threads insert them into the cache.
+    const int num_channels = 50;
+    const auto read_order = GENERATE(dorado::ReadOrder::BY_CHANNEL, dorado::ReadOrder::BY_TIME);
+    CAPTURE(dorado::to_string(read_order));
+
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    pipeline_desc.add_node<dorado::PairingNode>(
+            {sink}, dorado::DuplexPairingParameters{read_order, dorado::DEFAULT_DUPLEX_CACHE_DEPTH},
+            4, 100);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+    for (int channel = 0; channel < num_channels; ++channel) {
+        for (int delay_ms : {0, 2550}) {
+            auto read = make_read(delay_ms, 5000);
+            read->read_common.attributes.channel_number = channel;
+            pipeline->push_message(std::move(read));
+        }
+    }
+    pipeline.reset();
+
+    auto num_reads =
+            std::count_if(messages.begin(), messages.end(), [](const dorado::Message& message) {
+                return std::holds_alternative<dorado::SimplexReadPtr>(message);
+            });
+    CHECK(num_reads == 2 * num_channels);
+    auto num_pairs =
+            std::count_if(messages.begin(), messages.end(), [](const dorado::Message& message) {
+                return std::holds_alternative<dorado::ReadPair>(message);
+            });
+    CHECK(num_pairs == num_channels);
+}
@@ -1,12 +1,17 @@
 #include "MessageSinkUtils.h"
 #include "TestUtils.h"
 #include "data_loader/DataLoader.h"
+#include "data_loader/Pod5ChannelIndex.h"
 #include "models/models.h"
 #include "read_pipeline/ReadPipeline.h"
 #include "utils/fs_utils.h"
 
 #include <catch2/catch.hpp>
 
+#include <cstdint>
+#include <fstream>
+#include <limits>
+
 #define TEST_GROUP "[dorado::DataLoader::pod5]"
 
 TEST_CASE(TEST_GROUP " Test loading single-read POD5 file from data dir, empty read list",
@@ -130,3 +135,104 @@ TEST_CASE(TEST_GROUP " Test correct previous and next read ids when loaded by ch
         next_read_id = (*i)->read_common.read_id;
     }
 }
+
+TEST_CASE(TEST_GROUP " Test loading multiple POD5 files with max reads", TEST_GROUP) {
+    const auto data_path = get_pod5_data_dir() / "dna_r10.4.1_e8.2_260bps";
+
+    const auto num_reads = CountSinkReads(data_path, "cpu", 2, 0, std::nullopt, {});
+    REQUIRE(num_reads > 1);
+    CHECK(CountSinkReads(data_path, "cpu", 2, 1, std::nullopt, {}) == 1);
+    CHECK(CountSinkReads(data_path, "cpu", 2, num_reads - 1, std::nullopt, {}) == num_reads - 1);
+}
+
+TEST_CASE(TEST_GROUP " Test saving and loading a POD5 channel index", TEST_GROUP) {
+    const auto temp_dir = make_temp_dir("pod5_channel_index");
+    const auto pod5_path = temp_dir.m_path / "reads.pod5";
+    std::filesystem::copy_file(get_data_dir("multi_read_pod5") / "filtered.pod5", pod5_path);
+    const auto index_path = dorado::Pod5ChannelIndex::sidecar_path(pod5_path);
+
+    auto index = dorado::Pod5ChannelIndex::build(pod5_path);
+    REQUIRE(index.has_value());
+    CHECK(index->num_reads() == 4);
+    REQUIRE(index->save(index_path));
+
+    SECTION("Saved index matches built index") {
+        auto loaded = dorado::Pod5ChannelIndex::load(pod5_path, index_path);
+        REQUIRE(loaded.has_value());
+        CHECK(loaded->num_reads() == index->num_reads());
+        CHECK(loaded->max_channel() == index->max_channel());
+        REQUIRE(loaded->channels().size() == index->channels().size());
+        for (const auto& [channel, reads] : index->channels()) {
+            const auto& loaded_reads = loaded->reads_in_channel(channel);
+            REQUIRE(loaded_reads.size() == reads.size());
+            for (size_t i = 0; i < reads.size(); ++i) {
+                CHECK(loaded_reads[i].read_id == reads[i].read_id);
+                CHECK(loaded_reads[i].batch == reads[i].batch);
+                CHECK(loaded_reads[i].row == reads[i].row);
+                CHECK(loaded_reads[i].mux == reads[i].mux);
+                CHECK(loaded_reads[i].read_number == reads[i].read_number);
+            }
+        }
+    }
+
+    SECTION("Index is ignored once the POD5 file changes") {
+        std::ofstream(pod5_path, std::ios::binary | std::ios::app) << '\0';
+        CHECK_FALSE(dorado::Pod5ChannelIndex::load(pod5_path, index_path).has_value());
+    }
+
+    SECTION("Truncated index is ignored") {
+        std::filesystem::resize_file(index_path, std::filesystem::file_size(index_path) - 1);
+        CHECK_FALSE(dorado::Pod5ChannelIndex::load(pod5_path, index_path).has_value());
+    }
+
+    SECTION("Index with an oversized read count is ignored") {
+        // The read count of the first channel follows the 32 byte header and the channel id.
+        std::fstream stream(index_path, std::ios::binary | std::ios::in | std::ios::out);
+        stream.seekp(36);
+        const uint64_t num_entries = std::numeric_limits<uint64_t>::max() / 2;
+        stream.write(reinterpret_cast<const char*>(&num_entries), sizeof(num_entries));
+        stream.close();
+        CHECK_FALSE(dorado::Pod5ChannelIndex::load(pod5_path, index_path).has_value());
+    }
+
+    SECTION("Index is still built when the sidecar can't be saved") {
+        std::filesystem::remove(index_path);
+        std::filesystem::create_directories(index_path / "blocker");
+        auto rebuilt = dorado::Pod5ChannelIndex::load_or_build(pod5_path, true);
+        REQUIRE(rebuilt.has_value());
+        CHECK(rebuilt->num_reads() == index->num_reads());
+        CHECK(std::filesystem::is_directory(index_path));
+    }
+}
+
+TEST_CASE(TEST_GROUP " Load data sorted by channel id using sidecar channel indexes", TEST_GROUP) {
+    const auto temp_dir = make_temp_dir("pod5_channel_index");
+    std::filesystem::copy_file(get_data_dir("multi_read_pod5") / "filtered.pod5",
+                               temp_dir.m_path / "reads.pod5");
+    const auto input_files = dorado::DataLoader::InputFiles::search(temp_dir.m_path, false);
+    REQUIRE(input_files.has_value());
+
+    auto load_read_ids = [&] {
+        dorado::PipelineDescriptor pipeline_desc;
+        std::vector<dorado::Message> messages;
+        pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+        auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+        dorado::DataLoader loader(*pipeline, "cpu", 1, 0, std::nullopt, {});
+        loader.set_use_channel_index_sidecars(true);
+        loader.load_reads(*input_files, dorado::ReadOrder::BY_CHANNEL);
+        pipeline.reset();
+        std::vector<std::string> read_ids;
+        for (const auto& read : ConvertMessages<dorado::SimplexReadPtr>(std::move(messages))) {
+            read_ids.push_back(read->read_common.read_id);
+        }
+        return read_ids;
+    };
+
+    // The first load builds and saves the index, and the second reuses it.
+    const auto built_read_ids = load_read_ids();
+    CHECK(built_read_ids.size() == 4);
+    CHECK(std::filesystem::exists(
+            dorado::Pod5ChannelIndex::sidecar_path(temp_dir.m_path / "reads.pod5")));
+    CHECK(load_read_ids() == built_read_ids);
+}
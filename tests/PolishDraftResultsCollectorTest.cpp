@@ -0,0 +1,128 @@
+#include "polish/draft_results_collector.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#define TEST_GROUP "[PolishDraftResultsCollector]"
+
+namespace dorado::polisher::draft_results_collector::tests {
+
+namespace {
+
+ConsensusResult make_result(const int32_t draft_id, const int64_t start) {
+    ConsensusResult ret;
+    ret.draft_id = draft_id;
+    ret.draft_start = start;
+    ret.draft_end = start + 10;
+    return ret;
+}
+
+}  // namespace
+
+TEST_CASE("DraftResultsCollector hands out complete drafts in order", TEST_GROUP) {
+    DraftResultsCollector collector(3);
+
+    collector.add_samples(0, 2);
+    collector.add_samples(1, 1);
+    collector.seal(1);
+    // Draft 2 has no samples at all.
+    collector.seal(2);
+
+    // Draft 1 is complete first, but it has to wait for draft 0.
+    collector.add_results({1}, {make_result(1, 0)}, {});
+    collector.add_results({0}, {make_result(0, 0)}, {});
+    CHECK(collector.num_in_flight() == 3);
+
+    // Filtered results are dropped, but the sample still counts as decoded.
+    collector.add_results({0}, {ConsensusResult{}}, {});
+    collector.seal(0);
+
+    std::vector<DraftResults> ready;
+    REQUIRE(collector.pop_ready(ready));
+    REQUIRE(std::size(ready) == 3);
+    CHECK(ready[0].seq_id == 0);
+    CHECK(std::size(ready[0].results_cons) == 1);
+    CHECK(ready[1].seq_id == 1);
+    CHECK(std::size(ready[1].results_cons) == 1);
+    CHECK(ready[2].seq_id == 2);
+    CHECK(std::empty(ready[2].results_cons));
+    CHECK(collector.num_in_flight() == 0);
+
+    // All drafts have been handed out.
+    CHECK_FALSE(collector.pop_ready(ready));
+}
+
+TEST_CASE("DraftResultsCollector does not hand out drafts with pending samples", TEST_GROUP) {
+    DraftResultsCollector collector(2);
+
+    collector.add_samples(0, 1);
+    collector.seal(0);
+    collector.add_samples(1, 1);
+    collector.seal(1);
+    collector.add_results({0}, {make_result(0, 0)}, {});
+
+    std::vector<DraftResults> ready;
+    REQUIRE(collector.pop_ready(ready));
+    REQUIRE(std::size(ready) == 1);
+    CHECK(ready[0].seq_id == 0);
+
+    // Draft 1 never completes, so terminating unblocks the consumer without it.
+    collector.terminate();
+    CHECK_FALSE(collector.pop_ready(ready));
+    CHECK(std::empty(ready));
+}
+
+TEST_CASE("DraftResultsCollector rejects invalid input", TEST_GROUP) {
+    DraftResultsCollector collector(1);
+
+    CHECK_THROWS_AS(collector.add_samples(1, 1), std::out_of_range);
+    CHECK_THROWS_AS(collector.add_results({0}, {}, {}), std::runtime_error);
+
+    collector.seal(0);
+    CHECK_THROWS_AS(collector.add_samples(0, 1), std::runtime_error);
+}
+
+TEST_CASE("DraftResultsCollector collects results from concurrent decoders", TEST_GROUP) {
+    const int32_t num_drafts = 50;
+    const int32_t num_samples = 20;
+    const int32_t num_threads = 4;
+
+    DraftResultsCollector collector(num_drafts);
+    for (int32_t seq_id = 0; seq_id < num_drafts; ++seq_id) {
+        collector.add_samples(seq_id, num_samples);
+        collector.seal(seq_id);
+    }
+
+    std::vector<std::thread> threads;
+    for (int32_t tid = 0; tid < num_threads; ++tid) {
+        threads.emplace_back([&, tid]() {
+            // Each thread decodes every num_threads-th sample, from the last draft backwards.
+            for (int32_t seq_id = num_drafts - 1; seq_id >= 0; --seq_id) {
+                for (int32_t i = tid; i < num_samples; i += num_threads) {
+                    collector.add_results({seq_id}, {make_result(seq_id, i * 10)}, {});
+                }
+            }
+        });
+    }
+
+    int32_t next_seq_id = 0;
+    std::vector<DraftResults> ready;
+    while (collector.pop_ready(ready)) {
+        for (const auto& draft : ready) {
+            CHECK(draft.seq_id == next_seq_id);
+            CHECK(std::size(draft.results_cons) == num_samples);
+            ++next_seq_id;
+        }
+    }
+    CHECK(next_seq_id == num_drafts);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+}  // namespace dorado::polisher::draft_results_collector::tests
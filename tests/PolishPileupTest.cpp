@@ -0,0 +1,190 @@
+#include "TestUtils.h"
+#include "polish/bam_file.h"
+#include "polish/features/medaka_counts.h"
+#include "utils/types.h"
+
+#include <catch2/catch.hpp>
+#include <htslib/sam.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace dorado::polisher::pileup::tests {
+
+#define TEST_GROUP "[PolishPileup]"
+
+namespace {
+
+const std::string REF_NAME = "contig_1";
+
+struct PileupArgs {
+    int64_t start = 0;
+    int64_t end = 0;
+    int64_t num_homop = 1;
+    int32_t min_mapq = 0;
+};
+
+PileupData run_mpileup(BamFile &bam_file, const PileupArgs &args) {
+    return calculate_pileup(bam_file, REF_NAME, args.start, args.end, 1, {}, args.num_homop, "",
+                            0, false, false, "", args.min_mapq);
+}
+
+PileupData run_cigar_pileup(BamFile &bam_file, const PileupArgs &args) {
+    return calculate_pileup_from_cigars(bam_file, REF_NAME, args.start, args.end, 1, {},
+                                        args.num_homop, "", 0, false, false, "", args.min_mapq);
+}
+
+void check_same_pileup(const PileupData &result,
+                       const PileupData &expected,
+                       const int64_t num_homop) {
+    const int64_t featlen = PILEUP_BASES_SIZE * num_homop;
+    REQUIRE(result.n_cols == expected.n_cols);
+    CHECK(result.major == expected.major);
+    CHECK(result.minor == expected.minor);
+    // The mpileup matrix may have spare capacity past the last column.
+    const std::vector<int64_t> expected_matrix(
+            std::begin(expected.matrix), std::begin(expected.matrix) + expected.n_cols * featlen);
+    const std::vector<int64_t> result_matrix(std::begin(result.matrix),
+                                             std::begin(result.matrix) + result.n_cols * featlen);
+    CHECK(result_matrix == expected_matrix);
+}
+
+// Writes the SAM |records| to an indexed BAM aligned to a 1 kb REF_NAME.
+std::filesystem::path write_indexed_bam(const std::filesystem::path &dir,
+                                        const std::vector<std::string> &records) {
+    const auto bam_path = dir / "pileup.bam";
+    const std::string header_txt =
+            "@HD\tVN:1.6\tSO:coordinate\n@SQ\tSN:" + REF_NAME + "\tLN:1000\n";
+    {
+        SamHdrPtr header(sam_hdr_parse(header_txt.size(), header_txt.c_str()));
+        REQUIRE(header != nullptr);
+        HtsFilePtr file(hts_open(bam_path.string().c_str(), "wb"));
+        REQUIRE(file != nullptr);
+        REQUIRE(sam_hdr_write(file.get(), header.get()) == 0);
+        BamPtr record(bam_init1());
+        for (std::string line : records) {
+            kstring_t line_str{std::size(line), std::size(line), std::data(line)};
+            REQUIRE(sam_parse1(&line_str, header.get(), record.get()) >= 0);
+            REQUIRE(sam_write1(file.get(), header.get(), record.get()) >= 0);
+        }
+    }
+    REQUIRE(sam_index_build(bam_path.string().c_str(), 0) == 0);
+    return bam_path;
+}
+
+std::string make_sam_record(const int64_t id,
+                            const int64_t pos,  // Zero-based.
+                            const std::string &cigar,
+                            const std::string &seq) {
+    return "read_" + std::to_string(id) + "\t0\t" + REF_NAME + '\t' + std::to_string(pos + 1) +
+           "\t60\t" + cigar + "\t*\t0\t0\t" + seq + "\t*";
+}
+
+}  // namespace
+
+TEST_CASE("calculate_pileup_from_cigars matches calculate_pileup", TEST_GROUP) {
+    const auto bam_name = GENERATE("calls_to_draft.bam", "calls_to_draft.broken_single.bam",
+                                   "calls_to_draft.single_read.long_insertion.bam");
+    const auto [start, end] = GENERATE(table<int64_t, int64_t>({
+            {0, 10000},
+            {0, 1},
+            {1234, 5678},
+            {9990, 10000},
+    }));
+    const auto num_homop = GENERATE(1, 3);
+    const auto min_mapq = GENERATE(0, 60);
+    CAPTURE(bam_name, start, end, num_homop, min_mapq);
+
+    const PileupArgs args{start, end, num_homop, min_mapq};
+
+    BamFile mpileup_bam(get_data_dir("polish/test-01-supertiny") / bam_name);
+    const PileupData expected = run_mpileup(mpileup_bam, args);
+
+    BamFile cigar_bam(get_data_dir("polish/test-01-supertiny") / bam_name);
+    const PileupData result = run_cigar_pileup(cigar_bam, args);
+
+    check_same_pileup(result, expected, num_homop);
+}
+
+TEST_CASE("calculate_pileup_from_cigars keeps to the mpileup depth cap", TEST_GROUP) {
+    // More alignments start at each of two positions than mpileup's cap of 8000 allows.
+    const std::string bases = "ACGT";
+    std::vector<std::string> records;
+    for (const int64_t pos : {100, 105}) {
+        for (int64_t i = 0; i < 8100; ++i) {
+            std::string seq;
+            for (int64_t j = 0; j < 20; ++j) {
+                seq += bases[(i + j) % 4];
+            }
+            records.push_back(
+                    make_sam_record(static_cast<int64_t>(std::size(records)), pos, "20M", seq));
+        }
+    }
+    auto temp_dir = make_temp_dir("polish_pileup_depth");
+    const auto bam_path = write_indexed_bam(temp_dir.m_path, records);
+
+    const PileupArgs args{0, 200, 1, 0};
+    BamFile mpileup_bam(bam_path);
+    const PileupData expected = run_mpileup(mpileup_bam, args);
+    BamFile cigar_bam(bam_path);
+    const PileupData result = run_cigar_pileup(cigar_bam, args);
+
+    check_same_pileup(result, expected, args.num_homop);
+
+    // Check that the region is deep enough for mpileup to have dropped alignments.
+    REQUIRE(expected.n_cols > 5);
+    CHECK(expected.major[5] == 105);
+    const auto col_start = std::begin(expected.matrix) + 5 * PILEUP_BASES_SIZE;
+    CHECK(std::accumulate(col_start, col_start + PILEUP_BASES_SIZE, int64_t{0}) < 16200);
+}
+
+TEST_CASE("calculate_pileup_from_cigars leaves reference skips uncounted", TEST_GROUP) {
+    // The insertion follows the skip's last position, 10 + 5 - 1 bases into each alignment.
+    const std::vector<std::string> records{
+            make_sam_record(0, 50, "25M", "ACGTACGTACGTACGTACGTACGTA"),
+            make_sam_record(1, 50, "10M5N3I10M", "ACGTACGTACGGGCGTACGTACG"),
+            make_sam_record(2, 50, "10M5N3I10M", "ACGTACGTACTTTCGTACGTACG"),
+            make_sam_record(3, 52, "25M", "GTACGTACGTACGTACGTACGTACG"),
+    };
+    auto temp_dir = make_temp_dir("polish_pileup_refskip");
+    const auto bam_path = write_indexed_bam(temp_dir.m_path, records);
+
+    const PileupArgs args{0, 100, 1, 0};
+    BamFile mpileup_bam(bam_path);
+    const PileupData expected = run_mpileup(mpileup_bam, args);
+    BamFile cigar_bam(bam_path);
+    const PileupData result = run_cigar_pileup(cigar_bam, args);
+
+    check_same_pileup(result, expected, args.num_homop);
+
+    // As in mpileup, the insertion after the skip widens its column but isn't counted, and the
+    // skipped positions only count the two alignments without a skip.
+    int64_t num_inserted_cols = 0;
+    for (int64_t col = 0; col < result.n_cols; ++col) {
+        const auto col_start = std::begin(result.matrix) + col * PILEUP_BASES_SIZE;
+        const int64_t depth = std::accumulate(col_start, col_start + PILEUP_BASES_SIZE, int64_t{0});
+        if (result.minor[col] != 0) {
+            ++num_inserted_cols;
+            CHECK(result.major[col] == 64);
+            CHECK(depth == 0);
+        } else if ((result.major[col] >= 60) && (result.major[col] < 65)) {
+            CHECK(depth == 2);
+        }
+    }
+    CHECK(num_inserted_cols == 3);
+}
+
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE("calculate_pileup benchmark", TEST_GROUP) {
+    const PileupArgs args{0, 10000, 1, 0};
+    BamFile bam_file(get_data_dir("polish/test-01-supertiny") / "calls_to_draft.bam");
+
+    BENCHMARK("mpileup") { return run_mpileup(bam_file, args).n_cols; };
+    BENCHMARK("cigar walk") { return run_cigar_pileup(bam_file, args).n_cols; };
+}
+#endif  // CATCH_CONFIG_ENABLE_BENCHMARKING
+
+}  // namespace dorado::polisher::pileup::tests
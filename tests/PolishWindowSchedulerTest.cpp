@@ -0,0 +1,122 @@
+#include "TestUtils.h"
+#include "polish/bam_file.h"
+#include "polish/window_scheduler.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define TEST_GROUP "[PolishWindowScheduler]"
+
+namespace dorado::polisher::window_scheduler::tests {
+
+TEST_CASE("WindowScheduler runs every task exactly once", TEST_GROUP) {
+    const int32_t num_threads = GENERATE(1, 2, 7);
+    const int32_t num_tasks = GENERATE(0, 1, 5, 1000);
+    CAPTURE(num_threads, num_tasks);
+
+    WindowScheduler scheduler(num_threads);
+    CHECK(scheduler.num_threads() == num_threads);
+
+    // Skewed costs, including ties.
+    std::vector<int64_t> costs(num_tasks);
+    for (int32_t i = 0; i < num_tasks; ++i) {
+        costs[i] = (i % 3 == 0) ? 1000 : (i % 7);
+    }
+
+    std::vector<std::atomic<int32_t>> num_calls(num_tasks);
+    std::vector<std::atomic<int32_t>> active_per_thread(num_threads);
+    std::atomic<bool> valid_thread_ids{true};
+
+    const auto task = [&](const int32_t thread_id, const int32_t task_id) {
+        if ((thread_id < 0) || (thread_id >= num_threads) ||
+            (active_per_thread[thread_id].fetch_add(1) != 0)) {
+            valid_thread_ids = false;
+        }
+        ++num_calls[task_id];
+        if ((thread_id >= 0) && (thread_id < num_threads)) {
+            --active_per_thread[thread_id];
+        }
+    };
+
+    // The same scheduler is reused across several runs.
+    for (int32_t run = 0; run < 3; ++run) {
+        scheduler.run(Span<const int64_t>(std::data(costs), std::size(costs)), task);
+        for (int32_t i = 0; i < num_tasks; ++i) {
+            CHECK(num_calls[i] == (run + 1));
+        }
+    }
+    CHECK(valid_thread_ids);
+}
+
+TEST_CASE("WindowScheduler runs the most expensive tasks first", TEST_GROUP) {
+    WindowScheduler scheduler(1);
+
+    const std::vector<int64_t> costs{5, 100, 1, 50, 50};
+    std::vector<int32_t> order;
+
+    scheduler.run(Span<const int64_t>(std::data(costs), std::size(costs)),
+                  [&](const int32_t /*thread_id*/, const int32_t task_id) {
+                      order.emplace_back(task_id);
+                  });
+
+    CHECK(order == std::vector<int32_t>{1, 3, 4, 0, 2});
+}
+
+TEST_CASE("WindowScheduler rethrows task exceptions and stays usable", TEST_GROUP) {
+    WindowScheduler scheduler(4);
+
+    const std::vector<int64_t> costs(100, 1);
+    const Span<const int64_t> costs_span(std::data(costs), std::size(costs));
+
+    CHECK_THROWS_WITH(scheduler.run(costs_span,
+                                    [](const int32_t /*thread_id*/, const int32_t task_id) {
+                                        if (task_id == 42) {
+                                            throw std::runtime_error("Task failed.");
+                                        }
+                                    }),
+                      "Task failed.");
+
+    std::atomic<int32_t> num_calls{0};
+    scheduler.run(costs_span,
+                  [&](const int32_t /*thread_id*/, const int32_t /*task_id*/) { ++num_calls; });
+    CHECK(num_calls == 100);
+}
+
+TEST_CASE("WindowScheduler rejects zero threads", TEST_GROUP) {
+    CHECK_THROWS_AS(WindowScheduler(0), std::runtime_error);
+}
+
+TEST_CASE("estimate_window_costs uses the read counts from the BAM index", TEST_GROUP) {
+    const BamFile bam_file(get_data_dir("polish/test-01-supertiny") / "calls_to_draft.bam");
+
+    const std::vector<std::pair<std::string, int64_t>> draft_lens{{"contig_1", 10000},
+                                                                 {"missing_contig", 10000}};
+    const std::vector<Window> windows{
+            Window{0, 10000, 0, 10000, 0, 10000},
+            Window{0, 10000, 0, 5000, 0, 5000},
+            Window{0, 10000, 5000, 5001, 5000, 5001},
+            Window{1, 10000, 0, 10000, 0, 10000},
+    };
+
+    const std::vector<int64_t> costs = estimate_window_costs(
+            bam_file, draft_lens, Span<const Window>(std::data(windows), std::size(windows)));
+
+    REQUIRE(std::size(costs) == std::size(windows));
+    for (const int64_t cost : costs) {
+        CHECK(cost >= 1);
+    }
+    // A longer window of the same sequence is estimated to have more reads.
+    CHECK(costs[0] > 1);
+    CHECK(costs[0] >= costs[1]);
+    CHECK(costs[1] >= costs[2]);
+    // Sequences which are not in the BAM have no reads.
+    CHECK(costs[3] == 1);
+}
+
+}  // namespace dorado::polisher::window_scheduler::tests
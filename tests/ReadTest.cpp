@@ -5,6 +5,10 @@
 #include <catch2/catch.hpp>
 #include <htslib/sam.h>
 
+#include <random>
+#include <string>
+#include <vector>
+
 #define TEST_GROUP "[ReadTest]"
 
 using Catch::Matchers::Equals;
@@ -147,6 +151,30 @@ TEST_CASE(TEST_GROUP ": Test tag generation", TEST_GROUP) {
 
         read_common.rna_poly_tail_length = old_tail_length;
     }
+
+    SECTION("Moves") {
+        read_common.model_stride = 5;
+        read_common.moves = {1, 0, 1, 1};
+
+        auto alignments = read_common.extract_sam_lines(true, 0, false);
+        REQUIRE(alignments.size() == 1);
+        auto* aln = alignments[0].get();
+
+        auto* mv = bam_aux_get(aln, "mv");
+        REQUIRE(mv != nullptr);
+        CHECK(mv[0] == 'B');
+        CHECK(mv[1] == 'c');
+        REQUIRE(bam_auxB_len(mv) == 5);
+        const std::vector<int64_t> expected_moves{5, 1, 0, 1, 1};
+        for (uint32_t i = 0; i < 5; ++i) {
+            CHECK(bam_auxB2i(mv, i) == expected_moves[i]);
+        }
+
+        // Tags written after the record is created should follow the generated ones.
+        CHECK(bam_aux_append(aln, "XX", 'Z', 4, reinterpret_cast<const uint8_t*>("abc")) == 0);
+        CHECK_THAT(bam_aux2Z(bam_aux_get(aln, "XX")), Equals("abc"));
+        CHECK_THAT(bam_aux2Z(bam_aux_get(aln, "fn")), Equals("batch_0.fast5"));
+    }
 }
 
 TEST_CASE(TEST_GROUP ": Test sam record generation", TEST_GROUP) {
@@ -375,3 +403,69 @@ TEST_CASE(TEST_GROUP ": Test mean q-score generation", TEST_GROUP) {
         CHECK(read_common.calculate_mean_qscore() == Approx(8.79143f));
     }
 }
+
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE(TEST_GROUP ": SAM record generation throughput", TEST_GROUP) {
+    constexpr size_t num_reads = 100;
+    constexpr size_t read_length = 10000;
+    constexpr int model_stride = 6;
+
+    const std::vector<std::string> modbase_alphabet = {"A", "C", "m", "h", "G", "T"};
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> base_dist(0, 3);
+    std::uniform_int_distribution<int> qual_dist(5, 40);
+    std::uniform_int_distribution<int> prob_dist(0, 255);
+
+    auto make_read = [&](bool duplex, bool modbases) {
+        dorado::ReadCommon read_common;
+        read_common.read_id = "002bd127-db82-436f-b828-28567c3d505d";
+        read_common.raw_data = at::empty({int64_t(read_length * model_stride)});
+        read_common.sample_rate = 5000;
+        read_common.model_stride = model_stride;
+        read_common.scaling_method = "quantile";
+        read_common.attributes.start_time = "2017-04-29T09:10:04Z";
+        read_common.attributes.filename = "batch_0.pod5";
+        read_common.run_id = "xyz";
+        read_common.model_name = "test_model";
+        read_common.is_duplex = duplex;
+        read_common.seq.resize(read_length);
+        read_common.qstring.resize(read_length);
+        for (size_t i = 0; i < read_length; ++i) {
+            read_common.seq[i] = "ACGT"[base_dist(rng)];
+            read_common.qstring[i] = char(33 + qual_dist(rng));
+        }
+        read_common.moves.assign(read_length * 2, 0);
+        for (size_t i = 0; i < read_common.moves.size(); i += 2) {
+            read_common.moves[i] = 1;
+        }
+        if (modbases) {
+            read_common.mod_base_info =
+                    std::make_shared<dorado::ModBaseInfo>(modbase_alphabet, "5mC 5hmC", "");
+            read_common.base_mod_probs.resize(read_length * modbase_alphabet.size());
+            for (auto& prob : read_common.base_mod_probs) {
+                prob = uint8_t(prob_dist(rng));
+            }
+        }
+        return read_common;
+    };
+
+    const auto [name, duplex, modbases] = GENERATE(table<std::string, bool, bool>({
+            {"simplex", false, false},
+            {"duplex", true, false},
+            {"modbase", false, true},
+    }));
+    std::vector<dorado::ReadCommon> reads;
+    for (size_t i = 0; i < num_reads; ++i) {
+        reads.push_back(make_read(duplex, modbases));
+    }
+
+    BENCHMARK(name + ": " + std::to_string(num_reads) + " reads") {
+        size_t num_bytes = 0;
+        for (const auto& read_common : reads) {
+            auto alignments = read_common.extract_sam_lines(!duplex, 10, false);
+            num_bytes += alignments[0]->l_data;
+        }
+        return num_bytes;
+    };
+}
+#endif  // CATCH_CONFIG_ENABLE_BENCHMARKING
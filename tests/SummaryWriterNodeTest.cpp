@@ -0,0 +1,56 @@
+#include "MessageSinkUtils.h"
+#include "TestUtils.h"
+#include "read_pipeline/HtsReader.h"
+#include "read_pipeline/ReadPipeline.h"
+#include "read_pipeline/SummaryWriterNode.h"
+#include "summary/summary.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define TEST_GROUP "[SummaryWriterNodeTest]"
+
+namespace dorado::summary_writer_node::test {
+
+TEST_CASE("SummaryWriterNode matches summarising the output file", TEST_GROUP) {
+    const auto input = GENERATE(std::filesystem::path("bam_reader") / "small.sam",
+                                std::filesystem::path("aligner_test") / "prealigned.sam");
+    const auto sam_path = get_data_dir(input.parent_path().string()) / input.filename();
+    CAPTURE(sam_path);
+
+    std::ostringstream expected_stream;
+    SummaryData().process_file(sam_path.string(), expected_stream);
+    const auto expected = expected_stream.str();
+
+    HtsReader reader(sam_path.string(), std::nullopt);
+    const auto flags = SummaryData::GENERAL_FIELDS | SummaryData::BARCODING_FIELDS |
+                       (reader.is_aligned ? SummaryData::ALIGNMENT_FIELDS : 0);
+    std::ostringstream output;
+    auto summary_writer = std::make_shared<SummaryWriter>(output, SummaryData(flags));
+
+    std::vector<Message> messages;
+    PipelineDescriptor pipeline_desc;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    auto summary_node = pipeline_desc.add_node<SummaryWriterNode>({sink}, summary_writer);
+    auto pipeline = Pipeline::create(std::move(pipeline_desc), nullptr);
+    dynamic_cast<SummaryWriterNode&>(pipeline->get_node_ref(summary_node))
+            .set_header(reader.header());
+
+    const auto num_records = reader.read(*pipeline, 0);
+    const auto final_stats = pipeline->terminate(DefaultFlushOptions());
+
+    CHECK(output.str() == expected);
+    // Every record is passed on, including those without a summary row.
+    CHECK(messages.size() == num_records);
+    // Less one for the header.
+    const auto num_rows = std::count(expected.begin(), expected.end(), '\n') - 1;
+    CHECK(final_stats.at("SummaryWriterNode.summary_rows_written") == num_rows);
+}
+
+}  // namespace dorado::summary_writer_node::test
@@ -80,6 +80,80 @@ TEST_CASE(CUT_TAG ": quantile benchmark", CUT_TAG) {
 }
 #endif  // CATCH_CONFIG_ENABLE_BENCHMARKING
 
+TEST_CASE(CUT_TAG ": quantiles_int16 matches quantile_counting", CUT_TAG) {
+    const auto size = GENERATE(1, 2, 999, 1000);
+    CAPTURE(size);
+    // Include negative values, which the signal can have.
+    auto in = torch::randint(-100, 2047, size).to(torch::kI16);
+    auto q = torch::tensor({0.2, 0.9}, {torch::kFloat});
+
+    auto expected = dorado::utils::quantile_counting(in, q);
+    auto [q_a, q_b] = dorado::utils::quantiles_int16(in.data_ptr<int16_t>(), size, 0.2f, 0.9f);
+
+    CHECK(q_a == expected[0].item<float>());
+    CHECK(q_b == expected[1].item<float>());
+}
+
+TEST_CASE(CUT_TAG ": median_and_mad_int16 matches torch", CUT_TAG) {
+    const auto size = GENERATE(1, 2, 999, 1000);
+    CAPTURE(size);
+    auto in = torch::randint(-100, 2047, size).to(torch::kI16);
+
+    auto expected_median = in.median();
+    auto expected_mad = torch::median(torch::abs(in - expected_median));
+    auto [median, mad] = dorado::utils::median_and_mad_int16(in.data_ptr<int16_t>(), size);
+
+    CHECK(median == expected_median.item<float>());
+    CHECK(mad == expected_mad.item<float>());
+}
+
+TEST_CASE(CUT_TAG ": normalise_int16", CUT_TAG) {
+    torch::manual_seed(42);
+
+    // Cover sizes either side of a whole number of SIMD registers.
+    for (const int num_elems : {0, 1, 7, 8, 9, 31, 1000}) {
+        CAPTURE(num_elems);
+        const auto in = torch::randint(-100, 2047, num_elems).to(torch::kI16);
+        const float shift = 512.3f;
+        const float scale = 97.1f;
+        const auto expected_f32 = (in.to(torch::kFloat) - shift) / scale;
+        const auto expected_f16 = expected_f32.to(torch::kHalf);
+
+        auto normalised_f32 = torch::empty({num_elems}, torch::kFloat);
+        dorado::utils::normalise_int16(normalised_f32.data_ptr<float>(), in.data_ptr<int16_t>(),
+                                       num_elems, shift, scale);
+        CHECK(torch::equal(normalised_f32, expected_f32));
+
+        auto normalised_f16 = torch::empty({num_elems}, torch::kHalf);
+        dorado::utils::normalise_int16(normalised_f16.data_ptr<c10::Half>(),
+                                       in.data_ptr<int16_t>(), num_elems, shift, scale);
+        CHECK(torch::equal(normalised_f16, expected_f16));
+    }
+
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+    {
+        const auto num_elems = GENERATE(10'000, 1'000'000);
+        const auto in = torch::randint(0, 2047, num_elems).to(torch::kI16);
+        auto normalised_f16 = torch::empty({num_elems}, torch::kHalf);
+        const auto q = torch::tensor({0.2, 0.9}, {torch::kFloat});
+
+        BENCHMARK("torch normalise " + std::to_string(num_elems)) {
+            auto quantiles = dorado::utils::quantile_counting(in, q);
+            const float shift = quantiles[0].item<float>();
+            const float scale = quantiles[1].item<float>() - shift + 1;
+            return ((in.to(torch::kFloat) - shift) / scale).to(torch::kHalf);
+        };
+
+        BENCHMARK("our normalise " + std::to_string(num_elems)) {
+            const auto [q_a, q_b] =
+                    dorado::utils::quantiles_int16(in.data_ptr<int16_t>(), num_elems, 0.2f, 0.9f);
+            dorado::utils::normalise_int16(normalised_f16.data_ptr<c10::Half>(),
+                                           in.data_ptr<int16_t>(), num_elems, q_a, q_b - q_a + 1);
+        };
+    }
+#endif  // CATCH_CONFIG_ENABLE_BENCHMARKING
+}
+
 TEST_CASE(CUT_TAG ": convert_f32_to_f16", CUT_TAG) {
     torch::manual_seed(42);
     srand(42);
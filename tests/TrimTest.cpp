@@ -4,6 +4,8 @@
 #include "demux/Trimmer.h"
 #include "read_pipeline/HtsReader.h"
 #include "read_pipeline/read_utils.h"
+#include "utils/bam_utils.h"
+#include "utils/sequence_utils.h"
 
 #include <ATen/TensorIndexing.h>
 #include <catch2/catch.hpp>
@@ -214,6 +216,27 @@ TEST_CASE("Test trim removes all alignment information", TEST_GROUP) {
     CHECK(trimmed_record->core.mpos == -1);
 }
 
+TEST_CASE("Test trim of reverse strand record in place", TEST_GROUP) {
+    const auto data_dir = fs::path(get_data_dir("trimmer"));
+    const auto bam_file = data_dir / "reverse_strand_record.bam";
+    HtsReader reader(bam_file.string(), std::nullopt);
+    reader.read();
+    auto &record = reader.record;
+
+    const std::pair<int, int> trim_interval = {72, 647};
+    const auto expected_seq = utils::trim_sequence(
+            utils::reverse_complement(utils::extract_sequence(record.get())), trim_interval);
+    Trimmer::trim_sequence_in_place(record.get(), trim_interval);
+    auto seqlen = record->core.l_qseq;
+
+    CHECK(seqlen == (trim_interval.second - trim_interval.first));
+    CHECK(utils::extract_sequence(record.get()) == expected_seq);
+    CHECK(record->core.flag == 4);
+    CHECK(record->core.n_cigar == 0);
+    CHECK(bam_aux2i(bam_aux_get(record.get(), "MN")) == seqlen);
+    CHECK_THAT(bam_aux2Z(bam_aux_get(record.get(), "MM")), Equals("C+h?,18,24;C+m?,18,24;"));
+}
+
 std::string to_qstr(std::vector<int8_t> qscore) {
     std::string qstr;
     for (size_t i = 0; i < qscore.size(); ++i) {
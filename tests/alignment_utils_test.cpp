@@ -0,0 +1,212 @@
+#include "utils/alignment_utils.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#define CUT_TAG "[dorado::utils::alignment_utils]"
+
+namespace dorado::utils::alignment_utils_test {
+
+namespace {
+
+int reference_edit_distance(std::string_view query, std::string_view target) {
+    std::vector<int> prev(target.size() + 1);
+    std::vector<int> curr(target.size() + 1);
+    for (size_t col = 0; col <= target.size(); ++col) {
+        prev[col] = static_cast<int>(col);
+    }
+    for (size_t row = 1; row <= query.size(); ++row) {
+        curr[0] = static_cast<int>(row);
+        for (size_t col = 1; col <= target.size(); ++col) {
+            const int sub = prev[col - 1] + (query[row - 1] == target[col - 1] ? 0 : 1);
+            curr[col] = std::min({sub, prev[col] + 1, curr[col - 1] + 1});
+        }
+        std::swap(prev, curr);
+    }
+    return prev[target.size()];
+}
+
+// Checks that |alignment| is a valid path for the sequences, returning its edit distance.
+int check_alignment(std::string_view query,
+                    std::string_view target,
+                    const std::vector<uint8_t>& alignment) {
+    size_t query_pos = 0;
+    size_t target_pos = 0;
+    int edit_distance = 0;
+    for (const auto op : alignment) {
+        switch (op) {
+        case EDLIB_EDOP_MATCH:
+            REQUIRE(query[query_pos++] == target[target_pos++]);
+            break;
+        case EDLIB_EDOP_MISMATCH:
+            REQUIRE(query[query_pos++] != target[target_pos++]);
+            ++edit_distance;
+            break;
+        case EDLIB_EDOP_INSERT:
+            ++query_pos;
+            ++edit_distance;
+            break;
+        case EDLIB_EDOP_DELETE:
+            ++target_pos;
+            ++edit_distance;
+            break;
+        default:
+            FAIL("Unexpected edit op " << int(op));
+        }
+        REQUIRE(query_pos <= query.size());
+        REQUIRE(target_pos <= target.size());
+    }
+    CHECK(query_pos == query.size());
+    CHECK(target_pos == target.size());
+    return edit_distance;
+}
+
+// Makes a copy of |seq| with a few percent of substitutions and small indels.
+std::string mutate(std::string_view seq, std::mt19937& rng) {
+    std::uniform_int_distribution<int> event_dist(0, 99);
+    std::uniform_int_distribution<int> base_dist(0, 3);
+    std::string mutated;
+    for (const char base : seq) {
+        const int event = event_dist(rng);
+        if (event == 0) {
+            continue;
+        }
+        mutated += event == 1 ? "ACGT"[base_dist(rng)] : base;
+        if (event == 2) {
+            mutated += "ACGT"[base_dist(rng)];
+        }
+    }
+    return mutated;
+}
+
+std::string random_sequence(size_t length, std::mt19937& rng) {
+    std::uniform_int_distribution<int> base_dist(0, 3);
+    std::string seq(length, 'A');
+    for (auto& base : seq) {
+        base = "ACGT"[base_dist(rng)];
+    }
+    return seq;
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG " banded_global_alignment matches full alignment", CUT_TAG) {
+    const auto length = GENERATE(1, 10, 500, 3000);
+    const auto offset = GENERATE(0, 7, -7);
+    CAPTURE(length, offset);
+
+    std::mt19937 rng(length);
+    const auto query = random_sequence(length, rng);
+    auto target = mutate(query, rng);
+    // Shift the target relative to the query.
+    if (offset > 0) {
+        target = random_sequence(offset, rng) + target;
+    } else {
+        target = target.substr(std::min<size_t>(-offset, target.size()));
+    }
+
+    const int64_t end_diagonal = int64_t(target.size()) - int64_t(query.size());
+    const int64_t margin = 64;
+    const auto alignment = banded_global_alignment(
+            query, target, std::min<int64_t>({0, end_diagonal, offset}) - margin,
+            std::max<int64_t>({0, end_diagonal, offset}) + margin);
+    REQUIRE(alignment.has_value());
+    CHECK(check_alignment(query, target, *alignment) == reference_edit_distance(query, target));
+}
+
+TEST_CASE(CUT_TAG " banded_global_alignment gives the same path as edlib", CUT_TAG) {
+    // Short enough that edlib finds the path by traceback rather than by Hirschberg's algorithm.
+    const auto length = GENERATE(10, 50, 200, 300);
+    const auto seed = GENERATE(range(0, 20));
+    CAPTURE(length, seed);
+
+    std::mt19937 rng(seed);
+    const auto query = random_sequence(length, rng);
+    // Mutate twice, and use a 2 base alphabet for part of the sequence, so that there are plenty
+    // of equally good paths to choose between.
+    auto target = mutate(mutate(query, rng), rng);
+    std::replace(target.begin(), target.begin() + target.size() / 2, 'C', 'A');
+
+    EdlibAlignConfig align_config = edlibDefaultAlignConfig();
+    align_config.task = EDLIB_TASK_PATH;
+    EdlibAlignResult edlib_result =
+            edlibAlign(query.data(), static_cast<int>(query.size()), target.data(),
+                       static_cast<int>(target.size()), align_config);
+    REQUIRE(edlib_result.status == EDLIB_STATUS_OK);
+    const std::vector<uint8_t> expected(edlib_result.alignment,
+                                        edlib_result.alignment + edlib_result.alignmentLength);
+    edlibFreeAlignResult(edlib_result);
+
+    const int64_t band = int64_t(query.size()) + int64_t(target.size());
+    const auto alignment = banded_global_alignment(query, target, -band, band);
+    REQUIRE(alignment.has_value());
+    CHECK(*alignment == expected);
+}
+
+TEST_CASE(CUT_TAG " banded_global_alignment empty sequences", CUT_TAG) {
+    const auto both_empty = banded_global_alignment("", "", -1, 1);
+    REQUIRE(both_empty.has_value());
+    CHECK(both_empty->empty());
+
+    const auto empty_target = banded_global_alignment("ACGT", "", -5, 5);
+    REQUIRE(empty_target.has_value());
+    CHECK(*empty_target == std::vector<uint8_t>(4, EDLIB_EDOP_INSERT));
+
+    const auto empty_query = banded_global_alignment("", "ACG", -5, 5);
+    REQUIRE(empty_query.has_value());
+    CHECK(*empty_query == std::vector<uint8_t>(3, EDLIB_EDOP_DELETE));
+}
+
+TEST_CASE(CUT_TAG " banded_global_alignment rejects bands that are too narrow", CUT_TAG) {
+    std::mt19937 rng(42);
+    const auto query = random_sequence(1000, rng);
+
+    SECTION("Band doesn't contain both corners") {
+        const auto target = query.substr(10);
+        CHECK_FALSE(banded_global_alignment(query, target, -5, 5).has_value());
+    }
+
+    SECTION("Best path leaves the band") {
+        // The target has a 100 base insertion followed later by a 100 base deletion, so the
+        // corners are on the same diagonal but the best path isn't.
+        const auto target = query.substr(0, 400) + random_sequence(100, rng) +
+                            query.substr(400, 300) + query.substr(800);
+        CHECK(banded_global_alignment(query, target, -10, 110).has_value());
+        CHECK_FALSE(banded_global_alignment(query, target, -10, 10).has_value());
+    }
+}
+
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE(CUT_TAG " banded_global_alignment benchmark", CUT_TAG) {
+    // Strands of a duplex pair, with the band the stereo encoder uses for an overlap on the
+    // main diagonal.
+    const auto length = GENERATE(1000, 10000, 50000);
+    CAPTURE(length);
+    std::mt19937 rng(length);
+    const auto query = random_sequence(length, rng);
+    const auto target = mutate(query, rng);
+    const int64_t end_diagonal = int64_t(target.size()) - int64_t(query.size());
+    const int64_t margin = 256;
+
+    BENCHMARK("banded " + std::to_string(length)) {
+        return banded_global_alignment(query, target, std::min<int64_t>(0, end_diagonal) - margin,
+                                       std::max<int64_t>(0, end_diagonal) + margin);
+    };
+    BENCHMARK("edlib " + std::to_string(length)) {
+        EdlibAlignConfig align_config = edlibDefaultAlignConfig();
+        align_config.task = EDLIB_TASK_PATH;
+        EdlibAlignResult result =
+                edlibAlign(query.data(), static_cast<int>(query.size()), target.data(),
+                           static_cast<int>(target.size()), align_config);
+        const int alignment_length = result.alignmentLength;
+        edlibFreeAlignResult(result);
+        return alignment_length;
+    };
+}
+#endif  // CATCH_CONFIG_ENABLE_BENCHMARKING
+
+}  // namespace dorado::utils::alignment_utils_test
@@ -5,6 +5,7 @@
 
 #include <catch2/catch.hpp>
 
+#include <random>
 #include <sstream>
 #include <string>
 
@@ -17,6 +18,32 @@ const BedFile::Entry LAMBDA_1{"Lambda\t1234\t2345\tcomment1\t100\t+", 1234, 2345
 const BedFile::Entry LAMBDA_2{"Lambda\t3456\t4567\tcomment2\t101\t-", 3456, 4567, '-'};
 const BedFile::Entry RANDOM_1{"Random\t3456\t4567\tcomment3\t102\t-", 3456, 4567, '-'};
 const BedFile::Entry RANDOM_2{"Random\t5678\t6789\tcomment4\t101\t+", 5678, 6789, '+'};
+
+std::string make_random_bed(size_t num_entries, size_t genome_length, uint32_t seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> start_dist(0, genome_length);
+    std::uniform_int_distribution<size_t> length_dist(0, 2000);
+    std::ostringstream bed;
+    for (size_t i = 0; i < num_entries; ++i) {
+        const auto start = start_dist(gen);
+        bed << "chr1\t" << start << '\t' << start + length_dist(gen) << "\tentry" << i << "\t0\t"
+            << ((i % 3 == 0) ? '+' : (i % 3 == 1) ? '-' : '.') << '\n';
+    }
+    return bed.str();
+}
+
+std::vector<size_t> brute_force_overlaps(const BedFile::Entries& entries,
+                                         size_t start,
+                                         size_t end) {
+    std::vector<size_t> hits;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].start <= end && entries[i].end >= start) {
+            hits.push_back(i);
+        }
+    }
+    return hits;
+}
+
 }  // namespace
 
 TEST_CASE(CUT_TAG " load from valid file all entries loaded", CUT_TAG) {
@@ -268,4 +295,72 @@ TEST_CASE(CUT_TAG " load from stream. Parameterised testing.", CUT_TAG) {
     CHECK(entries[0] == BedFile::Entry{line, start, end, strand});
 }
 
+TEST_CASE(CUT_TAG " overlapping_entries matches a linear scan of the entries", CUT_TAG) {
+    const size_t genome_length = 1'000'000;
+    dorado::alignment::BedFile cut{};
+    std::istringstream input_stream{make_random_bed(10'000, genome_length, 42)};
+    REQUIRE(cut.load(input_stream));
+    const auto& entries = cut.entries("chr1");
+    REQUIRE(entries.size() == 10'000);
+
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<size_t> start_dist(0, genome_length);
+    std::uniform_int_distribution<size_t> length_dist(0, 50'000);
+    for (int i = 0; i < 100; ++i) {
+        const auto start = start_dist(gen);
+        const auto end = start + length_dist(gen);
+        CAPTURE(start, end);
+        CHECK(cut.overlapping_entries("chr1", start, end) ==
+              brute_force_overlaps(entries, start, end));
+    }
+    CHECK(cut.overlapping_entries("unknown", 0, genome_length).empty());
+}
+
+TEST_CASE(CUT_TAG " overlapping_entries includes entries touching the query boundaries",
+          CUT_TAG) {
+    dorado::alignment::BedFile cut{};
+    std::istringstream input_stream{LAMBDA_1.bed_line + "\n" + LAMBDA_2.bed_line};
+    REQUIRE(cut.load(input_stream));
+
+    CHECK(cut.overlapping_entries("Lambda", 0, 1233).empty());
+    CHECK(cut.overlapping_entries("Lambda", 0, 1234) == std::vector<size_t>{0});
+    CHECK(cut.overlapping_entries("Lambda", 2345, 3456) == std::vector<size_t>{0, 1});
+    CHECK(cut.overlapping_entries("Lambda", 4568, 5000).empty());
+}
+
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+TEST_CASE(CUT_TAG " overlapping_entries benchmark", CUT_TAG) {
+    const auto num_entries = GENERATE(1'000, 10'000, 100'000, 1'000'000);
+    CAPTURE(num_entries);
+
+    const size_t genome_length = 250'000'000;
+    dorado::alignment::BedFile cut{};
+    std::istringstream input_stream{make_random_bed(num_entries, genome_length, 42)};
+    REQUIRE(cut.load(input_stream));
+    const auto& entries = cut.entries("chr1");
+
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<size_t> start_dist(0, genome_length);
+    std::vector<size_t> starts(100);
+    for (auto& start : starts) {
+        start = start_dist(gen);
+    }
+
+    BENCHMARK("linear scan " + std::to_string(num_entries)) {
+        size_t hits = 0;
+        for (const auto start : starts) {
+            hits += brute_force_overlaps(entries, start, start + 20'000).size();
+        }
+        return hits;
+    };
+    BENCHMARK("indexed query " + std::to_string(num_entries)) {
+        size_t hits = 0;
+        for (const auto start : starts) {
+            hits += cut.overlapping_entries("chr1", start, start + 20'000).size();
+        }
+        return hits;
+    };
+}
+#endif  // CATCH_CONFIG_ENABLE_BENCHMARKING
+
 }  // namespace dorado::alignment::bed_file::test
\ No newline at end of file
@@ -366,4 +366,64 @@ DEFINE_TEST("FastqReader files parameterised testing") {
     }
 }
 
+DEFINE_TEST("ChunkedLineReader splits lines across chunk boundaries") {
+    const auto chunk_size =
+            GENERATE(std::size_t{1}, 2, 3, 7, ChunkedLineReader::DEFAULT_CHUNK_SIZE);
+    CAPTURE(chunk_size);
+    std::istringstream input_stream{"abc\n\nlonger line than a chunk\nlast"};
+    ChunkedLineReader cut(input_stream, chunk_size);
+
+    std::string_view line;
+    CHECK(cut.peek() == 'a');
+    REQUIRE(cut.get_non_empty_line(line));
+    CHECK(line == "abc");
+    CHECK_FALSE(cut.get_non_empty_line(line));
+    CHECK(line.empty());
+    CHECK(cut.peek() == 'l');
+    REQUIRE(cut.get_non_empty_line(line));
+    CHECK(line == "longer line than a chunk");
+    REQUIRE(cut.get_non_empty_line(line));
+    CHECK(line == "last");
+    CHECK(cut.at_end());
+    CHECK(cut.peek() == std::char_traits<char>::eof());
+    CHECK_FALSE(cut.get_non_empty_line(line));
+}
+
+DEFINE_TEST("FastqRecord::try_create from ChunkedLineReader matches reading from a stream") {
+    const auto chunk_size =
+            GENERATE(std::size_t{1}, 5, 16, ChunkedLineReader::DEFAULT_CHUNK_SIZE);
+    CAPTURE(chunk_size);
+    const std::string input{VALID_ID_LINE + VALID_LINE_WRAPPED_SEQ_LINE + VALID_SEPARATOR_LINE +
+                            VALID_LINE_WRAPPED_QUAL_LINE + VALID_ID_LINE_2 + VALID_SEQ_LINE_WITH_U +
+                            VALID_SEPARATOR_LINE + VALID_QUAL_LINE_2 + VALID_ID_LINE_WITH_TABS +
+                            VALID_SEQ_LINE_2 + VALID_SEPARATOR_LINE + VALID_QUAL};
+
+    std::istringstream expected_stream{input};
+    std::istringstream chunked_stream{input};
+    ChunkedLineReader line_reader(chunked_stream, chunk_size);
+    std::size_t num_records{};
+    for (;;) {
+        std::string expected_error, error;
+        auto expected = FastqRecord::try_create(expected_stream, expected_error);
+        auto record = FastqRecord::try_create(line_reader, error);
+        CHECK(error == expected_error);
+        REQUIRE(record.has_value() == expected.has_value());
+        if (!record) {
+            break;
+        }
+        CHECK(*record == *expected);
+        ++num_records;
+    }
+    CHECK(num_records == 3);
+}
+
+DEFINE_TEST("FastqRecord::try_create from ChunkedLineReader with invalid qstring sets error") {
+    std::istringstream input_stream{VALID_ID_LINE + VALID_SEQ_LINE + VALID_SEPARATOR_LINE +
+                                    "!$#(%\n"};
+    ChunkedLineReader line_reader(input_stream, 4);
+    std::string error;
+    CHECK_FALSE(FastqRecord::try_create(line_reader, error).has_value());
+    CHECK(error == "Invalid qstring.");
+}
+
 }  // namespace dorado::utils::fastq_reader::test
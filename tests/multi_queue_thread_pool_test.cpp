@@ -5,7 +5,11 @@
 
 #include <catch2/catch.hpp>
 
+#include <atomic>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #define CUT_TAG "[dorado::utils::concurrency::MultiQueueThreadPool]"
 #define DEFINE_TEST(name) TEST_CASE(CUT_TAG " " name, CUT_TAG)
@@ -173,4 +177,111 @@ DEFINE_TEST_FIXTURE_METHOD(
     REQUIRE(task_started_flags[2]->wait_for(TIMEOUT));
 }
 
+DEFINE_TEST_FIXTURE_METHOD(
+        "ThreadPoolQueue::push() normal priority with pool size 2 and 2 busy high priority tasks "
+        "then only 1 normal priority task is invoked until one finishes") {
+    auto& high_task_queue = cut->create_task_queue(TaskPriority::high);
+    high_task_queue.push(create_task(0));
+    high_task_queue.push(create_task(1));
+    REQUIRE(task_started_flags[0]->wait_for(TIMEOUT));
+    REQUIRE(task_started_flags[1]->wait_for(TIMEOUT));
+
+    auto& normal_task_queue = cut->create_task_queue(TaskPriority::normal);
+    normal_task_queue.push(create_task(2));
+    normal_task_queue.push(create_task(3));
+
+    REQUIRE(task_started_flags[2]->wait_for(TIMEOUT));
+    CHECK_FALSE(task_started_flags[3]->wait_for(FAST_TIMEOUT));
+
+    task_release_flags[2]->signal();
+    REQUIRE(task_started_flags[3]->wait_for(TIMEOUT));
+}
+
+DEFINE_TEST("ThreadPoolQueue tasks from a single queue run on every thread") {
+    constexpr std::size_t num_threads{4};
+    MultiQueueThreadPool cut{num_threads, "test_executor"};
+    auto& task_queue = cut.create_task_queue(TaskPriority::normal);
+    Flag release_busy_tasks{};
+    Latch all_busy_tasks_started{num_threads};
+    auto release_tasks = PostCondition([&release_busy_tasks] { release_busy_tasks.signal(); });
+    for (std::size_t index{0}; index < num_threads; ++index) {
+        task_queue.push([&release_busy_tasks, &all_busy_tasks_started] {
+            all_busy_tasks_started.count_down();
+            release_busy_tasks.wait();
+        });
+    }
+
+    REQUIRE(all_busy_tasks_started.wait_for(TIMEOUT));
+}
+
+DEFINE_TEST("ThreadPoolQueue::push() from multiple producers invokes every task once") {
+    constexpr std::size_t num_producers{4};
+    constexpr std::size_t num_tasks_per_producer{10000};
+    MultiQueueThreadPool cut{4, "test_executor"};
+    std::atomic<std::size_t> num_invoked{0};
+    Latch all_tasks_invoked{num_producers * num_tasks_per_producer};
+
+    std::vector<std::thread> producer_threads{};
+    for (std::size_t producer{0}; producer < num_producers; ++producer) {
+        const auto priority = producer % 2 == 0 ? TaskPriority::normal : TaskPriority::high;
+        auto& task_queue = cut.create_task_queue(priority);
+        producer_threads.emplace_back([&task_queue, &num_invoked, &all_tasks_invoked] {
+            for (std::size_t index{0}; index < num_tasks_per_producer; ++index) {
+                task_queue.push([&num_invoked, &all_tasks_invoked] {
+                    ++num_invoked;
+                    all_tasks_invoked.count_down();
+                });
+            }
+        });
+    }
+    for (auto& producer_thread : producer_threads) {
+        producer_thread.join();
+    }
+
+    REQUIRE(all_tasks_invoked.wait_for(TIMEOUT));
+    cut.join();
+    CHECK(num_invoked.load() == num_producers * num_tasks_per_producer);
+}
+
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+DEFINE_TEST("MultiQueueThreadPool task throughput") {
+    // Tiny tasks, so that the benchmark measures the scheduling overhead.
+    const auto num_threads = GENERATE(as<std::size_t>{}, 1, 2, 4, 8, 16);
+    // A single queue is how an AlignerNode uses the pool.
+    const auto num_producers = GENERATE(as<std::size_t>{}, 1, 2);
+    CAPTURE(num_threads, num_producers);
+    constexpr std::size_t num_tasks{100000};
+    const std::size_t num_tasks_per_producer{num_tasks / num_producers};
+
+    MultiQueueThreadPool cut{num_threads, "bench_executor"};
+    std::vector<MultiQueueThreadPool::ThreadPoolQueue*> task_queues{};
+    for (std::size_t producer{0}; producer < num_producers; ++producer) {
+        task_queues.push_back(&cut.create_task_queue(TaskPriority::normal));
+    }
+
+    BENCHMARK(std::to_string(num_tasks) + " tasks, " + std::to_string(num_threads) +
+              " threads, " + std::to_string(num_producers) + " queues") {
+        std::atomic<std::size_t> num_invoked{0};
+        Latch all_tasks_invoked{num_tasks};
+        std::vector<std::thread> producer_threads{};
+        for (auto* task_queue : task_queues) {
+            producer_threads.emplace_back([task_queue, num_tasks_per_producer, &num_invoked,
+                                           &all_tasks_invoked] {
+                for (std::size_t index{0}; index < num_tasks_per_producer; ++index) {
+                    task_queue->push([&num_invoked, &all_tasks_invoked] {
+                        num_invoked.fetch_add(1, std::memory_order_relaxed);
+                        all_tasks_invoked.count_down();
+                    });
+                }
+            });
+        }
+        for (auto& producer_thread : producer_threads) {
+            producer_thread.join();
+        }
+        all_tasks_invoked.wait();
+        return num_invoked.load();
+    };
+}
+#endif  // CATCH_CONFIG_ENABLE_BENCHMARKING
+
 }  // namespace dorado::utils::concurrency::multi_queue_thread_pool
\ No newline at end of file
@@ -2,6 +2,12 @@
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #define CUT_TAG "[myers]"
 #define DEFINE_TEST(name) TEST_CASE(CUT_TAG " " name, CUT_TAG)
 
@@ -93,3 +99,70 @@ DEFINE_TEST("Complex alignment, doesn't crash when high edist near start") {
     const auto alignments = myers_align(query, seq, max_edist);
     CHECK(!alignments.empty());
 }
+
+namespace {
+
+// Reference global edit distance using the full DP matrix.
+int reference_global_edist(std::string_view pattern, std::string_view text) {
+    std::vector<int> prev(pattern.size() + 1);
+    std::vector<int> curr(pattern.size() + 1);
+    for (size_t i = 0; i <= pattern.size(); ++i) {
+        prev[i] = static_cast<int>(i);
+    }
+    for (size_t j = 1; j <= text.size(); ++j) {
+        curr[0] = static_cast<int>(j);
+        for (size_t i = 1; i <= pattern.size(); ++i) {
+            const int sub = prev[i - 1] + (pattern[i - 1] == text[j - 1] ? 0 : 1);
+            curr[i] = std::min({sub, prev[i] + 1, curr[i - 1] + 1});
+        }
+        std::swap(prev, curr);
+    }
+    return prev[pattern.size()];
+}
+
+std::string random_sequence(std::minstd_rand& rng, size_t length, std::string_view alphabet) {
+    std::uniform_int_distribution<size_t> dist(0, alphabet.size() - 1);
+    std::string seq(length, ' ');
+    for (auto& c : seq) {
+        c = alphabet[dist(rng)];
+    }
+    return seq;
+}
+
+}  // namespace
+
+DEFINE_TEST("MultiPatternMyers matches reference edit distances") {
+    const auto pattern_length = GENERATE(size_t{1}, size_t{7}, size_t{39}, size_t{63}, size_t{64});
+    const auto num_patterns = GENERATE(size_t{1}, size_t{5}, size_t{96});
+    CAPTURE(pattern_length, num_patterns);
+
+    std::minstd_rand rng(static_cast<unsigned>(pattern_length * 1000 + num_patterns));
+    std::vector<std::string> patterns;
+    for (size_t i = 0; i < num_patterns; ++i) {
+        patterns.push_back(random_sequence(rng, pattern_length, "ACGT"));
+    }
+    const dorado::splitter::MultiPatternMyers scorer(patterns);
+    CHECK(scorer.num_patterns() == num_patterns);
+    CHECK(scorer.pattern_length() == pattern_length);
+
+    // Texts include characters that don't appear in any pattern.
+    for (const size_t text_length : {size_t{0}, size_t{1}, pattern_length, pattern_length * 2}) {
+        CAPTURE(text_length);
+        const auto text = random_sequence(rng, text_length, "ACGTN");
+        const auto edists = scorer.global_edists(text);
+        REQUIRE(edists.size() == num_patterns);
+        for (size_t i = 0; i < num_patterns; ++i) {
+            CAPTURE(i);
+            CHECK(edists[i] == reference_global_edist(patterns[i], text));
+        }
+    }
+}
+
+DEFINE_TEST("MultiPatternMyers rejects invalid patterns") {
+    using dorado::splitter::MultiPatternMyers;
+    CHECK_THROWS_AS(MultiPatternMyers({}), std::invalid_argument);
+    CHECK_THROWS_AS(MultiPatternMyers({""}), std::invalid_argument);
+    CHECK_THROWS_AS(MultiPatternMyers({"ACGT", "ACG"}), std::invalid_argument);
+    const std::string too_long(MultiPatternMyers::MAX_PATTERN_LENGTH + 1, 'A');
+    CHECK_THROWS_AS(MultiPatternMyers({too_long}), std::invalid_argument);
+}
@@ -0,0 +1,112 @@
+#include "utils/read_id_set.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_set>
+
+#define CUT_TAG "[dorado::utils::ReadIdSet]"
+
+namespace dorado::utils::read_id_set {
+
+namespace {
+
+std::string random_uuid(std::mt19937& rng) {
+    std::uniform_int_distribution<int> byte_dist(0, 255);
+    std::string uuid;
+    for (int i = 0; i < 16; ++i) {
+        char hex[3];
+        std::snprintf(hex, sizeof(hex), "%02x", byte_dist(rng));
+        uuid += hex;
+        if (i == 3 || i == 5 || i == 7 || i == 9) {
+            uuid += '-';
+        }
+    }
+    return uuid;
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG " pack", CUT_TAG) {
+    ReadIdSet::PackedReadId packed{};
+    CHECK(ReadIdSet::pack("002bd127-db82-436f-b828-28567c3d505d", packed));
+    CHECK(packed[0] == 0x00);
+    CHECK(packed[1] == 0x2b);
+    CHECK(packed[4] == 0xdb);
+    CHECK(packed[15] == 0x5d);
+
+    // Anything other than a lowercase UUID isn't packed.
+    CHECK_FALSE(ReadIdSet::pack("002BD127-DB82-436F-B828-28567C3D505D", packed));
+    CHECK_FALSE(ReadIdSet::pack("002bd127-db82-436f-b828-28567c3d505", packed));
+    CHECK_FALSE(ReadIdSet::pack("002bd127db82-436f-b828-28567c3d505d0", packed));
+    CHECK_FALSE(ReadIdSet::pack("002bd127-db82-436f-b828-28567c3d505g", packed));
+    CHECK_FALSE(ReadIdSet::pack("read_1", packed));
+}
+
+TEST_CASE(CUT_TAG " behaves as a set of strings", CUT_TAG) {
+    ReadIdSet read_ids;
+    CHECK(read_ids.empty());
+
+    const std::string uuid = "002bd127-db82-436f-b828-28567c3d505d";
+    const std::string zero_uuid = "00000000-0000-0000-0000-000000000000";
+    const std::string upper_uuid = "002BD127-DB82-436F-B828-28567C3D505D";
+    const std::string name = "read_1";
+
+    for (const auto& read_id : {uuid, zero_uuid, upper_uuid, name}) {
+        CAPTURE(read_id);
+        CHECK_FALSE(read_ids.contains(read_id));
+        CHECK(read_ids.insert(read_id));
+        CHECK_FALSE(read_ids.insert(read_id));
+        CHECK(read_ids.count(read_id) == 1);
+    }
+    CHECK(read_ids.size() == 4);
+    CHECK_FALSE(read_ids.contains("002bd127-db82-436f-b828-28567c3d505e"));
+
+    ReadIdSet::PackedReadId packed{};
+    REQUIRE(ReadIdSet::pack(uuid, packed));
+    CHECK(read_ids.contains(packed));
+
+    CHECK(read_ids.erase(uuid));
+    CHECK_FALSE(read_ids.erase(uuid));
+    CHECK(read_ids.erase(zero_uuid));
+    CHECK(read_ids.erase(name));
+    CHECK(read_ids.size() == 1);
+    CHECK(read_ids.contains(upper_uuid));
+
+    read_ids.clear();
+    CHECK(read_ids.empty());
+    CHECK_FALSE(read_ids.contains(upper_uuid));
+}
+
+TEST_CASE(CUT_TAG " matches std::unordered_set", CUT_TAG) {
+    std::mt19937 rng(42);
+    std::vector<std::string> all_ids;
+    for (int i = 0; i < 20000; ++i) {
+        all_ids.push_back(i % 10 == 0 ? "read_" + std::to_string(i) : random_uuid(rng));
+    }
+
+    ReadIdSet read_ids;
+    std::unordered_set<std::string> expected;
+    std::uniform_int_distribution<size_t> id_dist(0, all_ids.size() - 1);
+    for (int i = 0; i < 100000; ++i) {
+        const auto& read_id = all_ids[id_dist(rng)];
+        if (i % 3 == 0) {
+            CHECK(read_ids.erase(read_id) == (expected.erase(read_id) > 0));
+        } else {
+            CHECK(read_ids.insert(read_id) == expected.insert(read_id).second);
+        }
+    }
+
+    CHECK(read_ids.size() == expected.size());
+    for (const auto& read_id : all_ids) {
+        CHECK(read_ids.contains(read_id) == (expected.count(read_id) > 0));
+    }
+
+    ReadIdSet copy(expected);
+    CHECK(copy.size() == expected.size());
+    CHECK(copy.memory_usage() < copy.string_set_memory_usage());
+}
+
+}  // namespace dorado::utils::read_id_set
@@ -0,0 +1,86 @@
+#include "utils/concurrency/detail/small_task.h"
+
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#define CUT_TAG "[dorado::utils::concurrency::detail::SmallTask]"
+#define DEFINE_TEST(name) TEST_CASE(CUT_TAG " " name, CUT_TAG)
+
+namespace dorado::utils::concurrency::detail::small_task_test {
+
+DEFINE_TEST("default constructed task is empty") {
+    SmallTask cut{};
+
+    CHECK_FALSE(cut);
+    CHECK_THROWS_AS(cut(), std::bad_function_call);
+}
+
+DEFINE_TEST("small callable is stored inline and invoked") {
+    int num_calls{0};
+    SmallTask cut{[&num_calls] { ++num_calls; }};
+
+    REQUIRE(cut);
+    CHECK(cut.is_inline());
+    cut();
+    cut();
+    CHECK(num_calls == 2);
+}
+
+DEFINE_TEST("large callable is stored on the heap and invoked") {
+    std::array<char, SmallTask::INLINE_SIZE + 1> payload{};
+    payload.back() = 'x';
+    char invoked_with{};
+    SmallTask cut{[payload, &invoked_with] { invoked_with = payload.back(); }};
+
+    CHECK_FALSE(cut.is_inline());
+    cut();
+    CHECK(invoked_with == 'x');
+}
+
+DEFINE_TEST("move-only callable is accepted and destroyed with the task") {
+    auto value = std::make_shared<int>(42);
+    int invoked_with{};
+    {
+        SmallTask cut{[owned = std::make_unique<std::shared_ptr<int>>(value), &invoked_with] {
+            invoked_with = **owned;
+        }};
+        CHECK(value.use_count() == 2);
+        cut();
+    }
+    CHECK(invoked_with == 42);
+    CHECK(value.use_count() == 1);
+}
+
+DEFINE_TEST("moving a task transfers the callable") {
+    auto value = std::make_shared<int>(1);
+    SmallTask source{[value] { ++*value; }};
+
+    SmallTask target{std::move(source)};
+    CHECK_FALSE(source);
+    REQUIRE(target);
+    target();
+    CHECK(*value == 2);
+
+    source = std::move(target);
+    CHECK_FALSE(target);
+    source();
+    CHECK(*value == 3);
+
+    source = nullptr;
+    CHECK(value.use_count() == 1);
+}
+
+DEFINE_TEST("mutable callable keeps its state between calls") {
+    int last_count{0};
+    SmallTask cut{[count = 0, &last_count]() mutable { last_count = ++count; }};
+
+    cut();
+    cut();
+    CHECK(last_count == 2);
+}
+
+}  // namespace dorado::utils::concurrency::detail::small_task_test
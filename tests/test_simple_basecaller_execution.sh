@@ -117,6 +117,10 @@ cp $output_dir/calls.sam $output_dir/folder/calls.sam
 cp $output_dir/calls.sam $output_dir/folder/subfolder/calls.sam
 $dorado_bin aligner $output_dir/ref.fq $output_dir/folder -o $output_dir/aligner_out
 dorado_check_bam_not_empty
+$dorado_bin aligner $output_dir/ref.fq $output_dir/folder -r --concurrent-files 2 -o $output_dir/aligner_out_concurrent
+for bam in calls.bam subfolder/calls.bam; do
+    samtools quickcheck -u $output_dir/aligner_out_concurrent/$bam
+done
 $dorado_bin basecaller ${model} $data_dir/pod5 -b ${batch} --modified-bases 5mCG_5hmCG | $dorado_bin aligner $output_dir/ref.fq > $output_dir/calls.bam
 dorado_check_bam_not_empty
 $dorado_bin basecaller ${model} $data_dir/pod5 -b ${batch} --modified-bases 5mCG_5hmCG --reference $output_dir/ref.fq > $output_dir/calls.bam